@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSBaselineStore.h"
+#include "ULSClientNetworkOwner.h"
+
+FULSBaselineStore::FULSBaselineStore(int32 historySize)
+	: HistorySize(FMath::Clamp(historySize, 2, MaxHistorySize))
+{
+}
+
+FULSBaselineLayout& FULSBaselineStore::GetLayout(const UClass* cls)
+{
+	return Layouts.FindOrAdd(cls);
+}
+
+int32 FULSBaselineStore::FindOrAddField(const UClass* cls, FName fieldName, int8 type)
+{
+	FULSBaselineLayout& layout = GetLayout(cls);
+	if (const int32* existingIndex = layout.FieldIndices.Find(fieldName))
+	{
+		return layout.Fields[*existingIndex].Type == type ? *existingIndex : INDEX_NONE;
+	}
+
+	FProperty* prop = cls->FindPropertyByName(fieldName);
+	if (prop == nullptr || type == EReplicatedFieldType::String)
+	{
+		return INDEX_NONE;
+	}
+
+	FULSBaselineField& field = layout.Fields.AddDefaulted_GetRef();
+	field.Name = fieldName;
+	field.Property = prop;
+	field.RepNotify = cls->FindFunctionByName(FName(TEXT("OnRep_") + fieldName.ToString()));
+	field.Type = type;
+	field.Slot = layout.NumWords;
+	field.NumWords = (type == EReplicatedFieldType::Vector3 ? 3 : 1);
+	layout.NumWords += field.NumWords;
+
+	const int32 fieldIndex = layout.Fields.Num() - 1;
+	layout.FieldIndices.Add(fieldName, fieldIndex);
+	return fieldIndex;
+}
+
+bool FULSBaselineStore::BeginRow(int64 uniqueId, const UClass* cls, int64 baseSequence, int64 newSequence, uint64*& outNewRow, const uint64*& outLatestRow)
+{
+	if (UnusedWords > Words.Num() / 2)
+	{
+		Compact();
+	}
+
+	const FULSBaselineLayout& layout = GetLayout(cls);
+	FObjectRows& rows = Objects.FindOrAdd(uniqueId);
+	if (rows.Class != cls)
+	{
+		// New object, or the id was reused for an object of another class
+		UnusedWords += rows.RowWords * HistorySize;
+		rows = FObjectRows();
+		rows.Class = cls;
+	}
+
+	if (rows.RowWords < layout.NumWords)
+	{
+		Allocate(rows, layout.NumWords);
+	}
+
+	int32 baseSlot = INDEX_NONE;
+	if (baseSequence != 0)
+	{
+		for (int32 slot = 0; slot < HistorySize; slot++)
+		{
+			if (rows.Sequences[slot] == baseSequence)
+			{
+				baseSlot = slot;
+				break;
+			}
+		}
+
+		if (baseSlot == INDEX_NONE)
+		{
+			return false;
+		}
+	}
+
+	const int32 latestSlot = rows.Newest;
+	const int32 newSlot = (latestSlot + 1) % HistorySize;
+
+	uint64* newRow = GetRow(rows, newSlot);
+	if (baseSlot == INDEX_NONE)
+	{
+		FMemory::Memzero(newRow, rows.RowWords * sizeof(uint64));
+	}
+	else if (baseSlot != newSlot)
+	{
+		FMemory::Memcpy(newRow, GetRow(rows, baseSlot), rows.RowWords * sizeof(uint64));
+	}
+
+	rows.Sequences[newSlot] = newSequence;
+	rows.Newest = newSlot;
+
+	outNewRow = newRow;
+	outLatestRow = (latestSlot != INDEX_NONE ? GetRow(rows, latestSlot) : nullptr);
+	return true;
+}
+
+int64 FULSBaselineStore::GetLatestSequence(int64 uniqueId) const
+{
+	const FObjectRows* rows = Objects.Find(uniqueId);
+	if (rows == nullptr || rows->Newest == INDEX_NONE)
+	{
+		return 0;
+	}
+	return rows->Sequences[rows->Newest];
+}
+
+void FULSBaselineStore::RemoveObject(int64 uniqueId)
+{
+	FObjectRows rows;
+	if (Objects.RemoveAndCopyValue(uniqueId, rows))
+	{
+		UnusedWords += rows.RowWords * HistorySize;
+	}
+}
+
+void FULSBaselineStore::Reset()
+{
+	Words.Reset();
+	UnusedWords = 0;
+	Objects.Reset();
+	Layouts.Reset();
+}
+
+void FULSBaselineStore::Allocate(FObjectRows& rows, int32 rowWords)
+{
+	// Grown rows move to the end of the arena. Existing values are kept, new fields start zeroed.
+	const int32 newOffset = Words.Num();
+	Words.AddZeroed(rowWords * HistorySize);
+
+	if (rows.RowWords > 0)
+	{
+		for (int32 slot = 0; slot < HistorySize; slot++)
+		{
+			FMemory::Memcpy(Words.GetData() + newOffset + slot * rowWords, GetRow(rows, slot), rows.RowWords * sizeof(uint64));
+		}
+		UnusedWords += rows.RowWords * HistorySize;
+	}
+
+	rows.Offset = newOffset;
+	rows.RowWords = rowWords;
+}
+
+void FULSBaselineStore::Compact()
+{
+	TArray<uint64> compacted;
+	compacted.Reserve(Words.Num() - UnusedWords);
+
+	for (auto& pair : Objects)
+	{
+		FObjectRows& rows = pair.Value;
+		const int32 newOffset = compacted.Num();
+		compacted.Append(Words.GetData() + rows.Offset, rows.RowWords * HistorySize);
+		rows.Offset = newOffset;
+	}
+
+	Words = MoveTemp(compacted);
+	UnusedWords = 0;
+}
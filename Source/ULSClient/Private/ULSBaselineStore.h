@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* A replicated field as stored in a baseline row.
+*
+* Every value occupies one or more 64 bit words: references store the unique id, integers and
+* bools the sign-extended value, floats the bits of the value as double and vectors the double
+* bits of each component. Strings are not baselined.
+*/
+struct FULSBaselineField
+{
+	FName Name;
+	FProperty* Property = nullptr;
+	UFunction* RepNotify = nullptr;
+	int8 Type = 0;
+	int32 Slot = 0;
+	int32 NumWords = 0;
+};
+
+/* Fields of a class in the order they were first received. Shared by all objects of the class. */
+struct FULSBaselineLayout
+{
+	TArray<FULSBaselineField> Fields;
+	TMap<FName, int32> FieldIndices;
+	int32 NumWords = 0;
+};
+
+/**
+ * Per-object replication baselines, keyed by the sequence number they were received with.
+ *
+ * Each object keeps a small ring of rows. All rows live in one contiguous word arena, so applying
+ * a delta touches two adjacent rows instead of the reflected properties of the object. Space of
+ * removed or grown objects is reclaimed by compacting the arena once half of it is unused.
+ */
+class FULSBaselineStore
+{
+public:
+	static constexpr int32 MaxHistorySize = 16;
+
+	explicit FULSBaselineStore(int32 historySize);
+
+	FULSBaselineLayout& GetLayout(const UClass* cls);
+
+	/* Returns the index of the field in the layout of cls, or INDEX_NONE if it can't be baselined */
+	int32 FindOrAddField(const UClass* cls, FName fieldName, int8 type);
+
+	/*
+	* Starts the row for newSequence of uniqueId.
+	*
+	* The new row is initialized from the row stored for baseSequence (zeroed if baseSequence is 0).
+	* outLatestRow is the newest row before this call, or nullptr if there was none. Returns false if the
+	* base row is no longer available. The pointers are valid until the next call into the store.
+	*/
+	bool BeginRow(int64 uniqueId, const UClass* cls, int64 baseSequence, int64 newSequence, uint64*& outNewRow, const uint64*& outLatestRow);
+
+	/* Sequence of the newest row of uniqueId, 0 if there is none */
+	int64 GetLatestSequence(int64 uniqueId) const;
+
+	void RemoveObject(int64 uniqueId);
+
+	void Reset();
+
+private:
+	struct FObjectRows
+	{
+		const UClass* Class = nullptr;
+		int32 Offset = 0;
+		int32 RowWords = 0;
+		int32 Newest = INDEX_NONE;
+		int64 Sequences[MaxHistorySize] = {};
+	};
+
+	uint64* GetRow(const FObjectRows& rows, int32 slot) { return Words.GetData() + rows.Offset + slot * rows.RowWords; }
+
+	void Allocate(FObjectRows& rows, int32 rowWords);
+
+	void Compact();
+
+	int32 HistorySize;
+	TArray<uint64> Words;
+	int32 UnusedWords = 0;
+	TMap<int64, FObjectRows> Objects;
+	TMap<const UClass*, FULSBaselineLayout> Layouts;
+};
@@ -0,0 +1,359 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSTestSupport.h"
+#include "ULSPacketWriter.h"
+#include "ULSWirePacket.h"
+#include "ULSStats.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "HAL/PlatformMemory.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Decode and apply throughput of synthetic server streams.
+*
+* Run headless with
+*   UnrealEditor-Cmd <Project>.uproject -nullrhi -unattended -ExecCmds="Automation RunTests ULS.Benchmark; Quit"
+*
+* Every stream (Replication, Rpc, Spawn, Despawn) runs at 1k, 10k and 100k objects, or at the scales
+* given with -ULSBenchmarkScales=1000,10000. Packets are built up front and fed through
+* UULSClientNetworkOwner::HandleWirePacket the way the transports do: a UULSWirePacket reading the
+* received bytes in place. Results go to Saved/ULSBenchmarks/<timestamp>.json or -ULSBenchmarkOutput=<file>.
+*
+* Allocations are counted by wrapping GMalloc for the timed section, so allocations of other threads
+* running at the same time are included. Keep the machine otherwise idle.
+*/
+
+namespace
+{
+	/* Replication and RPC streams are repeated until they have at least this many packets */
+	constexpr int32 MinUpdatePackets = 100000;
+
+	const int32 DefaultScales[] = { 1000, 10000, 100000 };
+
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* inner)
+			: Inner(inner)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T count, uint32 alignment) override
+		{
+			Allocations.fetch_add(1, std::memory_order_relaxed);
+			return Inner->Malloc(count, alignment);
+		}
+
+		virtual void* Realloc(void* original, SIZE_T count, uint32 alignment) override
+		{
+			if (count > 0)
+			{
+				Allocations.fetch_add(1, std::memory_order_relaxed);
+			}
+			return Inner->Realloc(original, count, alignment);
+		}
+
+		virtual void Free(void* original) override { Inner->Free(original); }
+
+		virtual SIZE_T QuantizeSize(SIZE_T count, uint32 alignment) override { return Inner->QuantizeSize(count, alignment); }
+
+		virtual bool GetAllocationSize(void* original, SIZE_T& sizeOut) override { return Inner->GetAllocationSize(original, sizeOut); }
+
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+		int64 GetAllocations() const { return Allocations.load(std::memory_order_relaxed); }
+
+	private:
+		FMalloc* Inner;
+		std::atomic<int64> Allocations { 0 };
+	};
+
+	struct FBenchmarkResult
+	{
+		FString Stream;
+		int32 NumObjects = 0;
+		int32 NumPackets = 0;
+		int64 NumFields = 0;
+		int64 NumBytes = 0;
+		double Seconds = 0;
+		int64 Allocations = 0;
+		/* Process memory after the run, and how much the run added to it */
+		uint64 UsedPhysical = 0;
+		int64 UsedPhysicalDelta = 0;
+	};
+
+	TArray<uint8> MakeCreateObject(int64 uniqueId)
+	{
+		FULSPacketWriter writer(EWirePacketType::CreateObject);
+		writer.WriteInt32(0);
+		writer.WriteString(UULSTestObject::StaticClass()->GetPathName());
+		writer.WriteInt64(uniqueId);
+		return writer.MoveBytes();
+	}
+
+	TArray<uint8> MakeSpawnActor(int64 uniqueId)
+	{
+		FULSPacketWriter writer(EWirePacketType::SpawnActor);
+		writer.WriteInt32(0);
+		writer.WriteString(AULSTestActor::StaticClass()->GetPathName());
+		writer.WriteInt64(uniqueId);
+		return writer.MoveBytes();
+	}
+
+	TArray<uint8> MakeDespawnActor(int64 uniqueId)
+	{
+		FULSPacketWriter writer(EWirePacketType::DespawnActor);
+		writer.WriteInt32(0);
+		writer.WriteInt64(uniqueId);
+		return writer.MoveBytes();
+	}
+
+	TArray<uint8> MakeDespawnActors(int64 firstId, int32 count)
+	{
+		FULSPacketWriter writer(EWirePacketType::DespawnActors, sizeof(int32) * 2 + sizeof(int64) * count);
+		writer.WriteInt32(0);
+		writer.WriteInt32(count);
+		for (int64 id = firstId; id < firstId + count; id++)
+		{
+			writer.WriteInt64(id);
+		}
+		return writer.MoveBytes();
+	}
+
+	/* Five fields, all of them changed every round */
+	TArray<uint8> MakeReplication(int64 uniqueId, int32 round)
+	{
+		FULSPacketWriter writer(EWirePacketType::Replication);
+		writer.WriteInt32(0);
+		writer.WriteInt64(uniqueId);
+		writer.WriteInt32(5);
+		writer.WriteField(FULSReplicatedField::Int32(TEXT("Health"), 100 - round));
+		writer.WriteField(FULSReplicatedField::Int64(TEXT("Score"), uniqueId * 10 + round));
+		writer.WriteField(FULSReplicatedField::Float(TEXT("Speed"), round * 0.5f));
+		writer.WriteField(FULSReplicatedField::String(TEXT("Label"), FString::Printf(TEXT("Object %lld round %d"), uniqueId, round)));
+		writer.WriteField(FULSReplicatedField::Vector(TEXT("Location"), FVector((double)uniqueId, (double)round, 0.0)));
+		return writer.MoveBytes();
+	}
+
+	/* Three parameters */
+	TArray<uint8> MakeRpc(int64 uniqueId, int32 round)
+	{
+		FULSPacketWriter writer(EWirePacketType::RpcCall);
+		writer.WriteInt32(1 << 0); // FullReflection
+		writer.WriteInt64(uniqueId);
+		writer.WriteString(TEXT("ApplyHit"));
+		writer.WriteString(FString());
+		writer.WriteInt32(3);
+		writer.WriteField(FULSReplicatedField::Int32(TEXT("damage"), 1 + round % 10));
+		writer.WriteField(FULSReplicatedField::Float(TEXT("force"), round * 0.25f));
+		writer.WriteField(FULSReplicatedField::String(TEXT("source"), TEXT("Benchmark")));
+		return writer.MoveBytes();
+	}
+
+	FBenchmarkResult RunTimed(FULSTestSession& session, const FString& stream, int32 numObjects, const TArray<TArray<uint8>>& packets, int32 fieldsPerPacket)
+	{
+		FBenchmarkResult result;
+		result.Stream = stream;
+		result.NumObjects = numObjects;
+		result.NumPackets = packets.Num();
+		result.NumFields = (int64)packets.Num() * fieldsPerPacket;
+		for (const TArray<uint8>& bytes : packets)
+		{
+			result.NumBytes += bytes.Num();
+		}
+
+		const int64 usedBefore = (int64)FPlatformMemory::GetStats().UsedPhysical;
+
+		// Other threads may still be inside the wrapper after it was swapped out, so it is never freed
+		static FCountingMalloc* countingMalloc = new FCountingMalloc(GMalloc);
+
+		FMalloc* previousMalloc = GMalloc;
+		const int64 allocationsBefore = countingMalloc->GetAllocations();
+		GMalloc = countingMalloc;
+
+		const double startTime = FPlatformTime::Seconds();
+		session.Apply(packets);
+		result.Seconds = FPlatformTime::Seconds() - startTime;
+
+		GMalloc = previousMalloc;
+		result.Allocations = countingMalloc->GetAllocations() - allocationsBefore;
+
+		// The process-wide peak would carry over from earlier runs, so each run reports its own before and after
+		result.UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+		result.UsedPhysicalDelta = (int64)result.UsedPhysical - usedBefore;
+		return result;
+	}
+
+	FBenchmarkResult RunStream(const FString& stream, int32 numObjects)
+	{
+		FULSTestSession session(TEXT("ULSBenchmark"));
+		TArray<TArray<uint8>> packets;
+
+		if (stream == TEXT("Replication") || stream == TEXT("Rpc"))
+		{
+			for (int64 id = 1; id <= numObjects; id++)
+			{
+				packets.Add(MakeCreateObject(id));
+			}
+			session.Apply(packets);
+			packets.Reset();
+
+			const bool bReplication = stream == TEXT("Replication");
+			const int32 numRounds = FMath::Max(1, MinUpdatePackets / numObjects);
+			packets.Reserve(numRounds * numObjects);
+			for (int32 round = 0; round < numRounds; round++)
+			{
+				for (int64 id = 1; id <= numObjects; id++)
+				{
+					packets.Add(bReplication ? MakeReplication(id, round) : MakeRpc(id, round));
+				}
+			}
+			return RunTimed(session, stream, numObjects, packets, bReplication ? 5 : 3);
+		}
+
+		if (stream == TEXT("Spawn"))
+		{
+			for (int64 id = 1; id <= numObjects; id++)
+			{
+				packets.Add(MakeSpawnActor(id));
+			}
+			return RunTimed(session, stream, numObjects, packets, 0);
+		}
+
+		// Despawn and BulkDespawn
+		for (int64 id = 1; id <= numObjects; id++)
+		{
+			packets.Add(MakeSpawnActor(id));
+		}
+		session.Apply(packets);
+		packets.Reset();
+
+		if (stream == TEXT("BulkDespawn"))
+		{
+			// Destroyed within the timed run, like the single packets
+			session.Owner->DespawnBudgetMilliseconds = 0;
+			packets.Add(MakeDespawnActors(1, numObjects));
+			return RunTimed(session, stream, numObjects, packets, 0);
+		}
+
+		for (int64 id = 1; id <= numObjects; id++)
+		{
+			packets.Add(MakeDespawnActor(id));
+		}
+		return RunTimed(session, stream, numObjects, packets, 0);
+	}
+
+	TSharedRef<FJsonObject> ToJson(const FBenchmarkResult& result)
+	{
+		TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+		json->SetStringField(TEXT("stream"), result.Stream);
+		json->SetNumberField(TEXT("objects"), result.NumObjects);
+		json->SetNumberField(TEXT("packets"), result.NumPackets);
+		json->SetNumberField(TEXT("bytes"), (double)result.NumBytes);
+		json->SetNumberField(TEXT("seconds"), result.Seconds);
+		json->SetNumberField(TEXT("packetsPerSecond"), result.Seconds > 0 ? result.NumPackets / result.Seconds : 0);
+		if (result.NumFields > 0)
+		{
+			json->SetNumberField(TEXT("nsPerField"), result.Seconds * 1e9 / result.NumFields);
+		}
+		json->SetNumberField(TEXT("allocationsPerPacket"), result.NumPackets > 0 ? (double)result.Allocations / result.NumPackets : 0);
+		json->SetNumberField(TEXT("usedPhysicalBytes"), (double)result.UsedPhysical);
+		json->SetNumberField(TEXT("usedPhysicalDeltaBytes"), (double)result.UsedPhysicalDelta);
+		return json;
+	}
+
+	TArray<int32> GetScales()
+	{
+		FString scalesArg;
+		if (FParse::Value(FCommandLine::Get(), TEXT("ULSBenchmarkScales="), scalesArg) == false)
+		{
+			return TArray<int32>(DefaultScales, UE_ARRAY_COUNT(DefaultScales));
+		}
+
+		TArray<FString> parts;
+		scalesArg.ParseIntoArray(parts, TEXT(","));
+
+		TArray<int32> scales;
+		for (const FString& part : parts)
+		{
+			const int32 scale = FCString::Atoi(*part);
+			if (scale > 0)
+			{
+				scales.Add(scale);
+			}
+		}
+		return scales;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSThroughputBenchmark, "ULS.Benchmark.Throughput",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FULSThroughputBenchmark::RunTest(const FString& Parameters)
+{
+	const TCHAR* streams[] = { TEXT("Replication"), TEXT("Rpc"), TEXT("Spawn"), TEXT("Despawn"), TEXT("BulkDespawn") };
+
+	TArray<TSharedPtr<FJsonValue>> results;
+	for (const TCHAR* stream : streams)
+	{
+		for (const int32 scale : GetScales())
+		{
+			const FBenchmarkResult result = RunStream(stream, scale);
+			AddInfo(FString::Printf(TEXT("%s x%d: %d packets in %.3f s, %.0f packets/s, %.2f allocations/packet"),
+				*result.Stream, result.NumObjects, result.NumPackets, result.Seconds,
+				result.Seconds > 0 ? result.NumPackets / result.Seconds : 0.0,
+				result.NumPackets > 0 ? (double)result.Allocations / result.NumPackets : 0.0));
+			results.Add(MakeShared<FJsonValueObject>(ToJson(result)));
+		}
+	}
+
+	TSharedRef<FJsonObject> report = MakeShared<FJsonObject>();
+	report->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	report->SetStringField(TEXT("engineVersion"), FEngineVersion::Current().ToString());
+	report->SetStringField(TEXT("buildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	report->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+	report->SetStringField(TEXT("cpu"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+	report->SetBoolField(TEXT("hotpathLogging"), ULS_HOTPATH_LOGGING != 0);
+	report->SetArrayField(TEXT("results"), results);
+
+	FString outputPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ULSBenchmarkOutput="), outputPath) == false)
+	{
+		outputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("ULSBenchmarks"), FDateTime::Now().ToString() + TEXT(".json"));
+	}
+
+	FString jsonText;
+	const TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&jsonText);
+	FJsonSerializer::Serialize(report, writer);
+
+	if (FFileHelper::SaveStringToFile(jsonText, *outputPath) == false)
+	{
+		AddError(FString::Printf(TEXT("Failed to write %s"), *outputPath));
+		return false;
+	}
+
+	AddInfo(FString::Printf(TEXT("Results written to %s"), *outputPath));
+	return true;
+}
+
+#endif
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSBlobTransfer.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSStats.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+void UULSBlobTransfer::BeginDestroy()
+{
+	Super::BeginDestroy();
+
+	File.Reset();
+}
+
+bool UULSBlobTransfer::WriteToFile(const FString& path)
+{
+	if (bUpload || HasDestination())
+	{
+		return false;
+	}
+
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*path));
+	if (File.IsValid() == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSBlobTransfer: Failed to open %s for writing"), *path);
+		return false;
+	}
+	return true;
+}
+
+bool UULSBlobTransfer::WriteToBuffer()
+{
+	if (bUpload || HasDestination() || TotalSize > MAX_int32)
+	{
+		return false;
+	}
+
+	Buffer.SetNumUninitialized((int32)TotalSize);
+	return true;
+}
+
+bool UULSBlobTransfer::WriteToMemory(TArrayView<uint8> destination)
+{
+	if (bUpload || HasDestination() || destination.Num() < TotalSize)
+	{
+		return false;
+	}
+
+	Memory = destination;
+	return true;
+}
+
+bool UULSBlobTransfer::HasDestination() const
+{
+	return File.IsValid() || Buffer.Num() > 0 || Memory.Num() > 0;
+}
+
+void UULSBlobTransfer::Cancel()
+{
+	if (State != EULSBlobState::Transferring)
+	{
+		return;
+	}
+
+	if (IsValid(Owner))
+	{
+		Owner->CancelBlobTransfer(this);
+	}
+	Finish(EULSBlobState::Cancelled);
+}
+
+bool UULSBlobTransfer::ReadFromFile(const FString& path)
+{
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*path));
+	if (File.IsValid() == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSBlobTransfer: Failed to open %s for reading"), *path);
+		return false;
+	}
+
+	TotalSize = File->Size();
+	return true;
+}
+
+void UULSBlobTransfer::ReadFromBuffer(const TArray<uint8>& data)
+{
+	Buffer = data;
+	TotalSize = Buffer.Num();
+}
+
+bool UULSBlobTransfer::WriteChunk(int64 offset, const uint8* data, int32 size)
+{
+	if (File.IsValid())
+	{
+		if (File->Tell() != offset && File->Seek(offset) == false)
+		{
+			return false;
+		}
+		return File->Write(data, size);
+	}
+
+	uint8* destination = (Buffer.Num() > 0 ? Buffer.GetData() : Memory.GetData());
+	if (destination == nullptr)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(destination + offset, data, size);
+	return true;
+}
+
+bool UULSBlobTransfer::ReadChunk(int64 offset, uint8* destination, int32 size)
+{
+	if (File.IsValid())
+	{
+		if (File->Tell() != offset && File->Seek(offset) == false)
+		{
+			return false;
+		}
+		return File->Read(destination, size);
+	}
+
+	FMemory::Memcpy(destination, Buffer.GetData() + offset, size);
+	return true;
+}
+
+void UULSBlobTransfer::Finish(EULSBlobState state)
+{
+	if (State != EULSBlobState::Transferring)
+	{
+		return;
+	}
+
+	State = state;
+	File.Reset();
+	Memory = TArrayView<uint8>();
+	if (state != EULSBlobState::Completed)
+	{
+		Buffer.Empty();
+	}
+
+	OnCompleted.Broadcast(state);
+}
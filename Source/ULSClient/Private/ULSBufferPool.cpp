@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSBufferPool.h"
+
+FULSBufferPool::FULSBufferPool(int32 bufferSize, int32 maxPooled)
+	: BufferSize(bufferSize)
+	, MaxPooled(maxPooled)
+{
+}
+
+TArray<uint8> FULSBufferPool::Acquire()
+{
+	{
+		FScopeLock lock(&Lock);
+		if (Free.Num() > 0)
+		{
+			return Free.Pop(false);
+		}
+	}
+
+	TArray<uint8> buffer;
+	buffer.Reserve(BufferSize);
+	return buffer;
+}
+
+void FULSBufferPool::Release(TArray<uint8>&& buffer)
+{
+	if (buffer.Max() < BufferSize || buffer.Max() > BufferSize * 4)
+	{
+		return;
+	}
+	buffer.Reset();
+
+	FScopeLock lock(&Lock);
+	if (Free.Num() < MaxPooled)
+	{
+		Free.Add(MoveTemp(buffer));
+	}
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Thread-safe pool of byte buffers with a common minimum capacity.
+ *
+ * Acquired buffers are empty but have at least BufferSize bytes reserved. Released buffers that
+ * grew far beyond BufferSize are freed instead of pooled so one large packet doesn't pin memory.
+ */
+class FULSBufferPool
+{
+public:
+	FULSBufferPool(int32 bufferSize, int32 maxPooled);
+
+	TArray<uint8> Acquire();
+
+	void Release(TArray<uint8>&& buffer);
+
+	int32 GetBufferSize() const { return BufferSize; }
+
+private:
+	FCriticalSection Lock;
+	TArray<TArray<uint8>> Free;
+	int32 BufferSize;
+	int32 MaxPooled;
+};
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSCapture.h"
+#include "ULSStats.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	constexpr int32 WriteBufferSize = 64 * 1024;
+	constexpr double WriteInterval = 1.0;
+}
+
+const uint8 ULSCapture::Magic[MagicSize] = { 'U', 'L', 'S', 'C', 'A', 'P', '0', '1' };
+
+FString ULSCapture::ResolvePath(const FString& path)
+{
+	if (FPaths::IsRelative(path))
+	{
+		return FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir(), path);
+	}
+	return path;
+}
+
+// Writer
+
+TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe> FULSCaptureWriter::Create(const FString& path)
+{
+	const FString fullPath = ULSCapture::ResolvePath(path);
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	platformFile.CreateDirectoryTree(*FPaths::GetPath(fullPath));
+
+	IFileHandle* file = platformFile.OpenWrite(*fullPath);
+	if (file == nullptr)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSCaptureWriter: Failed to open %s"), *fullPath);
+		return nullptr;
+	}
+
+	return TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe>(new FULSCaptureWriter(fullPath, file));
+}
+
+FULSCaptureWriter::FULSCaptureWriter(const FString& path, IFileHandle* file)
+	: Path(path)
+	, File(file)
+{
+	StartTime = FPlatformTime::Seconds();
+	LastWriteTime = StartTime;
+
+	const int64 startTicks = FDateTime::UtcNow().GetTicks();
+	Buffer.Reserve(WriteBufferSize);
+	Buffer.Append(ULSCapture::Magic, ULSCapture::MagicSize);
+	Buffer.Append((const uint8*)&startTicks, sizeof(int64));
+	WriteBufferLocked();
+}
+
+FULSCaptureWriter::~FULSCaptureWriter()
+{
+	FScopeLock lock(&Lock);
+	FlushLocked();
+}
+
+void FULSCaptureWriter::Write(EULSCaptureDirection direction, int32 channel, TConstArrayView<uint8> bytes)
+{
+	LLM_SCOPE_BYTAG(ULS);
+
+	const double now = FPlatformTime::Seconds();
+	const int64 micros = (int64)((now - StartTime) * 1000000.0);
+	const uint32 size = (uint32)bytes.Num();
+	const uint8 directionByte = (uint8)direction;
+	const uint8 channelByte = (uint8)FMath::Clamp(channel, 0, 255);
+	const uint16 reserved = 0;
+
+	FScopeLock lock(&Lock);
+	Buffer.Append((const uint8*)&micros, sizeof(int64));
+	Buffer.Append((const uint8*)&size, sizeof(uint32));
+	Buffer.Add(directionByte);
+	Buffer.Add(channelByte);
+	Buffer.Append((const uint8*)&reserved, sizeof(uint16));
+	Buffer.Append(bytes.GetData(), bytes.Num());
+
+	if (Buffer.Num() >= WriteBufferSize || now - LastWriteTime >= WriteInterval)
+	{
+		WriteBufferLocked();
+	}
+}
+
+void FULSCaptureWriter::Flush()
+{
+	FScopeLock lock(&Lock);
+	FlushLocked();
+}
+
+void FULSCaptureWriter::WriteBufferLocked()
+{
+	if (Buffer.Num() > 0 && File.IsValid() && File->Write(Buffer.GetData(), Buffer.Num()) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSCaptureWriter: Failed to write to %s. Capture stopped."), *Path);
+		File.Reset();
+	}
+	Buffer.Reset();
+	LastWriteTime = FPlatformTime::Seconds();
+}
+
+void FULSCaptureWriter::FlushLocked()
+{
+	WriteBufferLocked();
+	if (File.IsValid())
+	{
+		File->Flush();
+	}
+}
+
+// Reader
+
+FULSCaptureReader::FULSCaptureReader()
+{
+}
+
+FULSCaptureReader::~FULSCaptureReader()
+{
+	Close();
+}
+
+bool FULSCaptureReader::Open(const FString& path)
+{
+	Close();
+
+	const FString fullPath = ULSCapture::ResolvePath(path);
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*fullPath));
+	if (MappedFile.IsValid() == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSCaptureReader: Failed to map %s"), *fullPath);
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize(), true));
+	if (MappedRegion.IsValid() == false || MappedRegion->GetMappedSize() < ULSCapture::FileHeaderSize ||
+		FMemory::Memcmp(MappedRegion->GetMappedPtr(), ULSCapture::Magic, ULSCapture::MagicSize) != 0)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSCaptureReader: %s is not a ULS capture"), *fullPath);
+		Close();
+		return false;
+	}
+
+	Data = MappedRegion->GetMappedPtr();
+	Size = MappedRegion->GetMappedSize();
+	FMemory::Memcpy(&StartTicks, Data + ULSCapture::MagicSize, sizeof(int64));
+	Position = ULSCapture::FileHeaderSize;
+	return true;
+}
+
+void FULSCaptureReader::Close()
+{
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	Data = nullptr;
+	Size = 0;
+	Position = 0;
+	StartTicks = 0;
+}
+
+bool FULSCaptureReader::ReadRecordHeader(int64 position, int64& outMicros, uint32& outSize) const
+{
+	if (Data == nullptr || position + ULSCapture::RecordHeaderSize > Size)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&outMicros, Data + position, sizeof(int64));
+	FMemory::Memcpy(&outSize, Data + position + sizeof(int64), sizeof(uint32));
+
+	// A record cut short ends the capture
+	return position + ULSCapture::RecordHeaderSize + (int64)outSize <= Size;
+}
+
+bool FULSCaptureReader::Next(FULSCaptureFrame& outFrame)
+{
+	int64 micros;
+	uint32 size;
+	if (ReadRecordHeader(Position, micros, size) == false)
+	{
+		return false;
+	}
+
+	const uint8* record = Data + Position;
+	outFrame.Time = micros / 1000000.0;
+	outFrame.Direction = (EULSCaptureDirection)record[sizeof(int64) + sizeof(uint32)];
+	outFrame.Channel = record[sizeof(int64) + sizeof(uint32) + 1];
+	outFrame.Bytes = TConstArrayView<uint8>(record + ULSCapture::RecordHeaderSize, (int32)size);
+
+	Position += ULSCapture::RecordHeaderSize + size;
+	return true;
+}
+
+bool FULSCaptureReader::PeekTime(double& outTime) const
+{
+	int64 micros;
+	uint32 size;
+	if (ReadRecordHeader(Position, micros, size) == false)
+	{
+		return false;
+	}
+
+	outTime = micros / 1000000.0;
+	return true;
+}
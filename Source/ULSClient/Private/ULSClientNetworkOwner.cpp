@@ -4,80 +4,536 @@
 #include "ULSClientNetworkOwner.h"
 #include "ULSWirePacket.h"
 #include "GameFramework/PlayerState.h"
+#include "GameFramework/PlayerController.h"
 #include "ULSTransport.h"
+#include "ULSWireEncoding.h"
+#include "ULSBaselineStore.h"
+#include "ULSBlobTransfer.h"
+#include "ULSNetClock.h"
+#include "ULSStats.h"
+#include "ULSProfiler.h"
+#include "ULSLatencyStats.h"
 #include "Misc/OutputDeviceNull.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectIterator.h"
 
-#define DEBUG_LOG 1
-#define SERIALIZE_LOG 1 && DEBUG_LOG
+namespace
+{
+	/* The spawn queue is sorted again once the local player moved this far */
+	constexpr double SpawnResortDistance = 500.0;
+
+	void StartCaptureCommand(const TArray<FString>& args)
+	{
+		if (args.Num() != 1)
+		{
+			UE_LOG(LogULS, Display, TEXT("Usage: uls.Capture.Start <file>"));
+			return;
+		}
+
+		// Every live network owner records to its own file
+		int32 numOwners = 0;
+		for (TObjectIterator<UULSClientNetworkOwner> it; it; ++it)
+		{
+			if (it->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+			{
+				continue;
+			}
+
+			const FString path = (numOwners == 0) ? args[0] :
+				FPaths::Combine(FPaths::GetPath(args[0]), FString::Printf(TEXT("%s_%d%s"), *FPaths::GetBaseFilename(args[0]), numOwners, *FPaths::GetExtension(args[0], true)));
+			if (it->StartCapture(path))
+			{
+				numOwners++;
+			}
+		}
+		UE_LOG(LogULS, Display, TEXT("uls.Capture.Start: Capturing %d network owner(s)"), numOwners);
+	}
+
+	void StopCaptureCommand()
+	{
+		for (TObjectIterator<UULSClientNetworkOwner> it; it; ++it)
+		{
+			it->StopCapture();
+		}
+	}
+
+	FAutoConsoleCommand CaptureStartCommand(TEXT("uls.Capture.Start"),
+		TEXT("Records the traffic of every network owner to the file, relative to the Saved directory. Further owners get a numbered file."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StartCaptureCommand));
+
+	FAutoConsoleCommand CaptureStopCommand(TEXT("uls.Capture.Stop"),
+		TEXT("Stops the recording started with uls.Capture.Start."),
+		FConsoleCommandDelegate::CreateStatic(&StopCaptureCommand));
+}
 
 void UULSClientNetworkOwner::HandleWirePacket(const UULSWirePacket* packet)
 {
     if (packet != nullptr)
     {
-        switch (packet->PacketType)
-        {
-			// Basic connection setup
-			case EWirePacketType::ConnectionResponse:
-				HandleConnectionResponseMessage(packet);
-				break;
+		LLM_SCOPE_BYTAG(ULS);
+		ULS_SCOPE_CYCLE_COUNTER(STAT_ULSApply);
 
-			case EWirePacketType::ConnectionEnd:
-				HandleConnectionEndMessage(packet);
-				break;
+		LastReceiveTime = FPlatformTime::Seconds();
 
-			// Runtime
-			case EWirePacketType::Replication:
-				HandleReplicationMessage(packet);
-				break;
+		const bool bSequenced = (packet->HeaderFlags & EWirePacketFlags::Sequenced) != 0;
+		if (bSequenced && packet->Sequence <= LastAppliedSequence)
+		{
+			// Re-sent after a resume, but already applied before the connection dropped
+			return;
+		}
+
+		// Objects of a snapshot that aren't spawned yet get their packets once they are
+		if (PendingSpawnIds.Num() == 0 || ParkPacketForPendingSpawn(packet) == false)
+		{
+			DispatchWirePacket(packet);
+		}
 
-			case EWirePacketType::SpawnActor:
-                HandleSpawnActorMessage(packet);
-                break;
+		if (bSequenced)
+		{
+			LastAppliedSequence = packet->Sequence;
+			bSessionAckPending = true;
+		}
+    }
+}
 
-            case EWirePacketType::DespawnActor:
-                HandleDespawnActorMessage(packet);
-                break;
+void UULSClientNetworkOwner::DispatchWirePacket(const UULSWirePacket* packet)
+{
+    switch (packet->PacketType)
+    {
+		// Basic connection setup
+		case EWirePacketType::ConnectionResponse:
+			HandleConnectionResponseMessage(packet);
+			break;
 
-			case EWirePacketType::CreateObject:
-				HandleCreateObjectMessage(packet);
-				break;
+		case EWirePacketType::ConnectionEnd:
+			bConnectionEnded = true;
+			HandleConnectionEndMessage(packet);
+			break;
 
-			case EWirePacketType::DestroyObject:
-				HandleDestroyObjectMessage(packet);
-				break;
+		case EWirePacketType::TransportOptions:
+			HandleTransportOptionsMessage(packet);
+			break;
 
-			case EWirePacketType::RpcCall:
-				HandleRpcPacket(packet);
-				break;
+		case EWirePacketType::Ping:
+			HandlePingMessage(packet);
+			break;
 
-			case EWirePacketType::RpcCallResponse:
-				HandleRpcResponsePacket(packet);
-				break;
+		case EWirePacketType::Pong:
+			HandlePongMessage(packet);
+			break;
 
-			case EWirePacketType::TearOff:
-				HandleTearOffPacket(packet);
-				break;
+		// Runtime
+		case EWirePacketType::Replication:
+			HandleReplicationMessage(packet);
+			break;
 
-			// Custom packets
-			case EWirePacketType::Custom:
-				OnReceivePacket(packet);
-				break;
+		case EWirePacketType::ReplicationDelta:
+			HandleReplicationDeltaMessage(packet);
+			break;
+
+		case EWirePacketType::SpawnActor:
+            HandleSpawnActorMessage(packet);
+            break;
+
+        case EWirePacketType::DespawnActor:
+            HandleDespawnActorMessage(packet);
+            break;
+
+		case EWirePacketType::CreateObject:
+			HandleCreateObjectMessage(packet);
+			break;
+
+		case EWirePacketType::SpawnSnapshot:
+			HandleSpawnSnapshotMessage(packet);
+			break;
+
+		case EWirePacketType::DestroyObject:
+			HandleDestroyObjectMessage(packet);
+			break;
+
+		case EWirePacketType::DespawnActors:
+		case EWirePacketType::DestroyObjects:
+		case EWirePacketType::TearOffs:
+			HandleLifecycleBatchMessage(packet);
+			break;
+
+		case EWirePacketType::RpcCall:
+			HandleRpcPacket(packet);
+			break;
+
+		case EWirePacketType::RpcCallResponse:
+			HandleRpcResponsePacket(packet);
+			break;
+
+		case EWirePacketType::TearOff:
+			HandleTearOffPacket(packet);
+			break;
+
+		case EWirePacketType::ChannelChunk:
+			HandleChannelChunkMessage(packet);
+			break;
+
+		case EWirePacketType::BlobBegin:
+			HandleBlobBeginMessage(packet);
+			break;
+
+		case EWirePacketType::BlobChunk:
+			HandleBlobChunkMessage(packet);
+			break;
+
+		case EWirePacketType::BlobAck:
+			HandleBlobAckMessage(packet);
+			break;
+
+		case EWirePacketType::BlobCancel:
+			HandleBlobCancelMessage(packet);
+			break;
+
+		// Custom packets
+		case EWirePacketType::Custom:
+			// Blueprints may hold on to the packet, don't let it point into transport memory
+			packet->DetachFromView();
+			OnReceivePacket(packet);
+			break;
 
-            default:
-                // Unhandled / undefined packet type
-				// TODO: Add log output / error handling
-                break;
-        }
+        default:
+            // Unhandled / undefined packet type
+			// TODO: Add log output / error handling
+            break;
     }
 }
 
 void UULSClientNetworkOwner::OnConnected(bool success, const FString& errorMessage)
 {
+	if (TickerHandle.IsValid() == false)
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UULSClientNetworkOwner::Tick));
+	}
+
+	if (success == false)
+	{
+		if (bReconnecting)
+		{
+			ScheduleReconnect();
+		}
+		else
+		{
+			OnConnectionEvent.Broadcast(false);
+		}
+		return;
+	}
+
+	if (Capture.IsValid())
+	{
+		// The transport may have been replaced since StartCapture
+		Transport->SetCapture(Capture);
+	}
+
+	ResetNegotiatedFeatures();
+	bConnectionAccepted = false;
+	bConnectionEnded = false;
+	bSessionAckPending = false;
+
+	if (NetClock.IsValid() == false)
+	{
+		NetClock = MakeShared<FULSNetClock>();
+	}
+	NetClock->Reset();
+	LastPingTime = 0;
+	LastReceiveTime = FPlatformTime::Seconds();
+
+	SendTransportOptions();
+
+	if (bReconnecting && SessionToken != 0)
+	{
+		SendSessionResume();
+	}
+	else
+	{
+		if (bReconnecting)
+		{
+			// The server starts a new session and sends everything again
+			DiscardNetworkObjects();
+		}
+		SendConnectionRequest();
+	}
+}
+
+void UULSClientNetworkOwner::SendConnectionRequest()
+{
+	SessionToken = 0;
+	LastAppliedSequence = 0;
+
 	UULSWirePacket* connectionRequestPacket = NewObject<UULSWirePacket>();
 	BuildConnectionRequestPacket(connectionRequestPacket);
+	connectionRequestPacket->FinalizeHeader();
 	Transport->SendWirePacket(connectionRequestPacket);
 }
 
+void UULSClientNetworkOwner::SendSessionResume()
+{
+	// Token, last applied sequence, followed by the regular connection request data
+	UULSWirePacket* requestPacket = NewObject<UULSWirePacket>();
+	BuildConnectionRequestPacket(requestPacket);
+	const TConstArrayView<uint8> requestData = requestPacket->GetPayload();
+
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::SessionResume;
+	packet->SetPayloadSize(sizeof(int64) + sizeof(int64) + requestData.Num());
+
+	int position = 0;
+	packet->PutInt64(SessionToken, position, position);
+	packet->PutInt64(LastAppliedSequence, position, position);
+	if (requestData.Num() > 0)
+	{
+		FMemory::Memcpy(packet->GetMutablePayload().GetData() + position, requestData.GetData(), requestData.Num());
+	}
+	packet->FinalizeHeader();
+	Transport->SendWirePacket(packet);
+
+	bResumePending = true;
+}
+
+void UULSClientNetworkOwner::SendSessionAck()
+{
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::SessionAck;
+	packet->SetPayloadSize(sizeof(int64));
+
+	int position = 0;
+	packet->PutInt64(LastAppliedSequence, position, position);
+	packet->FinalizeHeader();
+	Transport->SendWirePacket(packet);
+
+	bSessionAckPending = false;
+	LastSessionAckTime = FPlatformTime::Seconds();
+}
+
+void UULSClientNetworkOwner::SendTransportOptions()
+{
+	const ETransportFeatures features = GetRequestedFeatures();
+	if (features == ETransportFeatures::None)
+	{
+		// Servers without support for optional features never see the packet
+		return;
+	}
+
+	// Feature mask followed by one options block per requested feature, in bit order
+	int32 payloadSize = sizeof(int32);
+	for (int32 bit = 0; bit < 31; bit++)
+	{
+		const ETransportFeatures feature = (ETransportFeatures)(1 << bit);
+		if (EnumHasAnyFlags(features, feature))
+		{
+			payloadSize += GetFeatureOptionsSize(feature);
+		}
+	}
+
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::TransportOptions;
+	packet->SetPayloadSize(payloadSize);
+
+	int position = 0;
+	packet->PutInt32((int32)features, position, position);
+	for (int32 bit = 0; bit < 31; bit++)
+	{
+		const ETransportFeatures feature = (ETransportFeatures)(1 << bit);
+		if (EnumHasAnyFlags(features, feature))
+		{
+			WriteFeatureOptions(feature, packet, position);
+		}
+	}
+
+	packet->FinalizeHeader();
+	Transport->SendWirePacket(packet);
+}
+
+void UULSClientNetworkOwner::HandleTransportOptionsMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const ETransportFeatures accepted = (ETransportFeatures)packet->ReadInt32(position, position);
+	if (EnumHasAnyFlags(accepted, ~GetRequestedFeatures()))
+	{
+		// Options blocks of features we don't know can't be skipped
+		UE_LOG(LogULS, Error, TEXT("HandleTransportOptionsMessage: Server accepted features that were not requested (%08x)"), (int32)accepted);
+		return;
+	}
+
+	for (int32 bit = 0; bit < 31; bit++)
+	{
+		const ETransportFeatures feature = (ETransportFeatures)(1 << bit);
+		if (EnumHasAnyFlags(accepted, feature))
+		{
+			ReadFeatureOptions(feature, packet, position);
+		}
+	}
+
+	NegotiatedFeatures = accepted;
+	Transport->SetNegotiatedFeatures(accepted);
+
+	if (EnumHasAnyFlags(NegotiatedFeatures, ETransportFeatures::DeltaBaselines))
+	{
+		Baselines = MakeShared<FULSBaselineStore>(NegotiatedBaselineHistorySize);
+	}
+}
+
+void UULSClientNetworkOwner::ResetNegotiatedFeatures()
+{
+	NegotiatedFeatures = ETransportFeatures::None;
+	NegotiatedQuantization = QuantizationSettings;
+	NegotiatedBaselineHistorySize = 0;
+	NegotiatedHeartbeatInterval = HeartbeatInterval;
+	Baselines.Reset();
+	PendingBaselineAcks.Reset();
+	PendingBaselineResyncs.Reset();
+	OutgoingChannelPackets.Reset();
+	IncomingChannelPackets.Reset();
+	IncomingChannelBytes = 0;
+	NextChannelMessageIds.Reset();
+	NegotiatedChannelChunkSize = 0;
+}
+
+ETransportFeatures UULSClientNetworkOwner::GetRequestedFeatures() const
+{
+	ETransportFeatures features = IsValid(Transport) ? Transport->GetRequestedFeatures() : ETransportFeatures::None;
+	if (bEnableCompactEncoding)
+	{
+		features |= ETransportFeatures::CompactEncoding;
+	}
+	if (bEnableDeltaBaselines)
+	{
+		features |= ETransportFeatures::DeltaBaselines;
+	}
+	if (bEnableChannelChunks)
+	{
+		features |= ETransportFeatures::ChannelChunks;
+	}
+	if (bAutoReconnect)
+	{
+		features |= ETransportFeatures::SessionResume;
+	}
+	if (bEnableHeartbeat)
+	{
+		features |= ETransportFeatures::Heartbeat;
+	}
+	return features;
+}
+
+int32 UULSClientNetworkOwner::GetFeatureOptionsSize(ETransportFeatures feature) const
+{
+	switch (feature)
+	{
+	case ETransportFeatures::CompactEncoding:
+		// Float precision, vector cell size, vector component bits
+		return sizeof(float) + sizeof(double) + sizeof(int32);
+
+	case ETransportFeatures::DeltaBaselines:
+		// Number of baselines kept per object
+		return sizeof(int32);
+
+	case ETransportFeatures::ChannelChunks:
+		// Largest chunk
+		return sizeof(int32);
+
+	case ETransportFeatures::SessionResume:
+		// Seconds a dropped session is kept
+		return sizeof(int32);
+
+	case ETransportFeatures::Heartbeat:
+		// Ping interval in milliseconds
+		return sizeof(int32);
+
+	default:
+		return Transport->GetFeatureOptionsSize(feature);
+	}
+}
+
+void UULSClientNetworkOwner::WriteFeatureOptions(ETransportFeatures feature, UULSWirePacket* packet, int& position) const
+{
+	switch (feature)
+	{
+	case ETransportFeatures::CompactEncoding:
+		packet->PutFloat32(QuantizationSettings.FloatPrecision, position, position);
+		packet->PutFloat64(QuantizationSettings.VectorCellSize, position, position);
+		packet->PutInt32(QuantizationSettings.VectorComponentBits, position, position);
+		break;
+
+	case ETransportFeatures::DeltaBaselines:
+		packet->PutInt32(FMath::Clamp(BaselineHistorySize, 2, FULSBaselineStore::MaxHistorySize), position, position);
+		break;
+
+	case ETransportFeatures::ChannelChunks:
+		packet->PutInt32(FMath::Max(ChannelChunkSize, 256), position, position);
+		break;
+
+	case ETransportFeatures::SessionResume:
+		packet->PutInt32(FMath::CeilToInt(ReconnectTimeout), position, position);
+		break;
+
+	case ETransportFeatures::Heartbeat:
+		packet->PutInt32(FMath::RoundToInt(HeartbeatInterval * 1000.0f), position, position);
+		break;
+
+	default:
+		Transport->WriteFeatureOptions(feature, packet, position);
+		break;
+	}
+}
+
+void UULSClientNetworkOwner::ReadFeatureOptions(ETransportFeatures feature, const UULSWirePacket* packet, int& position)
+{
+	switch (feature)
+	{
+	case ETransportFeatures::CompactEncoding:
+	{
+		// The server has the final say on the quantization it uses
+		FULSQuantizationSettings settings;
+		settings.FloatPrecision = packet->ReadFloat32(position, position);
+		settings.VectorCellSize = packet->ReadFloat64(position, position);
+		settings.VectorComponentBits = FMath::Clamp(packet->ReadInt32(position, position), 1, 32);
+
+		// A FloatPrecision of 0 leaves floats unquantized
+		if (FMath::IsFinite(settings.FloatPrecision) == false || settings.FloatPrecision < 0 ||
+			FMath::IsFinite(settings.VectorCellSize) == false || settings.VectorCellSize <= 0)
+		{
+			UE_LOG(LogULS, Error, TEXT("ReadFeatureOptions: Rejected quantization from the server (precision %f, cell size %f), keeping the requested one"),
+				settings.FloatPrecision, settings.VectorCellSize);
+			NegotiatedQuantization = QuantizationSettings;
+		}
+		else
+		{
+			NegotiatedQuantization = settings;
+		}
+		break;
+	}
+
+	case ETransportFeatures::DeltaBaselines:
+		// The server must not reference baselines older than the ones we keep
+		NegotiatedBaselineHistorySize = FMath::Clamp(packet->ReadInt32(position, position), 2, FMath::Clamp(BaselineHistorySize, 2, FULSBaselineStore::MaxHistorySize));
+		break;
+
+	case ETransportFeatures::ChannelChunks:
+		// Neither side sends chunks larger than the other one asked for
+		NegotiatedChannelChunkSize = FMath::Clamp(packet->ReadInt32(position, position), 256, FMath::Max(ChannelChunkSize, 256));
+		break;
+
+	case ETransportFeatures::SessionResume:
+		// Reconnecting after the server dropped the session only gets a new one
+		ServerSessionTimeout = (float)packet->ReadInt32(position, position);
+		break;
+
+	case ETransportFeatures::Heartbeat:
+		// The server times the connection out based on the interval it answers with
+		NegotiatedHeartbeatInterval = FMath::Max(packet->ReadInt32(position, position), 50) / 1000.0f;
+		break;
+
+	default:
+		Transport->ReadFeatureOptions(feature, packet, position);
+		break;
+	}
+}
+
 void UULSClientNetworkOwner::BuildConnectionRequestPacket(UULSWirePacket* packet)
 {
 	UWorld* world = GetWorld();
@@ -93,7 +549,7 @@ void UULSClientNetworkOwner::BuildConnectionRequestPacket(UULSWirePacket* packet
 			auto netId = playerState->GetUniqueId().GetUniqueNetId();
 			int position = 0;
 			FString data = netId->ToString();
-			packet->Payload.SetNumUninitialized(4 + data.Len());
+			packet->SetPayloadSize(4 + data.Len());
 			packet->PutString(data, position, position);
 		}
 	}
@@ -108,57 +564,261 @@ bool UULSClientNetworkOwner::ProcessConnectionResponsePacket(const UULSWirePacke
 
 void UULSClientNetworkOwner::OnDisconnected(int32 StatusCode, const FString& Reason, bool bWasClean)
 {
+	DisconnectChannelTransports();
+	OutgoingChannelPackets.Reset();
+	IncomingChannelPackets.Reset();
+	IncomingChannelBytes = 0;
+
+	const bool bWasAccepted = bConnectionAccepted;
+	bConnectionAccepted = false;
+	bResumePending = false;
+
+	if (bAutoReconnect && bConnectionEnded == false && (bWasAccepted || bReconnecting) && IsValid(Transport))
+	{
+		if (bReconnecting == false)
+		{
+			UE_LOG(LogULS, Display, TEXT("Connection interrupted (%d, %s), reconnecting"), StatusCode, *Reason);
+			bReconnecting = true;
+			ReconnectStartTime = FPlatformTime::Seconds();
+			ReconnectDelay = ReconnectInitialDelay;
+			InterruptedStatusCode = StatusCode;
+			OnConnectionInterruptedEvent.Broadcast();
+		}
+		ScheduleReconnect();
+		return;
+	}
+
+	bReconnecting = false;
+	SessionToken = 0;
+	LastAppliedSequence = 0;
+
 	OnDisconnectionEvent.Broadcast(StatusCode, bWasClean);
 }
 
-void UULSClientNetworkOwner::HandleConnectionResponseMessage(const UULSWirePacket* packet)
+void UULSClientNetworkOwner::UpdateHeartbeat()
 {
-	bool success = ProcessConnectionResponsePacket(packet);
-	if (success)
+	const double now = FPlatformTime::Seconds();
+	if (LastTickTime > 0 && now - LastTickTime > HeartbeatTimeout / 2)
 	{
-#if DEBUG_LOG
-		UE_LOG(LogTemp, Display, TEXT("Login successful"));
-#endif
+		// A hitch on our side, whatever arrived in the meantime wasn't processed yet
+		LastReceiveTime = now;
 	}
-	else
+
+	if (now - LastReceiveTime > HeartbeatTimeout)
 	{
-#if DEBUG_LOG
-		UE_LOG(LogTemp, Display, TEXT("Login failed"));
-#endif
+		UE_LOG(LogULS, Warning, TEXT("UpdateHeartbeat: Nothing received for %.1f seconds, closing the connection"), now - LastReceiveTime);
+		Transport->Disconnect();
+		OnDisconnected(0, TEXT("Heartbeat timed out"), false);
+		return;
 	}
 
-	OnConnectionEvent.Broadcast(success);
+	if (now - LastPingTime >= NegotiatedHeartbeatInterval)
+	{
+		SendPing();
+	}
 }
 
-void UULSClientNetworkOwner::HandleConnectionEndMessage(const UULSWirePacket* packet)
+void UULSClientNetworkOwner::SendPing()
 {
-	//
+	// Pings bypass the channel routing, queueing behind bulk data would distort the RTT
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::Ping;
+	packet->SetPayloadSize(sizeof(double));
+
+	LastPingTime = FPlatformTime::Seconds();
+
+	int position = 0;
+	packet->PutFloat64(LastPingTime, position, position);
+	packet->FinalizeHeader();
+	Transport->SendWirePacket(packet);
 }
 
-void UULSClientNetworkOwner::NetworkObjectWasTornOff(UObject* existingObject)
+void UULSClientNetworkOwner::HandlePingMessage(const UULSWirePacket* packet)
 {
-	//
+	int position = 0;
+	const double senderTime = packet->ReadFloat64(position, position);
+
+	UULSWirePacket* pong = NewObject<UULSWirePacket>();
+	pong->PacketType = EWirePacketType::Pong;
+	pong->SetPayloadSize(sizeof(double) + sizeof(double));
+
+	position = 0;
+	pong->PutFloat64(senderTime, position, position);
+	pong->PutFloat64(FPlatformTime::Seconds(), position, position);
+	pong->FinalizeHeader();
+	Transport->SendWirePacket(pong);
 }
 
-void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
+void UULSClientNetworkOwner::HandlePongMessage(const UULSWirePacket* packet)
 {
 	int position = 0;
-	const int32 flags = packet->ReadInt32(position, position);
-	const int64 uniqueId = packet->ReadInt64(position, position);
-	const auto existingObject = FindObjectRef(uniqueId);
-	if (IsValid(existingObject) == false)
+	const double sendTime = packet->ReadFloat64(position, position);
+	const double serverTime = packet->ReadFloat64(position, position);
+
+	if (NetClock.IsValid())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("HandleRpcPacket failed: Object with id %ld not found"), uniqueId);
-		return;
+		NetClock->AddSample(sendTime, serverTime, FPlatformTime::Seconds());
 	}
-	const FString methodName = packet->ReadString(position, position);
-	const FString returnType = packet->ReadString(position, position);
-	const int32 numberOfParameters = packet->ReadInt32(position, position);
+}
+
+float UULSClientNetworkOwner::GetRoundTripTime() const
+{
+	return NetClock.IsValid() ? (float)NetClock->GetSmoothedRtt() : 0.0f;
+}
+
+float UULSClientNetworkOwner::GetRoundTripJitter() const
+{
+	return NetClock.IsValid() ? (float)NetClock->GetRttVariation() : 0.0f;
+}
+
+float UULSClientNetworkOwner::GetRoundTripPercentile(float fraction) const
+{
+	return NetClock.IsValid() ? (float)NetClock->GetRttPercentile(fraction) : 0.0f;
+}
+
+double UULSClientNetworkOwner::GetServerTime() const
+{
+	return FPlatformTime::Seconds() + GetServerClockOffset();
+}
+
+double UULSClientNetworkOwner::GetServerClockOffset() const
+{
+	return (NetClock.IsValid() && NetClock->HasSamples()) ? NetClock->GetClockOffset(FPlatformTime::Seconds()) : 0.0;
+}
+
+void UULSClientNetworkOwner::ScheduleReconnect()
+{
+	NextReconnectTime = FPlatformTime::Seconds() + ReconnectDelay;
+	ReconnectDelay = FMath::Min(ReconnectDelay * 2.0f, ReconnectMaxDelay);
+}
+
+void UULSClientNetworkOwner::UpdateReconnect()
+{
+	const double now = FPlatformTime::Seconds();
+	if (NextReconnectTime == 0 || now < NextReconnectTime)
+	{
+		return;
+	}
+	NextReconnectTime = 0;
+
+	const float timeout = (ServerSessionTimeout > 0 && SessionToken != 0) ? FMath::Min(ReconnectTimeout, ServerSessionTimeout) : ReconnectTimeout;
+	if (now - ReconnectStartTime > timeout || IsValid(Transport) == false)
+	{
+		UE_LOG(LogULS, Display, TEXT("Reconnecting timed out"));
+		bReconnecting = false;
+		SessionToken = 0;
+		LastAppliedSequence = 0;
+		OnDisconnectionEvent.Broadcast(InterruptedStatusCode, false);
+		return;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("Reconnecting"));
+	if (Transport->Connect() == false)
+	{
+		ScheduleReconnect();
+	}
+}
+
+void UULSClientNetworkOwner::DiscardNetworkObjects()
+{
+	for (const TPair<int64, UObject*>& entry : objectMap)
+	{
+		if (AActor* actor = Cast<AActor>(entry.Value))
+		{
+			if (IsValid(actor))
+			{
+				actor->Destroy();
+			}
+		}
+		else if (IsValid(entry.Value))
+		{
+			entry.Value->MarkAsGarbage();
+		}
+	}
+	objectMap.Reset();
+	uniqueIdLookup.Reset();
+
+	ResetPendingSpawns();
+	FlushPendingDespawns();
+}
+
+void UULSClientNetworkOwner::HandleConnectionResponseMessage(const UULSWirePacket* packet)
+{
+	bool success = ProcessConnectionResponsePacket(packet);
+	const bool bResumed = bResumePending && success;
+	if (bResumePending && success == false)
+	{
+		// The server no longer knows the session. Start a new one on the same connection.
+		UE_LOG(LogULS, Display, TEXT("Session resume rejected, requesting a new session"));
+		bResumePending = false;
+		DiscardNetworkObjects();
+		SendConnectionRequest();
+		return;
+	}
+	bResumePending = false;
+
+	if (success)
+	{
+		UE_LOG(LogULS, Log, TEXT("Login successful"));
+
+		// The server appends the session token to its response data
+		if (EnumHasAnyFlags(NegotiatedFeatures, ETransportFeatures::SessionResume) && packet->GetPayloadSize() >= (int32)sizeof(int64))
+		{
+			int position = 0;
+			SessionToken = packet->ReadInt64(packet->GetPayloadSize() - (int32)sizeof(int64), position);
+		}
+
+		bConnectionAccepted = true;
+		ConnectChannelTransports();
+		ResumeBlobTransfers();
+	}
+	else
+	{
+		UE_LOG(LogULS, Log, TEXT("Login failed"));
+	}
+
+	if (bReconnecting)
+	{
+		bReconnecting = false;
+		if (success)
+		{
+			OnReconnectionEvent.Broadcast(bResumed);
+			return;
+		}
+	}
+
+	OnConnectionEvent.Broadcast(success);
+}
+
+void UULSClientNetworkOwner::HandleConnectionEndMessage(const UULSWirePacket* packet)
+{
+	//
+}
+
+void UULSClientNetworkOwner::NetworkObjectWasTornOff(UObject* existingObject)
+{
+	//
+}
+
+void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const int32 flags = DeserializeInt32(packet, position, position);
+	const int64 uniqueId = DeserializeInt64(packet, position, position);
+	const auto existingObject = FindObjectRef(uniqueId);
+	if (IsValid(existingObject) == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("HandleRpcPacket failed: Object with id %ld not found"), uniqueId);
+		return;
+	}
+	const FString methodName = DeserializeString(packet, position, position);
+	const FString returnType = DeserializeString(packet, position, position);
+	const int32 numberOfParameters = DeserializeInt32(packet, position, position);
+
+	FULSProfiler::FRpcScope profileScope(existingObject->GetClass(), methodName, packet->GetPayloadSize());
 
-#if SERIALIZE_LOG
-	UE_LOG(LogTemp, Display, TEXT("*** HandleRpcPacket *** -- methodName: %s"), *methodName);
-	UE_LOG(LogTemp, Display, TEXT("*** HandleRpcPacket *** -- existingObject: %s"), *existingObject->GetName());
-#endif
+	ULS_HOTPATH_LOG(Verbose, TEXT("*** HandleRpcPacket *** -- methodName: %s"), *methodName);
+	ULS_HOTPATH_LOG(Verbose, TEXT("*** HandleRpcPacket *** -- existingObject: %s"), *existingObject->GetName());
 	if ((flags & (1 << 0)) > 0)
 	{
 		// FullReflection
@@ -167,12 +827,10 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 		if (IsValid(function) == false)
 		{
 			// TODO: Log properly
-			UE_LOG(LogTemp, Error, TEXT("Failed to find function %s on object of type %s with uniqueId: %ld"), *methodName, *cls->GetName(), FindUniqueId(existingObject));
+			UE_LOG(LogULS, Error, TEXT("Failed to find function %s on object of type %s with uniqueId: %ld"), *methodName, *cls->GetName(), FindUniqueId(existingObject));
 			return;
 		}
-#if SERIALIZE_LOG
-		UE_LOG(LogTemp, Display, TEXT("numberOfParameters: %i"), numberOfParameters);
-#endif
+		ULS_HOTPATH_LOG(Verbose, TEXT("numberOfParameters: %i"), numberOfParameters);
 
 		uint8* Parms = (uint8*)FMemory_Alloca_Aligned(function->ParmsSize, function->GetMinAlignment());
 		FMemory::Memzero(Parms, function->ParmsSize);
@@ -180,19 +838,17 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 		for (size_t i = 0; i < numberOfParameters; i++)
 		{
 			int8 type = packet->ReadInt8(position, position);
-			FString fieldName = packet->ReadString(position, position);
+			FString fieldName = DeserializeString(packet, position, position);
 
 			FProperty* prop = function->FindPropertyByName(FName(*fieldName));
 			if (prop == nullptr)
 			{
 				// TODO: Log properly
-				UE_LOG(LogTemp, Error, TEXT("Failed to find property %s on function %s::%s"), *fieldName, *cls->GetName(), *methodName);
+				UE_LOG(LogULS, Error, TEXT("Failed to find property %s on function %s::%s"), *fieldName, *cls->GetName(), *methodName);
 				return;
 			}
 
-#if SERIALIZE_LOG
-			UE_LOG(LogTemp, Display, TEXT("param #%i: type %i -- name: %s"), i, type, *fieldName);
-#endif
+			ULS_HOTPATH_LOG(Verbose, TEXT("param #%i: type %i -- name: %s"), i, type, *fieldName);
 
 			switch (type)
 			{
@@ -224,7 +880,7 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 					}
 					else
 					{
-						UE_LOG(LogTemp, Warning, TEXT("HandleRpcPacket: valuePtr failed"));
+						UE_LOG(LogULS, Warning, TEXT("HandleRpcPacket: valuePtr failed"));
 					}
 				}
 			}
@@ -234,7 +890,7 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 			{
 				// Value
 				int32 propSize = prop->GetSize();
-				int32 size = packet->ReadInt32(position, position);
+				int32 size = DeserializeInt32(packet, position, position);
 
 				int64 newVal = 0;
 				if (size == 1)
@@ -258,9 +914,7 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				{
 					if (int32* iVal = intProp->ContainerPtrToValuePtr<int32>(Parms))
 					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleRpcPacket: %s.%s = %i"), *methodName, *prop->GetName(), newVal);
-#endif
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleRpcPacket: %s.%s = %i"), *methodName, *prop->GetName(), newVal);
 						*iVal = (int32)newVal;
 					}
 				}
@@ -268,9 +922,7 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				{
 					if (int16* iVal = int16Prop->ContainerPtrToValuePtr<int16>(Parms))
 					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleRpcPacket: %s.%s = %ld"), *methodName, *prop->GetName(), newVal);
-#endif
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleRpcPacket: %s.%s = %ld"), *methodName, *prop->GetName(), newVal);
 						*iVal = (int16)newVal;
 					}
 				}
@@ -278,9 +930,7 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				{
 					if (int64* iVal = int64Prop->ContainerPtrToValuePtr<int64>(Parms))
 					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleRpcPacket: %s.%s = %ld"), *methodName, *prop->GetName(), newVal);
-#endif
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleRpcPacket: %s.%s = %ld"), *methodName, *prop->GetName(), newVal);
 						*iVal = (int64)newVal;
 					}
 				}
@@ -288,15 +938,13 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				{
 					if (bool* bVal = boolProp->ContainerPtrToValuePtr<bool>(Parms))
 					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleRpcPacket: %s.%s = %s"), *methodName, *prop->GetName(), newVal ? TEXT("TRUE") : TEXT("FALSE"));
-#endif
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleRpcPacket: %s.%s = %s"), *methodName, *prop->GetName(), newVal ? TEXT("TRUE") : TEXT("FALSE"));
 						*bVal = (bool)newVal;
 					}
 				}
 				else
 				{
-					UE_LOG(LogTemp, Warning, TEXT("HandleRpcPacket: Unhandled property of type %s"), *prop->GetFullName());
+					UE_LOG(LogULS, Warning, TEXT("HandleRpcPacket: Unhandled property of type %s"), *prop->GetFullName());
 				}
 			}
 			break;
@@ -305,7 +953,7 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 			{
 				// Value
 				int32 propSize = prop->GetSize();
-				int32 size = packet->ReadInt32(position, position);
+				int32 size = DeserializeInt32(packet, position, position);
 
 				// Support upcasting
 				double newVal = 0;
@@ -322,9 +970,7 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				{
 					if (float_t* fVal = floatProp->ContainerPtrToValuePtr<float_t>(Parms))
 					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleRpcPacket: %s.%s = %f"), *methodName, *prop->GetName(), newVal);
-#endif
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleRpcPacket: %s.%s = %f"), *methodName, *prop->GetName(), newVal);
 						*fVal = (float)newVal;
 					}
 				}
@@ -332,15 +978,13 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				{
 					if (double* dVal = doubleProp->ContainerPtrToValuePtr<double>(Parms))
 					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleRpcPacket: %s.%s = %f"), *methodName, *prop->GetName(), newVal);
-#endif
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleRpcPacket: %s.%s = %f"), *methodName, *prop->GetName(), newVal);
 						*dVal = newVal;
 					}
 				}
 				else
 				{
-					UE_LOG(LogTemp, Warning, TEXT("HandleRpcPacket: Unhandled property of type %s"), *prop->GetFullName());
+					UE_LOG(LogULS, Warning, TEXT("HandleRpcPacket: Unhandled property of type %s"), *prop->GetFullName());
 				}
 			}
 			break;
@@ -352,14 +996,12 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				FStrProperty* strProp = (FStrProperty*)prop;
 				if (FString* valuePtr = strProp->ContainerPtrToValuePtr<FString>(Parms))
 				{
-#if SERIALIZE_LOG
-					UE_LOG(LogTemp, Display, TEXT("HandleRpcPacket: %s.%s = %s"), *methodName, *prop->GetName(), *fieldValue);
-#endif
+					ULS_HOTPATH_LOG(Verbose, TEXT("HandleRpcPacket: %s.%s = %s"), *methodName, *prop->GetName(), *fieldValue);
 					*valuePtr = fieldValue;
 				}
 				else
 				{
-					UE_LOG(LogTemp, Error, TEXT("HandleRpcPacket: valuePtr failed"));
+					UE_LOG(LogULS, Error, TEXT("HandleRpcPacket: valuePtr failed"));
 				}
 			}
 			break;
@@ -379,17 +1021,17 @@ void UULSClientNetworkOwner::HandleRpcPacket(const UULSWirePacket* packet)
 				}
 				else
 				{
-					UE_LOG(LogTemp, Error, TEXT("HandleRpcPacket: valuePtr failed"));
+					UE_LOG(LogULS, Error, TEXT("HandleRpcPacket: valuePtr failed"));
 				}
 			}
 			break;
 			}
 		}
 
-		//UE_LOG(LogTemp, Display, TEXT("Command: %s"), *command);
+		//UE_LOG(LogULS, Display, TEXT("Command: %s"), *command);
 		//bool res = existingObject->CallFunctionByNameWithArguments(*command, outputDevice, nullptr, true);
 		existingObject->ProcessEvent(function, Parms);
-		//UE_LOG(LogTemp, Display, TEXT("Command: %s -> %s"), *command, (res ? TEXT("TRUE") : TEXT("FALSE")));
+		//UE_LOG(LogULS, Display, TEXT("Command: %s -> %s"), *command, (res ? TEXT("TRUE") : TEXT("FALSE")));
 	}
 	else
 	{
@@ -406,14 +1048,14 @@ void UULSClientNetworkOwner::ProcessHandleRpcPacket(const UULSWirePacket* packet
 
 void UULSClientNetworkOwner::HandleRpcResponsePacket(const UULSWirePacket* packet)
 {
-    //UE_LOG(LogTemp, Display, TEXT("UWebSocketConnection::HandleRpHandleRpcResponsePacket"));
+    //UE_LOG(LogULS, Display, TEXT("UWebSocketConnection::HandleRpHandleRpcResponsePacket"));
 }
 
 void UULSClientNetworkOwner::HandleTearOffPacket(const UULSWirePacket* packet)
 {
 	int position = 0;
-	int32 flags = packet->ReadInt32(position, position);
-	int64 uniqueId = packet->ReadInt64(position, position);
+	int32 flags = DeserializeInt32(packet, position, position);
+	int64 uniqueId = DeserializeInt64(packet, position, position);
 
 	auto obj = FindObjectRef(uniqueId);
 	if (IsValid(obj))
@@ -423,15 +1065,18 @@ void UULSClientNetworkOwner::HandleTearOffPacket(const UULSWirePacket* packet)
 		NetworkObjectWasTornOff(obj);
 	}
 	objectMap.Remove(uniqueId);
+
+	if (Baselines.IsValid())
+	{
+		Baselines->RemoveObject(uniqueId);
+	}
 }
 
-void UULSClientNetworkOwner::HandleSpawnActorMessage(const UULSWirePacket* packet)
+void UULSClientNetworkOwner::HandleSpawnActorMessage(const UULSWirePacket* packet, int position)
 {
-	int position = 0;
-
-	int32 flags = packet->ReadInt32(position, position);
-	FString className = packet->ReadString(position, position);
-	int64 uniqueId = packet->ReadInt64(position, position);
+	int32 flags = DeserializeInt32(packet, position, position);
+	FString className = DeserializeString(packet, position, position);
+	int64 uniqueId = DeserializeInt64(packet, position, position);
 
 	// If there is no dot, add ".<object_name>_C"
 	int32 PackageDelimPos = INDEX_NONE;
@@ -450,9 +1095,9 @@ void UULSClientNetworkOwner::HandleSpawnActorMessage(const UULSWirePacket* packe
 		}
 	}
 
-	//UE_LOG(LogTemp, Display, TEXT("HandleSpawnActorMessage: flags: %i"), flags);
-	//UE_LOG(LogTemp, Display, TEXT("HandleSpawnActorMessage: className: %s"), *className);
-	//UE_LOG(LogTemp, Display, TEXT("HandleSpawnActorMessage: uniqueId: %ld"), uniqueId);
+	//UE_LOG(LogULS, Display, TEXT("HandleSpawnActorMessage: flags: %i"), flags);
+	//UE_LOG(LogULS, Display, TEXT("HandleSpawnActorMessage: className: %s"), *className);
+	//UE_LOG(LogULS, Display, TEXT("HandleSpawnActorMessage: uniqueId: %ld"), uniqueId);
 
 	UClass* cls = FindObject<UClass>(nullptr, *className);
 	if (IsValid(cls) == false)
@@ -460,24 +1105,40 @@ void UULSClientNetworkOwner::HandleSpawnActorMessage(const UULSWirePacket* packe
 		cls = LoadObject<UClass>(nullptr, *className);
 	}
 
-	UE_LOG(LogTemp, Display, TEXT("HandleSpawnActorMessage: Spawn %s with network id: %ld"), *className, uniqueId);
+	ULS_HOTPATH_LOG(Verbose, TEXT("HandleSpawnActorMessage: Spawn %s with network id: %ld"), *className, uniqueId);
+
+	// Optional initial state, see EWireSpawnFlags
+	FTransform transform = FTransform::Identity;
+	if ((flags & EWireSpawnFlags::SpawnTransform) != 0)
+	{
+		const FVector location = DeserializeVector(packet, position, position);
+		const FVector rotation = DeserializeVector(packet, position, position);
+		const FVector scale = DeserializeVector(packet, position, position);
+		transform = FTransform(FRotator(rotation.X, rotation.Y, rotation.Z), location, scale);
+	}
+
+	int32 numProperties = 0;
+	if ((flags & EWireSpawnFlags::SpawnProperties) != 0)
+	{
+		numProperties = DeserializeInt32(packet, position, position);
+	}
 
 	if (IsValid(cls))
 	{
-		//UE_LOG(LogTemp, Display, TEXT("HandleSpawnActorMessage: Class found: %s"), *cls->GetDescription());
-		SpawnNetworkActor(uniqueId, cls);
+		//UE_LOG(LogULS, Display, TEXT("HandleSpawnActorMessage: Class found: %s"), *cls->GetDescription());
+		SpawnNetworkActor(uniqueId, cls, transform, packet, numProperties, position);
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("HandleSpawnActorMessage failed: Class '%s' not found"), *className);
+		UE_LOG(LogULS, Error, TEXT("HandleSpawnActorMessage failed: Class '%s' not found"), *className);
 	}
 }
 
 void UULSClientNetworkOwner::HandleDespawnActorMessage(const UULSWirePacket* packet)
 {
 	int position = 0;
-	int32 flags = packet->ReadInt32(position, position);
-	int64 uniqueId = packet->ReadInt64(position, position);
+	int32 flags = DeserializeInt32(packet, position, position);
+	int64 uniqueId = DeserializeInt64(packet, position, position);
 
 	auto actor = Cast<AActor>(FindObjectRef(uniqueId));
 	if (IsValid(actor))
@@ -487,15 +1148,18 @@ void UULSClientNetworkOwner::HandleDespawnActorMessage(const UULSWirePacket* pac
 		uniqueIdLookup.Remove(actor);
 	}
 	objectMap.Remove(uniqueId);
+
+	if (Baselines.IsValid())
+	{
+		Baselines->RemoveObject(uniqueId);
+	}
 }
 
-void UULSClientNetworkOwner::HandleCreateObjectMessage(const UULSWirePacket* packet)
+void UULSClientNetworkOwner::HandleCreateObjectMessage(const UULSWirePacket* packet, int position)
 {
-	int position = 0;
-
-	int32 flags = packet->ReadInt32(position, position);
-	FString className = packet->ReadString(position, position);
-	int64 uniqueId = packet->ReadInt64(position, position);
+	int32 flags = DeserializeInt32(packet, position, position);
+	FString className = DeserializeString(packet, position, position);
+	int64 uniqueId = DeserializeInt64(packet, position, position);
 
 	// If there is no dot, add ".<object_name>_C"
 	int32 PackageDelimPos = INDEX_NONE;
@@ -520,310 +1184,1657 @@ void UULSClientNetworkOwner::HandleCreateObjectMessage(const UULSWirePacket* pac
 		cls = LoadObject<UClass>(nullptr, *className);
 	}
 
-	UE_LOG(LogTemp, Display, TEXT("HandleCreateObjectMessage: Spawn %s with network id: %ld"), *className, uniqueId);
+	ULS_HOTPATH_LOG(Verbose, TEXT("HandleCreateObjectMessage: Spawn %s with network id: %ld"), *className, uniqueId);
+
+	if (IsValid(cls))
+	{
+		//UE_LOG(LogULS, Display, TEXT("HandleCreateObjectMessage: Class found: %s"), *cls->GetDescription());
+		CreateNetworkObject(uniqueId, cls);
+	}
+	else
+	{
+		UE_LOG(LogULS, Error, TEXT("HandleCreateObjectMessage failed: Class '%s' not found"), *className);
+	}
+}
+
+void UULSClientNetworkOwner::HandleSpawnSnapshotMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	int32 flags = DeserializeInt32(packet, position, position);
+	int32 count = DeserializeInt32(packet, position, position);
+
+	// Every entry starts with its packet type and size
+	const int32 minEntrySize = packet->IsCompactEncoding() ? 2 : 2 * (int32)sizeof(int32);
+	if (count < 0 || count > (packet->GetPayloadSize() - position) / minEntrySize)
+	{
+		UE_LOG(LogULS, Error, TEXT("HandleSpawnSnapshotMessage failed: %d entries don't fit into %d bytes"), count, packet->GetPayloadSize() - position);
+		return;
+	}
+
+	// The entries are spawned from the packet later on
+	packet->DetachFromView();
+	HeldSpawnPackets.Add(packet);
+
+	PendingSpawns.Reserve(PendingSpawns.Num() + count);
+	for (int32 i = 0; i < count; i++)
+	{
+		const int32 packetType = DeserializeInt32(packet, position, position);
+		const int32 size = DeserializeInt32(packet, position, position);
+		if (size < 0 || position + size > packet->GetPayloadSize())
+		{
+			UE_LOG(LogULS, Error, TEXT("HandleSpawnSnapshotMessage failed: Entry %d of %d is truncated"), i, count);
+			break;
+		}
+
+		FULSPendingSpawn spawn;
+		spawn.Packet = packet;
+		spawn.PacketType = packetType;
+		spawn.Position = position;
+		spawn.Order = NextSpawnOrder++;
+
+		// Only the id and location are needed for now
+		int entryPosition = position;
+		const int32 entryFlags = DeserializeInt32(packet, entryPosition, entryPosition);
+		DeserializeString(packet, entryPosition, entryPosition);
+		spawn.UniqueId = DeserializeInt64(packet, entryPosition, entryPosition);
+		if (packetType == EWirePacketType::SpawnActor && (entryFlags & EWireSpawnFlags::SpawnTransform) != 0)
+		{
+			spawn.bHasLocation = true;
+			spawn.Location = DeserializeVector(packet, entryPosition, entryPosition);
+		}
+		position += size;
+
+		if (packetType != EWirePacketType::SpawnActor && packetType != EWirePacketType::CreateObject)
+		{
+			UE_LOG(LogULS, Warning, TEXT("HandleSpawnSnapshotMessage: Skipping entry of packet type %d"), packetType);
+			continue;
+		}
+		if (PendingSpawnIds.Contains(spawn.UniqueId))
+		{
+			UE_LOG(LogULS, Warning, TEXT("HandleSpawnSnapshotMessage: Object with id %ld is already waiting to be spawned"), spawn.UniqueId);
+			continue;
+		}
+
+		PendingSpawnIds.Add(spawn.UniqueId);
+		PendingSpawns.Add(spawn);
+	}
+
+	UE_LOG(LogULS, Log, TEXT("HandleSpawnSnapshotMessage: %d objects waiting to be spawned"), PendingSpawnIds.Num());
+
+	SortPendingSpawns(GetSpawnPriorityOrigin());
+
+	if (SpawnBudgetMilliseconds <= 0)
+	{
+		ProcessPendingSpawns();
+	}
+}
+
+void UULSClientNetworkOwner::ProcessPendingSpawns()
+{
+	ULS_SCOPE_CYCLE_COUNTER(STAT_ULSApply);
+
+	// The player moves while the world streams in
+	const FVector origin = GetSpawnPriorityOrigin();
+	if (FVector::DistSquared(origin, SpawnPriorityOrigin) > FMath::Square(SpawnResortDistance))
+	{
+		SortPendingSpawns(origin);
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+	const double budget = SpawnBudgetMilliseconds / 1000.0;
+	while (PendingSpawns.Num() > 0)
+	{
+		const FULSPendingSpawn spawn = PendingSpawns.Pop(false);
+		if (PendingSpawnIds.Remove(spawn.UniqueId) == 0)
+		{
+			// Despawned before its turn
+			continue;
+		}
+
+		SpawnPending(spawn);
+
+		if (budget > 0 && FPlatformTime::Seconds() - startTime >= budget)
+		{
+			break;
+		}
+	}
+
+	if (PendingSpawns.Num() == 0)
+	{
+		UE_LOG(LogULS, Log, TEXT("ProcessPendingSpawns: World ready"));
+
+		ResetPendingSpawns();
+		OnWorldReady.Broadcast();
+	}
+}
+
+void UULSClientNetworkOwner::SortPendingSpawns(const FVector& origin)
+{
+	SpawnPriorityOrigin = origin;
+
+	// Plain objects first, they are cheap and often referenced by the actors
+	for (FULSPendingSpawn& spawn : PendingSpawns)
+	{
+		spawn.Priority = spawn.PacketType == EWirePacketType::CreateObject ? -1.0 :
+			spawn.bHasLocation ? FVector::DistSquared(origin, spawn.Location) : TNumericLimits<double>::Max();
+	}
+
+	// Popped from the back, ties in snapshot order
+	PendingSpawns.Sort([](const FULSPendingSpawn& a, const FULSPendingSpawn& b)
+	{
+		return a.Priority != b.Priority ? a.Priority > b.Priority : a.Order > b.Order;
+	});
+}
+
+FVector UULSClientNetworkOwner::GetSpawnPriorityOrigin() const
+{
+	UWorld* world = GetWorld();
+	APlayerController* playerController = world != nullptr ? world->GetFirstPlayerController() : nullptr;
+	if (playerController == nullptr)
+	{
+		return FVector::ZeroVector;
+	}
+
+	FVector location;
+	FRotator rotation;
+	playerController->GetPlayerViewPoint(location, rotation);
+	return location;
+}
+
+bool UULSClientNetworkOwner::ParkPacketForPendingSpawn(const UULSWirePacket* packet)
+{
+	switch (packet->PacketType)
+	{
+	case EWirePacketType::Replication:
+	case EWirePacketType::ReplicationDelta:
+	case EWirePacketType::RpcCall:
+	case EWirePacketType::TearOff:
+	case EWirePacketType::DespawnActor:
+	case EWirePacketType::DestroyObject:
+		break;
+
+	default:
+		return false;
+	}
+
+	// All of them start with the flags and the id of the object
+	int position = 0;
+	int32 flags = DeserializeInt32(packet, position, position);
+	int64 uniqueId = DeserializeInt64(packet, position, position);
+	if (PendingSpawnIds.Contains(uniqueId) == false)
+	{
+		return false;
+	}
+
+	if (packet->PacketType == EWirePacketType::DespawnActor || packet->PacketType == EWirePacketType::DestroyObject)
+	{
+		CancelPendingSpawn(uniqueId);
+		return true;
+	}
+
+	packet->DetachFromView();
+	HeldSpawnPackets.Add(packet);
+	ParkedPackets.FindOrAdd(uniqueId).Add(packet);
+	return true;
+}
+
+void UULSClientNetworkOwner::SpawnPending(const FULSPendingSpawn& spawn)
+{
+	if (spawn.PacketType == EWirePacketType::SpawnActor)
+	{
+		HandleSpawnActorMessage(spawn.Packet, spawn.Position);
+	}
+	else
+	{
+		HandleCreateObjectMessage(spawn.Packet, spawn.Position);
+	}
+	ResolveParked(spawn.UniqueId);
+}
+
+void UULSClientNetworkOwner::SpawnPendingNow(int64 uniqueId)
+{
+	const FULSPendingSpawn* entry = PendingSpawns.FindByPredicate([uniqueId](const FULSPendingSpawn& spawn) { return spawn.UniqueId == uniqueId; });
+	if (entry != nullptr && PendingSpawnIds.Remove(uniqueId) > 0)
+	{
+		// The queue entry is skipped when its turn comes
+		const FULSPendingSpawn spawn = *entry;
+		SpawnPending(spawn);
+	}
+}
+
+void UULSClientNetworkOwner::CancelPendingSpawn(int64 uniqueId)
+{
+	// Not worth spawning anymore. The queue entry is skipped when its turn comes.
+	PendingSpawnIds.Remove(uniqueId);
+	ParkedPackets.Remove(uniqueId);
+	ParkedReferences.Remove(uniqueId);
+}
+
+void UULSClientNetworkOwner::ResolveParked(int64 uniqueId)
+{
+	UObject* obj = FindObjectRef(uniqueId);
+
+	TArray<FULSParkedReference> references;
+	ParkedReferences.MultiFind(uniqueId, references, true);
+	ParkedReferences.Remove(uniqueId);
+	for (const FULSParkedReference& reference : references)
+	{
+		UObject* targetObject = reference.Target.Get();
+		if (IsValid(targetObject) == false || IsValid(obj) == false)
+		{
+			continue;
+		}
+
+		UObject** valuePtr = reference.Property->ContainerPtrToValuePtr<UObject*>(targetObject);
+		if (valuePtr != nullptr && *valuePtr != obj)
+		{
+			*valuePtr = obj;
+			if (reference.bCallOnRep)
+			{
+				FString repFunctionName = TEXT("OnRep_") + reference.Property->GetName();
+				CallRepNotify(targetObject, targetObject->GetClass()->FindFunctionByName(FName(repFunctionName)));
+			}
+		}
+	}
+
+	TArray<const UULSWirePacket*> packets;
+	if (ParkedPackets.RemoveAndCopyValue(uniqueId, packets))
+	{
+		for (const UULSWirePacket* packet : packets)
+		{
+			DispatchWirePacket(packet);
+		}
+	}
+}
+
+void UULSClientNetworkOwner::ResetPendingSpawns()
+{
+	PendingSpawns.Reset();
+	PendingSpawnIds.Reset();
+	ParkedPackets.Reset();
+	ParkedReferences.Reset();
+	HeldSpawnPackets.Reset();
+	NextSpawnOrder = 0;
+}
+
+void UULSClientNetworkOwner::HandleDestroyObjectMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	int32 flags = DeserializeInt32(packet, position, position);
+	int64 uniqueId = DeserializeInt64(packet, position, position);
+
+	auto obj = FindObjectRef(uniqueId);
+	if (IsValid(obj))
+	{
+		obj->MarkAsGarbage();
+
+		uniqueIdLookup.Remove(obj);
+	}
+	objectMap.Remove(uniqueId);
+
+	if (Baselines.IsValid())
+	{
+		Baselines->RemoveObject(uniqueId);
+	}
+}
+
+void UULSClientNetworkOwner::HandleLifecycleBatchMessage(const UULSWirePacket* packet)
+{
+	ULS_SCOPE_CYCLE_COUNTER(STAT_ULSApply);
+
+	int position = 0;
+	int32 flags = DeserializeInt32(packet, position, position);
+	int32 count = DeserializeInt32(packet, position, position);
+
+	const int32 minIdSize = packet->IsCompactEncoding() ? 1 : (int32)sizeof(int64);
+	if (count < 0 || count > (packet->GetPayloadSize() - position) / minIdSize)
+	{
+		UE_LOG(LogULS, Error, TEXT("HandleLifecycleBatchMessage failed: %d ids don't fit into %d bytes"), count, packet->GetPayloadSize() - position);
+		return;
+	}
+
+	const bool bDespawn = packet->PacketType == EWirePacketType::DespawnActors;
+	const bool bTearOff = packet->PacketType == EWirePacketType::TearOffs;
+	const bool bTimeSliced = bDespawn && DespawnBudgetMilliseconds > 0;
+	if (bTimeSliced)
+	{
+		PendingDespawns.Reserve(PendingDespawns.Num() + count);
+	}
+
+	// One lookup per id, the registry entry is taken out while it is found
+	for (int32 i = 0; i < count; i++)
+	{
+		const int64 uniqueId = DeserializeInt64(packet, position, position);
+
+		if (PendingSpawnIds.Num() > 0 && PendingSpawnIds.Contains(uniqueId))
+		{
+			if (bTearOff == false)
+			{
+				CancelPendingSpawn(uniqueId);
+				continue;
+			}
+			// The client takes over the object, so it has to exist
+			SpawnPendingNow(uniqueId);
+		}
+
+		if (Baselines.IsValid())
+		{
+			Baselines->RemoveObject(uniqueId);
+		}
+
+		UObject* obj = nullptr;
+		if (objectMap.RemoveAndCopyValue(uniqueId, obj) == false || IsValid(obj) == false)
+		{
+			continue;
+		}
+		uniqueIdLookup.Remove(obj);
+
+		if (bTearOff)
+		{
+			NetworkObjectWasTornOff(obj);
+		}
+		else if (bDespawn)
+		{
+			AActor* actor = Cast<AActor>(obj);
+			if (IsValid(actor) == false)
+			{
+				continue;
+			}
+			if (bTimeSliced)
+			{
+				// Gone for the game right away, destroyed by ProcessPendingDespawns
+				actor->SetActorHiddenInGame(true);
+				actor->SetActorEnableCollision(false);
+				actor->SetActorTickEnabled(false);
+				PendingDespawns.Add(actor);
+			}
+			else
+			{
+				actor->Destroy();
+			}
+		}
+		else
+		{
+			obj->MarkAsGarbage();
+		}
+	}
+
+	UE_LOG(LogULS, Verbose, TEXT("HandleLifecycleBatchMessage: %d ids of packet type %d, %d actors waiting to be destroyed"), count, packet->PacketType, PendingDespawns.Num());
+}
+
+void UULSClientNetworkOwner::ProcessPendingDespawns()
+{
+	ULS_SCOPE_CYCLE_COUNTER(STAT_ULSApply);
+
+	const double startTime = FPlatformTime::Seconds();
+	const double budget = DespawnBudgetMilliseconds / 1000.0;
+	while (PendingDespawns.Num() > 0)
+	{
+		AActor* actor = PendingDespawns.Pop(false).Get();
+		if (IsValid(actor))
+		{
+			actor->Destroy();
+		}
+
+		if (FPlatformTime::Seconds() - startTime >= budget)
+		{
+			break;
+		}
+	}
+}
+
+void UULSClientNetworkOwner::FlushPendingDespawns()
+{
+	for (const TWeakObjectPtr<AActor>& entry : PendingDespawns)
+	{
+		AActor* actor = entry.Get();
+		if (IsValid(actor))
+		{
+			actor->Destroy();
+		}
+	}
+	PendingDespawns.Reset();
+}
+
+void UULSClientNetworkOwner::HandleReplicationMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	int32 flags = DeserializeInt32(packet, position, position);
+	int64 uniqueId = DeserializeInt64(packet, position, position);
+	auto existingObject = FindObjectRef(uniqueId);
+	if (IsValid(existingObject) == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("HandleReplicationMessage failed: Object with id %ld not found"), uniqueId);
+		return;
+	}
+
+	int32 fieldCount = DeserializeInt32(packet, position, position);
+	if (fieldCount == 0)
+	{
+		// Should not happen (server should not send empty packets)
+		// Not an error regardless, just return
+		return;
+	}
+
+	ReadProperties(packet, existingObject->GetClass(), fieldCount, existingObject, position, true);
+}
+
+void UULSClientNetworkOwner::ReadProperties(const UULSWirePacket* packet, const UClass* theClass, int numProperties, UObject* targetObject, int position, bool callOnRep)
+{
+	const bool bProfile = FULSProfiler::IsEnabled();
+	for (int32 i = 0; i < numProperties; i++)
+	{
+		const int fieldPosition = position;
+		const uint64 applyStartCycles = bProfile ? FPlatformTime::Cycles64() : 0;
+
+		int8 type = packet->ReadInt8(position, position);
+		FString fieldName = DeserializeString(packet, position, position);
+
+		auto prop = theClass->FindPropertyByName(FName(*fieldName));
+
+		if (prop == nullptr)
+		{
+			UE_LOG(LogULS, Warning, TEXT("HandleReplicationMessage: prop %s not found on actor %ld of class %s"), *fieldName, FindUniqueId(targetObject), *theClass->GetName());
+			continue;
+		}
+
+		bool valueDidChange = false;
+
+		switch (type)
+		{
+		case EReplicatedFieldType::Reference:
+		{
+			if (PendingSpawnIds.Num() > 0)
+			{
+				int refPosition = position;
+				const int64 refId = DeserializeInt64(packet, position, refPosition);
+				if (PendingSpawnIds.Contains(refId))
+				{
+					// Set by ResolveParked once the object is spawned
+					position = refPosition;
+					ParkedReferences.Add(refId, FULSParkedReference{ targetObject, (FObjectProperty*)prop, callOnRep });
+					break;
+				}
+			}
+
+			// Ref
+			auto objRef = DeserializeRef(packet, position, position);
+			if (IsValid(objRef) == false)
+			{
+				// Set the reference to "null"
+				FObjectProperty* objProp = (FObjectProperty*)prop;
+				if (UObject** valuePtr = objProp->ContainerPtrToValuePtr<UObject*>(targetObject))
+				{
+					if (*valuePtr != nullptr)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = nullptr -- (%li)=(%li)"), *targetObject->GetName(), *prop->GetName(),
+							FindUniqueId(targetObject), -1);
+						valueDidChange = true;
+						*valuePtr = nullptr;
+					}
+				}
+			}
+			else
+			{
+				FObjectProperty* objProp = (FObjectProperty*)prop;
+				if (UObject** valuePtr = objProp->ContainerPtrToValuePtr<UObject*>(targetObject))
+				{
+					if (*valuePtr != objRef)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %s -- (%li)=(%li)"), 
+							*targetObject->GetName(), *prop->GetName(),
+							*objRef->GetName(), FindUniqueId(targetObject), FindUniqueId(objRef));
+						valueDidChange = true;
+						*valuePtr = objRef;
+					}
+				}
+				else
+				{
+					UE_LOG(LogULS, Warning, TEXT("HandleReplicationMessage: valuePtr failed"));
+				}
+			}
+		}
+		break;
+
+		case EReplicatedFieldType::PrimitiveInt:
+		{
+			// Value
+			int32 propSize = prop->GetSize();
+			int32 size = DeserializeInt32(packet, position, position);
+			
+			if (FIntProperty* intProp = CastField<FIntProperty>(prop))
+			{
+				if (int32* iVal = intProp->ContainerPtrToValuePtr<int32>(targetObject))
+				{
+					int32 newVal = DeserializeInt32(packet, position, position);
+					if (*iVal != newVal)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %i"), *targetObject->GetName(), *prop->GetName(), newVal);
+						valueDidChange = true;
+						*iVal = newVal;
+					}
+				}
+			}
+			else if (FInt16Property* int16Prop = CastField<FInt16Property>(prop))
+			{
+				if (int16* iVal = int16Prop->ContainerPtrToValuePtr<int16>(targetObject))
+				{
+					int16 newVal = DeserializeInt16(packet, position, position);
+					if (*iVal != newVal)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %ld"), *targetObject->GetName(), *prop->GetName(), newVal);
+						valueDidChange = true;
+						*iVal = newVal;
+					}
+				}
+			}
+			else if (FInt64Property* int64Prop = CastField<FInt64Property>(prop))
+			{
+				if (int64* iVal = int64Prop->ContainerPtrToValuePtr<int64>(targetObject))
+				{
+					int64 newVal = DeserializeInt64(packet, position, position);
+					if (*iVal != newVal)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %ld"), *targetObject->GetName(), *prop->GetName(), newVal);
+						valueDidChange = true;
+						*iVal = newVal;
+					}
+				}
+			}
+			else if (FBoolProperty* boolProp = CastField<FBoolProperty>(prop))
+			{
+				if (bool* bVal = boolProp->ContainerPtrToValuePtr<bool>(targetObject))
+				{
+					bool newVal = DeserializeBool(packet, position, position, size);
+					if (*bVal != newVal)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %s"), *targetObject->GetName(), *prop->GetName(), newVal ? TEXT("TRUE") : TEXT("FALSE"));
+						valueDidChange = true;
+						*bVal = newVal;
+					}
+				}
+			}
+			else
+			{
+				UE_LOG(LogULS, Warning, TEXT("HandleReplicationMessage: Unhandled property of type %s"), *prop->GetFullName());
+			}
+		}
+		break;
+
+		case EReplicatedFieldType::PrimitiveFloat:
+		{
+			// Value
+			int32 propSize = prop->GetSize();
+			int32 size = DeserializeInt32(packet, position, position);
+
+			if (FFloatProperty* floatProp = CastField<FFloatProperty>(prop))
+			{
+				if (float_t* fVal = floatProp->ContainerPtrToValuePtr<float_t>(targetObject))
+				{
+					float_t newVal = DeserializeFloat32(packet, position, position);
+					if (*fVal != newVal)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %f"), *targetObject->GetName(), *prop->GetName(), newVal);
+						valueDidChange = true;
+						*fVal = newVal;
+					}
+				}
+			}
+			else if (FDoubleProperty* doubleProp = CastField<FDoubleProperty>(prop))
+			{
+				if (double* dVal = doubleProp->ContainerPtrToValuePtr<double>(targetObject))
+				{
+					double newVal = DeserializeFloat64(packet, position, position);
+					if (*dVal != newVal)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %f"), *targetObject->GetName(), *prop->GetName(), newVal);
+						valueDidChange = true;
+						*dVal = newVal;
+					}
+				}
+			}
+			else
+			{
+				UE_LOG(LogULS, Warning, TEXT("HandleReplicationMessage: Unhandled property of type %s"), *prop->GetFullName());
+			}
+		}
+		break;
+
+		case EReplicatedFieldType::String:
+		{
+			// String
+			FString fieldValue = DeserializeString(packet, position, position);
+			FStrProperty* strProp = (FStrProperty*)prop;
+			if (FString* valuePtr = strProp->ContainerPtrToValuePtr<FString>(targetObject))
+			{
+				if (*valuePtr != fieldValue)
+				{
+					ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %s"), *targetObject->GetName(), *prop->GetName(), *fieldValue);
+					valueDidChange = true;
+					*valuePtr = fieldValue;
+				}
+			}
+			else
+			{
+				UE_LOG(LogULS, Error, TEXT("HandleReplicationMessage: valuePtr failed"));
+			}
+		}
+		break;
+
+		case EReplicatedFieldType::Vector3:
+		{
+			// String
+			FVector vec = DeserializeVector(packet, position, position);
+
+			FProperty* vecProp = (FProperty*)prop;
+			if (FVector* valuePtr = vecProp->ContainerPtrToValuePtr<FVector>(targetObject))
+			{
+				if (valuePtr != nullptr)
+				{
+					FVector val = *valuePtr;
+					if (FMath::IsNearlyEqual(val.X, vec.X) == false ||
+						FMath::IsNearlyEqual(val.Y, vec.Y) == false ||
+						FMath::IsNearlyEqual(val.Z, vec.Z) == false)
+					{
+						ULS_HOTPATH_LOG(Verbose, TEXT("HandleReplicationMessage: %s.%s = %s"), *targetObject->GetName(), *prop->GetName(), *vec.ToString());
+						valueDidChange = true;
+						*valuePtr = vec;
+					}
+				}
+			}
+			else
+			{
+				UE_LOG(LogULS, Error, TEXT("HandleReplicationMessage: valuePtr failed"));
+			}
+		}
+		break;
+		}
+
+		const uint64 applyEndCycles = bProfile ? FPlatformTime::Cycles64() : 0;
+
+		if (valueDidChange && callOnRep)
+		{
+			FString repFunctionName = TEXT("OnRep_") + fieldName;
+			CallRepNotify(targetObject, theClass->FindFunctionByName(FName(repFunctionName)));
+		}
+
+		if (bProfile)
+		{
+			FULSProfiler::RecordFieldBytes(theClass, prop->GetFName(), position - fieldPosition);
+			FULSProfiler::RecordFieldApply(theClass, prop->GetFName(), valueDidChange,
+				applyEndCycles - applyStartCycles, FPlatformTime::Cycles64() - applyEndCycles);
+		}
+	}
+}
+
+void UULSClientNetworkOwner::CallRepNotify(UObject* existingObject, UFunction* repFunction)
+{
+	if (IsValid(repFunction))
+	{
+		ULS_SCOPE_CYCLE_COUNTER(STAT_ULSOnRep);
+
+		ULS_HOTPATH_LOG(Verbose, TEXT("repFunctionName: %s"), *repFunction->GetName());
+		ULS_HOTPATH_LOG(Verbose, TEXT("  -> repFunction->ParmsSize: %i"), repFunction->ParmsSize);
+		uint8* Parms = (uint8*)FMemory_Alloca_Aligned(repFunction->ParmsSize, repFunction->GetMinAlignment());
+		FMemory::Memzero(Parms, repFunction->ParmsSize);
+
+		if (IsValid(existingObject) == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("existingObject is invalid. Can't process call to function %s"),
+				*repFunction->GetName());
+		}
+		else
+		{
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			existingObject->ProcessEvent(repFunction, Parms);
+			FULSLatencyStats::AddOnRepCycles(FPlatformTime::Cycles64() - startCycles);
+		}
+	}
+}
+
+void UULSClientNetworkOwner::HandleReplicationDeltaMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const int32 flags = DeserializeInt32(packet, position, position);
+	const int64 uniqueId = DeserializeInt64(packet, position, position);
+	const int64 baseSequence = DeserializeInt64(packet, position, position);
+	const int64 sequence = DeserializeInt64(packet, position, position);
+	const int32 fieldCount = DeserializeInt32(packet, position, position);
+
+	auto existingObject = FindObjectRef(uniqueId);
+	if (IsValid(existingObject) == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("HandleReplicationDeltaMessage failed: Object with id %ld not found"), uniqueId);
+		return;
+	}
+
+	if (Baselines.IsValid() == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("HandleReplicationDeltaMessage: Delta baselines were not negotiated"));
+		return;
+	}
+
+	if (sequence <= Baselines->GetLatestSequence(uniqueId))
+	{
+		// Overtaken by a newer update on an unordered channel
+		return;
+	}
+
+	// Decode everything first. Resolving fields can grow the layout, which moves the baseline rows.
+	struct FDecodedField
+	{
+		int32 FieldIndex;
+		uint64 Words[3];
+	};
+	TArray<FDecodedField, TInlineAllocator<16>> decodedFields;
+	TArray<TPair<FProperty*, FString>, TInlineAllocator<4>> stringFields;
+
+	UClass* cls = existingObject->GetClass();
+	const bool bProfile = FULSProfiler::IsEnabled();
+	for (int32 i = 0; i < fieldCount; i++)
+	{
+		const int fieldPosition = position;
+		const int8 type = packet->ReadInt8(position, position);
+		const FName fieldName = FName(*DeserializeString(packet, position, position));
+
+		if (type == EReplicatedFieldType::String)
+		{
+			// Strings are not baselined and always sent in full
+			FString value = DeserializeString(packet, position, position);
+			if (FProperty* prop = cls->FindPropertyByName(fieldName))
+			{
+				stringFields.Emplace(prop, MoveTemp(value));
+			}
+			if (bProfile)
+			{
+				FULSProfiler::RecordFieldBytes(cls, fieldName, position - fieldPosition);
+			}
+			continue;
+		}
+
+		FDecodedField decoded;
+		const int32 numWords = (type == EReplicatedFieldType::Vector3 ? 3 : 1);
+		for (int32 word = 0; word < numWords; word++)
+		{
+			decoded.Words[word] = (uint64)DeserializeInt64(packet, position, position);
+		}
+
+		decoded.FieldIndex = Baselines->FindOrAddField(cls, fieldName, type);
+		if (decoded.FieldIndex == INDEX_NONE)
+		{
+			UE_LOG(LogULS, Warning, TEXT("HandleReplicationDeltaMessage: prop %s not found on object %ld of class %s"), *fieldName.ToString(), uniqueId, *cls->GetName());
+			continue;
+		}
+		decodedFields.Add(decoded);
+
+		if (bProfile)
+		{
+			FULSProfiler::RecordFieldBytes(cls, fieldName, position - fieldPosition);
+		}
+	}
+
+	uint64* newRow = nullptr;
+	const uint64* latestRow = nullptr;
+	if (Baselines->BeginRow(uniqueId, cls, baseSequence, sequence, newRow, latestRow) == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("HandleReplicationDeltaMessage: Baseline %ld of object %ld is no longer available. Requesting full update."), baseSequence, uniqueId);
+		PendingBaselineResyncs.AddUnique(uniqueId);
+		return;
+	}
+
+	const FULSBaselineLayout& layout = Baselines->GetLayout(cls);
+	TBitArray<> fieldInPacket(false, layout.Fields.Num());
+	for (const FDecodedField& decoded : decodedFields)
+	{
+		const FULSBaselineField& field = layout.Fields[decoded.FieldIndex];
+		for (int32 word = 0; word < field.NumWords; word++)
+		{
+			newRow[field.Slot + word] ^= decoded.Words[word];
+		}
+		fieldInPacket[decoded.FieldIndex] = true;
+	}
+
+	// Only touch properties whose value differs from the state that was applied last
+	for (int32 fieldIndex = 0; fieldIndex < layout.Fields.Num(); fieldIndex++)
+	{
+		const FULSBaselineField& field = layout.Fields[fieldIndex];
+		if (fieldInPacket[fieldIndex] == false &&
+			(latestRow == nullptr || FMemory::Memcmp(newRow + field.Slot, latestRow + field.Slot, field.NumWords * sizeof(uint64)) == 0))
+		{
+			continue;
+		}
+
+		const uint64 applyStartCycles = bProfile ? FPlatformTime::Cycles64() : 0;
+		const bool bChanged = ApplyBaselineField(existingObject, field, newRow + field.Slot);
+		const uint64 applyEndCycles = bProfile ? FPlatformTime::Cycles64() : 0;
+		if (bChanged)
+		{
+			CallRepNotify(existingObject, field.RepNotify);
+		}
+
+		if (bProfile)
+		{
+			FULSProfiler::RecordFieldApply(cls, field.Name, bChanged,
+				applyEndCycles - applyStartCycles, FPlatformTime::Cycles64() - applyEndCycles);
+		}
+	}
+
+	for (const auto& stringField : stringFields)
+	{
+		const uint64 applyStartCycles = bProfile ? FPlatformTime::Cycles64() : 0;
+		FString* valuePtr = stringField.Key->ContainerPtrToValuePtr<FString>(existingObject);
+		const bool bChanged = (valuePtr != nullptr && *valuePtr != stringField.Value);
+		if (bChanged)
+		{
+			*valuePtr = stringField.Value;
+		}
+		const uint64 applyEndCycles = bProfile ? FPlatformTime::Cycles64() : 0;
+		if (bChanged)
+		{
+			CallRepNotify(existingObject, cls->FindFunctionByName(FName(TEXT("OnRep_") + stringField.Key->GetName())));
+		}
+
+		if (bProfile)
+		{
+			FULSProfiler::RecordFieldApply(cls, stringField.Key->GetFName(), bChanged,
+				applyEndCycles - applyStartCycles, FPlatformTime::Cycles64() - applyEndCycles);
+		}
+	}
+
+	// Deltas arrive unordered, so a sequence only tells something about its own object
+	int64& ackedSequence = PendingBaselineAcks.FindOrAdd(uniqueId);
+	ackedSequence = FMath::Max(ackedSequence, sequence);
+}
+
+bool UULSClientNetworkOwner::ApplyBaselineField(UObject* targetObject, const FULSBaselineField& field, const uint64* words)
+{
+	switch (field.Type)
+	{
+	case EReplicatedFieldType::Reference:
+	{
+		if (FObjectProperty* objProp = CastField<FObjectProperty>(field.Property))
+		{
+			UObject* newVal = FindObjectRef((int64)words[0]);
+			UObject** valuePtr = objProp->ContainerPtrToValuePtr<UObject*>(targetObject);
+			if (*valuePtr != newVal)
+			{
+				*valuePtr = newVal;
+				return true;
+			}
+		}
+	}
+	break;
+
+	case EReplicatedFieldType::PrimitiveInt:
+	{
+		const int64 newVal = (int64)words[0];
+		if (FIntProperty* intProp = CastField<FIntProperty>(field.Property))
+		{
+			int32* iVal = intProp->ContainerPtrToValuePtr<int32>(targetObject);
+			if (*iVal != (int32)newVal)
+			{
+				*iVal = (int32)newVal;
+				return true;
+			}
+		}
+		else if (FInt16Property* int16Prop = CastField<FInt16Property>(field.Property))
+		{
+			int16* iVal = int16Prop->ContainerPtrToValuePtr<int16>(targetObject);
+			if (*iVal != (int16)newVal)
+			{
+				*iVal = (int16)newVal;
+				return true;
+			}
+		}
+		else if (FInt64Property* int64Prop = CastField<FInt64Property>(field.Property))
+		{
+			int64* iVal = int64Prop->ContainerPtrToValuePtr<int64>(targetObject);
+			if (*iVal != newVal)
+			{
+				*iVal = newVal;
+				return true;
+			}
+		}
+		else if (FBoolProperty* boolProp = CastField<FBoolProperty>(field.Property))
+		{
+			if (boolProp->GetPropertyValue_InContainer(targetObject) != (newVal != 0))
+			{
+				boolProp->SetPropertyValue_InContainer(targetObject, newVal != 0);
+				return true;
+			}
+		}
+	}
+	break;
+
+	case EReplicatedFieldType::PrimitiveFloat:
+	{
+		double newVal;
+		FMemory::Memcpy(&newVal, &words[0], sizeof(double));
+		if (FFloatProperty* floatProp = CastField<FFloatProperty>(field.Property))
+		{
+			float* fVal = floatProp->ContainerPtrToValuePtr<float>(targetObject);
+			if (*fVal != (float)newVal)
+			{
+				*fVal = (float)newVal;
+				return true;
+			}
+		}
+		else if (FDoubleProperty* doubleProp = CastField<FDoubleProperty>(field.Property))
+		{
+			double* dVal = doubleProp->ContainerPtrToValuePtr<double>(targetObject);
+			if (*dVal != newVal)
+			{
+				*dVal = newVal;
+				return true;
+			}
+		}
+	}
+	break;
+
+	case EReplicatedFieldType::Vector3:
+	{
+		FVector newVal;
+		for (int32 i = 0; i < 3; i++)
+		{
+			double component;
+			FMemory::Memcpy(&component, &words[i], sizeof(double));
+			newVal[i] = component;
+		}
+
+		FVector* valuePtr = field.Property->ContainerPtrToValuePtr<FVector>(targetObject);
+		if (*valuePtr != newVal)
+		{
+			*valuePtr = newVal;
+			return true;
+		}
+	}
+	break;
+	}
+
+	return false;
+}
+
+void UULSClientNetworkOwner::SendBaselineAck()
+{
+	// The newest applied sequence of each object, then the objects that need a full update
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::BaselineAck;
+	packet->SetPayloadSize(sizeof(int32) + PendingBaselineAcks.Num() * 2 * sizeof(int64) + sizeof(int32) + PendingBaselineResyncs.Num() * sizeof(int64));
+
+	int position = 0;
+	packet->PutInt32(PendingBaselineAcks.Num(), position, position);
+	for (const TPair<int64, int64>& ack : PendingBaselineAcks)
+	{
+		packet->PutInt64(ack.Key, position, position);
+		packet->PutInt64(ack.Value, position, position);
+	}
+	packet->PutInt32(PendingBaselineResyncs.Num(), position, position);
+	for (int64 uniqueId : PendingBaselineResyncs)
+	{
+		packet->PutInt64(uniqueId, position, position);
+	}
+	packet->FinalizeHeader();
+	SendWirePacket(packet);
+
+	PendingBaselineAcks.Reset();
+	PendingBaselineResyncs.Reset();
+	LastBaselineAckTime = FPlatformTime::Seconds();
+}
+
+void UULSClientNetworkOwner::SendWirePacket(const UULSWirePacket* packet)
+{
+	if (IsValid(packet) == false || IsValid(Transport) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("SendWirePacket: Failed to send packet. Packet or Transport is NULL."));
+		return;
+	}
+
+	const int32* routedChannel = ChannelRouting.Find(packet->PacketType);
+	const int32 channel = (routedChannel != nullptr ? *routedChannel : 0);
+	if (channel == 0)
+	{
+		Transport->SendWirePacket(packet);
+		return;
+	}
+
+	// Packets of a channel stay in order, so nothing overtakes chunks that are still queued
+	const bool bChunksQueued = OutgoingChannelPackets.ContainsByPredicate([channel](const FULSOutgoingChannelPacket& outgoing)
+		{
+			return outgoing.Channel == channel;
+		});
+
+	UULSTransport* const* channelTransport = ChannelTransports.Find(channel);
+	if (bChunksQueued == false && channelTransport != nullptr && IsValid(*channelTransport) && (*channelTransport)->IsConnected())
+	{
+		(*channelTransport)->SendWirePacket(packet);
+		return;
+	}
+
+	if (NegotiatedChannelChunkSize > 0)
+	{
+		// Sliced up in Tick. Small packets are queued as well, they become a single chunk.
+		FULSOutgoingChannelPacket& outgoing = OutgoingChannelPackets.AddDefaulted_GetRef();
+		outgoing.Channel = channel;
+		outgoing.MessageId = NextChannelMessageIds.FindOrAdd(channel)++;
+		outgoing.Bytes = packet->SerializeToBytes();
+		return;
+	}
+
+	Transport->SendWirePacket(packet);
+}
+
+void UULSClientNetworkOwner::SendChannelChunks()
+{
+	// Latency-critical packets sent in between only wait for what this tick hands to the transport
+	int32 budget = ChannelBytesPerTick;
+	while (OutgoingChannelPackets.Num() > 0 && budget > 0)
+	{
+		FULSOutgoingChannelPacket& outgoing = OutgoingChannelPackets[0];
+		const int32 size = FMath::Min(NegotiatedChannelChunkSize, outgoing.Bytes.Num() - outgoing.Offset);
+
+		// Channel, message id, total size, offset, slice of the wire bytes
+		UULSWirePacket* packet = NewObject<UULSWirePacket>();
+		packet->PacketType = EWirePacketType::ChannelChunk;
+		packet->SetPayloadSize(4 * sizeof(int32) + size);
+
+		int position = 0;
+		packet->PutInt32(outgoing.Channel, position, position);
+		packet->PutInt32(outgoing.MessageId, position, position);
+		packet->PutInt32(outgoing.Bytes.Num(), position, position);
+		packet->PutInt32(outgoing.Offset, position, position);
+		FMemory::Memcpy(packet->GetMutablePayload().GetData() + position, outgoing.Bytes.GetData() + outgoing.Offset, size);
+		packet->FinalizeHeader();
+		Transport->SendWirePacket(packet);
+
+		outgoing.Offset += size;
+		budget -= size;
+		if (outgoing.Offset >= outgoing.Bytes.Num())
+		{
+			OutgoingChannelPackets.RemoveAt(0);
+		}
+	}
+}
+
+void UULSClientNetworkOwner::HandleChannelChunkMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const int32 channel = packet->ReadInt32(position, position);
+	const int32 messageId = packet->ReadInt32(position, position);
+	const int32 totalSize = packet->ReadInt32(position, position);
+	const int32 offset = packet->ReadInt32(position, position);
+	const int32 size = packet->GetPayloadSize() - position;
+
+	if (size < 0 || totalSize < UULSWirePacket::HeaderSize || totalSize > Transport->MaxDecompressedSize ||
+		offset < 0 || (int64)offset + size > totalSize)
+	{
+		UE_LOG(LogULS, Error, TEXT("HandleChannelChunkMessage: Invalid chunk (channel %d, message %d, size %d, offset %d)"), channel, messageId, totalSize, offset);
+		return;
+	}
+
+	const uint64 key = ((uint64)(uint32)channel << 32) | (uint32)messageId;
+	FULSIncomingChannelPacket* found = IncomingChannelPackets.Find(key);
+	if (found == nullptr)
+	{
+		if (IncomingChannelPackets.Num() >= MaxIncomingChannelPackets || IncomingChannelBytes + totalSize > MaxIncomingChannelBytes)
+		{
+			UE_LOG(LogULS, Error, TEXT("HandleChannelChunkMessage: Dropped message %d on channel %d, %d messages of %lld bytes in reassembly already"),
+				messageId, channel, IncomingChannelPackets.Num(), IncomingChannelBytes);
+			return;
+		}
+		found = &IncomingChannelPackets.Add(key);
+		found->Bytes.SetNumUninitialized(totalSize);
+		IncomingChannelBytes += totalSize;
+	}
+	else if (found->Bytes.Num() != totalSize)
+	{
+		UE_LOG(LogULS, Error, TEXT("HandleChannelChunkMessage: Size of message %d on channel %d changed"), messageId, channel);
+		IncomingChannelBytes -= found->Bytes.Num();
+		IncomingChannelPackets.Remove(key);
+		return;
+	}
+	FULSIncomingChannelPacket& incoming = *found;
+
+	if (size > 0)
+	{
+		FMemory::Memcpy(incoming.Bytes.GetData() + offset, packet->ReadDataPtr(size, position, position), size);
+	}
+
+	// Merge the chunk into the received ranges, counting only the bytes no earlier chunk covered
+	int32 rangeStart = offset;
+	int32 rangeEnd = offset + size;
+	int32 overlap = 0;
+	for (int32 i = incoming.ReceivedRanges.Num() - 1; i >= 0; i--)
+	{
+		const FIntPoint range = incoming.ReceivedRanges[i];
+		if (range.Y < offset || range.X > offset + size)
+		{
+			continue;
+		}
+		overlap += FMath::Max(0, FMath::Min(range.Y, offset + size) - FMath::Max(range.X, offset));
+		rangeStart = FMath::Min(rangeStart, range.X);
+		rangeEnd = FMath::Max(rangeEnd, range.Y);
+		incoming.ReceivedRanges.RemoveAtSwap(i);
+	}
+	incoming.ReceivedRanges.Add(FIntPoint(rangeStart, rangeEnd));
+	incoming.ReceivedSize += size - overlap;
+	if (incoming.ReceivedSize < totalSize)
+	{
+		return;
+	}
+
+	// The reassembled bytes are a complete wire packet and may be compressed. Its chunks are captured already.
+	TArray<uint8> bytes = MoveTemp(incoming.Bytes);
+	IncomingChannelPackets.Remove(key);
+	IncomingChannelBytes -= totalSize;
+	Transport->DecodeReceivedBytes(MoveTemp(bytes), false);
+}
+
+void UULSClientNetworkOwner::ConnectChannelTransports()
+{
+	for (const TPair<int32, UULSTransport*>& entry : ChannelTransports)
+	{
+		UULSTransport* channelTransport = entry.Value;
+		if (entry.Key == 0 || IsValid(channelTransport) == false || channelTransport == Transport)
+		{
+			continue;
+		}
+
+		channelTransport->ClientNetworkOwner = this;
+		channelTransport->ChannelIndex = entry.Key;
+		channelTransport->SetCapture(Capture);
+		if (channelTransport->Connect() == false)
+		{
+			UE_LOG(LogULS, Warning, TEXT("ConnectChannelTransports: Failed to connect channel %d. Its packets use the main transport."), entry.Key);
+		}
+	}
+}
+
+void UULSClientNetworkOwner::DisconnectChannelTransports()
+{
+	for (const TPair<int32, UULSTransport*>& entry : ChannelTransports)
+	{
+		if (entry.Key != 0 && IsValid(entry.Value) && entry.Value != Transport)
+		{
+			entry.Value->Disconnect();
+		}
+	}
+}
+
+bool UULSClientNetworkOwner::StartCapture(const FString& path)
+{
+	StopCapture();
+
+	Capture = FULSCaptureWriter::Create(path);
+	if (Capture.IsValid() == false)
+	{
+		return false;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("StartCapture: Recording to %s"), *Capture->GetPath());
+	if (IsValid(Transport))
+	{
+		Transport->SetCapture(Capture);
+	}
+	for (const TPair<int32, UULSTransport*>& entry : ChannelTransports)
+	{
+		if (IsValid(entry.Value))
+		{
+			entry.Value->SetCapture(Capture);
+		}
+	}
+	return true;
+}
+
+void UULSClientNetworkOwner::StopCapture()
+{
+	if (Capture.IsValid() == false)
+	{
+		return;
+	}
+
+	if (IsValid(Transport))
+	{
+		Transport->SetCapture(nullptr);
+	}
+	for (const TPair<int32, UULSTransport*>& entry : ChannelTransports)
+	{
+		if (IsValid(entry.Value))
+		{
+			entry.Value->SetCapture(nullptr);
+		}
+	}
+
+	// The file is closed once the I/O threads let go of the writer as well
+	Capture->Flush();
+	UE_LOG(LogULS, Display, TEXT("StopCapture: Recorded %s"), *Capture->GetPath());
+	Capture.Reset();
+}
+
+void UULSClientNetworkOwner::OnChannelConnected(UULSTransport* channelTransport, bool success, const FString& errorMessage)
+{
+	if (success == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("OnChannelConnected: Channel %d failed to connect: %s. Its packets use the main transport."), channelTransport->ChannelIndex, *errorMessage);
+		return;
+	}
+
+	// Channel followed by the connection request data, so the server can tell which client attaches
+	UULSWirePacket* requestPacket = NewObject<UULSWirePacket>();
+	BuildConnectionRequestPacket(requestPacket);
+	const TConstArrayView<uint8> requestData = requestPacket->GetPayload();
+
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::ChannelAttach;
+	packet->SetPayloadSize(sizeof(int32) + requestData.Num());
+
+	int position = 0;
+	packet->PutInt32(channelTransport->ChannelIndex, position, position);
+	if (requestData.Num() > 0)
+	{
+		FMemory::Memcpy(packet->GetMutablePayload().GetData() + position, requestData.GetData(), requestData.Num());
+	}
+	packet->FinalizeHeader();
+	channelTransport->SendWirePacket(packet);
+}
+
+void UULSClientNetworkOwner::OnChannelDisconnected(UULSTransport* channelTransport, int32 StatusCode, const FString& Reason)
+{
+	UE_LOG(LogULS, Warning, TEXT("OnChannelDisconnected: Channel %d closed (%d, %s). Its packets use the main transport."), channelTransport->ChannelIndex, StatusCode, *Reason);
+}
+
+UULSBlobTransfer* UULSClientNetworkOwner::SendBlob(const FString& name, const TArray<uint8>& data)
+{
+	UULSBlobTransfer* transfer = NewObject<UULSBlobTransfer>(this);
+	transfer->ReadFromBuffer(data);
+	transfer->Name = name;
+	return StartBlobUpload(transfer);
+}
+
+UULSBlobTransfer* UULSClientNetworkOwner::SendBlobFile(const FString& name, const FString& path)
+{
+	UULSBlobTransfer* transfer = NewObject<UULSBlobTransfer>(this);
+	if (transfer->ReadFromFile(path) == false)
+	{
+		return nullptr;
+	}
+	transfer->Name = name;
+	return StartBlobUpload(transfer);
+}
+
+UULSBlobTransfer* UULSClientNetworkOwner::StartBlobUpload(UULSBlobTransfer* transfer)
+{
+	transfer->Owner = this;
+	transfer->BlobId = NextBlobId--;
+	transfer->bUpload = true;
+	BlobTransfers.Add(transfer->BlobId, transfer);
+
+	if (bConnectionAccepted && IsValid(Transport) && Transport->IsConnected())
+	{
+		SendBlobBegin(transfer);
+	}
+	else
+	{
+		// Announced by ResumeBlobTransfers once connected
+		transfer->bAwaitingAck = true;
+	}
+	return transfer;
+}
+
+void UULSClientNetworkOwner::CancelBlobTransfer(UULSBlobTransfer* transfer)
+{
+	if (BlobTransfers.Remove(transfer->BlobId) > 0 && bConnectionAccepted && IsValid(Transport) && Transport->IsConnected())
+	{
+		SendBlobCancel(transfer->BlobId);
+	}
+}
+
+void UULSClientNetworkOwner::OnBlobTransferStarted_Implementation(UULSBlobTransfer* transfer)
+{
+	//
+}
+
+void UULSClientNetworkOwner::ResumeBlobTransfers()
+{
+	for (const TPair<int64, UULSBlobTransfer*>& entry : BlobTransfers)
+	{
+		UULSBlobTransfer* transfer = entry.Value;
+		if (transfer->bUpload)
+		{
+			// The server answers with a BlobAck that tells where to continue
+			transfer->bAwaitingAck = true;
+			SendBlobBegin(transfer);
+		}
+		else
+		{
+			SendBlobAck(transfer);
+		}
+	}
+}
+
+void UULSClientNetworkOwner::SendBlobChunks()
+{
+	int32 budget = BlobBytesPerTick;
+	for (auto it = BlobTransfers.CreateIterator(); it && budget > 0; ++it)
+	{
+		UULSBlobTransfer* transfer = it.Value();
+		if (IsValid(transfer) == false || transfer->State != EULSBlobState::Transferring)
+		{
+			it.RemoveCurrent();
+			continue;
+		}
+
+		if (transfer->bUpload == false || transfer->bAwaitingAck)
+		{
+			continue;
+		}
+
+		while (budget > 0 && transfer->SendOffset < transfer->TotalSize)
+		{
+			const int32 size = (int32)FMath::Min<int64>(FMath::Max(BlobChunkSize, 256), transfer->TotalSize - transfer->SendOffset);
+
+			UULSWirePacket* packet = NewObject<UULSWirePacket>();
+			packet->PacketType = EWirePacketType::BlobChunk;
+			packet->SetPayloadSize(sizeof(int64) + sizeof(int64) + size);
+
+			int position = 0;
+			packet->PutInt64(transfer->BlobId, position, position);
+			packet->PutInt64(transfer->SendOffset, position, position);
+			if (transfer->ReadChunk(transfer->SendOffset, packet->GetMutablePayload().GetData() + position, size) == false)
+			{
+				UE_LOG(LogULS, Error, TEXT("SendBlobChunks: Failed to read blob %s at %lld"), *transfer->Name, transfer->SendOffset);
+				SendBlobCancel(transfer->BlobId);
+				it.RemoveCurrent();
+				transfer->Finish(EULSBlobState::Failed);
+				break;
+			}
+			packet->FinalizeHeader();
+			SendWirePacket(packet);
+
+			transfer->SendOffset += size;
+			budget -= size;
+		}
+	}
+}
+
+void UULSClientNetworkOwner::SendBlobBegin(const UULSBlobTransfer* transfer)
+{
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::BlobBegin;
+	packet->SetPayloadSize(sizeof(int64) + sizeof(int64) + 4 + FTCHARToUTF8(*transfer->Name).Length());
+
+	int position = 0;
+	packet->PutInt64(transfer->BlobId, position, position);
+	packet->PutInt64(transfer->TotalSize, position, position);
+	packet->PutString(transfer->Name, position, position);
+	packet->FinalizeHeader();
+	SendWirePacket(packet);
+}
+
+void UULSClientNetworkOwner::SendBlobAck(UULSBlobTransfer* transfer)
+{
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::BlobAck;
+	packet->SetPayloadSize(sizeof(int64) + sizeof(int64));
+
+	int position = 0;
+	packet->PutInt64(transfer->BlobId, position, position);
+	packet->PutInt64(transfer->TransferredSize, position, position);
+	packet->FinalizeHeader();
+	SendWirePacket(packet);
+
+	transfer->UnacknowledgedSize = 0;
+}
+
+void UULSClientNetworkOwner::SendBlobCancel(int64 blobId)
+{
+	UULSWirePacket* packet = NewObject<UULSWirePacket>();
+	packet->PacketType = EWirePacketType::BlobCancel;
+	packet->SetPayloadSize(sizeof(int64));
+
+	int position = 0;
+	packet->PutInt64(blobId, position, position);
+	packet->FinalizeHeader();
+	SendWirePacket(packet);
+}
+
+void UULSClientNetworkOwner::HandleBlobBeginMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const int64 blobId = packet->ReadInt64(position, position);
+	const int64 totalSize = packet->ReadInt64(position, position);
+	const FString name = packet->ReadString(position, position);
+
+	if (UULSBlobTransfer** existing = BlobTransfers.Find(blobId))
+	{
+		// Announced again after a reconnect
+		SendBlobAck(*existing);
+		return;
+	}
+
+	if (blobId <= 0 || totalSize < 0)
+	{
+		UE_LOG(LogULS, Error, TEXT("HandleBlobBeginMessage: Invalid blob %lld of %lld bytes"), blobId, totalSize);
+		return;
+	}
+
+	UULSBlobTransfer* transfer = NewObject<UULSBlobTransfer>(this);
+	transfer->Owner = this;
+	transfer->BlobId = blobId;
+	transfer->Name = name;
+	transfer->TotalSize = totalSize;
+	BlobTransfers.Add(blobId, transfer);
+
+	OnBlobTransferStarted(transfer);
+	if (transfer->State != EULSBlobState::Transferring)
+	{
+		// Cancelled by the handler
+		return;
+	}
+
+	if (transfer->HasDestination() == false && (totalSize > MaxBlobBufferSize || transfer->WriteToBuffer() == false))
+	{
+		UE_LOG(LogULS, Warning, TEXT("HandleBlobBeginMessage: No destination for blob %s of %lld bytes"), *name, totalSize);
+		CancelBlobTransfer(transfer);
+		transfer->Finish(EULSBlobState::Failed);
+		return;
+	}
+
+	if (totalSize == 0)
+	{
+		SendBlobAck(transfer);
+		BlobTransfers.Remove(blobId);
+		transfer->Finish(EULSBlobState::Completed);
+	}
+}
+
+void UULSClientNetworkOwner::HandleBlobChunkMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const int64 blobId = packet->ReadInt64(position, position);
+	const int64 offset = packet->ReadInt64(position, position);
+	const int32 size = packet->GetPayloadSize() - position;
+
+	UULSBlobTransfer** found = BlobTransfers.Find(blobId);
+	UULSBlobTransfer* transfer = (found != nullptr ? *found : nullptr);
+	if (transfer == nullptr || transfer->bUpload || size < 0)
+	{
+		// Chunks still in flight when the transfer was cancelled
+		return;
+	}
+
+	if (offset != transfer->TransferredSize)
+	{
+		// Repeated chunks after a resume are dropped. A gap means chunks were lost, ask to continue from what we have.
+		if (offset > transfer->TransferredSize)
+		{
+			SendBlobAck(transfer);
+		}
+		return;
+	}
+
+	if (offset + size > transfer->TotalSize ||
+		transfer->WriteChunk(offset, packet->ReadDataPtr(size, position, position), size) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("HandleBlobChunkMessage: Failed to write %d bytes at %lld of blob %s"), size, offset, *transfer->Name);
+		CancelBlobTransfer(transfer);
+		transfer->Finish(EULSBlobState::Failed);
+		return;
+	}
+
+	transfer->TransferredSize += size;
+	transfer->UnacknowledgedSize += size;
+	transfer->OnProgress.Broadcast(transfer->TransferredSize, transfer->TotalSize);
+
+	if (transfer->TransferredSize == transfer->TotalSize)
+	{
+		SendBlobAck(transfer);
+		BlobTransfers.Remove(blobId);
+		transfer->Finish(EULSBlobState::Completed);
+	}
+	else if (transfer->UnacknowledgedSize >= BlobAckInterval)
+	{
+		SendBlobAck(transfer);
+	}
+}
+
+void UULSClientNetworkOwner::HandleBlobAckMessage(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const int64 blobId = packet->ReadInt64(position, position);
+	const int64 receivedSize = packet->ReadInt64(position, position);
+
+	UULSBlobTransfer** found = BlobTransfers.Find(blobId);
+	UULSBlobTransfer* transfer = (found != nullptr ? *found : nullptr);
+	if (transfer == nullptr || transfer->bUpload == false)
+	{
+		return;
+	}
 
-	if (IsValid(cls))
+	transfer->TransferredSize = FMath::Clamp<int64>(receivedSize, 0, transfer->TotalSize);
+	if (transfer->bAwaitingAck)
 	{
-		//UE_LOG(LogTemp, Display, TEXT("HandleCreateObjectMessage: Class found: %s"), *cls->GetDescription());
-		CreateNetworkObject(uniqueId, cls);
+		transfer->SendOffset = transfer->TransferredSize;
+		transfer->bAwaitingAck = false;
 	}
-	else
+	transfer->OnProgress.Broadcast(transfer->TransferredSize, transfer->TotalSize);
+
+	if (transfer->TransferredSize == transfer->TotalSize)
 	{
-		UE_LOG(LogTemp, Error, TEXT("HandleCreateObjectMessage failed: Class '%s' not found"), *className);
+		BlobTransfers.Remove(blobId);
+		transfer->Finish(EULSBlobState::Completed);
 	}
 }
 
-void UULSClientNetworkOwner::HandleDestroyObjectMessage(const UULSWirePacket* packet)
+void UULSClientNetworkOwner::HandleBlobCancelMessage(const UULSWirePacket* packet)
 {
 	int position = 0;
-	int32 flags = packet->ReadInt32(position, position);
-	int64 uniqueId = packet->ReadInt64(position, position);
+	const int64 blobId = packet->ReadInt64(position, position);
 
-	auto obj = FindObjectRef(uniqueId);
-	if (IsValid(obj))
+	UULSBlobTransfer* transfer = nullptr;
+	if (BlobTransfers.RemoveAndCopyValue(blobId, transfer) && IsValid(transfer))
 	{
-		obj->MarkAsGarbage();
+		transfer->Finish(EULSBlobState::Cancelled);
+	}
+}
 
-		uniqueIdLookup.Remove(obj);
+void UULSClientNetworkOwner::ProcessInboundQueue()
+{
+	FULSInboundFrame frame;
+	while (InboundQueue->Dequeue(frame))
+	{
+		if (UULSTransport* transport = frame.Transport.Get())
+		{
+			transport->HandleReceivedBytes(MoveTemp(frame.Bytes), frame.ReceiveCycles);
+		}
 	}
-	objectMap.Remove(uniqueId);
 }
 
-void UULSClientNetworkOwner::HandleReplicationMessage(const UULSWirePacket* packet)
+bool UULSClientNetworkOwner::Tick(float DeltaTime)
 {
-	int position = 0;
-	int32 flags = packet->ReadInt32(position, position);
-	int64 uniqueId = packet->ReadInt64(position, position);
-	auto existingObject = FindObjectRef(uniqueId);
-	if (IsValid(existingObject) == false)
+	ProcessInboundQueue();
+	FULSLatencyStats::Tick();
+
+	if (PendingSpawns.Num() > 0)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("HandleReplicationMessage failed: Object with id %ld not found"), uniqueId);
-		return;
+		ProcessPendingSpawns();
 	}
 
-	int32 fieldCount = packet->ReadInt32(position, position);
-	if (fieldCount == 0)
+	if (PendingDespawns.Num() > 0)
 	{
-		// Should not happen (server should not send empty packets)
-		// Not an error regardless, just return
-		return;
+		ProcessPendingDespawns();
 	}
 
-	auto cls = existingObject->GetClass();
-	for (size_t i = 0; i < fieldCount; i++)
+	if ((PendingBaselineAcks.Num() > 0 || PendingBaselineResyncs.Num() > 0) &&
+		FPlatformTime::Seconds() - LastBaselineAckTime >= BaselineAckInterval &&
+		IsValid(Transport) && Transport->IsConnected())
 	{
-		int8 type = packet->ReadInt8(position, position);
-		FString fieldName = packet->ReadString(position, position);
+		SendBaselineAck();
+	}
 
-		auto prop = cls->FindPropertyByName(FName(*fieldName));
+	if (bReconnecting)
+	{
+		UpdateReconnect();
+	}
 
-		if (prop == nullptr)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("HandleReplicationMessage: prop %s not found on actor %ld of class %s"), *fieldName, uniqueId, *cls->GetName());
-			continue;
-		}
+	if (bConnectionAccepted && EnumHasAnyFlags(NegotiatedFeatures, ETransportFeatures::Heartbeat) &&
+		IsValid(Transport) && Transport->IsConnected())
+	{
+		UpdateHeartbeat();
+	}
+	LastTickTime = FPlatformTime::Seconds();
 
-		bool valueDidChange = false;
+	if (bSessionAckPending && bConnectionAccepted &&
+		FPlatformTime::Seconds() - LastSessionAckTime >= SessionAckInterval &&
+		IsValid(Transport) && Transport->IsConnected())
+	{
+		SendSessionAck();
+	}
 
-		switch (type)
-		{
-		case EReplicatedFieldType::Reference:
-		{
-			// Ref
-			auto objRef = DeserializeRef(packet, position, position);
-			if (IsValid(objRef) == false)
-			{
-				// Set the reference to "null"
-				FObjectProperty* objProp = (FObjectProperty*)prop;
-				if (UObject** valuePtr = objProp->ContainerPtrToValuePtr<UObject*>(existingObject))
-				{
-					if (*valuePtr != nullptr)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = nullptr -- (%li)=(%li)"), *existingObject->GetName(), *prop->GetName(),
-							uniqueId, -1);
-#endif
-						valueDidChange = true;
-						*valuePtr = nullptr;
-					}
-				}
-			}
-			else
-			{
-				FObjectProperty* objProp = (FObjectProperty*)prop;
-				if (UObject** valuePtr = objProp->ContainerPtrToValuePtr<UObject*>(existingObject))
-				{
-					if (*valuePtr != objRef)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %s -- (%li)=(%li)"), 
-							*existingObject->GetName(), *prop->GetName(),
-							*objRef->GetName(), uniqueId, FindUniqueId(objRef));
-#endif
-						valueDidChange = true;
-						*valuePtr = objRef;
-					}
-				}
-				else
-				{
-					UE_LOG(LogTemp, Warning, TEXT("HandleReplicationMessage: valuePtr failed"));
-				}
-			}
-		}
-		break;
+	if (bConnectionAccepted && BlobTransfers.Num() > 0 && IsValid(Transport) && Transport->IsConnected())
+	{
+		SendBlobChunks();
+	}
 
-		case EReplicatedFieldType::PrimitiveInt:
-		{
-			// Value
-			int32 propSize = prop->GetSize();
-			int32 size = packet->ReadInt32(position, position);
-			
-			if (FIntProperty* intProp = CastField<FIntProperty>(prop))
-			{
-				if (int32* iVal = intProp->ContainerPtrToValuePtr<int32>(existingObject))
-				{
-					int32 newVal = DeserializeInt32(packet, position, position);
-					if (*iVal != newVal)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %i"), *existingObject->GetName(), *prop->GetName(), newVal);
-#endif
-						valueDidChange = true;
-						*iVal = newVal;
-					}
-				}
-			}
-			else if (FInt16Property* int16Prop = CastField<FInt16Property>(prop))
-			{
-				if (int16* iVal = int16Prop->ContainerPtrToValuePtr<int16>(existingObject))
-				{
-					int16 newVal = DeserializeInt16(packet, position, position);
-					if (*iVal != newVal)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %ld"), *existingObject->GetName(), *prop->GetName(), newVal);
-#endif
-						valueDidChange = true;
-						*iVal = newVal;
-					}
-				}
-			}
-			else if (FInt64Property* int64Prop = CastField<FInt64Property>(prop))
-			{
-				if (int64* iVal = int64Prop->ContainerPtrToValuePtr<int64>(existingObject))
-				{
-					int64 newVal = DeserializeInt64(packet, position, position);
-					if (*iVal != newVal)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %ld"), *existingObject->GetName(), *prop->GetName(), newVal);
-#endif
-						valueDidChange = true;
-						*iVal = newVal;
-					}
-				}
-			}
-			else if (FBoolProperty* boolProp = CastField<FBoolProperty>(prop))
-			{
-				if (bool* bVal = boolProp->ContainerPtrToValuePtr<bool>(existingObject))
-				{
-					bool newVal = DeserializeBool(packet, position, position, size);
-					if (*bVal != newVal)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %s"), *existingObject->GetName(), *prop->GetName(), newVal ? TEXT("TRUE") : TEXT("FALSE"));
-#endif
-						valueDidChange = true;
-						*bVal = newVal;
-					}
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Warning, TEXT("HandleReplicationMessage: Unhandled property of type %s"), *prop->GetFullName());
-			}
-		}
-		break;
+	if (OutgoingChannelPackets.Num() > 0 && IsValid(Transport) && Transport->IsConnected())
+	{
+		SendChannelChunks();
+	}
 
-		case EReplicatedFieldType::PrimitiveFloat:
+	// Packets queued by worker threads
+	if (IsValid(Transport))
+	{
+		Transport->FlushOutboundQueue();
+	}
+	for (const TPair<int32, UULSTransport*>& entry : ChannelTransports)
+	{
+		if (IsValid(entry.Value))
 		{
-			// Value
-			int32 propSize = prop->GetSize();
-			int32 size = packet->ReadInt32(position, position);
-
-			if (FFloatProperty* floatProp = CastField<FFloatProperty>(prop))
-			{
-				if (float_t* fVal = floatProp->ContainerPtrToValuePtr<float_t>(existingObject))
-				{
-					float_t newVal = DeserializeFloat32(packet, position, position);
-					if (*fVal != newVal)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %f"), *existingObject->GetName(), *prop->GetName(), newVal);
-#endif
-						valueDidChange = true;
-						*fVal = newVal;
-					}
-				}
-			}
-			else if (FDoubleProperty* doubleProp = CastField<FDoubleProperty>(prop))
-			{
-				if (double* dVal = doubleProp->ContainerPtrToValuePtr<double>(existingObject))
-				{
-					double newVal = DeserializeFloat64(packet, position, position);
-					if (*dVal != newVal)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %f"), *existingObject->GetName(), *prop->GetName(), newVal);
-#endif
-						valueDidChange = true;
-						*dVal = newVal;
-					}
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Warning, TEXT("HandleReplicationMessage: Unhandled property of type %s"), *prop->GetFullName());
-			}
+			entry.Value->FlushOutboundQueue();
 		}
-		break;
+	}
 
-		case EReplicatedFieldType::String:
-		{
-			// String
-			FString fieldValue = DeserializeString(packet, position, position);
-			FStrProperty* strProp = (FStrProperty*)prop;
-			if (FString* valuePtr = strProp->ContainerPtrToValuePtr<FString>(existingObject))
-			{
-				if (*valuePtr != fieldValue)
-				{
-#if SERIALIZE_LOG
-					UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %s"), *existingObject->GetName(), *prop->GetName(), *fieldValue);
-#endif
-					valueDidChange = true;
-					*valuePtr = fieldValue;
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Error, TEXT("HandleReplicationMessage: valuePtr failed"));
-			}
-		}
-		break;
+	return true;
+}
 
-		case EReplicatedFieldType::Vector3:
-		{
-			// String
-			FVector vec = DeserializeVector(packet, position, position);
+void UULSClientNetworkOwner::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
 
-			FProperty* vecProp = (FProperty*)prop;
-			if (FVector* valuePtr = vecProp->ContainerPtrToValuePtr<FVector>(existingObject))
-			{
-				if (valuePtr != nullptr)
-				{
-					FVector val = *valuePtr;
-					if (FMath::IsNearlyEqual(val.X, vec.X) == false ||
-						FMath::IsNearlyEqual(val.Y, vec.Y) == false ||
-						FMath::IsNearlyEqual(val.Z, vec.Z) == false)
-					{
-#if SERIALIZE_LOG
-						UE_LOG(LogTemp, Display, TEXT("HandleReplicationMessage: %s.%s = %s"), *existingObject->GetName(), *prop->GetName(), *vec.ToString());
-#endif
-						valueDidChange = true;
-						*valuePtr = vec;
-					}
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Error, TEXT("HandleReplicationMessage: valuePtr failed"));
-			}
-		}
-		break;
-		}
+	UULSClientNetworkOwner* owner = CastChecked<UULSClientNetworkOwner>(InThis);
+	Collector.AddReferencedObjects(owner->HeldSpawnPackets, owner);
+}
 
-		if (valueDidChange)
-		{
-			FString repFunctionName = TEXT("OnRep_") + fieldName;
-			auto repFunction = cls->FindFunctionByName(FName(repFunctionName));
-			if (IsValid(repFunction))
-			{
-				UE_LOG(LogTemp, Display, TEXT("repFunctionName: %s"), *repFunctionName);
-				UE_LOG(LogTemp, Display, TEXT("  -> repFunction->ParmsSize: %i"), repFunction->ParmsSize);
-				uint8* Parms = (uint8*)FMemory_Alloca_Aligned(repFunction->ParmsSize, repFunction->GetMinAlignment());
-				FMemory::Memzero(Parms, repFunction->ParmsSize);
+void UULSClientNetworkOwner::BeginDestroy()
+{
+	Super::BeginDestroy();
 
-				if (IsValid(existingObject) == false)
-				{
-					UE_LOG(LogTemp, Error, TEXT("existingObject is invalid. Can't process call to function %s"),
-						*repFunctionName);
-				}
-				else
-				{
-					existingObject->ProcessEvent(repFunction, Parms);
-				}
-			}
-		}
+	// The transports hold on to the writer until they are destroyed as well
+	Capture.Reset();
+
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
 	}
 }
 
@@ -870,26 +2881,46 @@ int64 UULSClientNetworkOwner::FindUniqueId(const UObject* obj) const
 }
 
 AActor* UULSClientNetworkOwner::SpawnNetworkActor(int64 uniqueId, UClass* cls)
+{
+	return SpawnNetworkActor(uniqueId, cls, FTransform::Identity, nullptr, 0, 0);
+}
+
+AActor* UULSClientNetworkOwner::SpawnNetworkActor(int64 uniqueId, UClass* cls, const FTransform& transform, const UULSWirePacket* packet, int numProperties, int propertiesPosition)
 {
 	auto existingObject = FindObjectRef(uniqueId);
 	if (existingObject != nullptr)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("SpawnNetworkActor failed: Actor with id %ld already exists"), uniqueId);
+		UE_LOG(LogULS, Warning, TEXT("SpawnNetworkActor failed: Actor with id %ld already exists"), uniqueId);
 		return nullptr;
 	}
 
 	UWorld* world = GetWorld();
-	FTransform actorTransform = FTransform::Identity;
-	auto actor = world->SpawnActor(cls, &actorTransform);
-	auto networkActor = Cast<AActor>(actor);
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.bDeferConstruction = true;
+	auto networkActor = world->SpawnActor(cls, &transform, spawnParameters);
 	if (networkActor == nullptr)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("SpawnNetworkActor failed: Class %s is not a subclass of AActor"), *cls->GetName());
-		actor->Destroy();
+		UE_LOG(LogULS, Warning, TEXT("SpawnNetworkActor failed: Class %s is not a subclass of AActor"), *cls->GetName());
 		return nullptr;
 	}
+
+	// Registered first, so the initial state and BeginPlay can resolve the actor's own id
 	objectMap.Add(uniqueId, networkActor);
 	uniqueIdLookup.Add(networkActor, uniqueId);
+
+	if (packet != nullptr && numProperties > 0)
+	{
+		ReadProperties(packet, cls, numProperties, networkActor, propertiesPosition, false);
+	}
+
+	networkActor->FinishSpawning(transform);
+	if (IsValid(networkActor) == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("SpawnNetworkActor failed: Actor with id %ld was destroyed while spawning"), uniqueId);
+		objectMap.Remove(uniqueId);
+		uniqueIdLookup.Remove(networkActor);
+		return nullptr;
+	}
 	return networkActor;
 }
 
@@ -898,14 +2929,14 @@ UObject* UULSClientNetworkOwner::CreateNetworkObject(int64 uniqueId, UClass* cls
 	auto existingObject = FindObjectRef(uniqueId);
 	if (existingObject != nullptr)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CreateNetworkObject failed: Object with id %ld already exists"), uniqueId);
+		UE_LOG(LogULS, Warning, TEXT("CreateNetworkObject failed: Object with id %ld already exists"), uniqueId);
 		return nullptr;
 	}
 
 	auto obj = NewObject<UObject>((UObject*)GetTransientPackage(), cls);
 	if (IsValid(obj) == false)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CreateNetworkObject failed: Class %s is not a subclass of UObject"), *cls->GetName());
+		UE_LOG(LogULS, Warning, TEXT("CreateNetworkObject failed: Class %s is not a subclass of UObject"), *cls->GetName());
 		return nullptr;
 	}
 	objectMap.Add(uniqueId, obj);
@@ -915,7 +2946,7 @@ UObject* UULSClientNetworkOwner::CreateNetworkObject(int64 uniqueId, UClass* cls
 
 UObject* UULSClientNetworkOwner::DeserializeRef(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
-	int64 uniqueId = packet->ReadInt64(index, advancedPosition);	
+	int64 uniqueId = DeserializeInt64(packet, index, advancedPosition);
 	if (uniqueId == -1)
 	{
 		return nullptr;
@@ -924,43 +2955,72 @@ UObject* UULSClientNetworkOwner::DeserializeRef(const UULSWirePacket* packet, in
 	auto res = FindObjectRef(uniqueId);
 	if (IsValid(res) == false)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("HandleReplicationMessage: Could not find object with id %ld"), uniqueId);
+		UE_LOG(LogULS, Warning, TEXT("HandleReplicationMessage: Could not find object with id %ld"), uniqueId);
 	}
 	return res;
 }
 
 int8 UULSClientNetworkOwner::DeserializeInt8(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding())
+	{
+		return (int8)packet->ReadVarInt(index, advancedPosition);
+	}
 	return packet->ReadInt8(index, advancedPosition);
 }
 
 int16 UULSClientNetworkOwner::DeserializeInt16(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding())
+	{
+		return (int16)packet->ReadVarInt(index, advancedPosition);
+	}
 	return packet->ReadInt16(index, advancedPosition);
 }
 
 int32 UULSClientNetworkOwner::DeserializeInt32(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding())
+	{
+		return (int32)packet->ReadVarInt(index, advancedPosition);
+	}
 	return packet->ReadInt32(index, advancedPosition);
 }
 
 int64 UULSClientNetworkOwner::DeserializeInt64(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding())
+	{
+		return packet->ReadVarInt(index, advancedPosition);
+	}
 	return packet->ReadInt64(index, advancedPosition);
 }
 
 float UULSClientNetworkOwner::DeserializeFloat32(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding() && NegotiatedQuantization.FloatPrecision > 0)
+	{
+		return (float)FULSWireEncoding::DequantizeFloat(packet->ReadVarInt(index, advancedPosition), NegotiatedQuantization);
+	}
 	return packet->ReadFloat32(index, advancedPosition);
 }
 
 double UULSClientNetworkOwner::DeserializeFloat64(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding() && NegotiatedQuantization.FloatPrecision > 0)
+	{
+		return FULSWireEncoding::DequantizeFloat(packet->ReadVarInt(index, advancedPosition), NegotiatedQuantization);
+	}
 	return packet->ReadFloat64(index, advancedPosition);
 }
 
 bool UULSClientNetworkOwner::DeserializeBool(const UULSWirePacket* packet, int index, int& advancedPosition, int boolSize) const
 {
+	if (packet->IsCompactEncoding())
+	{
+		return packet->ReadVarInt(index, advancedPosition) != 0;
+	}
+
 	bool newVal = false;
 	if (boolSize == 4)
 	{
@@ -979,11 +3039,28 @@ bool UULSClientNetworkOwner::DeserializeBool(const UULSWirePacket* packet, int i
 
 FString UULSClientNetworkOwner::DeserializeString(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding())
+	{
+		return packet->ReadVarString(index, advancedPosition);
+	}
 	return packet->ReadString(index, advancedPosition);
 }
 
 FVector UULSClientNetworkOwner::DeserializeVector(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
+	if (packet->IsCompactEncoding())
+	{
+		// Cell-relative, keeps full precision for double vectors far away from the origin
+		FULSBitReader reader(packet->GetPayload(), index);
+		const FVector result = reader.ReadQuantizedVector(NegotiatedQuantization);
+		if (reader.IsOverflowed())
+		{
+			return FVector::ZeroVector;
+		}
+		advancedPosition += reader.GetNumBytesConsumed();
+		return result;
+	}
+
 	return FVector(
 		packet->ReadFloat32(index, advancedPosition),
 		packet->ReadFloat32(advancedPosition, advancedPosition),
@@ -994,7 +3071,7 @@ FVector UULSClientNetworkOwner::DeserializeVector(const UULSWirePacket* packet,
 UObject* UULSClientNetworkOwner::DeserializeRefParameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeRef(packet, advancedPosition, advancedPosition);
 }
@@ -1003,8 +3080,8 @@ UObject* UULSClientNetworkOwner::DeserializeRefParameter(const UULSWirePacket* p
 int16 UULSClientNetworkOwner::DeserializeInt16Parameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
-	int32 size = packet->ReadInt32(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
+	int32 size = DeserializeInt32(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeInt16(packet, advancedPosition, advancedPosition);
 }
@@ -1012,8 +3089,8 @@ int16 UULSClientNetworkOwner::DeserializeInt16Parameter(const UULSWirePacket* pa
 int32 UULSClientNetworkOwner::DeserializeInt32Parameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
-	int32 size = packet->ReadInt32(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
+	int32 size = DeserializeInt32(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeInt32(packet, advancedPosition, advancedPosition);
 }
@@ -1021,8 +3098,8 @@ int32 UULSClientNetworkOwner::DeserializeInt32Parameter(const UULSWirePacket* pa
 int64 UULSClientNetworkOwner::DeserializeInt64Parameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
-	int32 size = packet->ReadInt32(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
+	int32 size = DeserializeInt32(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeInt64(packet, advancedPosition, advancedPosition);
 }
@@ -1030,8 +3107,8 @@ int64 UULSClientNetworkOwner::DeserializeInt64Parameter(const UULSWirePacket* pa
 float UULSClientNetworkOwner::DeserializeFloat32Parameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
-	int32 size = packet->ReadInt32(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
+	int32 size = DeserializeInt32(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeFloat32(packet, advancedPosition, advancedPosition);
 }
@@ -1039,8 +3116,8 @@ float UULSClientNetworkOwner::DeserializeFloat32Parameter(const UULSWirePacket*
 double UULSClientNetworkOwner::DeserializeFloat64Parameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
-	int32 size = packet->ReadInt32(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
+	int32 size = DeserializeInt32(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeFloat64(packet, advancedPosition, advancedPosition);
 }
@@ -1048,8 +3125,8 @@ double UULSClientNetworkOwner::DeserializeFloat64Parameter(const UULSWirePacket*
 bool UULSClientNetworkOwner::DeserializeBoolParameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
-	int32 size = packet->ReadInt32(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
+	int32 size = DeserializeInt32(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeBool(packet, advancedPosition, advancedPosition, size);
 }
@@ -1057,7 +3134,7 @@ bool UULSClientNetworkOwner::DeserializeBoolParameter(const UULSWirePacket* pack
 FString UULSClientNetworkOwner::DeserializeStringParameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeString(packet, advancedPosition, advancedPosition);
 }
@@ -1065,7 +3142,7 @@ FString UULSClientNetworkOwner::DeserializeStringParameter(const UULSWirePacket*
 FVector UULSClientNetworkOwner::DeserializeVectorParameter(const UULSWirePacket* packet, int index, int& advancedPosition) const
 {
 	int8 type = packet->ReadInt8(index, advancedPosition);
-	FString fieldName = packet->ReadString(advancedPosition, advancedPosition);
+	FString fieldName = DeserializeString(packet, advancedPosition, advancedPosition);
 	// TODO: Validate type
 	return DeserializeVector(packet, advancedPosition, advancedPosition);
 }
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSCompression.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace ULSCompressionTraining
+{
+	// Length of the byte sequences whose frequency is counted
+	constexpr int32 KmerSize = 8;
+
+	// Length of the segments that are copied into the dictionary
+	constexpr int32 SegmentSize = 64;
+
+	static uint64 ReadKmer(const uint8* data)
+	{
+		uint64 kmer;
+		FMemory::Memcpy(&kmer, data, sizeof(kmer));
+		return kmer;
+	}
+}
+
+uint32 FULSCompression::GetDictionaryId(TConstArrayView<uint8> dictionary)
+{
+	if (dictionary.Num() == 0)
+	{
+		return 0;
+	}
+
+	return (uint32)adler32(adler32(0L, Z_NULL, 0), dictionary.GetData(), dictionary.Num());
+}
+
+bool FULSCompression::Compress(TConstArrayView<uint8> source, TConstArrayView<uint8> dictionary, TArray<uint8>& outCompressed)
+{
+	z_stream stream;
+	FMemory::Memzero(stream);
+
+	// Negative window bits: raw deflate stream without zlib header and checksum
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		return false;
+	}
+
+	if (dictionary.Num() > 0 &&
+		deflateSetDictionary(&stream, dictionary.GetData(), dictionary.Num()) != Z_OK)
+	{
+		deflateEnd(&stream);
+		return false;
+	}
+
+	const int32 startSize = outCompressed.Num();
+	const uLong bound = deflateBound(&stream, source.Num());
+	outCompressed.AddUninitialized((int32)bound);
+
+	stream.next_in = (Bytef*)source.GetData();
+	stream.avail_in = source.Num();
+	stream.next_out = outCompressed.GetData() + startSize;
+	stream.avail_out = bound;
+
+	const int result = deflate(&stream, Z_FINISH);
+	const int32 compressedSize = (int32)stream.total_out;
+	deflateEnd(&stream);
+
+	if (result != Z_STREAM_END || compressedSize >= source.Num())
+	{
+		outCompressed.SetNum(startSize, false);
+		return false;
+	}
+
+	outCompressed.SetNum(startSize + compressedSize, false);
+	return true;
+}
+
+bool FULSCompression::Decompress(TConstArrayView<uint8> source, TConstArrayView<uint8> dictionary, uint8* dest, int32 destSize)
+{
+	z_stream stream;
+	FMemory::Memzero(stream);
+
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+	{
+		return false;
+	}
+
+	// Raw streams take the dictionary right away instead of asking for it with Z_NEED_DICT
+	if (dictionary.Num() > 0 &&
+		inflateSetDictionary(&stream, dictionary.GetData(), dictionary.Num()) != Z_OK)
+	{
+		inflateEnd(&stream);
+		return false;
+	}
+
+	stream.next_in = (Bytef*)source.GetData();
+	stream.avail_in = source.Num();
+	stream.next_out = dest;
+	stream.avail_out = destSize;
+
+	const int result = inflate(&stream, Z_FINISH);
+	const bool success = (result == Z_STREAM_END && stream.total_out == (uLong)destSize);
+	inflateEnd(&stream);
+
+	return success;
+}
+
+TArray<uint8> FULSCompression::TrainDictionary(const TArray<TArray<uint8>>& samples, int32 maxDictionarySize)
+{
+	using namespace ULSCompressionTraining;
+
+	// Concatenate all samples and remember where k-mers would cross a sample boundary
+	TArray<uint8> data;
+	TArray<bool> kmerValid;
+	for (const TArray<uint8>& sample : samples)
+	{
+		const int32 start = data.Num();
+		data.Append(sample);
+		kmerValid.AddZeroed(sample.Num());
+		for (int32 i = 0; i + KmerSize <= sample.Num(); i++)
+		{
+			kmerValid[start + i] = true;
+		}
+	}
+
+	TArray<uint8> dictionary;
+	const int32 numSegments = maxDictionarySize / SegmentSize;
+	if (data.Num() < SegmentSize || numSegments <= 0)
+	{
+		return dictionary;
+	}
+
+	TMap<uint64, int32> frequencies;
+	for (int32 i = 0; i < data.Num(); i++)
+	{
+		if (kmerValid[i])
+		{
+			frequencies.FindOrAdd(ReadKmer(data.GetData() + i))++;
+		}
+	}
+
+	// Split the data into one epoch per dictionary segment and pick the best segment of each epoch.
+	// A k-mer that occurs only once is worthless, so scores count repetitions beyond the first.
+	struct FSegment
+	{
+		int32 Offset;
+		int64 Score;
+	};
+	TArray<FSegment> segments;
+
+	const int32 epochSize = FMath::Max(data.Num() / numSegments, SegmentSize);
+	TArray<int32> scores;
+	for (int32 epochStart = 0; epochStart + SegmentSize <= data.Num(); epochStart += epochSize)
+	{
+		const int32 epochEnd = FMath::Min(epochStart + epochSize + SegmentSize, data.Num());
+
+		scores.SetNumUninitialized(epochEnd - epochStart);
+		for (int32 i = epochStart; i < epochEnd; i++)
+		{
+			const int32* frequency = kmerValid[i] ? frequencies.Find(ReadKmer(data.GetData() + i)) : nullptr;
+			scores[i - epochStart] = (frequency != nullptr ? FMath::Max(*frequency - 1, 0) : 0);
+		}
+
+		// Sliding window over the k-mers that start inside a segment
+		const int32 window = SegmentSize - KmerSize + 1;
+		int64 windowScore = 0;
+		for (int32 i = 0; i < window; i++)
+		{
+			windowScore += scores[i];
+		}
+
+		FSegment best = { epochStart, windowScore };
+		for (int32 i = 1; i + SegmentSize <= scores.Num(); i++)
+		{
+			windowScore += scores[i + window - 1] - scores[i - 1];
+			if (windowScore > best.Score)
+			{
+				best = { epochStart + i, windowScore };
+			}
+		}
+
+		if (best.Score <= 0)
+		{
+			continue;
+		}
+
+		// Content that made it into the dictionary should not be picked again
+		for (int32 i = best.Offset; i + KmerSize <= best.Offset + SegmentSize; i++)
+		{
+			if (kmerValid[i])
+			{
+				frequencies.FindOrAdd(ReadKmer(data.GetData() + i)) = 0;
+			}
+		}
+		segments.Add(best);
+	}
+
+	// Deflate encodes short distances more cheaply, so the most valuable segments go last
+	segments.Sort([](const FSegment& a, const FSegment& b) { return a.Score < b.Score; });
+
+	dictionary.Reserve(segments.Num() * SegmentSize);
+	for (const FSegment& segment : segments)
+	{
+		dictionary.Append(data.GetData() + segment.Offset, SegmentSize);
+	}
+	return dictionary;
+}
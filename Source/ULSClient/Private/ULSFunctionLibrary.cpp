@@ -19,6 +19,10 @@ int32 UULSFunctionLibrary::GetPacketTypeByName(const FString& str)
     {
         return (int32)EWirePacketType::ConnectionEnd;
     }
+    else if (str == TEXT("TransportOptions"))
+    {
+        return (int32)EWirePacketType::TransportOptions;
+    }
     // Runtime messages
     else if (str == TEXT("Replication"))
     {
@@ -48,6 +52,74 @@ int32 UULSFunctionLibrary::GetPacketTypeByName(const FString& str)
     {
         return (int32)EWirePacketType::RpcCallResponse;
     }
+    else if (str == TEXT("TearOff"))
+    {
+        return (int32)EWirePacketType::TearOff;
+    }
+    else if (str == TEXT("ReplicationDelta"))
+    {
+        return (int32)EWirePacketType::ReplicationDelta;
+    }
+    else if (str == TEXT("BaselineAck"))
+    {
+        return (int32)EWirePacketType::BaselineAck;
+    }
+    else if (str == TEXT("ChannelChunk"))
+    {
+        return (int32)EWirePacketType::ChannelChunk;
+    }
+    else if (str == TEXT("ChannelAttach"))
+    {
+        return (int32)EWirePacketType::ChannelAttach;
+    }
+    else if (str == TEXT("BlobBegin"))
+    {
+        return (int32)EWirePacketType::BlobBegin;
+    }
+    else if (str == TEXT("BlobChunk"))
+    {
+        return (int32)EWirePacketType::BlobChunk;
+    }
+    else if (str == TEXT("BlobAck"))
+    {
+        return (int32)EWirePacketType::BlobAck;
+    }
+    else if (str == TEXT("BlobCancel"))
+    {
+        return (int32)EWirePacketType::BlobCancel;
+    }
+    else if (str == TEXT("SessionResume"))
+    {
+        return (int32)EWirePacketType::SessionResume;
+    }
+    else if (str == TEXT("SessionAck"))
+    {
+        return (int32)EWirePacketType::SessionAck;
+    }
+    else if (str == TEXT("Ping"))
+    {
+        return (int32)EWirePacketType::Ping;
+    }
+    else if (str == TEXT("Pong"))
+    {
+        return (int32)EWirePacketType::Pong;
+    }
+    else if (str == TEXT("SpawnSnapshot"))
+    {
+        return (int32)EWirePacketType::SpawnSnapshot;
+    }
+    else if (str == TEXT("DespawnActors"))
+    {
+        return (int32)EWirePacketType::DespawnActors;
+    }
+    else if (str == TEXT("DestroyObjects"))
+    {
+        return (int32)EWirePacketType::DestroyObjects;
+    }
+    else if (str == TEXT("TearOffs"))
+    {
+        return (int32)EWirePacketType::TearOffs;
+    }
     // Custom
     else if (str == TEXT("Custom"))
     {
@@ -67,6 +139,7 @@ FString UULSFunctionLibrary::GetPacketNameByType(int32 type)
         case EWirePacketType::ConnectionRequest: return TEXT("ConnectionRequest");
         case EWirePacketType::ConnectionResponse: return TEXT("ConnectionResponse");
         case EWirePacketType::ConnectionEnd: return TEXT("ConnectionEnd");
+        case EWirePacketType::TransportOptions: return TEXT("TransportOptions");
 
         // Runtime messages
         case EWirePacketType::Replication: return TEXT("Replication");
@@ -76,6 +149,23 @@ FString UULSFunctionLibrary::GetPacketNameByType(int32 type)
         case EWirePacketType::DestroyObject: return TEXT("DestroyObject");
         case EWirePacketType::RpcCall: return TEXT("RpcCall");
         case EWirePacketType::RpcCallResponse: return TEXT("RpcCallResponse");
+        case EWirePacketType::TearOff: return TEXT("TearOff");
+        case EWirePacketType::ReplicationDelta: return TEXT("ReplicationDelta");
+        case EWirePacketType::BaselineAck: return TEXT("BaselineAck");
+        case EWirePacketType::ChannelChunk: return TEXT("ChannelChunk");
+        case EWirePacketType::ChannelAttach: return TEXT("ChannelAttach");
+        case EWirePacketType::BlobBegin: return TEXT("BlobBegin");
+        case EWirePacketType::BlobChunk: return TEXT("BlobChunk");
+        case EWirePacketType::BlobAck: return TEXT("BlobAck");
+        case EWirePacketType::BlobCancel: return TEXT("BlobCancel");
+        case EWirePacketType::SessionResume: return TEXT("SessionResume");
+        case EWirePacketType::SessionAck: return TEXT("SessionAck");
+        case EWirePacketType::Ping: return TEXT("Ping");
+        case EWirePacketType::Pong: return TEXT("Pong");
+        case EWirePacketType::SpawnSnapshot: return TEXT("SpawnSnapshot");
+        case EWirePacketType::DespawnActors: return TEXT("DespawnActors");
+        case EWirePacketType::DestroyObjects: return TEXT("DestroyObjects");
+        case EWirePacketType::TearOffs: return TEXT("TearOffs");
 
         // Custom
         case EWirePacketType::Custom: return TEXT("Custom");
@@ -0,0 +1,271 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSLatencyStats.h"
+#include "ULSStats.h"
+#include "ULSFunctionLibrary.h"
+#include "ULSWirePacket.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Histogram
+
+FULSLatencyHistogram::FULSLatencyHistogram()
+{
+	Counts.SetNumZeroed(BucketCount);
+}
+
+int32 FULSLatencyHistogram::GetBucketIndex(uint64 value)
+{
+	if (value < SubBucketCount)
+	{
+		return (int32)value;
+	}
+
+	// The top SubBucketBits + 1 bits select the bucket, the rest is below its resolution
+	const int32 shift = (int32)FPlatformMath::FloorLog2_64(value) - SubBucketBits;
+	return (shift + 1) * SubBucketCount + (int32)((value >> shift) - SubBucketCount);
+}
+
+uint64 FULSLatencyHistogram::GetHighestEquivalentValue(int32 bucketIndex)
+{
+	if (bucketIndex < SubBucketCount)
+	{
+		return (uint64)bucketIndex;
+	}
+
+	const int32 shift = bucketIndex / SubBucketCount - 1;
+	const uint64 subBucket = (uint64)(bucketIndex % SubBucketCount + SubBucketCount);
+	return ((subBucket + 1) << shift) - 1;
+}
+
+void FULSLatencyHistogram::Record(uint64 value)
+{
+	Counts[GetBucketIndex(value)]++;
+	Count++;
+	Max = FMath::Max(Max, value);
+}
+
+void FULSLatencyHistogram::Add(const FULSLatencyHistogram& other)
+{
+	for (int32 bucketIndex = 0; bucketIndex < BucketCount; bucketIndex++)
+	{
+		Counts[bucketIndex] += other.Counts[bucketIndex];
+	}
+	Count += other.Count;
+	Max = FMath::Max(Max, other.Max);
+}
+
+void FULSLatencyHistogram::Reset()
+{
+	FMemory::Memzero(Counts.GetData(), Counts.Num() * sizeof(uint32));
+	Count = 0;
+	Max = 0;
+}
+
+uint64 FULSLatencyHistogram::GetPercentile(double percentile) const
+{
+	if (Count == 0)
+	{
+		return 0;
+	}
+
+	const uint64 rank = FMath::Max<uint64>(1, (uint64)FMath::CeilToDouble(FMath::Clamp(percentile, 0.0, 100.0) / 100.0 * Count));
+	uint64 seen = 0;
+	for (int32 bucketIndex = 0; bucketIndex < BucketCount; bucketIndex++)
+	{
+		seen += Counts[bucketIndex];
+		if (seen >= rank)
+		{
+			return FMath::Min(GetHighestEquivalentValue(bucketIndex), Max);
+		}
+	}
+	return Max;
+}
+
+// Stats
+
+uint64 FULSLatencyStats::OnRepCycles = 0;
+
+namespace
+{
+	constexpr int32 MaxPacketTypes = 256;
+	constexpr int32 NumStages = (int32)EULSLatencyStage::Count;
+
+	const TCHAR* StageNames[NumStages] = { TEXT("Queue"), TEXT("Decode"), TEXT("Apply"), TEXT("OnRep"), TEXT("Total") };
+
+	bool GLatencyEnabled = true;
+	FAutoConsoleVariableRef CVarLatencyEnabled(TEXT("uls.Latency.Enabled"), GLatencyEnabled,
+		TEXT("Records the latency of inbound packets from socket receive to applied state."));
+
+	float GLatencyCsvInterval = 0;
+	FAutoConsoleVariableRef CVarLatencyCsvInterval(TEXT("uls.Latency.CsvInterval"), GLatencyCsvInterval,
+		TEXT("Seconds between two rows of percentiles appended to Saved/Profiling/ULS/Latency-<time>.csv. 0 disables the file."));
+
+	struct FPacketTypeLatency
+	{
+		FULSLatencyHistogram Total[NumStages];
+		FULSLatencyHistogram Interval[NumStages];
+	};
+
+	/* Allocated for the packet types seen */
+	TUniquePtr<FPacketTypeLatency> PacketTypes[MaxPacketTypes];
+
+	FString CsvPath;
+	double LastCsvTime = 0;
+
+	/* Stamps are taken on different threads, don't let a later start wrap around */
+	uint64 CyclesBetween(uint64 startCycles, uint64 endCycles)
+	{
+		return endCycles > startCycles ? endCycles - startCycles : 0;
+	}
+
+	uint64 ToMicroseconds(uint64 cycles)
+	{
+		return (uint64)(FPlatformTime::ToMilliseconds64(cycles) * 1000.0);
+	}
+
+	FString GetTypeName(int32 packetType)
+	{
+		const FString typeName = UULSFunctionLibrary::GetPacketNameByType(packetType);
+		return typeName.IsEmpty() ? FString::Printf(TEXT("Type %d"), packetType) : typeName;
+	}
+
+	void WriteCsvInterval()
+	{
+		const bool bNewFile = CsvPath.IsEmpty();
+		if (bNewFile)
+		{
+			CsvPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Profiling"), TEXT("ULS"), TEXT("Latency-") + FDateTime::Now().ToString() + TEXT(".csv"));
+		}
+
+		FString csv = bNewFile ? TEXT("Time,PacketType,Stage,Count,P50Us,P99Us,P999Us,MaxUs\n") : FString();
+		const FString time = FDateTime::UtcNow().ToIso8601();
+		for (int32 packetType = 0; packetType < MaxPacketTypes; packetType++)
+		{
+			FPacketTypeLatency* latency = PacketTypes[packetType].Get();
+			if (latency == nullptr || latency->Interval[(int32)EULSLatencyStage::Total].GetCount() == 0)
+			{
+				continue;
+			}
+
+			const FString typeName = GetTypeName(packetType);
+			for (int32 stage = 0; stage < NumStages; stage++)
+			{
+				FULSLatencyHistogram& histogram = latency->Interval[stage];
+				csv += FString::Printf(TEXT("%s,%s,%s,%llu,%llu,%llu,%llu,%llu\n"), *time, *typeName, StageNames[stage], histogram.GetCount(),
+					histogram.GetPercentile(50.0), histogram.GetPercentile(99.0), histogram.GetPercentile(99.9), histogram.GetMax());
+				histogram.Reset();
+			}
+		}
+
+		if (csv.IsEmpty() == false &&
+			FFileHelper::SaveStringToFile(csv, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append) == false)
+		{
+			UE_LOG(LogULS, Warning, TEXT("FULSLatencyStats: Failed to write %s"), *CsvPath);
+		}
+	}
+
+	FAutoConsoleCommand LatencyDumpCommand(TEXT("uls.Latency.Dump"),
+		TEXT("Logs p50 / p99 / p999 of every stage of every inbound packet type, in microseconds."),
+		FConsoleCommandDelegate::CreateStatic(&FULSLatencyStats::Dump));
+
+	FAutoConsoleCommand LatencyResetCommand(TEXT("uls.Latency.Reset"),
+		TEXT("Clears the latency histograms."),
+		FConsoleCommandDelegate::CreateStatic(&FULSLatencyStats::Reset));
+}
+
+bool FULSLatencyStats::IsEnabled()
+{
+	return GLatencyEnabled;
+}
+
+void FULSLatencyStats::RecordPacket(int32 packetType, uint64 receiveCycles, uint64 decodeStartCycles, uint64 decodedCycles,
+	uint64 onRepCycles, uint64 appliedCycles)
+{
+	const int32 index = FMath::Clamp(packetType & UULSWirePacket::PacketTypeMask, 0, MaxPacketTypes - 1);
+	TUniquePtr<FPacketTypeLatency>& latency = PacketTypes[index];
+	if (latency.IsValid() == false)
+	{
+		latency = MakeUnique<FPacketTypeLatency>();
+	}
+
+	const uint64 applyCycles = CyclesBetween(decodedCycles, appliedCycles);
+	const uint64 microseconds[NumStages] =
+	{
+		ToMicroseconds(CyclesBetween(receiveCycles, decodeStartCycles)),
+		ToMicroseconds(CyclesBetween(decodeStartCycles, decodedCycles)),
+		ToMicroseconds(applyCycles - FMath::Min(onRepCycles, applyCycles)),
+		ToMicroseconds(onRepCycles),
+		ToMicroseconds(CyclesBetween(receiveCycles, appliedCycles)),
+	};
+
+	const bool bInterval = GLatencyCsvInterval > 0;
+	for (int32 stage = 0; stage < NumStages; stage++)
+	{
+		latency->Total[stage].Record(microseconds[stage]);
+		if (bInterval)
+		{
+			latency->Interval[stage].Record(microseconds[stage]);
+		}
+	}
+}
+
+void FULSLatencyStats::Tick()
+{
+	if (GLatencyCsvInterval <= 0)
+	{
+		return;
+	}
+
+	const double now = FPlatformTime::Seconds();
+	if (LastCsvTime == 0)
+	{
+		LastCsvTime = now;
+	}
+	else if (now - LastCsvTime >= GLatencyCsvInterval)
+	{
+		LastCsvTime = now;
+		WriteCsvInterval();
+	}
+}
+
+void FULSLatencyStats::Reset()
+{
+	for (TUniquePtr<FPacketTypeLatency>& latency : PacketTypes)
+	{
+		latency.Reset();
+	}
+}
+
+void FULSLatencyStats::Dump()
+{
+	UE_LOG(LogULS, Display, TEXT("Inbound latency in microseconds (count, p50, p99, p999, max):"));
+	for (int32 packetType = 0; packetType < MaxPacketTypes; packetType++)
+	{
+		const FPacketTypeLatency* latency = PacketTypes[packetType].Get();
+		if (latency == nullptr)
+		{
+			continue;
+		}
+
+		UE_LOG(LogULS, Display, TEXT("  %s"), *GetTypeName(packetType));
+		for (int32 stage = 0; stage < NumStages; stage++)
+		{
+			const FULSLatencyHistogram& histogram = latency->Total[stage];
+			UE_LOG(LogULS, Display, TEXT("    %-8s %10llu %10llu %10llu %10llu %10llu"), StageNames[stage], histogram.GetCount(),
+				histogram.GetPercentile(50.0), histogram.GetPercentile(99.0), histogram.GetPercentile(99.9), histogram.GetMax());
+		}
+	}
+}
+
+const FULSLatencyHistogram* FULSLatencyStats::GetHistogram(int32 packetType, EULSLatencyStage stage)
+{
+	const int32 index = FMath::Clamp(packetType & UULSWirePacket::PacketTypeMask, 0, MaxPacketTypes - 1);
+	if (PacketTypes[index].IsValid() == false || stage >= EULSLatencyStage::Count)
+	{
+		return nullptr;
+	}
+	return &PacketTypes[index]->Total[(int32)stage];
+}
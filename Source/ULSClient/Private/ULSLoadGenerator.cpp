@@ -0,0 +1,840 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSLoadGenerator.h"
+#include "ULSLoadServer.h"
+#include "ULSLoadLink.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSPacketWriter.h"
+#include "ULSStats.h"
+#include "WireCore/ULSWireReader.h"
+#include "HAL/RunnableThread.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "WebSocketsModule.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	constexpr double ConnectTimeoutSeconds = 10.0;
+	constexpr double DisconnectDrainSeconds = 5.0;
+
+	uint64 ToMicroseconds(uint64 cycles)
+	{
+		return (uint64)(FPlatformTime::ToMilliseconds64(cycles) * 1000.0);
+	}
+
+	bool ParseCount(const FString& token, int32& outValue)
+	{
+		if (token.IsNumeric() == false)
+		{
+			return false;
+		}
+		outValue = FCString::Atoi(*token);
+		return outValue >= 0;
+	}
+}
+
+// Script
+
+bool FULSLoadScript::Parse(const FString& text, FULSLoadScript& outScript, FString& outError)
+{
+	outScript.Steps.Reset();
+
+	TArray<FString> lines;
+	text.Replace(TEXT("\n"), TEXT(";")).ParseIntoArray(lines, TEXT(";"), true);
+	for (FString& line : lines)
+	{
+		line.TrimStartAndEndInline();
+		if (line.IsEmpty() || line.StartsWith(TEXT("#")))
+		{
+			continue;
+		}
+
+		TArray<FString> tokens;
+		line.ParseIntoArrayWS(tokens);
+
+		FULSLoadStep step;
+		bool bValid = true;
+		if (tokens[0] == TEXT("connect"))
+		{
+			step.Type = EULSLoadStep::Connect;
+		}
+		else if (tokens[0] == TEXT("rpc"))
+		{
+			step.Type = EULSLoadStep::Rpc;
+			bValid = (tokens.Num() == 3 || tokens.Num() == 4) &&
+				ParseCount(tokens[1], step.Count) && ParseCount(tokens[2], step.Milliseconds) &&
+				(tokens.Num() == 3 || ParseCount(tokens[3], step.PayloadBytes));
+		}
+		else if (tokens[0] == TEXT("idle"))
+		{
+			step.Type = EULSLoadStep::Idle;
+			bValid = tokens.Num() == 2 && ParseCount(tokens[1], step.Milliseconds);
+		}
+		else if (tokens[0] == TEXT("disconnect"))
+		{
+			step.Type = EULSLoadStep::Disconnect;
+		}
+		else
+		{
+			outError = FString::Printf(TEXT("Unknown step \"%s\""), *line);
+			return false;
+		}
+
+		if (bValid == false)
+		{
+			outError = FString::Printf(TEXT("Invalid arguments in \"%s\""), *line);
+			return false;
+		}
+		outScript.Steps.Add(step);
+	}
+
+	if (outScript.Steps.Num() == 0)
+	{
+		outError = TEXT("The script has no steps");
+		return false;
+	}
+	return true;
+}
+
+// Stats
+
+void FULSLoadSessionStats::Add(const FULSLoadSessionStats& other)
+{
+	bConnected |= other.bConnected;
+	ConnectMicroseconds = FMath::Max(ConnectMicroseconds, other.ConnectMicroseconds);
+	ActiveSeconds = FMath::Max(ActiveSeconds, other.ActiveSeconds);
+
+	PacketsSent += other.PacketsSent;
+	BytesSent += other.BytesSent;
+	PacketsReceived += other.PacketsReceived;
+	BytesReceived += other.BytesReceived;
+	FieldsDecoded += other.FieldsDecoded;
+	RpcsSent += other.RpcsSent;
+	RpcsAnswered += other.RpcsAnswered;
+	DecodeCycles += other.DecodeCycles;
+
+	RpcLatency.Add(other.RpcLatency);
+	PingLatency.Add(other.PingLatency);
+	DeliveryLatency.Add(other.DeliveryLatency);
+}
+
+// Session
+
+/* One scripted client. Only touched by the worker thread that runs it, until the workers have exited. */
+class FULSLoadSession
+{
+public:
+	FULSLoadSession(int32 index, const FULSLoadSettings& settings, FULSLoadServer* server, double startTime)
+		: Index(index)
+		, Settings(settings)
+		, Server(server)
+		, StartTime(startTime)
+	{
+	}
+
+	/* Handles what was received and advances the script. Returns the number of packets handled. */
+	int32 Tick(double now);
+
+	/* Ends the session where it is, for sessions still running when the load test is stopped */
+	void Stop(double now);
+
+	bool IsFinished() const { return bFinished; }
+
+	FULSLoadSessionStats Stats;
+
+private:
+	void RunScript(double now);
+
+	void NextStep(double now);
+
+	void Finish(double now);
+
+	void Close();
+
+	void HandleFrame(const FULSLoadFrame& frame);
+
+	/* Reads the fields of a Replication packet the way the network owner does, without applying them */
+	int32 DecodeReplication(const ULSWire::FWireReader& reader) const;
+
+	void Send(const FULSPacketWriter& writer);
+
+	void SendConnectionRequest();
+
+	void SendRpc(int32 payloadBytes);
+
+	void SendPing();
+
+	const int32 Index;
+	const FULSLoadSettings& Settings;
+	/* SelfTest only */
+	FULSLoadServer* Server;
+	const double StartTime;
+
+	TUniquePtr<FULSLoadLink> Link;
+	bool bRequestSent = false;
+	bool bOnline = false;
+	bool bConnectRefused = false;
+	uint64 ConnectStartCycles = 0;
+
+	int32 StepIndex = INDEX_NONE;
+	int32 StepCounter = 0;
+	double NextActionTime = 0;
+	double StepEndTime = 0;
+	bool bFinished = false;
+
+	/*
+	* Send stamps of the RpcCalls waiting for their response, by the call number in the low half of the
+	* call's unique id. Answers echo the call, so they are matched in whatever order they arrive.
+	*/
+	TMap<uint32, uint64> PendingRpcCycles;
+	uint32 NextRpcNumber = 0;
+
+	FString RpcParameter;
+};
+
+int32 FULSLoadSession::Tick(double now)
+{
+	if (bFinished || now < StartTime)
+	{
+		return 0;
+	}
+
+	int32 numHandled = 0;
+	if (Link.IsValid())
+	{
+		Link->Tick(now);
+
+		FULSLoadFrame frame;
+		while (Link.IsValid() && Link->Receive(frame))
+		{
+			HandleFrame(frame);
+			numHandled++;
+		}
+
+		// The link logged why
+		if (bOnline && Link.IsValid() && Link->HasFailed())
+		{
+			Close();
+		}
+	}
+
+	if (StepIndex == INDEX_NONE)
+	{
+		NextStep(now);
+	}
+	RunScript(now);
+
+	return numHandled;
+}
+
+void FULSLoadSession::Stop(double now)
+{
+	if (bFinished == false)
+	{
+		Finish(now);
+	}
+}
+
+void FULSLoadSession::RunScript(double now)
+{
+	const TArray<FULSLoadStep>& steps = Settings.Script.Steps;
+	while (StepIndex < steps.Num())
+	{
+		const FULSLoadStep& step = steps[StepIndex];
+		switch (step.Type)
+		{
+		case EULSLoadStep::Connect:
+			if (Link.IsValid() == false)
+			{
+				ConnectStartCycles = FPlatformTime::Cycles64();
+				bRequestSent = false;
+				Link = FULSLoadLink::Create(Settings, Server, Index);
+				Link->Open();
+			}
+			if (bRequestSent == false && Link->IsOpen())
+			{
+				SendConnectionRequest();
+				bRequestSent = true;
+			}
+			if (bOnline == false)
+			{
+				if (Link->HasFailed())
+				{
+					Finish(now);
+				}
+				else if (bConnectRefused || now - NextActionTime >= ConnectTimeoutSeconds)
+				{
+					UE_LOG(LogULS, Warning, TEXT("FULSLoadSession %d: %s"), Index, bConnectRefused ? TEXT("Connection refused") : TEXT("Connection timed out"));
+					Finish(now);
+				}
+				return;
+			}
+			break;
+
+		case EULSLoadStep::Rpc:
+			// Steps that need a connection are skipped without one
+			if (bOnline)
+			{
+				while (StepCounter < step.Count && now >= NextActionTime)
+				{
+					SendRpc(step.PayloadBytes);
+					StepCounter++;
+					NextActionTime += step.Milliseconds / 1000.0;
+				}
+				if (StepCounter < step.Count)
+				{
+					return;
+				}
+			}
+			break;
+
+		case EULSLoadStep::Idle:
+			if (now < StepEndTime)
+			{
+				if (bOnline && now >= NextActionTime)
+				{
+					SendPing();
+					NextActionTime = now + Settings.PingIntervalMs / 1000.0;
+				}
+				return;
+			}
+			break;
+
+		case EULSLoadStep::Disconnect:
+			if (bOnline && PendingRpcCycles.Num() > 0 && now < StepEndTime)
+			{
+				return;
+			}
+			Close();
+			break;
+		}
+
+		NextStep(now);
+	}
+
+	Finish(now);
+}
+
+void FULSLoadSession::NextStep(double now)
+{
+	StepIndex++;
+	StepCounter = 0;
+	NextActionTime = now;
+
+	const TArray<FULSLoadStep>& steps = Settings.Script.Steps;
+	if (steps.IsValidIndex(StepIndex))
+	{
+		StepEndTime = now + (steps[StepIndex].Type == EULSLoadStep::Disconnect ? DisconnectDrainSeconds : steps[StepIndex].Milliseconds / 1000.0);
+	}
+}
+
+void FULSLoadSession::Finish(double now)
+{
+	Close();
+	bFinished = true;
+	Stats.ActiveSeconds = now - StartTime;
+}
+
+void FULSLoadSession::Close()
+{
+	if (Link.IsValid())
+	{
+		Link->Close();
+		Link.Reset();
+	}
+
+	// Calls without an answer stay counted in RpcsSent only
+	bOnline = false;
+	PendingRpcCycles.Reset();
+}
+
+void FULSLoadSession::HandleFrame(const FULSLoadFrame& frame)
+{
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	Stats.PacketsReceived++;
+	Stats.BytesReceived += frame.Bytes.Num();
+
+	ULSWire::FWireHeader header;
+	if (ULSWire::ParseHeader(frame.Bytes.GetData(), frame.Bytes.Num(), header) == false)
+	{
+		return;
+	}
+
+	const ULSWire::FWireReader reader(frame.Bytes.GetData() + header.PayloadOffset, frame.Bytes.Num() - header.PayloadOffset);
+	int position = 0;
+
+	switch (header.PacketType)
+	{
+	case EWirePacketType::ConnectionResponse:
+		if (reader.Read<int8>(position, position) == 1)
+		{
+			bOnline = true;
+			Stats.bConnected = true;
+			Stats.ConnectMicroseconds = ToMicroseconds(startCycles - ConnectStartCycles);
+		}
+		else
+		{
+			bConnectRefused = true;
+		}
+		break;
+
+	case EWirePacketType::Replication:
+		Stats.FieldsDecoded += DecodeReplication(reader);
+		break;
+
+	case EWirePacketType::RpcCallResponse:
+	{
+		// Flags, then the unique id the call was sent with
+		reader.Read<int32>(position, position);
+		const uint32 rpcNumber = (uint32)reader.Read<int64>(position, position);
+		uint64 sendCycles = 0;
+		if (PendingRpcCycles.RemoveAndCopyValue(rpcNumber, sendCycles))
+		{
+			Stats.RpcLatency.Record(ToMicroseconds(startCycles - sendCycles));
+			Stats.RpcsAnswered++;
+		}
+	}
+	break;
+
+	case EWirePacketType::Pong:
+	{
+		const double sendTime = reader.Read<double>(position, position);
+		Stats.PingLatency.Record((uint64)FMath::Max((FPlatformTime::Seconds() - sendTime) * 1000000.0, 0.0));
+	}
+	break;
+
+	case EWirePacketType::ConnectionEnd:
+		Close();
+		break;
+
+	default:
+		break;
+	}
+
+	const uint64 endCycles = FPlatformTime::Cycles64();
+	Stats.DecodeCycles += endCycles - startCycles;
+	Stats.DeliveryLatency.Record(endCycles > frame.SendCycles ? ToMicroseconds(endCycles - frame.SendCycles) : 0);
+}
+
+int32 FULSLoadSession::DecodeReplication(const ULSWire::FWireReader& reader) const
+{
+	int position = 0;
+	reader.Read<int32>(position, position);		// Flags
+	reader.Read<int64>(position, position);		// Unique id
+	const int32 numFields = reader.Read<int32>(position, position);
+
+	int32 numDecoded = 0;
+	for (; numDecoded < numFields; numDecoded++)
+	{
+		const int startPosition = position;
+		const int8 fieldType = reader.Read<int8>(position, position);
+
+		int32 nameLength;
+		if (reader.ReadString(position, position, nameLength) == nullptr)
+		{
+			break;
+		}
+
+		switch (fieldType)
+		{
+		case EReplicatedFieldType::Reference:
+			reader.Read<int64>(position, position);
+			break;
+
+		case EReplicatedFieldType::PrimitiveInt:
+		case EReplicatedFieldType::PrimitiveFloat:
+		{
+			const int32 size = reader.Read<int32>(position, position);
+			reader.ReadDataPtr(size, position, position);
+		}
+		break;
+
+		case EReplicatedFieldType::String:
+		{
+			int32 length;
+			reader.ReadString(position, position, length);
+		}
+		break;
+
+		case EReplicatedFieldType::Vector3:
+			reader.ReadDataPtr(3 * sizeof(float), position, position);
+			break;
+		}
+
+		if (position == startPosition)
+		{
+			break;
+		}
+	}
+	return numDecoded;
+}
+
+void FULSLoadSession::Send(const FULSPacketWriter& writer)
+{
+	if (Link.IsValid() == false)
+	{
+		return;
+	}
+
+	Stats.PacketsSent++;
+	Stats.BytesSent += writer.GetBytes().Num();
+	Link->Send(writer.GetBytes());
+}
+
+void FULSLoadSession::SendConnectionRequest()
+{
+	// Takes the place of the player's unique net id
+	FULSPacketWriter writer(EWirePacketType::ConnectionRequest);
+	writer.WriteString(FString::Printf(TEXT("LoadSession-%d"), Index));
+	Send(writer);
+}
+
+void FULSLoadSession::SendRpc(int32 payloadBytes)
+{
+	if (RpcParameter.Len() != payloadBytes)
+	{
+		RpcParameter = FString::ChrN(payloadBytes, TEXT('x'));
+	}
+
+	FULSPacketWriter writer(EWirePacketType::RpcCall, 64 + payloadBytes);
+	writer.WriteInt32(1 << 0); // FullReflection
+	const uint32 rpcNumber = NextRpcNumber++;
+	writer.WriteInt64(((int64)Index << 32) | rpcNumber);
+	writer.WriteString(TEXT("LoadTestRpc"));
+	writer.WriteString(FString());
+	writer.WriteInt32(1);
+	writer.WriteField(FULSReplicatedField::String(TEXT("payload"), RpcParameter));
+
+	// Stamped first, the self-test stand-in answers while the call is sent
+	PendingRpcCycles.Add(rpcNumber, FPlatformTime::Cycles64());
+	Stats.RpcsSent++;
+	Send(writer);
+}
+
+void FULSLoadSession::SendPing()
+{
+	FULSPacketWriter writer(EWirePacketType::Ping, sizeof(double));
+	writer.WriteFloat64(FPlatformTime::Seconds());
+	Send(writer);
+}
+
+// Worker
+
+/* Runs a fixed set of sessions, and decodes everything they receive */
+class FULSLoadWorker : public FRunnable
+{
+public:
+	FULSLoadWorker(int32 index, TArray<FULSLoadSession*>&& sessions)
+		: Index(index)
+		, Sessions(MoveTemp(sessions))
+	{
+	}
+
+	virtual ~FULSLoadWorker()
+	{
+		Shutdown();
+	}
+
+	bool Start()
+	{
+		bRunning = true;
+		Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("ULSLoadWorker%d"), Index), 0, TPri_Normal);
+		bRunning = Thread != nullptr;
+		return bRunning;
+	}
+
+	/* Blocks until the thread has exited */
+	void Shutdown()
+	{
+		bStopping = true;
+
+		if (Thread != nullptr)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+			Thread = nullptr;
+		}
+	}
+
+	bool IsRunning() const { return bRunning; }
+
+	int32 GetNumActiveSessions() const { return NumActiveSessions; }
+
+	// FRunnable
+	virtual uint32 Run() override
+	{
+		LLM_SCOPE_BYTAG(ULS);
+
+		while (!bStopping)
+		{
+			const double now = FPlatformTime::Seconds();
+			int32 numHandled = 0;
+			int32 numActive = 0;
+			for (FULSLoadSession* session : Sessions)
+			{
+				numHandled += session->Tick(now);
+				numActive += session->IsFinished() ? 0 : 1;
+			}
+
+			NumActiveSessions = numActive;
+			if (numActive == 0)
+			{
+				break;
+			}
+
+			// Only yields when idle, so busy workers don't add a sleep to every latency they measure
+			if (numHandled == 0)
+			{
+				FPlatformProcess::SleepNoStats(0.0002f);
+			}
+		}
+
+		const double now = FPlatformTime::Seconds();
+		for (FULSLoadSession* session : Sessions)
+		{
+			session->Stop(now);
+		}
+
+		NumActiveSessions = 0;
+		bRunning = false;
+		return 0;
+	}
+
+	virtual void Stop() override { bStopping = true; }
+
+private:
+	const int32 Index;
+	TArray<FULSLoadSession*> Sessions;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping { false };
+	std::atomic<bool> bRunning { false };
+	std::atomic<int32> NumActiveSessions { 0 };
+};
+
+// Generator
+
+FULSLoadGenerator::FULSLoadGenerator(const FULSLoadSettings& settings)
+	: Settings(settings)
+{
+	Settings.NumSessions = FMath::Max(Settings.NumSessions, 1);
+	Settings.NumWorkers = FMath::Clamp(Settings.NumWorkers, 1, Settings.NumSessions);
+}
+
+FULSLoadGenerator::~FULSLoadGenerator()
+{
+	// Workers reference the sessions, and sessions the server
+	Workers.Reset();
+	Sessions.Reset();
+	Server.Reset();
+}
+
+void FULSLoadGenerator::Run()
+{
+	check(IsInGameThread());
+
+	if (Settings.Transport == EULSLoadTransport::SelfTest)
+	{
+		Server = MakeUnique<FULSLoadServer>(Settings.ReplicationRate, Settings.ObjectsPerSession);
+		if (Server->Start() == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("FULSLoadGenerator: Failed to start the server stand-in"));
+			return;
+		}
+	}
+	else if (Settings.Transport == EULSLoadTransport::WebSocket)
+	{
+		FModuleManager::LoadModuleChecked<FWebSocketsModule>(TEXT("WebSockets"));
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+
+	TArray<TArray<FULSLoadSession*>> assignments;
+	assignments.SetNum(Settings.NumWorkers);
+	for (int32 sessionIndex = 0; sessionIndex < Settings.NumSessions; sessionIndex++)
+	{
+		const double sessionStartTime = startTime + Settings.RampUpSeconds * sessionIndex / Settings.NumSessions;
+		Sessions.Add(MakeUnique<FULSLoadSession>(sessionIndex, Settings, Server.Get(), sessionStartTime));
+		assignments[sessionIndex % Settings.NumWorkers].Add(Sessions.Last().Get());
+	}
+
+	const TCHAR* transportNames[] = { TEXT("WebSocket"), TEXT("TCP"), TEXT("UDP"), TEXT("self-test") };
+	if (Settings.Transport == EULSLoadTransport::SelfTest)
+	{
+		UE_LOG(LogULS, Display, TEXT("FULSLoadGenerator: Running %d sessions on %d workers against the in-process stand-in"), Settings.NumSessions, Settings.NumWorkers);
+	}
+	else
+	{
+		UE_LOG(LogULS, Display, TEXT("FULSLoadGenerator: Running %d sessions on %d workers against %s:%d over %s"),
+			Settings.NumSessions, Settings.NumWorkers, *Settings.Host, Settings.Port, transportNames[(int32)Settings.Transport]);
+	}
+
+	for (int32 workerIndex = 0; workerIndex < Settings.NumWorkers; workerIndex++)
+	{
+		Workers.Add(MakeUnique<FULSLoadWorker>(workerIndex, MoveTemp(assignments[workerIndex])));
+		if (Workers.Last()->Start() == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("FULSLoadGenerator: Failed to start worker %d"), workerIndex);
+		}
+	}
+
+	bool bStopRequested = false;
+	double nextProgressTime = startTime + 5.0;
+	double lastPumpTime = startTime;
+	while (true)
+	{
+		PumpGameThread(lastPumpTime);
+
+		int32 numRunning = 0;
+		int32 numActive = 0;
+		for (const TUniquePtr<FULSLoadWorker>& worker : Workers)
+		{
+			numRunning += worker->IsRunning() ? 1 : 0;
+			numActive += worker->GetNumActiveSessions();
+		}
+		if (numRunning == 0)
+		{
+			break;
+		}
+
+		const double now = FPlatformTime::Seconds();
+		if (bStopRequested == false && now - startTime >= Settings.MaxSeconds)
+		{
+			UE_LOG(LogULS, Warning, TEXT("FULSLoadGenerator: Stopping %d sessions after %.0f seconds"), numActive, Settings.MaxSeconds);
+			for (const TUniquePtr<FULSLoadWorker>& worker : Workers)
+			{
+				worker->Stop();
+			}
+			bStopRequested = true;
+		}
+		if (now >= nextProgressTime)
+		{
+			UE_LOG(LogULS, Display, TEXT("FULSLoadGenerator: %.0f s, %d sessions active"), now - startTime, numActive);
+			nextProgressTime += 5.0;
+		}
+
+		// WebSocket events are raised on this thread, don't hold them back longer than a worker would
+		FPlatformProcess::Sleep(Settings.Transport == EULSLoadTransport::WebSocket ? 0.001f : 0.05f);
+	}
+
+	for (const TUniquePtr<FULSLoadWorker>& worker : Workers)
+	{
+		worker->Shutdown();
+	}
+	ElapsedSeconds = FPlatformTime::Seconds() - startTime;
+	if (Server.IsValid())
+	{
+		Server->Shutdown();
+	}
+
+	// Closes posted by the sessions
+	PumpGameThread(lastPumpTime);
+
+	SessionStats.Reset(Sessions.Num());
+	for (const TUniquePtr<FULSLoadSession>& session : Sessions)
+	{
+		SessionStats.Add(session->Stats);
+	}
+}
+
+void FULSLoadGenerator::PumpGameThread(double& lastPumpTime)
+{
+	const double now = FPlatformTime::Seconds();
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+	FTSTicker::GetCoreTicker().Tick((float)(now - lastPumpTime));
+	lastPumpTime = now;
+}
+
+FULSLoadSessionStats FULSLoadGenerator::GetAggregateStats() const
+{
+	FULSLoadSessionStats total;
+	for (const FULSLoadSessionStats& stats : SessionStats)
+	{
+		total.Add(stats);
+	}
+	return total;
+}
+
+void FULSLoadGenerator::LogReport() const
+{
+	const FULSLoadSessionStats total = GetAggregateStats();
+	const double seconds = FMath::Max(ElapsedSeconds, 0.001);
+
+	FULSLatencyHistogram connectLatency;
+	for (const FULSLoadSessionStats& stats : SessionStats)
+	{
+		if (stats.bConnected)
+		{
+			connectLatency.Record(stats.ConnectMicroseconds);
+		}
+	}
+
+	UE_LOG(LogULS, Display, TEXT("ULS load test: %d sessions, %llu connected, %.1f s"), SessionStats.Num(), connectLatency.GetCount(), ElapsedSeconds);
+	UE_LOG(LogULS, Display, TEXT("  Sent      %10lld packets %10.0f/s %10.2f MB %8.2f MB/s"),
+		total.PacketsSent, total.PacketsSent / seconds, total.BytesSent / (1024.0 * 1024.0), total.BytesSent / (1024.0 * 1024.0) / seconds);
+	UE_LOG(LogULS, Display, TEXT("  Received  %10lld packets %10.0f/s %10.2f MB %8.2f MB/s"),
+		total.PacketsReceived, total.PacketsReceived / seconds, total.BytesReceived / (1024.0 * 1024.0), total.BytesReceived / (1024.0 * 1024.0) / seconds);
+	UE_LOG(LogULS, Display, TEXT("  Decoded   %10lld fields, %.3f us per packet"),
+		total.FieldsDecoded, FPlatformTime::ToMilliseconds64(total.DecodeCycles) * 1000.0 / FMath::Max<int64>(total.PacketsReceived, 1));
+	UE_LOG(LogULS, Display, TEXT("  RPCs      %10lld sent, %lld answered"), total.RpcsSent, total.RpcsAnswered);
+
+	UE_LOG(LogULS, Display, TEXT("  Latency in microseconds    count        p50        p99       p999        max"));
+	const TPair<const TCHAR*, const FULSLatencyHistogram*> histograms[] =
+	{
+		{ TEXT("Connect"), &connectLatency },
+		{ TEXT("Rpc"), &total.RpcLatency },
+		{ TEXT("Ping"), &total.PingLatency },
+		{ TEXT("Delivery"), &total.DeliveryLatency },
+	};
+	for (const TPair<const TCHAR*, const FULSLatencyHistogram*>& entry : histograms)
+	{
+		const FULSLatencyHistogram& histogram = *entry.Value;
+		UE_LOG(LogULS, Display, TEXT("    %-20s %10llu %10llu %10llu %10llu %10llu"), entry.Key, histogram.GetCount(),
+			histogram.GetPercentile(50.0), histogram.GetPercentile(99.0), histogram.GetPercentile(99.9), histogram.GetMax());
+	}
+
+	for (int32 sessionIndex = 0; sessionIndex < SessionStats.Num(); sessionIndex++)
+	{
+		const FULSLoadSessionStats& stats = SessionStats[sessionIndex];
+		UE_LOG(LogULS, Log, TEXT("  Session %5d: %s, connect %llu us, sent %lld, received %lld packets in %.1f s, rpc p50 %llu p99 %llu us, delivery p99 %llu us"),
+			sessionIndex, stats.bConnected ? TEXT("connected") : TEXT("failed"), stats.ConnectMicroseconds, stats.PacketsSent, stats.PacketsReceived,
+			stats.ActiveSeconds, stats.RpcLatency.GetPercentile(50.0), stats.RpcLatency.GetPercentile(99.0), stats.DeliveryLatency.GetPercentile(99.0));
+	}
+}
+
+bool FULSLoadGenerator::WriteCsv(const FString& path) const
+{
+	FString csv = TEXT("Session,Connected,ConnectUs,ActiveSeconds,PacketsSent,BytesSent,PacketsReceived,BytesReceived,ReceivedPerSecond,")
+		TEXT("FieldsDecoded,RpcsSent,RpcsAnswered,RpcP50Us,RpcP99Us,PingP50Us,PingP99Us,DeliveryP50Us,DeliveryP99Us,DeliveryP999Us,DecodeUsPerPacket\n");
+
+	auto appendRow = [&csv](const FString& name, const FULSLoadSessionStats& stats, double seconds)
+	{
+		csv += FString::Printf(TEXT("%s,%d,%llu,%.3f,%lld,%lld,%lld,%lld,%.1f,%lld,%lld,%lld,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f\n"),
+			*name, stats.bConnected ? 1 : 0, stats.ConnectMicroseconds, seconds,
+			stats.PacketsSent, stats.BytesSent, stats.PacketsReceived, stats.BytesReceived, stats.PacketsReceived / FMath::Max(seconds, 0.001),
+			stats.FieldsDecoded, stats.RpcsSent, stats.RpcsAnswered,
+			stats.RpcLatency.GetPercentile(50.0), stats.RpcLatency.GetPercentile(99.0),
+			stats.PingLatency.GetPercentile(50.0), stats.PingLatency.GetPercentile(99.0),
+			stats.DeliveryLatency.GetPercentile(50.0), stats.DeliveryLatency.GetPercentile(99.0), stats.DeliveryLatency.GetPercentile(99.9),
+			FPlatformTime::ToMilliseconds64(stats.DecodeCycles) * 1000.0 / FMath::Max<int64>(stats.PacketsReceived, 1));
+	};
+
+	for (int32 sessionIndex = 0; sessionIndex < SessionStats.Num(); sessionIndex++)
+	{
+		appendRow(FString::FromInt(sessionIndex), SessionStats[sessionIndex], SessionStats[sessionIndex].ActiveSeconds);
+	}
+	appendRow(TEXT("Total"), GetAggregateStats(), ElapsedSeconds);
+
+	const FString fullPath = FPaths::IsRelative(path) ? FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir(), path) : path;
+	if (FFileHelper::SaveStringToFile(csv, *fullPath) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSLoadGenerator: Failed to write %s"), *fullPath);
+		return false;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("FULSLoadGenerator: Wrote %d sessions to %s"), SessionStats.Num(), *fullPath);
+	return true;
+}
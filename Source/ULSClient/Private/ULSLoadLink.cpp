@@ -0,0 +1,470 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSLoadLink.h"
+#include "ULSLoadGenerator.h"
+#include "ULSTcpConnection.h"
+#include "ULSReliableEndpoint.h"
+#include "ULSWebSocketTransport.h"
+#include "ULSStats.h"
+#include "Async/Async.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include <atomic>
+
+namespace
+{
+	constexpr float TcpConnectTimeout = 5.0f;
+	constexpr int32 TcpMaxFrameSize = 64 * 1024 * 1024;
+	constexpr double UdpConnectRetryInterval = 0.25;
+	constexpr double UdpConnectTimeout = 5.0;
+	constexpr double UdpIdleTimeout = 10.0;
+
+	/* Session and in-process stand-in exchange frames through queues, no sockets involved */
+	class FULSLoadSelfTestLink final : public FULSLoadLink
+	{
+	public:
+		FULSLoadSelfTestLink(FULSLoadServer& server, int32 sessionIndex)
+			: Server(server)
+			, SessionIndex(sessionIndex)
+		{
+		}
+
+		virtual ~FULSLoadSelfTestLink() { Close(); }
+
+		virtual void Open() override { Connection = Server.Open(SessionIndex); }
+
+		virtual bool IsOpen() const override { return Connection.IsValid(); }
+
+		virtual bool HasFailed() const override { return false; }
+
+		virtual void Send(TConstArrayView<uint8> bytes) override
+		{
+			if (Connection.IsValid())
+			{
+				Server.HandleClientBytes(*Connection, bytes);
+			}
+		}
+
+		virtual bool Receive(FULSLoadFrame& outFrame) override
+		{
+			return Connection.IsValid() && Connection->ToClient.Dequeue(outFrame);
+		}
+
+		virtual void Close() override
+		{
+			if (Connection.IsValid())
+			{
+				Server.Close(Connection.ToSharedRef());
+				Connection.Reset();
+			}
+		}
+
+	private:
+		FULSLoadServer& Server;
+		const int32 SessionIndex;
+		TSharedPtr<FULSLoadConnection, ESPMode::ThreadSafe> Connection;
+	};
+
+	/* Length prefixed frames over FULSTcpConnection, which runs an I/O thread per link */
+	class FULSLoadTcpLink final : public FULSLoadLink
+	{
+	public:
+		FULSLoadTcpLink(const FULSLoadSettings& settings, int32 sessionIndex)
+			: SessionIndex(sessionIndex)
+			, InboundQueue(MakeShared<FULSInboundQueue, ESPMode::ThreadSafe>())
+			, OutboundQueue(MakeShared<FULSOutboundQueue, ESPMode::ThreadSafe>())
+		{
+			TcpSettings.Host = settings.Host;
+			TcpSettings.Port = settings.Port;
+			TcpSettings.MaxFrameSize = TcpMaxFrameSize;
+			TcpSettings.ConnectTimeout = TcpConnectTimeout;
+		}
+
+		virtual ~FULSLoadTcpLink() { Close(); }
+
+		virtual void Open() override
+		{
+			Connection = MakeUnique<FULSTcpConnection>(TcpSettings, InboundQueue, OutboundQueue, nullptr);
+
+			// Raised on the I/O thread, which Close joins before the link goes away
+			Connection->OnConnected = [this](bool bSuccess, const FString& error)
+			{
+				if (bSuccess == false)
+				{
+					UE_LOG(LogULS, Warning, TEXT("FULSLoadSession %d: %s"), SessionIndex, *error);
+					bFailed = true;
+				}
+			};
+			Connection->OnClosed = [this](const FString& reason, bool bWasClean)
+			{
+				UE_LOG(LogULS, Warning, TEXT("FULSLoadSession %d: Connection closed (%s)"), SessionIndex, *reason);
+				bFailed = true;
+			};
+
+			if (Connection->Start() == false)
+			{
+				UE_LOG(LogULS, Warning, TEXT("FULSLoadSession %d: Failed to start the TCP I/O thread"), SessionIndex);
+				bFailed = true;
+			}
+		}
+
+		virtual bool IsOpen() const override { return Connection.IsValid() && Connection->IsConnected(); }
+
+		virtual bool HasFailed() const override { return bFailed; }
+
+		virtual void Send(TConstArrayView<uint8> bytes) override
+		{
+			if (Connection.IsValid())
+			{
+				Connection->Send(bytes);
+			}
+		}
+
+		virtual bool Receive(FULSLoadFrame& outFrame) override
+		{
+			FULSInboundFrame frame;
+			if (InboundQueue->Dequeue(frame) == false)
+			{
+				return false;
+			}
+			outFrame.Bytes = MoveTemp(frame.Bytes);
+			outFrame.SendCycles = frame.ReceiveCycles;
+			return true;
+		}
+
+		virtual void Close() override
+		{
+			if (Connection.IsValid())
+			{
+				Connection->Shutdown();
+				Connection.Reset();
+			}
+		}
+
+	private:
+		const int32 SessionIndex;
+		FULSTcpSettings TcpSettings;
+		TSharedRef<FULSInboundQueue, ESPMode::ThreadSafe> InboundQueue;
+		TSharedRef<FULSOutboundQueue, ESPMode::ThreadSafe> OutboundQueue;
+		TUniquePtr<FULSTcpConnection> Connection;
+		std::atomic<bool> bFailed { false };
+	};
+
+	/* Datagrams through FULSReliableEndpoint with the handshake of UULSUdpTransport, pumped by Tick */
+	class FULSLoadUdpLink final : public FULSLoadLink
+	{
+	public:
+		FULSLoadUdpLink(const FULSLoadSettings& settings, int32 sessionIndex)
+			: SessionIndex(sessionIndex)
+			, Host(settings.Host)
+			, Port(settings.Port)
+			, Mtu(settings.Mtu)
+		{
+		}
+
+		virtual ~FULSLoadUdpLink() { Close(); }
+
+		virtual void Open() override
+		{
+			ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+			FAddressInfoResult addressInfo = socketSubsystem->GetAddressInfo(*Host, nullptr, EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Datagram);
+			if (addressInfo.ReturnCode != SE_NO_ERROR || addressInfo.Results.Num() == 0)
+			{
+				Fail(FString::Printf(TEXT("Failed to resolve %s"), *Host));
+				return;
+			}
+
+			ServerAddress = addressInfo.Results[0].Address;
+			ServerAddress->SetPort(Port);
+			ReceiveAddress = socketSubsystem->CreateInternetAddr(ServerAddress->GetProtocolType());
+
+			Socket = socketSubsystem->CreateSocket(NAME_DGram, TEXT("ULSLoadUdpLink"), ServerAddress->GetProtocolType());
+			if (Socket == nullptr)
+			{
+				Fail(TEXT("Failed to create socket"));
+				return;
+			}
+			Socket->SetNonBlocking(true);
+			ReceiveBuffer.SetNumUninitialized(FMath::Max(Mtu, 2048));
+
+			Endpoint = MakeUnique<FULSReliableEndpoint>(Mtu);
+			Endpoint->OnSendDatagram = [this](TConstArrayView<uint8> datagram)
+			{
+				SendDatagram(datagram);
+			};
+			Endpoint->OnReceiveMessage = [this](EULSDeliveryChannel channel, TArray<uint8>&& message)
+			{
+				Frames.Enqueue(FULSLoadFrame{ MoveTemp(message), FPlatformTime::Cycles64() });
+			};
+
+			ConnectStartTime = FPlatformTime::Seconds();
+			LastConnectAttemptTime = ConnectStartTime;
+			SendControl(EULSDatagramKind::Connect);
+		}
+
+		virtual bool IsOpen() const override { return bAccepted && !bFailed; }
+
+		virtual bool HasFailed() const override { return bFailed; }
+
+		virtual void Tick(double now) override
+		{
+			if (Socket == nullptr)
+			{
+				return;
+			}
+
+			int32 bytesRead = 0;
+			while (Socket != nullptr && Socket->RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), bytesRead, *ReceiveAddress))
+			{
+				if (bytesRead <= 0 || !(*ReceiveAddress == *ServerAddress))
+				{
+					continue;
+				}
+
+				switch ((EULSDatagramKind)ReceiveBuffer[0])
+				{
+				case EULSDatagramKind::Accept:
+					bAccepted = true;
+					break;
+
+				case EULSDatagramKind::Disconnect:
+					Fail(TEXT("Closed by server"));
+					break;
+
+				case EULSDatagramKind::Data:
+					if (bAccepted)
+					{
+						Endpoint->ReceiveDatagram(TConstArrayView<uint8>(ReceiveBuffer.GetData(), bytesRead), now);
+					}
+					break;
+
+				default:
+					break;
+				}
+			}
+
+			if (Socket == nullptr)
+			{
+				return;
+			}
+
+			if (bAccepted == false)
+			{
+				if (now - ConnectStartTime > UdpConnectTimeout)
+				{
+					Fail(TEXT("Connection timed out"));
+				}
+				else if (now - LastConnectAttemptTime >= UdpConnectRetryInterval)
+				{
+					LastConnectAttemptTime = now;
+					SendControl(EULSDatagramKind::Connect);
+				}
+			}
+			else if (now - FMath::Max(Endpoint->GetLastReceiveTime(), ConnectStartTime) > UdpIdleTimeout)
+			{
+				Fail(TEXT("Connection timed out"));
+			}
+			else
+			{
+				Endpoint->Update(now);
+			}
+		}
+
+		virtual void Send(TConstArrayView<uint8> bytes) override
+		{
+			if (IsOpen())
+			{
+				Endpoint->Send(EULSDeliveryChannel::ReliableOrdered, bytes);
+			}
+		}
+
+		virtual bool Receive(FULSLoadFrame& outFrame) override
+		{
+			return Frames.Dequeue(outFrame);
+		}
+
+		virtual void Close() override
+		{
+			if (Socket != nullptr && bAccepted && !bFailed)
+			{
+				// Flush what is queued, the server times the connection out if the notification is lost
+				Endpoint->Update(FPlatformTime::Seconds());
+				SendControl(EULSDatagramKind::Disconnect);
+			}
+			CloseSocket();
+		}
+
+	private:
+		void Fail(const FString& reason)
+		{
+			UE_LOG(LogULS, Warning, TEXT("FULSLoadSession %d: %s"), SessionIndex, *reason);
+			bFailed = true;
+			CloseSocket();
+		}
+
+		void CloseSocket()
+		{
+			if (Socket != nullptr)
+			{
+				Socket->Close();
+				ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+				Socket = nullptr;
+			}
+		}
+
+		void SendControl(EULSDatagramKind kind)
+		{
+			const uint8 datagram = (uint8)kind;
+			SendDatagram(TConstArrayView<uint8>(&datagram, 1));
+		}
+
+		void SendDatagram(TConstArrayView<uint8> datagram)
+		{
+			int32 bytesSent = 0;
+			if (Socket != nullptr)
+			{
+				Socket->SendTo(datagram.GetData(), datagram.Num(), bytesSent, *ServerAddress);
+			}
+		}
+
+		const int32 SessionIndex;
+		const FString Host;
+		const int32 Port;
+		const int32 Mtu;
+
+		FSocket* Socket = nullptr;
+		TSharedPtr<FInternetAddr> ServerAddress;
+		TSharedPtr<FInternetAddr> ReceiveAddress;
+		TUniquePtr<FULSReliableEndpoint> Endpoint;
+		TArray<uint8> ReceiveBuffer;
+		TQueue<FULSLoadFrame> Frames;
+		double ConnectStartTime = 0;
+		double LastConnectAttemptTime = 0;
+		bool bAccepted = false;
+		bool bFailed = false;
+	};
+
+	/**
+	 * Binary messages over IWebSocket. The socket is connected and closed on the game thread, like
+	 * UULSWebSocketTransport does, and raises its events there. FULSLoadGenerator::Run pumps it.
+	 */
+	class FULSLoadWebSocketLink final : public FULSLoadLink
+	{
+	public:
+		FULSLoadWebSocketLink(const FULSLoadSettings& settings, int32 sessionIndex)
+			: SessionIndex(sessionIndex)
+			, Url(FString::Printf(TEXT("%s://%s:%d/%s"), *settings.Protocol, *settings.Host, settings.Port, *settings.Resource))
+			, Protocol(settings.Protocol)
+			, State(MakeShared<FState, ESPMode::ThreadSafe>())
+		{
+		}
+
+		virtual ~FULSLoadWebSocketLink() { Close(); }
+
+		virtual void Open() override
+		{
+			Socket = FWebSocketsModule::Get().CreateWebSocket(Url, Protocol);
+
+			// The events may still arrive after Close, so they only reach the shared state
+			TSharedRef<FState, ESPMode::ThreadSafe> state = State;
+			const int32 sessionIndex = SessionIndex;
+			Socket->OnConnected().AddLambda([state]()
+				{
+					state->bOpen = true;
+				});
+			Socket->OnConnectionError().AddLambda([state, sessionIndex](const FString& error)
+				{
+					UE_LOG(LogULS, Warning, TEXT("FULSLoadSession %d: %s"), sessionIndex, *error);
+					state->bFailed = true;
+				});
+			Socket->OnClosed().AddLambda([state, sessionIndex](int32 statusCode, const FString& reason, bool bWasClean)
+				{
+					UE_LOG(LogULS, Warning, TEXT("FULSLoadSession %d: Connection closed (%d %s)"), sessionIndex, statusCode, *reason);
+					state->bFailed = true;
+				});
+			Socket->OnBinaryMessage().AddLambda([state](const void* data, SIZE_T size, bool bIsLastFragment)
+				{
+					TArray<uint8> bytes;
+					if (state->Assembler.AddFragment((const uint8*)data, (int32)size, bIsLastFragment, bytes))
+					{
+						state->Frames.Enqueue(FULSLoadFrame{ MoveTemp(bytes), FPlatformTime::Cycles64() });
+					}
+				});
+
+			TSharedPtr<IWebSocket> socket = Socket;
+			AsyncTask(ENamedThreads::GameThread, [socket]()
+				{
+					socket->Connect();
+				});
+		}
+
+		virtual bool IsOpen() const override { return State->bOpen && !State->bFailed; }
+
+		virtual bool HasFailed() const override { return State->bFailed; }
+
+		virtual void Send(TConstArrayView<uint8> bytes) override
+		{
+			// IWebSocket::Send only queues the message for the WebSockets thread
+			if (IsOpen())
+			{
+				Socket->Send(bytes.GetData(), bytes.Num(), true);
+			}
+		}
+
+		virtual bool Receive(FULSLoadFrame& outFrame) override
+		{
+			return State->Frames.Dequeue(outFrame);
+		}
+
+		virtual void Close() override
+		{
+			if (Socket.IsValid())
+			{
+				TSharedPtr<IWebSocket> socket = MoveTemp(Socket);
+				AsyncTask(ENamedThreads::GameThread, [socket]()
+					{
+						socket->OnClosed().Clear();
+						socket->Close();
+					});
+			}
+		}
+
+	private:
+		struct FState
+		{
+			std::atomic<bool> bOpen { false };
+			std::atomic<bool> bFailed { false };
+			TQueue<FULSLoadFrame, EQueueMode::Mpsc> Frames;
+			/* Only touched by the thread raising the socket events */
+			FULSWebSocketMessageAssembler Assembler;
+		};
+
+		const int32 SessionIndex;
+		const FString Url;
+		const FString Protocol;
+		TSharedRef<FState, ESPMode::ThreadSafe> State;
+		TSharedPtr<IWebSocket> Socket;
+	};
+}
+
+TUniquePtr<FULSLoadLink> FULSLoadLink::Create(const FULSLoadSettings& settings, FULSLoadServer* server, int32 sessionIndex)
+{
+	switch (settings.Transport)
+	{
+	case EULSLoadTransport::Tcp:
+		return MakeUnique<FULSLoadTcpLink>(settings, sessionIndex);
+
+	case EULSLoadTransport::Udp:
+		return MakeUnique<FULSLoadUdpLink>(settings, sessionIndex);
+
+	case EULSLoadTransport::SelfTest:
+		check(server != nullptr);
+		return MakeUnique<FULSLoadSelfTestLink>(*server, sessionIndex);
+
+	case EULSLoadTransport::WebSocket:
+	default:
+		return MakeUnique<FULSLoadWebSocketLink>(settings, sessionIndex);
+	}
+}
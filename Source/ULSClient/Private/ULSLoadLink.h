@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSLoadServer.h"
+
+struct FULSLoadSettings;
+
+/**
+ * Connection of one load session to the server, over the transport chosen in FULSLoadSettings.
+ *
+ * Links are driven by the worker thread that runs their session: Tick, Send and Receive are only called
+ * from there. Frames are complete wire packets, the way the matching UULSTransport hands them to the
+ * network owner.
+ */
+class FULSLoadLink
+{
+public:
+	/* server is only used, and must be valid, for EULSLoadTransport::SelfTest */
+	static TUniquePtr<FULSLoadLink> Create(const FULSLoadSettings& settings, FULSLoadServer* server, int32 sessionIndex);
+
+	virtual ~FULSLoadLink() {}
+
+	/* Starts connecting */
+	virtual void Open() = 0;
+
+	/* Connected, packets can be sent */
+	virtual bool IsOpen() const = 0;
+
+	/* The connection could not be established or was lost. The reason has been logged. */
+	virtual bool HasFailed() const = 0;
+
+	/* Pumps sockets that aren't driven by a thread of their own */
+	virtual void Tick(double now) {}
+
+	virtual void Send(TConstArrayView<uint8> bytes) = 0;
+
+	/* SendCycles of the frame is when it was queued by the stand-in or read from the socket */
+	virtual bool Receive(FULSLoadFrame& outFrame) = 0;
+
+	/* Closes the connection. The link is not used afterwards. */
+	virtual void Close() = 0;
+};
@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSLoadServer.h"
+#include "ULSPacketWriter.h"
+#include "ULSTransport.h"
+#include "ULSStats.h"
+#include "WireCore/ULSWireReader.h"
+#include "HAL/RunnableThread.h"
+
+FULSLoadServer::FULSLoadServer(float replicationRate, int32 objectsPerConnection)
+	: ReplicationRate(replicationRate)
+	, ObjectsPerConnection(objectsPerConnection)
+{
+}
+
+FULSLoadServer::~FULSLoadServer()
+{
+	Shutdown();
+}
+
+bool FULSLoadServer::Start()
+{
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("ULSLoadServer"), 0, TPri_AboveNormal);
+	return Thread != nullptr;
+}
+
+void FULSLoadServer::Shutdown()
+{
+	bStopping = true;
+
+	if (Thread != nullptr)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe> FULSLoadServer::Open(int32 sessionIndex)
+{
+	TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe> connection = MakeShared<FULSLoadConnection, ESPMode::ThreadSafe>(sessionIndex);
+
+	FScopeLock lock(&ConnectionsLock);
+	Connections.Add(connection);
+	return connection;
+}
+
+void FULSLoadServer::Close(const TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe>& connection)
+{
+	connection->bClosed = true;
+
+	FScopeLock lock(&ConnectionsLock);
+	Connections.Remove(connection);
+}
+
+void FULSLoadServer::HandleClientBytes(FULSLoadConnection& connection, TConstArrayView<uint8> bytes)
+{
+	if (connection.bClosed)
+	{
+		return;
+	}
+
+	ULSWire::FWireHeader header;
+	if (ULSWire::ParseHeader(bytes.GetData(), bytes.Num(), header) == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("FULSLoadServer: Session %d sent a malformed packet"), connection.SessionIndex);
+		return;
+	}
+
+	const ULSWire::FWireReader reader(bytes.GetData() + header.PayloadOffset, bytes.Num() - header.PayloadOffset);
+
+	switch (header.PacketType)
+	{
+	case EWirePacketType::ConnectionRequest:
+	{
+		FULSPacketWriter writer(EWirePacketType::ConnectionResponse);
+		writer.WriteInt8(1);
+		Send(connection, writer.MoveBytes());
+		connection.bAccepted = true;
+	}
+	break;
+
+	case EWirePacketType::TransportOptions:
+	{
+		// No optional features
+		FULSPacketWriter writer(EWirePacketType::TransportOptions);
+		writer.WriteInt32((int32)ETransportFeatures::None);
+		Send(connection, writer.MoveBytes());
+	}
+	break;
+
+	case EWirePacketType::RpcCall:
+	{
+		// Echoed, so answers cost the client what the calls cost the server
+		FULSPacketWriter writer(EWirePacketType::RpcCallResponse, reader.GetSize());
+		writer.WriteBytes(TConstArrayView<uint8>(bytes.GetData() + header.PayloadOffset, reader.GetSize()));
+		Send(connection, writer.MoveBytes());
+	}
+	break;
+
+	case EWirePacketType::Ping:
+	{
+		int position = 0;
+		const double senderTime = reader.Read<double>(position, position);
+
+		FULSPacketWriter writer(EWirePacketType::Pong, sizeof(double) * 2);
+		writer.WriteFloat64(senderTime);
+		writer.WriteFloat64(FPlatformTime::Seconds());
+		Send(connection, writer.MoveBytes());
+	}
+	break;
+
+	default:
+		break;
+	}
+}
+
+uint32 FULSLoadServer::Run()
+{
+	LLM_SCOPE_BYTAG(ULS);
+
+	const double interval = ReplicationRate > 0 ? 1.0 / ReplicationRate : 0;
+	TArray<TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe>> connections;
+
+	while (!bStopping)
+	{
+		if (interval > 0 && ObjectsPerConnection > 0)
+		{
+			{
+				FScopeLock lock(&ConnectionsLock);
+				connections = Connections;
+			}
+
+			const double now = FPlatformTime::Seconds();
+			for (const TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe>& connection : connections)
+			{
+				if (connection->bAccepted == false || connection->bClosed)
+				{
+					continue;
+				}
+
+				if (connection->NextReplicationTime == 0)
+				{
+					connection->NextReplicationTime = now;
+				}
+				if (now >= connection->NextReplicationTime)
+				{
+					SendReplication(*connection);
+
+					// Rounds the stand-in fell behind on are skipped rather than sent in a burst
+					connection->NextReplicationTime = FMath::Max(connection->NextReplicationTime + interval, now);
+				}
+			}
+			connections.Reset();
+		}
+
+		FPlatformProcess::SleepNoStats(0.001f);
+	}
+
+	return 0;
+}
+
+void FULSLoadServer::Send(FULSLoadConnection& connection, TArray<uint8>&& bytes)
+{
+	connection.ToClient.Enqueue(FULSLoadFrame{ MoveTemp(bytes), FPlatformTime::Cycles64() });
+}
+
+void FULSLoadServer::SendReplication(FULSLoadConnection& connection)
+{
+	const int32 round = connection.ReplicationRound++;
+	for (int32 objectIndex = 0; objectIndex < ObjectsPerConnection; objectIndex++)
+	{
+		const int64 uniqueId = ((int64)connection.SessionIndex << 32) | (objectIndex + 1);
+
+		// Shaped like the movement and state updates of a typical pawn
+		FULSPacketWriter writer(EWirePacketType::Replication);
+		writer.WriteInt32(0);
+		writer.WriteInt64(uniqueId);
+		writer.WriteInt32(4);
+		writer.WriteField(FULSReplicatedField::Vector(TEXT("Location"), FVector(round * 10.0, objectIndex * 100.0, 0.0)));
+		writer.WriteField(FULSReplicatedField::Float(TEXT("Speed"), round * 0.5f));
+		writer.WriteField(FULSReplicatedField::Int32(TEXT("Health"), 100 - round % 100));
+		writer.WriteField(FULSReplicatedField::Bool(TEXT("bIsSprinting"), (round & 1) != 0));
+		Send(connection, writer.MoveBytes());
+	}
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+class FRunnableThread;
+
+/* Wire bytes on their way from the stand-in to a load session */
+struct FULSLoadFrame
+{
+	TArray<uint8> Bytes;
+	/* FPlatformTime::Cycles64 when the stand-in queued the frame */
+	uint64 SendCycles = 0;
+};
+
+/* Server side of one load session's connection */
+class FULSLoadConnection
+{
+public:
+	explicit FULSLoadConnection(int32 sessionIndex) : SessionIndex(sessionIndex) {}
+
+	/* Filled by the session's worker thread (answers) and the server thread (replication), drained by the session */
+	TQueue<FULSLoadFrame, EQueueMode::Mpsc> ToClient;
+
+	const int32 SessionIndex;
+
+	/* Set once the connection request was accepted, cleared when either side closes */
+	std::atomic<bool> bAccepted { false };
+	std::atomic<bool> bClosed { false };
+
+	// Server thread only
+	double NextReplicationTime = 0;
+	int32 ReplicationRound = 0;
+};
+
+/**
+ * In-process stand-in for a ULS server, driving the sessions of FULSLoadGenerator in self-test mode.
+ *
+ * Client packets are handled synchronously on the thread that sends them: connection requests are
+ * accepted, TransportOptions declined, RpcCall packets echoed as RpcCallResponse and Pings answered.
+ * A server thread pushes Replication packets to every accepted connection at the configured rate.
+ */
+class FULSLoadServer : public FRunnable
+{
+public:
+	FULSLoadServer(float replicationRate, int32 objectsPerConnection);
+
+	virtual ~FULSLoadServer();
+
+	bool Start();
+
+	/* Stops the server thread. Blocks until it has exited. */
+	void Shutdown();
+
+	/* Thread-safe */
+	TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe> Open(int32 sessionIndex);
+
+	/* Thread-safe */
+	void Close(const TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe>& connection);
+
+	/* Handles complete wire bytes a session sent on the connection. Thread-safe per connection. */
+	void HandleClientBytes(FULSLoadConnection& connection, TConstArrayView<uint8> bytes);
+
+	// FRunnable
+	virtual uint32 Run() override;
+
+	virtual void Stop() override { bStopping = true; }
+
+private:
+	void Send(FULSLoadConnection& connection, TArray<uint8>&& bytes);
+
+	void SendReplication(FULSLoadConnection& connection);
+
+	const float ReplicationRate;
+	const int32 ObjectsPerConnection;
+
+	FCriticalSection ConnectionsLock;
+	TArray<TSharedRef<FULSLoadConnection, ESPMode::ThreadSafe>> Connections;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping { false };
+};
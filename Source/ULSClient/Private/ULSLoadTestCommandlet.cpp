@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSLoadTestCommandlet.h"
+#include "ULSLoadGenerator.h"
+#include "ULSStats.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	const TCHAR* DefaultScript = TEXT("connect; rpc 50 100 64; idle 5000; rpc 50 100 256; disconnect");
+}
+
+UULSLoadTestCommandlet::UULSLoadTestCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UULSLoadTestCommandlet::Main(const FString& Params)
+{
+	FULSLoadSettings settings;
+
+	FString transport = TEXT("WebSocket");
+	FParse::Value(*Params, TEXT("Transport="), transport);
+	if (FParse::Param(*Params, TEXT("SelfTest")) || transport == TEXT("SelfTest"))
+	{
+		settings.Transport = EULSLoadTransport::SelfTest;
+	}
+	else if (transport == TEXT("WebSocket"))
+	{
+		settings.Transport = EULSLoadTransport::WebSocket;
+	}
+	else if (transport == TEXT("Tcp"))
+	{
+		settings.Transport = EULSLoadTransport::Tcp;
+	}
+	else if (transport == TEXT("Udp"))
+	{
+		settings.Transport = EULSLoadTransport::Udp;
+	}
+	else
+	{
+		UE_LOG(LogULS, Error, TEXT("ULSLoadTest: Unknown transport %s, expected WebSocket, Tcp, Udp or SelfTest"), *transport);
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("Host="), settings.Host);
+	FParse::Value(*Params, TEXT("Port="), settings.Port);
+	FParse::Value(*Params, TEXT("Protocol="), settings.Protocol);
+	FParse::Value(*Params, TEXT("Resource="), settings.Resource);
+	FParse::Value(*Params, TEXT("Mtu="), settings.Mtu);
+	if (settings.Transport != EULSLoadTransport::SelfTest && (settings.Port <= 0 || settings.Port > MAX_uint16))
+	{
+		UE_LOG(LogULS, Error, TEXT("ULSLoadTest: -Port=<port> of the server is required, or -SelfTest to run against the in-process stand-in"));
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("Sessions="), settings.NumSessions);
+	FParse::Value(*Params, TEXT("Workers="), settings.NumWorkers);
+	FParse::Value(*Params, TEXT("RampUp="), settings.RampUpSeconds);
+	FParse::Value(*Params, TEXT("MaxSeconds="), settings.MaxSeconds);
+	FParse::Value(*Params, TEXT("PingInterval="), settings.PingIntervalMs);
+	FParse::Value(*Params, TEXT("ReplicationRate="), settings.ReplicationRate);
+	FParse::Value(*Params, TEXT("Objects="), settings.ObjectsPerSession);
+
+	FString scriptText = DefaultScript;
+	FString scriptFile;
+	if (FParse::Value(*Params, TEXT("ScriptFile="), scriptFile))
+	{
+		if (FFileHelper::LoadFileToString(scriptText, *scriptFile) == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("ULSLoadTest: Failed to read %s"), *scriptFile);
+			return 1;
+		}
+	}
+	else
+	{
+		FParse::Value(*Params, TEXT("Script="), scriptText);
+	}
+
+	FString error;
+	if (FULSLoadScript::Parse(scriptText, settings.Script, error) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("ULSLoadTest: %s"), *error);
+		UE_LOG(LogULS, Error, TEXT("Usage: -run=ULSLoadTest -Port=<port> [-Host=127.0.0.1] [-Transport=WebSocket|Tcp|Udp] [-Protocol=ws] [-Resource=<path>] [-Mtu=1200] ")
+			TEXT("[-Sessions=100] [-Workers=4] [-Script=\"%s\"] [-ScriptFile=<file>] [-RampUp=1] [-MaxSeconds=300] [-PingInterval=1000] [-Csv=<file>]"), DefaultScript);
+		UE_LOG(LogULS, Error, TEXT("       -run=ULSLoadTest -SelfTest [-ReplicationRate=10] [-Objects=10] ..."));
+		return 1;
+	}
+
+	FULSLoadGenerator generator(settings);
+	generator.Run();
+	generator.LogReport();
+
+	FString csvPath;
+	if (FParse::Value(*Params, TEXT("Csv="), csvPath) == false)
+	{
+		csvPath = FPaths::Combine(TEXT("Profiling"), TEXT("ULS"), TEXT("LoadTest-") + FDateTime::Now().ToString() + TEXT(".csv"));
+	}
+	generator.WriteCsv(csvPath);
+
+	for (const FULSLoadSessionStats& stats : generator.GetSessionStats())
+	{
+		if (stats.bConnected == false)
+		{
+			return 1;
+		}
+	}
+	return generator.GetSessionStats().Num() > 0 ? 0 : 1;
+}
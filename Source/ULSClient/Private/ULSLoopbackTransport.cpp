@@ -0,0 +1,433 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSLoopbackTransport.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSWirePacket.h"
+#include "ULSCompression.h"
+#include "ULSStats.h"
+
+namespace
+{
+	/* Options block the client sends per feature, see UULSClientNetworkOwner::GetFeatureOptionsSize */
+	int32 GetFeatureOptionsSize(ETransportFeatures feature)
+	{
+		switch (feature)
+		{
+		case ETransportFeatures::Compression:
+			return sizeof(int32) + sizeof(uint32);
+
+		case ETransportFeatures::CompactEncoding:
+			return sizeof(float) + sizeof(double) + sizeof(int32);
+
+		case ETransportFeatures::DeltaBaselines:
+		case ETransportFeatures::ChannelChunks:
+		case ETransportFeatures::SessionResume:
+		case ETransportFeatures::Heartbeat:
+			return sizeof(int32);
+
+		default:
+			return INDEX_NONE;
+		}
+	}
+}
+
+// Transport
+
+bool UULSLoopbackTransport::Connect()
+{
+	ResetNegotiatedFeatures();
+
+	if (Server == nullptr)
+	{
+		Server = NewObject<UULSLoopbackServer>(this);
+	}
+	Server->Transport = this;
+	Server->HandleClientConnected();
+
+	bConnected = true;
+
+	FString empty = FString();
+	NotifyConnected(true, empty);
+	return true;
+}
+
+void UULSLoopbackTransport::Disconnect()
+{
+	bConnected = false;
+}
+
+void UULSLoopbackTransport::SendBytes(TConstArrayView<uint8> bytes)
+{
+	if (!IsConnected())
+	{
+		// Don't send if we're not connected.
+		return;
+	}
+
+	Server->HandleClientBytes(bytes);
+}
+
+void UULSLoopbackTransport::DeliverToClient(TArray<uint8>&& bytes)
+{
+	if (!IsConnected())
+	{
+		return;
+	}
+
+	ClientNetworkOwner->GetInboundQueue()->Enqueue(this, MoveTemp(bytes));
+}
+
+void UULSLoopbackTransport::CloseFromServer(int32 statusCode, const FString& reason)
+{
+	if (!IsConnected())
+	{
+		return;
+	}
+
+	bConnected = false;
+
+	// Like the other transports, packets sent before closing are handled first
+	ClientNetworkOwner->ProcessInboundQueue();
+	NotifyDisconnected(statusCode, reason, true);
+}
+
+// Server
+
+void UULSLoopbackServer::SendSpawnActor(int64 uniqueId, const FString& className)
+{
+	FULSPacketWriter writer(EWirePacketType::SpawnActor);
+	writer.WriteInt32(0);
+	writer.WriteString(className);
+	writer.WriteInt64(uniqueId);
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendSpawnActorWithState(int64 uniqueId, const FString& className, const FTransform& transform, const TArray<FULSReplicatedField>& fields)
+{
+	const FRotator rotation = transform.Rotator();
+
+	FULSPacketWriter writer(EWirePacketType::SpawnActor);
+	writer.WriteInt32(EWireSpawnFlags::SpawnTransform | EWireSpawnFlags::SpawnProperties);
+	writer.WriteString(className);
+	writer.WriteInt64(uniqueId);
+	writer.WriteVector(transform.GetLocation());
+	writer.WriteVector(FVector(rotation.Pitch, rotation.Yaw, rotation.Roll));
+	writer.WriteVector(transform.GetScale3D());
+	writer.WriteInt32(fields.Num());
+	for (const FULSReplicatedField& field : fields)
+	{
+		writer.WriteField(field);
+	}
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendDespawnActor(int64 uniqueId)
+{
+	FULSPacketWriter writer(EWirePacketType::DespawnActor);
+	writer.WriteInt32(0);
+	writer.WriteInt64(uniqueId);
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendCreateObject(int64 uniqueId, const FString& className)
+{
+	FULSPacketWriter writer(EWirePacketType::CreateObject);
+	writer.WriteInt32(0);
+	writer.WriteString(className);
+	writer.WriteInt64(uniqueId);
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendDestroyObject(int64 uniqueId)
+{
+	FULSPacketWriter writer(EWirePacketType::DestroyObject);
+	writer.WriteInt32(0);
+	writer.WriteInt64(uniqueId);
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendDespawnActors(const TArray<int64>& uniqueIds)
+{
+	SendLifecycleBatch(EWirePacketType::DespawnActors, uniqueIds);
+}
+
+void UULSLoopbackServer::SendDestroyObjects(const TArray<int64>& uniqueIds)
+{
+	SendLifecycleBatch(EWirePacketType::DestroyObjects, uniqueIds);
+}
+
+void UULSLoopbackServer::SendTearOffs(const TArray<int64>& uniqueIds)
+{
+	SendLifecycleBatch(EWirePacketType::TearOffs, uniqueIds);
+}
+
+void UULSLoopbackServer::SendLifecycleBatch(int32 packetType, const TArray<int64>& uniqueIds)
+{
+	FULSPacketWriter writer(packetType, sizeof(int32) * 2 + sizeof(int64) * uniqueIds.Num());
+	writer.WriteInt32(0);
+	writer.WriteInt32(uniqueIds.Num());
+	for (const int64 uniqueId : uniqueIds)
+	{
+		writer.WriteInt64(uniqueId);
+	}
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendReplication(int64 uniqueId, const TArray<FULSReplicatedField>& fields)
+{
+	FULSPacketWriter writer(EWirePacketType::Replication);
+	writer.WriteInt32(0);
+	writer.WriteInt64(uniqueId);
+	writer.WriteInt32(fields.Num());
+	for (const FULSReplicatedField& field : fields)
+	{
+		writer.WriteField(field);
+	}
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendRpc(int64 uniqueId, const FString& methodName, const TArray<FULSReplicatedField>& parameters)
+{
+	FULSPacketWriter writer(EWirePacketType::RpcCall);
+	writer.WriteInt32(1 << 0); // FullReflection
+	writer.WriteInt64(uniqueId);
+	writer.WriteString(methodName);
+	writer.WriteString(FString());
+	writer.WriteInt32(parameters.Num());
+	for (const FULSReplicatedField& parameter : parameters)
+	{
+		writer.WriteField(parameter);
+	}
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::SendConnectionEnd()
+{
+	FULSPacketWriter writer(EWirePacketType::ConnectionEnd);
+	SendPacket(writer);
+}
+
+void UULSLoopbackServer::CloseConnection(int32 statusCode, const FString& reason)
+{
+	if (Transport != nullptr)
+	{
+		Transport->CloseFromServer(statusCode, reason);
+	}
+}
+
+void UULSLoopbackServer::SendBytes(TArray<uint8>&& bytes)
+{
+	if (bSessionActive && SessionToken != 0 && bytes.Num() >= UULSWirePacket::HeaderSize)
+	{
+		// The sequence number goes between the header and the payload. Kept as sent for a resume.
+		const int64 sequence = NextSequence++;
+		*(int32*)bytes.GetData() |= EWirePacketFlags::Sequenced;
+		bytes.Insert((const uint8*)&sequence, sizeof(int64), UULSWirePacket::HeaderSize);
+
+		FSequencedPacket& kept = UnacknowledgedPackets.AddDefaulted_GetRef();
+		kept.Sequence = sequence;
+		kept.Bytes = bytes;
+	}
+
+	DeliverBytes(MoveTemp(bytes));
+}
+
+void UULSLoopbackServer::DeliverBytes(TArray<uint8>&& bytes)
+{
+	if (Transport == nullptr)
+	{
+		return;
+	}
+
+	if (EnumHasAnyFlags(NegotiatedFeatures, ETransportFeatures::Compression) &&
+		bytes.Num() - UULSWirePacket::HeaderSize >= CompressionThreshold)
+	{
+		// Header, uncompressed payload size, deflate stream, like UULSTransport::CompressPacket
+		const TConstArrayView<uint8> payload = TConstArrayView<uint8>(bytes).RightChop(UULSWirePacket::HeaderSize);
+		TArray<uint8> compressed;
+		compressed.AddUninitialized(UULSWirePacket::HeaderSize + sizeof(int32));
+		*(int32*)compressed.GetData() = *(const int32*)bytes.GetData() | EWirePacketFlags::Compressed;
+		*(int32*)(compressed.GetData() + UULSWirePacket::HeaderSize) = payload.Num();
+		if (FULSCompression::Compress(payload, TConstArrayView<uint8>(), compressed))
+		{
+			bytes = MoveTemp(compressed);
+		}
+	}
+
+	Transport->DeliverToClient(MoveTemp(bytes));
+}
+
+void UULSLoopbackServer::HandleClientConnected()
+{
+	NegotiatedFeatures = ETransportFeatures::None;
+	CompressionThreshold = 0;
+	bSessionActive = false;
+}
+
+void UULSLoopbackServer::HandleClientBytes(TConstArrayView<uint8> bytes)
+{
+	TArray<uint8> wireBytes;
+	if (bytes.Num() >= UULSWirePacket::HeaderSize && (*(const int32*)bytes.GetData() & EWirePacketFlags::Compressed) != 0)
+	{
+		const int32 prefixSize = UULSWirePacket::HeaderSize + sizeof(int32);
+		const int32 uncompressedSize = (bytes.Num() >= prefixSize) ? *(const int32*)(bytes.GetData() + UULSWirePacket::HeaderSize) : -1;
+		if (uncompressedSize < 0 || uncompressedSize > Transport->MaxDecompressedSize)
+		{
+			UE_LOG(LogULS, Error, TEXT("UULSLoopbackServer: Invalid compressed WirePacket"));
+			return;
+		}
+
+		wireBytes.SetNumUninitialized(UULSWirePacket::HeaderSize + uncompressedSize);
+		*(int32*)wireBytes.GetData() = *(const int32*)bytes.GetData() & ~EWirePacketFlags::Compressed;
+		if (FULSCompression::Decompress(bytes.RightChop(prefixSize), TConstArrayView<uint8>(), wireBytes.GetData() + UULSWirePacket::HeaderSize, uncompressedSize) == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("UULSLoopbackServer: Failed to decompress WirePacket"));
+			return;
+		}
+	}
+	else
+	{
+		wireBytes.Append(bytes.GetData(), bytes.Num());
+	}
+
+	auto packet = NewObject<UULSWirePacket>();
+	if (packet->ParseFromBytes(MoveTemp(wireBytes)) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSLoopbackServer: Failed to parse WirePacket from bytes"));
+		return;
+	}
+
+	switch (packet->PacketType)
+	{
+	case EWirePacketType::TransportOptions:
+		HandleTransportOptions(packet);
+		break;
+
+	case EWirePacketType::ConnectionRequest:
+		// A new session, whatever was kept for the previous one is gone
+		UnacknowledgedPackets.Reset();
+		NextSequence = 1;
+		SessionToken = EnumHasAnyFlags(NegotiatedFeatures, ETransportFeatures::SessionResume) ? NextSessionToken++ : 0;
+		SendConnectionResponse(bAcceptConnections);
+		break;
+
+	case EWirePacketType::SessionResume:
+		HandleSessionResume(packet);
+		break;
+
+	case EWirePacketType::SessionAck:
+	{
+		int position = 0;
+		const int64 acknowledged = packet->ReadInt64(position, position);
+		UnacknowledgedPackets.RemoveAll([acknowledged](const FSequencedPacket& kept) { return kept.Sequence <= acknowledged; });
+	}
+	break;
+
+	case EWirePacketType::Ping:
+		if (bAnswerPings)
+		{
+			int position = 0;
+			const double senderTime = packet->ReadFloat64(position, position);
+
+			FULSPacketWriter writer(EWirePacketType::Pong, sizeof(double) * 2);
+			writer.WriteFloat64(senderTime);
+			writer.WriteFloat64(FPlatformTime::Seconds());
+			DeliverBytes(writer.MoveBytes());
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	OnClientPacketNative.Broadcast(packet);
+	OnClientPacket.Broadcast(packet);
+}
+
+void UULSLoopbackServer::HandleTransportOptions(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const ETransportFeatures requested = (ETransportFeatures)packet->ReadInt32(position, position);
+
+	// The options of every accepted feature are answered as the client asked for them
+	ETransportFeatures accepted = ETransportFeatures::None;
+	FULSPacketWriter options(EWirePacketType::TransportOptions);
+	for (int32 bit = 0; bit < 31; bit++)
+	{
+		const ETransportFeatures feature = (ETransportFeatures)(1 << bit);
+		if (EnumHasAnyFlags(requested, feature) == false)
+		{
+			continue;
+		}
+
+		const int32 size = GetFeatureOptionsSize(feature);
+		if (size == INDEX_NONE || position + size > packet->GetPayloadSize())
+		{
+			// The blocks that follow can't be found, decline the rest
+			break;
+		}
+
+		if (AcceptedFeatures & (1 << bit))
+		{
+			accepted |= feature;
+			if (feature == ETransportFeatures::Compression)
+			{
+				int compressionPosition = position;
+				CompressionThreshold = packet->ReadInt32(compressionPosition, compressionPosition);
+				options.WriteInt32(CompressionThreshold);
+				options.WriteInt32(0); // No dictionary
+			}
+			else
+			{
+				options.WriteBytes(packet->GetPayload().Slice(position, size));
+			}
+		}
+		position += size;
+	}
+
+	NegotiatedFeatures = accepted;
+
+	// Feature mask followed by the options blocks
+	FULSPacketWriter writer(EWirePacketType::TransportOptions);
+	writer.WriteInt32((int32)accepted);
+	writer.WriteBytes(TConstArrayView<uint8>(options.GetBytes()).RightChop(UULSWirePacket::HeaderSize));
+	DeliverBytes(writer.MoveBytes());
+}
+
+void UULSLoopbackServer::HandleSessionResume(const UULSWirePacket* packet)
+{
+	int position = 0;
+	const int64 token = packet->ReadInt64(position, position);
+	const int64 lastApplied = packet->ReadInt64(position, position);
+
+	if (token == 0 || token != SessionToken || bAcceptConnections == false)
+	{
+		// The client requests a new session on the same connection
+		SendConnectionResponse(false);
+		return;
+	}
+
+	SendConnectionResponse(true);
+
+	UnacknowledgedPackets.RemoveAll([lastApplied](const FSequencedPacket& kept) { return kept.Sequence <= lastApplied; });
+	for (const FSequencedPacket& kept : UnacknowledgedPackets)
+	{
+		DeliverBytes(CopyTemp(kept.Bytes));
+	}
+}
+
+void UULSLoopbackServer::SendConnectionResponse(bool bAccepted)
+{
+	// Not part of the session, so never sequenced
+	FULSPacketWriter writer(EWirePacketType::ConnectionResponse);
+	writer.WriteInt8(bAccepted ? 1 : 0);
+	if (bAccepted && SessionToken != 0)
+	{
+		// The client reads the token from the end of the response
+		writer.WriteInt64(SessionToken);
+	}
+	DeliverBytes(writer.MoveBytes());
+
+	bSessionActive = bAccepted;
+}
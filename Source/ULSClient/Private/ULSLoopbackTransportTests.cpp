@@ -0,0 +1,680 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSTestSupport.h"
+#include "ULSLoopbackTransport.h"
+#include "ULSReplayTransport.h"
+#include "ULSCapture.h"
+#include "ULSPacketWriter.h"
+#include "ULSWirePacket.h"
+#include "ULSStats.h"
+#include "WireCore/ULSWireReader.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/FileManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Optional transport features end to end, between a network owner and a UULSLoopbackServer that
+* accepts them. Every test drives the owner's tick itself, the timed ones (heartbeat, resume) sleep
+* between ticks for a fraction of a second.
+*/
+
+namespace
+{
+	/* A packet the server received, after the loopback server inflated it */
+	struct FClientPacket
+	{
+		int32 PacketType = 0;
+		TArray<uint8> Payload;
+	};
+
+	/* Test session with a loopback server that accepts the given features */
+	class FLoopbackSession : public FULSTestSession
+	{
+	public:
+		explicit FLoopbackSession(ETransportFeatures acceptedFeatures)
+			: FULSTestSession(TEXT("ULSLoopbackTest"))
+		{
+			Transport = NewObject<UULSLoopbackTransport>(Owner);
+			Transport->ClientNetworkOwner = Owner;
+			Owner->Transport = Transport;
+
+			Server = NewObject<UULSLoopbackServer>(Transport);
+			Server->AcceptedFeatures = (int32)acceptedFeatures;
+			Transport->Server = Server;
+			Record(Server, ClientPackets);
+		}
+
+		static void Record(UULSLoopbackServer* server, TArray<FClientPacket>& outPackets)
+		{
+			server->OnClientPacketNative.AddLambda([&outPackets](const UULSWirePacket* packet)
+			{
+				FClientPacket& received = outPackets.AddDefaulted_GetRef();
+				received.PacketType = packet->PacketType;
+				received.Payload = TArray<uint8>(packet->GetPayload().GetData(), packet->GetPayload().Num());
+			});
+		}
+
+		/* Connects and lets the owner handle the server's answers */
+		void Connect()
+		{
+			Transport->Connect();
+			Tick();
+		}
+
+		int32 CountPackets(int32 packetType) const
+		{
+			return ClientPackets.FilterByPredicate([packetType](const FClientPacket& packet) { return packet.PacketType == packetType; }).Num();
+		}
+
+		TArray<FClientPacket> GetPackets(int32 packetType) const
+		{
+			return ClientPackets.FilterByPredicate([packetType](const FClientPacket& packet) { return packet.PacketType == packetType; });
+		}
+
+		UULSTestObject* FindObject(int64 uniqueId) const
+		{
+			return Find<UULSTestObject>(uniqueId);
+		}
+
+		UULSLoopbackTransport* Transport;
+		UULSLoopbackServer* Server;
+		TArray<FClientPacket> ClientPackets;
+	};
+
+	FString GetObjectClassPath()
+	{
+		return UULSTestObject::StaticClass()->GetPathName();
+	}
+
+	FString ReadString(const ULSWire::FWireReader& reader, int32 index, int32& advancedPosition)
+	{
+		int32 length = 0;
+		const char* chars = reader.ReadString(index, advancedPosition, length);
+		return (chars != nullptr) ? FString(FUTF8ToTCHAR(chars, length)) : FString();
+	}
+
+	TArray<uint8> MakeBytes(int32 size, uint8 seed)
+	{
+		TArray<uint8> bytes;
+		bytes.SetNumUninitialized(size);
+		for (int32 i = 0; i < size; i++)
+		{
+			bytes[i] = (uint8)(seed + i * 7);
+		}
+		return bytes;
+	}
+
+	UULSWirePacket* MakePacket(int32 packetType, const TArray<uint8>& payload)
+	{
+		UULSWirePacket* packet = NewObject<UULSWirePacket>();
+		packet->PacketType = packetType;
+		packet->SetPayloadSize(payload.Num());
+		FMemory::Memcpy(packet->GetMutablePayload().GetData(), payload.GetData(), payload.Num());
+		packet->FinalizeHeader();
+		return packet;
+	}
+
+	uint64 DoubleBits(double value)
+	{
+		uint64 bits;
+		FMemory::Memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	/* A field of a ReplicationDelta packet, its words already XORed with the baseline */
+	struct FDeltaField
+	{
+		FString Name;
+		int8 Type = 0;
+		TArray<uint64> Words;
+	};
+
+	TArray<uint8> MakeReplicationDelta(int64 uniqueId, int64 baseSequence, int64 sequence, const TArray<FDeltaField>& fields)
+	{
+		FULSPacketWriter writer(EWirePacketType::ReplicationDelta);
+		writer.WriteInt32(0);
+		writer.WriteInt64(uniqueId);
+		writer.WriteInt64(baseSequence);
+		writer.WriteInt64(sequence);
+		writer.WriteInt32(fields.Num());
+		for (const FDeltaField& field : fields)
+		{
+			writer.WriteInt8(field.Type);
+			writer.WriteString(field.Name);
+			for (const uint64 word : field.Words)
+			{
+				writer.WriteInt64((int64)word);
+			}
+		}
+		return writer.MoveBytes();
+	}
+
+	/* Acknowledged (id, sequence) pairs and resync requests of a BaselineAck */
+	void ReadBaselineAck(const FClientPacket& packet, TMap<int64, int64>& outAcks, TArray<int64>& outResyncs)
+	{
+		const ULSWire::FWireReader reader(packet.Payload.GetData(), packet.Payload.Num());
+		int32 position = 0;
+		const int32 numAcks = reader.Read<int32>(position, position);
+		for (int32 i = 0; i < numAcks; i++)
+		{
+			const int64 uniqueId = reader.Read<int64>(position, position);
+			outAcks.Add(uniqueId, reader.Read<int64>(position, position));
+		}
+		const int32 numResyncs = reader.Read<int32>(position, position);
+		for (int32 i = 0; i < numResyncs; i++)
+		{
+			outResyncs.Add(reader.Read<int64>(position, position));
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackCompressionTest, "ULS.Loopback.Compression",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackCompressionTest::RunTest(const FString& Parameters)
+{
+	FLoopbackSession session(ETransportFeatures::Compression);
+	session.Transport->bEnableCompression = true;
+	session.Transport->CompressionThreshold = 64;
+	session.Connect();
+
+	TestTrue(TEXT("Compression negotiated"), EnumHasAnyFlags(session.Transport->GetNegotiatedFeatures(), ETransportFeatures::Compression));
+
+	// Server to client, above the threshold
+	const FString label = FString::ChrN(2000, TEXT('a'));
+	session.Server->SendCreateObject(1, GetObjectClassPath());
+
+	const FULSPacketTypeCounters replicationBefore = FULSNetStats::GetCounters(EWirePacketType::Replication);
+	session.Server->SendReplication(1, { FULSReplicatedField::String(TEXT("Label"), label), FULSReplicatedField::Int32(TEXT("Health"), 7) });
+	session.Tick();
+	const FULSPacketTypeCounters replicationAfter = FULSNetStats::GetCounters(EWirePacketType::Replication);
+
+	UULSTestObject* object = session.FindObject(1);
+	if (TestNotNull(TEXT("Object created"), object))
+	{
+		TestEqual(TEXT("Inflated string"), object->Label, label);
+		TestEqual(TEXT("Inflated int"), object->Health, 7);
+	}
+	TestEqual(TEXT("One replication packet received"), replicationAfter.PacketsIn - replicationBefore.PacketsIn, (int64)1);
+	TestTrue(TEXT("Replication arrived compressed"), replicationAfter.BytesIn - replicationBefore.BytesIn < 500);
+
+	// Client to server
+	TArray<uint8> payload;
+	payload.Init('b', 4000);
+	const FULSPacketTypeCounters customBefore = FULSNetStats::GetCounters(EWirePacketType::Custom);
+	session.Owner->SendWirePacket(MakePacket(EWirePacketType::Custom, payload));
+	const FULSPacketTypeCounters customAfter = FULSNetStats::GetCounters(EWirePacketType::Custom);
+
+	const TArray<FClientPacket> custom = session.GetPackets(EWirePacketType::Custom);
+	if (TestEqual(TEXT("Custom packet received"), custom.Num(), 1))
+	{
+		TestTrue(TEXT("Custom payload inflated by the server"), custom[0].Payload == payload);
+	}
+	TestTrue(TEXT("Custom packet sent compressed"), customAfter.BytesOut - customBefore.BytesOut < 500);
+
+	// Below the threshold nothing is compressed
+	const FULSPacketTypeCounters smallBefore = FULSNetStats::GetCounters(EWirePacketType::Custom);
+	session.Owner->SendWirePacket(MakePacket(EWirePacketType::Custom, MakeBytes(32, 1)));
+	const FULSPacketTypeCounters smallAfter = FULSNetStats::GetCounters(EWirePacketType::Custom);
+	TestEqual(TEXT("Small packet sent as it is"), smallAfter.BytesOut - smallBefore.BytesOut, (int64)(UULSWirePacket::HeaderSize + 32));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackDeltaBaselinesTest, "ULS.Loopback.DeltaBaselines",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackDeltaBaselinesTest::RunTest(const FString& Parameters)
+{
+	FLoopbackSession session(ETransportFeatures::DeltaBaselines);
+	session.Owner->bEnableDeltaBaselines = true;
+	session.Owner->BaselineAckInterval = 0;
+	session.Connect();
+	session.Server->SendCreateObject(1, GetObjectClassPath());
+
+	// Against the zero baseline the words are the values
+	const FVector location(1, 2, 3);
+	session.Server->SendBytes(MakeReplicationDelta(1, 0, 1, {
+		{ TEXT("Health"), EReplicatedFieldType::PrimitiveInt, { (uint64)(int64)100 } },
+		{ TEXT("Location"), EReplicatedFieldType::Vector3, { DoubleBits(location.X), DoubleBits(location.Y), DoubleBits(location.Z) } } }));
+	session.Tick();
+	session.Tick();
+
+	UULSTestObject* object = session.FindObject(1);
+	if (TestNotNull(TEXT("Object created"), object) == false)
+	{
+		return false;
+	}
+	TestEqual(TEXT("Health from the zero baseline"), object->Health, 100);
+	TestEqual(TEXT("Location from the zero baseline"), object->Location, location);
+
+	TArray<FClientPacket> acks = session.GetPackets(EWirePacketType::BaselineAck);
+	if (TestEqual(TEXT("First delta acknowledged"), acks.Num(), 1))
+	{
+		TMap<int64, int64> acked;
+		TArray<int64> resyncs;
+		ReadBaselineAck(acks[0], acked, resyncs);
+		TestEqual(TEXT("Acknowledged sequence"), acked.FindRef(1), (int64)1);
+		TestEqual(TEXT("No resync"), resyncs.Num(), 0);
+	}
+
+	// Only Health changes, the baseline keeps Location
+	const int32 onRepsBefore = object->NumOnReps;
+	session.Server->SendBytes(MakeReplicationDelta(1, 1, 2, {
+		{ TEXT("Health"), EReplicatedFieldType::PrimitiveInt, { (uint64)(int64)100 ^ (uint64)(int64)90 } } }));
+	session.Tick();
+	session.Tick();
+	TestEqual(TEXT("Health against baseline 1"), object->Health, 90);
+	TestEqual(TEXT("Location kept"), object->Location, location);
+	TestEqual(TEXT("OnRep called once"), object->NumOnReps, onRepsBefore + 1);
+
+	// Overtaken by sequence 2, e.g. on an unordered channel
+	session.Server->SendBytes(MakeReplicationDelta(1, 0, 1, {
+		{ TEXT("Health"), EReplicatedFieldType::PrimitiveInt, { (uint64)(int64)5 } } }));
+	session.Tick();
+	TestEqual(TEXT("Stale delta ignored"), object->Health, 90);
+
+	// The base is not kept, the client asks for a full update
+	const int32 numAcks = session.CountPackets(EWirePacketType::BaselineAck);
+	session.Server->SendBytes(MakeReplicationDelta(1, 40, 41, {
+		{ TEXT("Health"), EReplicatedFieldType::PrimitiveInt, { (uint64)(int64)1 } } }));
+	session.Tick();
+	session.Tick();
+	TestEqual(TEXT("Unknown base not applied"), object->Health, 90);
+
+	acks = session.GetPackets(EWirePacketType::BaselineAck);
+	if (TestEqual(TEXT("Resync sent"), acks.Num(), numAcks + 1))
+	{
+		TMap<int64, int64> acked;
+		TArray<int64> resyncs;
+		ReadBaselineAck(acks.Last(), acked, resyncs);
+		TestTrue(TEXT("Resync of the object"), resyncs.Contains(1));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackSessionResumeTest, "ULS.Loopback.SessionResume",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackSessionResumeTest::RunTest(const FString& Parameters)
+{
+	FLoopbackSession session(ETransportFeatures::SessionResume);
+	session.Owner->bAutoReconnect = true;
+	session.Owner->ReconnectInitialDelay = 0.01f;
+	session.Owner->SessionAckInterval = 0;
+	session.Connect();
+
+	session.Server->SendCreateObject(1, GetObjectClassPath());
+	session.Server->SendReplication(1, { FULSReplicatedField::Int32(TEXT("Health"), 10) });
+	session.Tick();
+	session.Tick();
+
+	UULSTestObject* object = session.FindObject(1);
+	if (TestNotNull(TEXT("Object created"), object) == false)
+	{
+		return false;
+	}
+	TestEqual(TEXT("Health before the drop"), object->Health, 10);
+	TestTrue(TEXT("Session acknowledged"), session.CountPackets(EWirePacketType::SessionAck) > 0);
+	TestEqual(TEXT("Nothing kept after the ack"), session.Server->GetNumUnacknowledgedPackets(), 0);
+
+	// Sent while the connection is down, kept by the server for the resume
+	session.Server->CloseConnection(1006, TEXT("Dropped"));
+	TestFalse(TEXT("Disconnected"), session.Transport->IsConnected());
+	session.Server->SendReplication(1, { FULSReplicatedField::Int32(TEXT("Health"), 20) });
+	TestEqual(TEXT("Missed packet kept"), session.Server->GetNumUnacknowledgedPackets(), 1);
+
+	const bool bResumed = session.TickUntil(2.0f, [&session, object]()
+	{
+		return session.Transport->IsConnected() && object->Health == 20;
+	});
+	TestTrue(TEXT("Resumed"), bResumed);
+	TestEqual(TEXT("Resumed with SessionResume"), session.CountPackets(EWirePacketType::SessionResume), 1);
+	TestEqual(TEXT("No new session requested"), session.CountPackets(EWirePacketType::ConnectionRequest), 1);
+	TestTrue(TEXT("Network object kept"), session.FindObject(1) == object);
+
+	// Already applied packets aren't applied twice, even if the server sends them again
+	session.TickUntil(1.0f, [&session]() { return session.Server->GetNumUnacknowledgedPackets() == 0; });
+	TestEqual(TEXT("Resent packet acknowledged"), session.Server->GetNumUnacknowledgedPackets(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackHeartbeatTest, "ULS.Loopback.Heartbeat",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackHeartbeatTest::RunTest(const FString& Parameters)
+{
+	FLoopbackSession session(ETransportFeatures::Heartbeat);
+	session.Owner->bEnableHeartbeat = true;
+	session.Owner->HeartbeatInterval = 0.05f;
+	session.Owner->HeartbeatTimeout = 0.4f;
+	session.Connect();
+
+	TestTrue(TEXT("Heartbeat negotiated"), EnumHasAnyFlags(session.Server->GetNegotiatedFeatures(), ETransportFeatures::Heartbeat));
+
+	// Pings at the interval, answered by the server
+	session.TickUntil(0.3f, []() { return false; });
+	TestTrue(TEXT("Pings sent"), session.CountPackets(EWirePacketType::Ping) >= 3);
+	TestTrue(TEXT("Round trip measured"), session.Owner->GetRoundTripTime() > 0);
+	TestTrue(TEXT("Still connected"), session.Transport->IsConnected());
+
+	// Pings of the server are answered with its time echoed
+	FULSPacketWriter ping(EWirePacketType::Ping);
+	ping.WriteFloat64(1234.5);
+	session.Server->SendPacket(ping);
+	session.Tick();
+
+	const TArray<FClientPacket> pongs = session.GetPackets(EWirePacketType::Pong);
+	if (TestEqual(TEXT("Pong sent"), pongs.Num(), 1))
+	{
+		const ULSWire::FWireReader reader(pongs[0].Payload.GetData(), pongs[0].Payload.Num());
+		int32 position = 0;
+		TestEqual(TEXT("Ping time echoed"), reader.Read<double>(position, position), 1234.5);
+	}
+
+	// A server that stopped answering is detected after the timeout
+	session.Server->bAnswerPings = false;
+	const double silentSince = FPlatformTime::Seconds();
+	const bool bTimedOut = session.TickUntil(2.0f, [&session]() { return session.Transport->IsConnected() == false; });
+	TestTrue(TEXT("Dead connection closed"), bTimedOut);
+	TestTrue(TEXT("Not before the timeout"), FPlatformTime::Seconds() - silentSince >= 0.3);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackChannelChunksTest, "ULS.Loopback.ChannelChunks",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackChannelChunksTest::RunTest(const FString& Parameters)
+{
+	FLoopbackSession session(ETransportFeatures::ChannelChunks);
+	session.Owner->bEnableChannelChunks = true;
+	session.Owner->ChannelChunkSize = 256;
+	session.Owner->ChannelBytesPerTick = 512;
+	session.Owner->ChannelRouting.Add(EWirePacketType::Custom, 1);
+	session.Connect();
+
+	// Client to server: queued and sliced up in Tick, two chunks per tick
+	UULSWirePacket* bulk = MakePacket(EWirePacketType::Custom, MakeBytes(2000, 3));
+	const TArray<uint8> bulkBytes = bulk->SerializeToBytes();
+	session.Owner->SendWirePacket(bulk);
+	TestEqual(TEXT("Nothing sent before the tick"), session.CountPackets(EWirePacketType::ChannelChunk), 0);
+
+	session.Tick();
+	TestEqual(TEXT("Two chunks per tick"), session.CountPackets(EWirePacketType::ChannelChunk), 2);
+
+	// Packets on channel 0 don't wait for the rest of the bulk packet
+	session.Owner->SendWirePacket(MakePacket(EWirePacketType::RpcCall, MakeBytes(16, 4)));
+	TestEqual(TEXT("Channel 0 packet sent right away"), session.CountPackets(EWirePacketType::RpcCall), 1);
+
+	session.TickUntil(1.0f, [&session, &bulkBytes]() { return session.CountPackets(EWirePacketType::ChannelChunk) * 256 >= bulkBytes.Num(); });
+
+	TArray<uint8> reassembled;
+	for (const FClientPacket& chunk : session.GetPackets(EWirePacketType::ChannelChunk))
+	{
+		const ULSWire::FWireReader reader(chunk.Payload.GetData(), chunk.Payload.Num());
+		int32 position = 0;
+		const int32 channel = reader.Read<int32>(position, position);
+		const int32 messageId = reader.Read<int32>(position, position);
+		const int32 totalSize = reader.Read<int32>(position, position);
+		const int32 offset = reader.Read<int32>(position, position);
+		TestEqual(TEXT("Chunk channel"), channel, 1);
+		TestEqual(TEXT("Chunk message"), messageId, 0);
+		TestEqual(TEXT("Chunk total size"), totalSize, bulkBytes.Num());
+		TestEqual(TEXT("Chunks in order"), offset, reassembled.Num());
+		TestTrue(TEXT("Chunk size"), chunk.Payload.Num() - position <= 256);
+		reassembled.Append(chunk.Payload.GetData() + position, chunk.Payload.Num() - position);
+	}
+	TestTrue(TEXT("Reassembled wire bytes"), reassembled == bulkBytes);
+	TestEqual(TEXT("Not sent unchunked"), session.CountPackets(EWirePacketType::Custom), 0);
+
+	// Server to client: a replication packet in three chunks, out of order and with a duplicate that must not fill the hole
+	session.Server->SendCreateObject(1, GetObjectClassPath());
+	const FString label = FString::ChrN(700, TEXT('c'));
+	FULSPacketWriter replication(EWirePacketType::Replication);
+	replication.WriteInt32(0);
+	replication.WriteInt64(1);
+	replication.WriteInt32(1);
+	replication.WriteField(FULSReplicatedField::String(TEXT("Label"), label));
+	const TArray<uint8> replicationBytes = replication.MoveBytes();
+
+	auto sendChunk = [&session, &replicationBytes](int32 offset)
+	{
+		const int32 size = FMath::Min(256, replicationBytes.Num() - offset);
+		FULSPacketWriter chunk(EWirePacketType::ChannelChunk);
+		chunk.WriteInt32(1);
+		chunk.WriteInt32(0);
+		chunk.WriteInt32(replicationBytes.Num());
+		chunk.WriteInt32(offset);
+		chunk.WriteBytes(TConstArrayView<uint8>(replicationBytes.GetData() + offset, size));
+		session.Server->SendPacket(chunk);
+	};
+	sendChunk(512);
+	sendChunk(0);
+	sendChunk(0);
+	session.Tick();
+
+	UULSTestObject* object = session.FindObject(1);
+	if (TestNotNull(TEXT("Object created"), object))
+	{
+		TestTrue(TEXT("Incomplete replication not applied"), object->Label.IsEmpty());
+	}
+
+	sendChunk(256);
+	session.Tick();
+	if (object != nullptr)
+	{
+		TestEqual(TEXT("Reassembled replication applied"), object->Label, label);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackChannelTransportTest, "ULS.Loopback.ChannelTransport",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackChannelTransportTest::RunTest(const FString& Parameters)
+{
+	FLoopbackSession session(ETransportFeatures::ChannelChunks);
+	session.Owner->bEnableChannelChunks = true;
+	session.Owner->ChannelRouting.Add(EWirePacketType::Custom, 1);
+
+	// Dedicated connection for channel 1, to a server of its own
+	UULSLoopbackTransport* channelTransport = NewObject<UULSLoopbackTransport>(session.Owner);
+	channelTransport->Server = NewObject<UULSLoopbackServer>(channelTransport);
+	TArray<FClientPacket> channelPackets;
+	FLoopbackSession::Record(channelTransport->Server, channelPackets);
+	session.Owner->ChannelTransports.Add(1, channelTransport);
+
+	session.Connect();
+	TestTrue(TEXT("Channel transport connected once the connection was accepted"), channelTransport->IsConnected());
+	TestEqual(TEXT("Channel index assigned"), channelTransport->ChannelIndex, 1);
+
+	if (TestEqual(TEXT("ChannelAttach sent"), channelPackets.Num(), 1))
+	{
+		const ULSWire::FWireReader reader(channelPackets[0].Payload.GetData(), channelPackets[0].Payload.Num());
+		int32 position = 0;
+		TestEqual(TEXT("ChannelAttach packet"), channelPackets[0].PacketType, (int32)EWirePacketType::ChannelAttach);
+		TestEqual(TEXT("ChannelAttach channel"), reader.Read<int32>(position, position), 1);
+	}
+
+	// Routed to the dedicated connection as a whole
+	const TArray<uint8> payload = MakeBytes(2000, 5);
+	session.Owner->SendWirePacket(MakePacket(EWirePacketType::Custom, payload));
+	TestEqual(TEXT("Nothing on the main connection"), session.CountPackets(EWirePacketType::Custom) + session.CountPackets(EWirePacketType::ChannelChunk), 0);
+	if (TestEqual(TEXT("Sent on the channel"), channelPackets.Num(), 2))
+	{
+		TestTrue(TEXT("Channel packet bytes"), channelPackets[1].Payload == payload);
+	}
+
+	// Without the dedicated connection the channel falls back to chunks on the main one
+	channelTransport->Disconnect();
+	session.Owner->SendWirePacket(MakePacket(EWirePacketType::Custom, payload));
+	session.Tick();
+	TestTrue(TEXT("Chunks on the main connection"), session.CountPackets(EWirePacketType::ChannelChunk) > 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackBlobChunksTest, "ULS.Loopback.BlobChunks",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackBlobChunksTest::RunTest(const FString& Parameters)
+{
+	FLoopbackSession session(ETransportFeatures::None);
+	session.Owner->BlobChunkSize = 256;
+	session.Owner->BlobBytesPerTick = 512;
+	session.Owner->BlobAckInterval = 1024;
+	session.Connect();
+
+	// Upload, announced right away and sent in chunks over the following ticks
+	const TArray<uint8> upload = MakeBytes(1500, 6);
+	UULSBlobTransfer* transfer = session.Owner->SendBlob(TEXT("Upload"), upload);
+
+	const TArray<FClientPacket> begins = session.GetPackets(EWirePacketType::BlobBegin);
+	int64 blobId = 0;
+	if (TestEqual(TEXT("BlobBegin sent"), begins.Num(), 1))
+	{
+		const ULSWire::FWireReader reader(begins[0].Payload.GetData(), begins[0].Payload.Num());
+		int32 position = 0;
+		blobId = reader.Read<int64>(position, position);
+		TestTrue(TEXT("Client blob ids are negative"), blobId < 0);
+		TestEqual(TEXT("Announced size"), reader.Read<int64>(position, position), (int64)upload.Num());
+		TestEqual(TEXT("Announced name"), ReadString(reader, position, position), FString(TEXT("Upload")));
+	}
+
+	session.Tick();
+	TestEqual(TEXT("Bytes per tick"), session.CountPackets(EWirePacketType::BlobChunk), 2);
+	session.Tick();
+	session.Tick();
+
+	TArray<uint8> uploaded;
+	for (const FClientPacket& chunk : session.GetPackets(EWirePacketType::BlobChunk))
+	{
+		const ULSWire::FWireReader reader(chunk.Payload.GetData(), chunk.Payload.Num());
+		int32 position = 0;
+		TestEqual(TEXT("Chunk blob"), reader.Read<int64>(position, position), blobId);
+		TestEqual(TEXT("Chunk offset"), reader.Read<int64>(position, position), (int64)uploaded.Num());
+		uploaded.Append(chunk.Payload.GetData() + position, chunk.Payload.Num() - position);
+	}
+	TestTrue(TEXT("Uploaded bytes"), uploaded == upload);
+	TestEqual(TEXT("Upload waits for the ack"), transfer->State, EULSBlobState::Transferring);
+
+	FULSPacketWriter uploadAck(EWirePacketType::BlobAck);
+	uploadAck.WriteInt64(blobId);
+	uploadAck.WriteInt64(upload.Num());
+	session.Server->SendPacket(uploadAck);
+	session.Tick();
+	TestEqual(TEXT("Upload completed"), transfer->State, EULSBlobState::Completed);
+	TestEqual(TEXT("Upload acknowledged"), transfer->TransferredSize, (int64)upload.Num());
+
+	// Download with a gap, the client tells where to continue
+	const TArray<uint8> download = MakeBytes(3000, 7);
+	FULSPacketWriter begin(EWirePacketType::BlobBegin);
+	begin.WriteInt64(7);
+	begin.WriteInt64(download.Num());
+	begin.WriteString(TEXT("Download"));
+	session.Server->SendPacket(begin);
+
+	const int32 offsets[] = { 0, 1000, 2500, 2000 };
+	for (const int32 offset : offsets)
+	{
+		const int32 size = (offset == 2000) ? 1000 : FMath::Min(1000, download.Num() - offset);
+		FULSPacketWriter chunk(EWirePacketType::BlobChunk);
+		chunk.WriteInt64(7);
+		chunk.WriteInt64(offset);
+		chunk.WriteBytes(TConstArrayView<uint8>(download.GetData() + offset, size));
+		session.Server->SendPacket(chunk);
+	}
+	session.Tick();
+
+	if (TestEqual(TEXT("Download started"), session.Owner->ReceivedBlobs.Num(), 1))
+	{
+		UULSBlobTransfer* received = session.Owner->ReceivedBlobs[0];
+		TestEqual(TEXT("Download name"), received->Name, FString(TEXT("Download")));
+		TestEqual(TEXT("Download completed"), received->State, EULSBlobState::Completed);
+		TestTrue(TEXT("Downloaded bytes"), received->GetBuffer() == download);
+	}
+
+	// Once past BlobAckInterval, for the gap and at the end
+	TArray<int64> ackedSizes;
+	for (const FClientPacket& ack : session.GetPackets(EWirePacketType::BlobAck))
+	{
+		const ULSWire::FWireReader reader(ack.Payload.GetData(), ack.Payload.Num());
+		int32 position = 0;
+		if (reader.Read<int64>(position, position) == 7)
+		{
+			ackedSizes.Add(reader.Read<int64>(position, position));
+		}
+	}
+	TestTrue(TEXT("Download acks"), ackedSizes == TArray<int64>({ 2000, 2000, 3000 }));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSLoopbackCaptureReplayTest, "ULS.Loopback.CaptureReplay",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSLoopbackCaptureReplayTest::RunTest(const FString& Parameters)
+{
+	const FString capturePath = TEXT("ULSTests/LoopbackCaptureReplay.ulscap");
+
+	// Record a short session
+	{
+		FLoopbackSession session(ETransportFeatures::None);
+		TestTrue(TEXT("Capture started"), session.Owner->StartCapture(capturePath));
+		session.Connect();
+
+		session.Server->SendCreateObject(1, GetObjectClassPath());
+		session.Server->SendReplication(1, { FULSReplicatedField::Int32(TEXT("Health"), 42), FULSReplicatedField::String(TEXT("Label"), TEXT("Captured")) });
+		session.Server->SendRpc(1, TEXT("ApplyHit"), {
+			FULSReplicatedField::Int32(TEXT("damage"), 2), FULSReplicatedField::Float(TEXT("force"), 1.0f), FULSReplicatedField::String(TEXT("source"), TEXT("Replay")) });
+		session.Tick();
+		session.Owner->StopCapture();
+		TestFalse(TEXT("Capture stopped"), session.Owner->IsCapturing());
+	}
+
+	// Every packet in both directions, in order
+	{
+		FULSCaptureReader reader;
+		if (TestTrue(TEXT("Capture readable"), reader.Open(capturePath)) == false)
+		{
+			return false;
+		}
+
+		TArray<int32> inbound;
+		TArray<int32> outbound;
+		FULSCaptureFrame frame;
+		while (reader.Next(frame))
+		{
+			const int32 packetType = *(const int32*)frame.Bytes.GetData() & UULSWirePacket::PacketTypeMask;
+			(frame.Direction == EULSCaptureDirection::Inbound ? inbound : outbound).Add(packetType);
+		}
+		TestTrue(TEXT("Inbound frames"), inbound == TArray<int32>({ EWirePacketType::ConnectionResponse, EWirePacketType::CreateObject, EWirePacketType::Replication, EWirePacketType::RpcCall }));
+		TestTrue(TEXT("Connection request recorded"), outbound.Num() > 0 && outbound[0] == EWirePacketType::ConnectionRequest);
+	}
+
+	// Played back into a fresh network owner
+	{
+		FLoopbackSession session(ETransportFeatures::None);
+		UULSReplayTransport* replay = NewObject<UULSReplayTransport>(session.Owner);
+		replay->CapturePath = capturePath;
+		replay->PlaybackRate = 0;
+		replay->ClientNetworkOwner = session.Owner;
+		session.Owner->Transport = replay;
+
+		TestTrue(TEXT("Replay connected"), replay->Connect());
+		TestEqual(TEXT("Inbound frames replayed"), replay->ReplayAll(), 4);
+		TestFalse(TEXT("Replay finished"), replay->IsConnected());
+
+		UULSTestObject* object = session.FindObject(1);
+		if (TestNotNull(TEXT("Object recreated"), object))
+		{
+			TestEqual(TEXT("Replicated and hit"), object->Health, 40);
+			TestEqual(TEXT("Replicated string"), object->Label, FString(TEXT("Captured")));
+			TestEqual(TEXT("RPC replayed"), object->NumHits, 1);
+		}
+	}
+
+	IFileManager::Get().Delete(*ULSCapture::ResolvePath(capturePath));
+	return true;
+}
+
+#endif
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSNetClock.h"
+#include "Algo/Sort.h"
+
+namespace
+{
+	/* Offset errors above this are corrected at once, smaller ones are slewed */
+	constexpr double StepThreshold = 0.25;
+
+	/* Share of the remaining offset error corrected per sample */
+	constexpr double SlewGain = 0.1;
+
+	/* Drift is only estimated over a window spanning at least this many seconds */
+	constexpr double MinDriftSpan = 10.0;
+
+	/* 1000 ppm, anything beyond that is measurement noise */
+	constexpr double MaxDrift = 0.001;
+}
+
+void FULSNetClock::AddSample(double localSendTime, double serverTime, double localReceiveTime)
+{
+	const double rtt = FMath::Max(localReceiveTime - localSendTime, 0.0);
+
+	Rtt.AddSample(rtt);
+
+	FSample& sample = Window[NextSample];
+	sample.LocalTime = localReceiveTime;
+	sample.Rtt = rtt;
+	sample.Offset = serverTime + rtt / 2 - localReceiveTime;
+	NextSample = (NextSample + 1) % WindowSize;
+	NumSamples = FMath::Min(NumSamples + 1, WindowSize);
+
+	UpdateDrift();
+
+	const FSample* best = &Window[0];
+	for (int32 i = 1; i < NumSamples; i++)
+	{
+		if (Window[i].Rtt < best->Rtt)
+		{
+			best = &Window[i];
+		}
+	}
+
+	// The best sample may be old, project it to now with the drift
+	const double target = best->Offset + Drift * (localReceiveTime - best->LocalTime);
+	const double current = GetClockOffset(localReceiveTime);
+	const double error = target - current;
+
+	Offset = (NumSamples == 1 || FMath::Abs(error) > StepThreshold) ? target : current + error * SlewGain;
+	OffsetTime = localReceiveTime;
+}
+
+void FULSNetClock::Reset()
+{
+	*this = FULSNetClock();
+}
+
+double FULSNetClock::GetRttPercentile(float fraction) const
+{
+	if (NumSamples == 0)
+	{
+		return 0;
+	}
+
+	double rtts[WindowSize];
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		rtts[i] = Window[i].Rtt;
+	}
+	Algo::Sort(MakeArrayView(rtts, NumSamples));
+
+	const int32 index = FMath::Clamp(FMath::CeilToInt(FMath::Clamp(fraction, 0.0f, 1.0f) * NumSamples) - 1, 0, NumSamples - 1);
+	return rtts[index];
+}
+
+double FULSNetClock::GetClockOffset(double localTime) const
+{
+	return Offset + Drift * (localTime - OffsetTime);
+}
+
+void FULSNetClock::UpdateDrift()
+{
+	if (NumSamples < 8)
+	{
+		return;
+	}
+
+	double minTime = Window[0].LocalTime;
+	double maxTime = Window[0].LocalTime;
+	double meanTime = 0;
+	double meanOffset = 0;
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		minTime = FMath::Min(minTime, Window[i].LocalTime);
+		maxTime = FMath::Max(maxTime, Window[i].LocalTime);
+		meanTime += Window[i].LocalTime;
+		meanOffset += Window[i].Offset;
+	}
+
+	if (maxTime - minTime < MinDriftSpan)
+	{
+		return;
+	}
+
+	meanTime /= NumSamples;
+	meanOffset /= NumSamples;
+
+	double covariance = 0;
+	double variance = 0;
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		const double dt = Window[i].LocalTime - meanTime;
+		covariance += dt * (Window[i].Offset - meanOffset);
+		variance += dt * dt;
+	}
+
+	if (variance > 0)
+	{
+		Drift = FMath::Clamp(covariance / variance, -MaxDrift, MaxDrift);
+	}
+}
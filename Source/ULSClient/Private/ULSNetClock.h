@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSRttEstimator.h"
+
+/**
+ * Round trip time and server clock estimation from Ping / Pong exchanges.
+ *
+ * RTT is smoothed with FULSRttEstimator, the variation being the reported jitter. Percentiles come from a sliding window of the most recent samples.
+ *
+ * Every sample also yields a clock offset, assuming the server stamped its time halfway through the
+ * round trip. The estimate follows the sample with the lowest RTT in the window, whose error is smallest,
+ * and is slewed towards it instead of stepping so server time never jumps backwards by small amounts.
+ * Drift between the clocks is the least squares slope of the window's offsets over local time.
+ */
+class FULSNetClock
+{
+public:
+	static constexpr int32 WindowSize = 64;
+
+	/* All times in seconds. localSendTime and localReceiveTime are FPlatformTime::Seconds(). */
+	void AddSample(double localSendTime, double serverTime, double localReceiveTime);
+
+	void Reset();
+
+	bool HasSamples() const { return NumSamples > 0; }
+
+	double GetSmoothedRtt() const { return Rtt.GetSmoothedRtt(); }
+
+	double GetRttVariation() const { return Rtt.GetRttVariation(); }
+
+	/* RTT below which the given fraction (0..1) of the recent samples lie */
+	double GetRttPercentile(float fraction) const;
+
+	/* Server time minus local time, at localTime */
+	double GetClockOffset(double localTime) const;
+
+	/* Seconds the server clock gains per local second */
+	double GetClockDrift() const { return Drift; }
+
+	double GetServerTime(double localTime) const { return localTime + GetClockOffset(localTime); }
+
+private:
+	struct FSample
+	{
+		double LocalTime = 0;
+		double Rtt = 0;
+		double Offset = 0;
+	};
+
+	void UpdateDrift();
+
+	FSample Window[WindowSize];
+	int32 NumSamples = 0;
+	int32 NextSample = 0;
+
+	FULSRttEstimator Rtt;
+
+	/* Offset estimate at OffsetTime, projected with Drift */
+	double Offset = 0;
+	double OffsetTime = 0;
+	double Drift = 0;
+};
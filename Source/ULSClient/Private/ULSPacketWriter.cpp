@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSPacketWriter.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSWirePacket.h"
+
+FULSReplicatedField FULSReplicatedField::Ref(const FString& name, int64 uniqueId)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::Reference;
+	field.IntValue = uniqueId;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::Int16(const FString& name, int16 value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::PrimitiveInt;
+	field.Size = sizeof(int16);
+	field.IntValue = value;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::Int32(const FString& name, int32 value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::PrimitiveInt;
+	field.Size = sizeof(int32);
+	field.IntValue = value;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::Int64(const FString& name, int64 value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::PrimitiveInt;
+	field.Size = sizeof(int64);
+	field.IntValue = value;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::Bool(const FString& name, bool value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::PrimitiveInt;
+	field.Size = 1;
+	field.IntValue = value ? 1 : 0;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::Float(const FString& name, float value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::PrimitiveFloat;
+	field.Size = sizeof(float);
+	field.FloatValue = value;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::Double(const FString& name, double value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::PrimitiveFloat;
+	field.Size = sizeof(double);
+	field.FloatValue = value;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::String(const FString& name, const FString& value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::String;
+	field.StringValue = value;
+	return field;
+}
+
+FULSReplicatedField FULSReplicatedField::Vector(const FString& name, const FVector& value)
+{
+	FULSReplicatedField field;
+	field.Name = name;
+	field.Type = EReplicatedFieldType::Vector3;
+	field.VectorValue = value;
+	return field;
+}
+
+FULSPacketWriter::FULSPacketWriter(int32 packetType, int32 initialCapacity)
+{
+	Bytes.Reserve(UULSWirePacket::HeaderSize + initialCapacity);
+	WriteInt32(packetType);
+}
+
+void FULSPacketWriter::WriteString(const FString& value)
+{
+	FTCHARToUTF8 utf8(*value);
+	WriteInt32(utf8.Length());
+	Bytes.Append((const uint8*)utf8.Get(), utf8.Length());
+}
+
+void FULSPacketWriter::WriteVector(const FVector& value)
+{
+	WriteFloat32((float)value.X);
+	WriteFloat32((float)value.Y);
+	WriteFloat32((float)value.Z);
+}
+
+void FULSPacketWriter::WriteField(const FULSReplicatedField& field)
+{
+	WriteInt8((int8)field.Type);
+	WriteString(field.Name);
+
+	switch (field.Type)
+	{
+	case EReplicatedFieldType::Reference:
+		WriteInt64(field.IntValue);
+		break;
+
+	case EReplicatedFieldType::PrimitiveInt:
+		WriteInt32(field.Size);
+		switch (field.Size)
+		{
+		case 1: WriteInt8((int8)field.IntValue); break;
+		case 2: WriteInt16((int16)field.IntValue); break;
+		case 8: WriteInt64(field.IntValue); break;
+		default: WriteInt32((int32)field.IntValue); break;
+		}
+		break;
+
+	case EReplicatedFieldType::PrimitiveFloat:
+		WriteInt32(field.Size);
+		if (field.Size == sizeof(float))
+		{
+			WriteFloat32((float)field.FloatValue);
+		}
+		else
+		{
+			WriteFloat64(field.FloatValue);
+		}
+		break;
+
+	case EReplicatedFieldType::String:
+		WriteString(field.StringValue);
+		break;
+
+	case EReplicatedFieldType::Vector3:
+		WriteVector(field.VectorValue);
+		break;
+	}
+}
+
+int32 FULSPacketWriter::GetPayloadSize() const
+{
+	return Bytes.Num() - UULSWirePacket::HeaderSize;
+}
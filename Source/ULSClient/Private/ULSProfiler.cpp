@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSProfiler.h"
+#include "ULSStats.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+bool FULSProfiler::bEnabled = false;
+
+namespace
+{
+	/* Class and field or method name */
+	typedef TPair<FName, FName> FProfileKey;
+
+	TMap<FProfileKey, FULSFieldProfile> FieldProfiles;
+	TMap<FProfileKey, FULSFieldProfile> RpcProfiles;
+
+	FULSFieldProfile& FindOrAddProfile(TMap<FProfileKey, FULSFieldProfile>& profiles, const UClass* cls, FName name)
+	{
+		return profiles.FindOrAdd(FProfileKey(cls != nullptr ? cls->GetFName() : NAME_None, name));
+	}
+
+	void StartProfileCommand()
+	{
+		FULSProfiler::SetEnabled(true);
+	}
+
+	void StopProfileCommand()
+	{
+		FULSProfiler::SetEnabled(false);
+	}
+
+	void ResetProfileCommand()
+	{
+		FULSProfiler::Reset();
+	}
+
+	void DumpProfileCommand(const TArray<FString>& args)
+	{
+		const FString path = args.Num() > 0 ? args[0] :
+			FPaths::Combine(TEXT("Profiling"), TEXT("ULS"), TEXT("Fields-") + FDateTime::Now().ToString() + TEXT(".csv"));
+		FULSProfiler::DumpCsv(path);
+	}
+
+	FAutoConsoleCommand ProfileStartCommand(TEXT("uls.Profile.Start"),
+		TEXT("Starts attributing replication and RPC bytes and time to classes, fields and methods."),
+		FConsoleCommandDelegate::CreateStatic(&StartProfileCommand));
+
+	FAutoConsoleCommand ProfileStopCommand(TEXT("uls.Profile.Stop"),
+		TEXT("Stops the profiler, keeping what it recorded."),
+		FConsoleCommandDelegate::CreateStatic(&StopProfileCommand));
+
+	FAutoConsoleCommand ProfileResetCommand(TEXT("uls.Profile.Reset"),
+		TEXT("Clears what the profiler recorded."),
+		FConsoleCommandDelegate::CreateStatic(&ResetProfileCommand));
+
+	FAutoConsoleCommand ProfileDumpCommand(TEXT("uls.Profile.Dump"),
+		TEXT("Writes what the profiler recorded as CSV. Optional file, relative to the Saved directory."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&DumpProfileCommand));
+}
+
+void FULSProfiler::SetEnabled(bool bInEnabled)
+{
+	check(IsInGameThread());
+	bEnabled = bInEnabled;
+	UE_LOG(LogULS, Display, TEXT("FULSProfiler: %s"), bEnabled ? TEXT("Started") : TEXT("Stopped"));
+}
+
+void FULSProfiler::Reset()
+{
+	check(IsInGameThread());
+	FieldProfiles.Reset();
+	RpcProfiles.Reset();
+}
+
+void FULSProfiler::RecordFieldBytes(const UClass* cls, FName fieldName, int32 numBytes)
+{
+	FindOrAddProfile(FieldProfiles, cls, fieldName).Bytes += numBytes;
+}
+
+void FULSProfiler::RecordFieldApply(const UClass* cls, FName fieldName, bool bChanged, uint64 applyCycles, uint64 onRepCycles)
+{
+	FULSFieldProfile& profile = FindOrAddProfile(FieldProfiles, cls, fieldName);
+	profile.Updates++;
+	if (bChanged == false)
+	{
+		profile.Unchanged++;
+	}
+	profile.ApplyCycles += applyCycles;
+	profile.OnRepCycles += onRepCycles;
+}
+
+void FULSProfiler::RecordRpc(const UClass* cls, FName methodName, int32 numBytes, uint64 cycles)
+{
+	FULSFieldProfile& profile = FindOrAddProfile(RpcProfiles, cls, methodName);
+	profile.Updates++;
+	profile.Bytes += numBytes;
+	profile.ApplyCycles += cycles;
+}
+
+bool FULSProfiler::DumpCsv(const FString& path)
+{
+	check(IsInGameThread());
+
+	struct FRow
+	{
+		const TCHAR* Kind;
+		const FProfileKey* Key;
+		const FULSFieldProfile* Profile;
+	};
+	TArray<FRow> rows;
+	rows.Reserve(FieldProfiles.Num() + RpcProfiles.Num());
+	for (const TPair<FProfileKey, FULSFieldProfile>& entry : FieldProfiles)
+	{
+		rows.Add({ TEXT("Field"), &entry.Key, &entry.Value });
+	}
+	for (const TPair<FProfileKey, FULSFieldProfile>& entry : RpcProfiles)
+	{
+		rows.Add({ TEXT("Rpc"), &entry.Key, &entry.Value });
+	}
+	rows.Sort([](const FRow& a, const FRow& b) { return a.Profile->Bytes > b.Profile->Bytes; });
+
+	FString csv = TEXT("Kind,Class,Name,Updates,Unchanged,UnchangedPercent,Bytes,BytesPerUpdate,ApplyMs,OnRepMs,ApplyUsPerUpdate\n");
+	for (const FRow& row : rows)
+	{
+		const FULSFieldProfile& profile = *row.Profile;
+		const double applyMs = FPlatformTime::ToMilliseconds64(profile.ApplyCycles);
+		const double onRepMs = FPlatformTime::ToMilliseconds64(profile.OnRepCycles);
+		const int64 updates = FMath::Max<int64>(profile.Updates, 1);
+		csv += FString::Printf(TEXT("%s,%s,%s,%lld,%lld,%.1f,%lld,%.1f,%.3f,%.3f,%.2f\n"),
+			row.Kind, *row.Key->Key.ToString(), *row.Key->Value.ToString(),
+			profile.Updates, profile.Unchanged, 100.0 * profile.Unchanged / updates,
+			profile.Bytes, (double)profile.Bytes / updates,
+			applyMs, onRepMs, 1000.0 * (applyMs + onRepMs) / updates);
+	}
+
+	const FString fullPath = FPaths::IsRelative(path) ? FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir(), path) : path;
+	if (FFileHelper::SaveStringToFile(csv, *fullPath) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSProfiler: Failed to write %s"), *fullPath);
+		return false;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("FULSProfiler: Wrote %d rows to %s"), rows.Num(), *fullPath);
+	return true;
+}
+
+FULSProfiler::FRpcScope::FRpcScope(const UClass* cls, const FString& methodName, int32 numBytes)
+{
+	if (IsEnabled())
+	{
+		Class = cls;
+		MethodName = FName(*methodName);
+		NumBytes = numBytes;
+		StartCycles = FPlatformTime::Cycles64();
+	}
+}
+
+FULSProfiler::FRpcScope::~FRpcScope()
+{
+	if (StartCycles != 0 && IsEnabled())
+	{
+		RecordRpc(Class, MethodName, NumBytes, FPlatformTime::Cycles64() - StartCycles);
+	}
+}
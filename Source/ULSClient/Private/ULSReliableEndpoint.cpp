@@ -0,0 +1,495 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSReliableEndpoint.h"
+#include "ULSStats.h"
+
+namespace
+{
+	// Message ids a receive channel keeps track of. The sender never runs further ahead than that.
+	constexpr int32 MessageWindow = 1024;
+	constexpr int32 SentDatagramHistory = 1024;
+	constexpr int32 MaxPartialUnreliable = 64;
+	constexpr double MinRetransmitTimeout = 0.05;
+	constexpr double MaxRetransmitTimeout = 2.0;
+	constexpr uint8 FragmentFlag = 0x80;
+
+	void AppendUInt16(TArray<uint8>& buffer, uint16 value)
+	{
+		buffer.Append((const uint8*)&value, sizeof(uint16));
+	}
+
+	uint16 ReadUInt16(const uint8* data)
+	{
+		uint16 value;
+		FMemory::Memcpy(&value, data, sizeof(uint16));
+		return value;
+	}
+
+	uint32 ReadUInt32(const uint8* data)
+	{
+		uint32 value;
+		FMemory::Memcpy(&value, data, sizeof(uint32));
+		return value;
+	}
+}
+
+FULSReliableEndpoint::FULSReliableEndpoint(int32 mtu)
+	: Mtu(FMath::Max(mtu, DatagramHeaderSize + MessageHeaderSize + FragmentHeaderSize + 64))
+{
+	SentDatagrams.SetNum(SentDatagramHistory);
+	ReceiveChannels[(int32)EULSDeliveryChannel::ReliableUnordered].Delivered.Init(false, MessageWindow);
+	DatagramBuffer.Reserve(Mtu);
+}
+
+void FULSReliableEndpoint::Send(EULSDeliveryChannel channel, TConstArrayView<uint8> message)
+{
+	const int32 maxFragmentSize = GetMaxFragmentSize();
+	const int32 fragmentCount = FMath::Max(1, FMath::DivideAndRoundUp(message.Num(), maxFragmentSize));
+	if (fragmentCount > MAX_uint16)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSReliableEndpoint::Send: Message of %d bytes is too large"), message.Num());
+		return;
+	}
+
+	const uint16 messageId = NextMessageIds[(int32)channel]++;
+	for (int32 i = 0; i < fragmentCount; i++)
+	{
+		const int32 offset = i * maxFragmentSize;
+		const int32 size = FMath::Min(maxFragmentSize, message.Num() - offset);
+
+		FOutgoingFragment fragment;
+		fragment.Channel = channel;
+		fragment.MessageId = messageId;
+		fragment.FragmentIndex = (uint16)i;
+		fragment.FragmentCount = (uint16)fragmentCount;
+		fragment.Data.Append(message.GetData() + offset, size);
+
+		if (channel == EULSDeliveryChannel::UnreliableSequenced)
+		{
+			OutgoingUnreliable.Add(MoveTemp(fragment));
+		}
+		else
+		{
+			const uint64 key = MakeFragmentKey(channel, messageId, (uint16)i);
+			Outgoing.Add(key, MoveTemp(fragment));
+			OutgoingOrder.Add(key);
+		}
+	}
+}
+
+void FULSReliableEndpoint::ReceiveDatagram(TConstArrayView<uint8> datagram, double now)
+{
+	if (datagram.Num() < DatagramHeaderSize || datagram[0] != (uint8)EULSDatagramKind::Data)
+	{
+		return;
+	}
+
+	const uint8* data = datagram.GetData();
+	const uint16 sequence = ReadUInt16(data + 1);
+	const uint16 ack = ReadUInt16(data + 3);
+	const uint32 ackBits = ReadUInt32(data + 5);
+	const int32 numMessages = data[9];
+
+	LastReceiveTime = now;
+
+	// Track the datagram for our own acks. Duplicates are dropped, their messages were handled already.
+	if (!bReceivedAnyDatagram)
+	{
+		bReceivedAnyDatagram = true;
+		RemoteSequence = sequence;
+		RemoteAckBits = 0;
+	}
+	else if (SequenceGreaterThan(sequence, RemoteSequence))
+	{
+		const uint32 shift = (uint16)(sequence - RemoteSequence);
+		RemoteAckBits = (shift <= 32 ? (uint32)(((uint64)RemoteAckBits << shift) | (1ull << (shift - 1))) : 0);
+		RemoteSequence = sequence;
+	}
+	else
+	{
+		const uint32 distance = (uint16)(RemoteSequence - sequence);
+		if (distance == 0)
+		{
+			return;
+		}
+		if (distance <= 32)
+		{
+			const uint32 bit = 1u << (distance - 1);
+			if (RemoteAckBits & bit)
+			{
+				return;
+			}
+			RemoteAckBits |= bit;
+		}
+	}
+	bAckPending = bAckPending || numMessages > 0;
+
+	ProcessAck(ack, ackBits, now);
+
+	int32 position = DatagramHeaderSize;
+	for (int32 i = 0; i < numMessages; i++)
+	{
+		if (position + MessageHeaderSize > datagram.Num())
+		{
+			return;
+		}
+
+		const uint8 channelByte = data[position];
+		const bool bFragment = (channelByte & FragmentFlag) != 0;
+		const uint8 channelIndex = channelByte & ~FragmentFlag;
+		if (channelIndex > (uint8)EULSDeliveryChannel::UnreliableSequenced)
+		{
+			return;
+		}
+
+		const uint16 messageId = ReadUInt16(data + position + 1);
+		position += 3;
+
+		uint16 fragmentIndex = 0;
+		uint16 fragmentCount = 1;
+		if (bFragment)
+		{
+			if (position + FragmentHeaderSize + 2 > datagram.Num())
+			{
+				return;
+			}
+			fragmentIndex = ReadUInt16(data + position);
+			fragmentCount = ReadUInt16(data + position + 2);
+			position += FragmentHeaderSize;
+		}
+
+		const int32 length = ReadUInt16(data + position);
+		position += 2;
+		if (position + length > datagram.Num() || fragmentCount == 0 || fragmentIndex >= fragmentCount)
+		{
+			return;
+		}
+
+		ReceiveFragment((EULSDeliveryChannel)channelIndex, messageId, fragmentIndex, fragmentCount, TConstArrayView<uint8>(data + position, length));
+		position += length;
+	}
+}
+
+void FULSReliableEndpoint::ProcessAck(uint16 ack, uint32 ackBits, double now)
+{
+	AcknowledgeDatagram(ack, now);
+	for (int32 i = 0; i < 32; i++)
+	{
+		if (ackBits & (1u << i))
+		{
+			AcknowledgeDatagram((uint16)(ack - 1 - i), now);
+		}
+	}
+}
+
+void FULSReliableEndpoint::AcknowledgeDatagram(uint16 sequence, double now)
+{
+	FSentDatagram& sent = SentDatagrams[sequence % SentDatagramHistory];
+	if (!sent.bValid || sent.Sequence != sequence)
+	{
+		return;
+	}
+	sent.bValid = false;
+
+	// Karn's algorithm: resent fragments make the sample ambiguous. Datagrams without messages are only acked
+	// along with the next data of the remote side, which would count its send interval as round trip time.
+	if (!sent.bContainsResend && sent.bCarriesMessages)
+	{
+		AddRttSample(now - sent.SendTime);
+	}
+
+	for (uint64 key : sent.FragmentKeys)
+	{
+		Outgoing.Remove(key);
+	}
+	sent.FragmentKeys.Reset();
+}
+
+void FULSReliableEndpoint::AddRttSample(double rtt)
+{
+	Rtt.AddSample(rtt);
+	RetransmitTimeout = Rtt.GetRetransmitTimeout(MinRetransmitTimeout, MaxRetransmitTimeout);
+}
+
+void FULSReliableEndpoint::ReceiveFragment(EULSDeliveryChannel channel, uint16 messageId, uint16 fragmentIndex, uint16 fragmentCount, TConstArrayView<uint8> data)
+{
+	FReceiveChannel& receive = ReceiveChannels[(int32)channel];
+
+	// Drop what was delivered already
+	if (channel == EULSDeliveryChannel::UnreliableSequenced)
+	{
+		if (receive.bReceivedAny && !SequenceGreaterThan(messageId, receive.NextMessageId - 1))
+		{
+			return;
+		}
+	}
+	else
+	{
+		if ((uint16)(messageId - receive.NextMessageId) >= MessageWindow)
+		{
+			return;
+		}
+		if (channel == EULSDeliveryChannel::ReliableOrdered ? receive.Completed.Contains(messageId) : receive.Delivered[messageId % MessageWindow])
+		{
+			return;
+		}
+	}
+
+	TArray<uint8> message;
+	if (fragmentCount == 1)
+	{
+		message.Append(data.GetData(), data.Num());
+	}
+	else
+	{
+		if (fragmentCount > FMath::DivideAndRoundUp(MaxMessageSize, GetMaxFragmentSize()))
+		{
+			UE_LOG(LogULS, Warning, TEXT("FULSReliableEndpoint::ReceiveFragment: Dropped fragment of message %d with %d fragments, more than MaxMessageSize allows"), messageId, fragmentCount);
+			return;
+		}
+		if (PartialBytes + data.Num() > MaxPartialBytes)
+		{
+			UE_LOG(LogULS, Warning, TEXT("FULSReliableEndpoint::ReceiveFragment: Dropped fragment of message %d, incomplete messages hold %d bytes already"), messageId, PartialBytes);
+			return;
+		}
+
+		FReassembly& reassembly = receive.Partial.FindOrAdd(messageId);
+		if (reassembly.Fragments.Num() != fragmentCount)
+		{
+			PartialBytes -= reassembly.NumBytes;
+			reassembly.Fragments.Reset();
+			reassembly.Fragments.SetNum(fragmentCount);
+			reassembly.NumReceived = 0;
+			reassembly.NumBytes = 0;
+		}
+
+		TArray<uint8>& fragment = reassembly.Fragments[fragmentIndex];
+		if (fragment.Num() > 0 || reassembly.NumReceived == fragmentCount)
+		{
+			return;
+		}
+		// Only the last fragment may be shorter, so an empty fragment can't be confused with a missing one
+		fragment.Append(data.GetData(), data.Num());
+		reassembly.NumReceived++;
+		reassembly.NumBytes += data.Num();
+		PartialBytes += data.Num();
+
+		if (reassembly.NumReceived < fragmentCount)
+		{
+			if (channel == EULSDeliveryChannel::UnreliableSequenced && receive.Partial.Num() > MaxPartialUnreliable)
+			{
+				// Lost fragments of unreliable messages are never resent. Forget the oldest ones.
+				const uint16 newest = messageId;
+				for (auto it = receive.Partial.CreateIterator(); it; ++it)
+				{
+					if ((uint16)(newest - it.Key()) >= MaxPartialUnreliable)
+					{
+						PartialBytes -= it.Value().NumBytes;
+						it.RemoveCurrent();
+					}
+				}
+			}
+			return;
+		}
+
+		message.Reserve(reassembly.NumBytes);
+		for (const TArray<uint8>& part : reassembly.Fragments)
+		{
+			message.Append(part);
+		}
+		PartialBytes -= reassembly.NumBytes;
+		receive.Partial.Remove(messageId);
+	}
+
+	DeliverMessage(channel, messageId, MoveTemp(message));
+}
+
+void FULSReliableEndpoint::DeliverMessage(EULSDeliveryChannel channel, uint16 messageId, TArray<uint8>&& message)
+{
+	FReceiveChannel& receive = ReceiveChannels[(int32)channel];
+
+	switch (channel)
+	{
+	case EULSDeliveryChannel::ReliableOrdered:
+		receive.Completed.Add(messageId, MoveTemp(message));
+		while (TArray<uint8>* next = receive.Completed.Find(receive.NextMessageId))
+		{
+			TArray<uint8> ready = MoveTemp(*next);
+			receive.Completed.Remove(receive.NextMessageId);
+			receive.NextMessageId++;
+			if (OnReceiveMessage)
+			{
+				OnReceiveMessage(channel, MoveTemp(ready));
+			}
+		}
+		break;
+
+	case EULSDeliveryChannel::ReliableUnordered:
+		// Ids behind NextMessageId count as delivered, the window only tracks the ones after it
+		receive.Delivered[messageId % MessageWindow] = true;
+		while (receive.Delivered[receive.NextMessageId % MessageWindow])
+		{
+			receive.Delivered[receive.NextMessageId % MessageWindow] = false;
+			receive.NextMessageId++;
+		}
+		if (OnReceiveMessage)
+		{
+			OnReceiveMessage(channel, MoveTemp(message));
+		}
+		break;
+
+	case EULSDeliveryChannel::UnreliableSequenced:
+		receive.bReceivedAny = true;
+		receive.NextMessageId = messageId + 1;
+		for (auto it = receive.Partial.CreateIterator(); it; ++it)
+		{
+			if (!SequenceGreaterThan(it.Key(), messageId))
+			{
+				PartialBytes -= it.Value().NumBytes;
+				it.RemoveCurrent();
+			}
+		}
+		if (OnReceiveMessage)
+		{
+			OnReceiveMessage(channel, MoveTemp(message));
+		}
+		break;
+	}
+}
+
+void FULSReliableEndpoint::BeginDatagram(double now)
+{
+	DatagramBuffer.Reset();
+	DatagramBuffer.AddZeroed(DatagramHeaderSize);
+	DatagramMessageCount = 0;
+
+	FSentDatagram& sent = SentDatagrams[NextSequence % SentDatagramHistory];
+	sent.Sequence = NextSequence;
+	sent.bValid = true;
+	sent.bContainsResend = false;
+	sent.SendTime = now;
+	sent.FragmentKeys.Reset();
+}
+
+void FULSReliableEndpoint::FinishDatagram(double now)
+{
+	uint8* header = DatagramBuffer.GetData();
+	header[0] = (uint8)EULSDatagramKind::Data;
+	FMemory::Memcpy(header + 1, &NextSequence, sizeof(uint16));
+	FMemory::Memcpy(header + 3, &RemoteSequence, sizeof(uint16));
+	FMemory::Memcpy(header + 5, &RemoteAckBits, sizeof(uint32));
+	header[9] = (uint8)DatagramMessageCount;
+	SentDatagrams[NextSequence % SentDatagramHistory].bCarriesMessages = DatagramMessageCount > 0;
+
+	NextSequence++;
+	bAckPending = false;
+	LastSendTime = now;
+
+	if (OnSendDatagram)
+	{
+		OnSendDatagram(DatagramBuffer);
+	}
+}
+
+void FULSReliableEndpoint::Update(double now)
+{
+	bool bDatagramOpen = false;
+
+	auto writeFragment = [&](const FOutgoingFragment& fragment, uint64 key, bool bResend)
+	{
+		const bool bFragment = fragment.FragmentCount > 1;
+		const int32 size = MessageHeaderSize + (bFragment ? FragmentHeaderSize : 0) + fragment.Data.Num();
+		if (bDatagramOpen && (DatagramBuffer.Num() + size > Mtu || DatagramMessageCount == MAX_uint8))
+		{
+			FinishDatagram(now);
+			bDatagramOpen = false;
+		}
+		if (!bDatagramOpen)
+		{
+			BeginDatagram(now);
+			bDatagramOpen = true;
+		}
+
+		DatagramBuffer.Add((uint8)fragment.Channel | (bFragment ? FragmentFlag : 0));
+		AppendUInt16(DatagramBuffer, fragment.MessageId);
+		if (bFragment)
+		{
+			AppendUInt16(DatagramBuffer, fragment.FragmentIndex);
+			AppendUInt16(DatagramBuffer, fragment.FragmentCount);
+		}
+		AppendUInt16(DatagramBuffer, (uint16)fragment.Data.Num());
+		DatagramBuffer.Append(fragment.Data);
+		DatagramMessageCount++;
+
+		if (fragment.Channel != EULSDeliveryChannel::UnreliableSequenced)
+		{
+			FSentDatagram& sent = SentDatagrams[NextSequence % SentDatagramHistory];
+			sent.FragmentKeys.Add(key);
+			sent.bContainsResend |= bResend;
+		}
+	};
+
+	// Drop acknowledged fragments from the send order and find the oldest unacknowledged message per channel
+	int32 numInFlight = 0;
+	uint16 windowStart[2] = { NextMessageIds[0], NextMessageIds[1] };
+	bool bWindowStartFound[2] = {};
+	OutgoingOrder.RemoveAll([&](uint64 key)
+	{
+		const FOutgoingFragment* fragment = Outgoing.Find(key);
+		if (fragment == nullptr)
+		{
+			return true;
+		}
+		const int32 channelIndex = (int32)fragment->Channel;
+		if (!bWindowStartFound[channelIndex])
+		{
+			bWindowStartFound[channelIndex] = true;
+			windowStart[channelIndex] = fragment->MessageId;
+		}
+		numInFlight += (fragment->SendCount > 0 ? 1 : 0);
+		return false;
+	});
+
+	for (uint64 key : OutgoingOrder)
+	{
+		FOutgoingFragment& fragment = Outgoing[key];
+		if (fragment.SendCount == 0)
+		{
+			const uint16 distance = fragment.MessageId - windowStart[(int32)fragment.Channel];
+			if (numInFlight >= MaxFragmentsInFlight || distance >= MessageWindow)
+			{
+				continue;
+			}
+			numInFlight++;
+		}
+		else
+		{
+			const double timeout = RetransmitTimeout * (double)(1 << FMath::Min(fragment.SendCount - 1, 5));
+			if (now - fragment.LastSendTime < timeout)
+			{
+				continue;
+			}
+		}
+
+		writeFragment(fragment, key, fragment.SendCount > 0);
+		fragment.LastSendTime = now;
+		fragment.SendCount++;
+	}
+
+	for (const FOutgoingFragment& fragment : OutgoingUnreliable)
+	{
+		writeFragment(fragment, 0, false);
+	}
+	OutgoingUnreliable.Reset();
+
+	if (!bDatagramOpen && (bAckPending || now - LastSendTime >= KeepAliveInterval))
+	{
+		BeginDatagram(now);
+		bDatagramOpen = true;
+	}
+	if (bDatagramOpen)
+	{
+		FinishDatagram(now);
+	}
+}
@@ -0,0 +1,417 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSReliableEndpoint.h"
+#include "Misc/AutomationTest.h"
+#include "Algo/Reverse.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Protocol tests of FULSReliableEndpoint against a loopback peer: a second endpoint wired back to back
+* through an in-memory link that drops, duplicates and reorders datagrams. Time is simulated, every
+* Step advances it by a fixed amount, updates both endpoints and then delivers what they sent.
+*/
+
+namespace
+{
+	constexpr double StepSeconds = 0.01;
+
+	struct FReceivedMessage
+	{
+		EULSDeliveryChannel Channel;
+		TArray<uint8> Bytes;
+	};
+
+	/* Datagrams from one endpoint to the other */
+	struct FLoopbackLink
+	{
+		TArray<TArray<uint8>> InFlight;
+		int32 NumSent = 0;
+
+		/* Called with the running index of every datagram, returns true to drop it */
+		TFunction<bool(int32)> ShouldDrop;
+		bool bDuplicate = false;
+		bool bReverse = false;
+
+		void Deliver(FULSReliableEndpoint& receiver, double now)
+		{
+			TArray<TArray<uint8>> datagrams = MoveTemp(InFlight);
+			InFlight.Reset();
+			if (bReverse)
+			{
+				Algo::Reverse(datagrams);
+			}
+			for (const TArray<uint8>& datagram : datagrams)
+			{
+				receiver.ReceiveDatagram(datagram, now);
+				if (bDuplicate)
+				{
+					receiver.ReceiveDatagram(datagram, now);
+				}
+			}
+		}
+	};
+
+	struct FLoopbackPeers
+	{
+		FULSReliableEndpoint Client;
+		FULSReliableEndpoint Server;
+		FLoopbackLink ToServer;
+		FLoopbackLink ToClient;
+		TArray<FReceivedMessage> ReceivedByServer;
+		TArray<FReceivedMessage> ReceivedByClient;
+		double Now = 0;
+
+		FLoopbackPeers()
+		{
+			Wire(Client, ToServer, ReceivedByClient);
+			Wire(Server, ToClient, ReceivedByServer);
+		}
+
+		void Step()
+		{
+			Now += StepSeconds;
+			Client.Update(Now);
+			Server.Update(Now);
+			ToServer.Deliver(Server, Now);
+			ToClient.Deliver(Client, Now);
+		}
+
+		/* Steps until the server received numMessages and the client saw all of them acknowledged */
+		bool RunUntilDelivered(int32 numMessages, double timeout)
+		{
+			const double deadline = Now + timeout;
+			while (Now < deadline)
+			{
+				Step();
+				if (ReceivedByServer.Num() >= numMessages && Client.GetNumUnackedFragments() == 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+	private:
+		static void Wire(FULSReliableEndpoint& endpoint, FLoopbackLink& outgoing, TArray<FReceivedMessage>& received)
+		{
+			endpoint.OnSendDatagram = [&outgoing](TConstArrayView<uint8> datagram)
+			{
+				const int32 index = outgoing.NumSent++;
+				if (outgoing.ShouldDrop && outgoing.ShouldDrop(index))
+				{
+					return;
+				}
+				outgoing.InFlight.Emplace(datagram.GetData(), datagram.Num());
+			};
+			endpoint.OnReceiveMessage = [&received](EULSDeliveryChannel channel, TArray<uint8>&& bytes)
+			{
+				received.Add(FReceivedMessage{ channel, MoveTemp(bytes) });
+			};
+		}
+	};
+
+	/* Index in the first four bytes, followed by a pattern derived from it */
+	TArray<uint8> MakeMessage(int32 index, int32 size)
+	{
+		TArray<uint8> message;
+		message.SetNumUninitialized(FMath::Max(size, (int32)sizeof(int32)));
+		FMemory::Memcpy(message.GetData(), &index, sizeof(int32));
+		for (int32 i = sizeof(int32); i < message.Num(); i++)
+		{
+			message[i] = (uint8)(index * 13 + i * 7);
+		}
+		return message;
+	}
+
+	int32 GetMessageIndex(const FReceivedMessage& message)
+	{
+		int32 index = -1;
+		if (message.Bytes.Num() >= (int32)sizeof(int32))
+		{
+			FMemory::Memcpy(&index, message.Bytes.GetData(), sizeof(int32));
+		}
+		return index;
+	}
+
+	/* Sizes from a few bytes to several fragments */
+	int32 GetMessageSize(int32 index)
+	{
+		return 4 + (index * 397) % 4000;
+	}
+
+	void SendMessages(FULSReliableEndpoint& endpoint, EULSDeliveryChannel channel, int32 numMessages)
+	{
+		for (int32 i = 0; i < numMessages; i++)
+		{
+			endpoint.Send(channel, MakeMessage(i, GetMessageSize(i)));
+		}
+	}
+
+	/* Every message exactly once with the right contents, and in send order if bOrdered */
+	void TestReceivedAll(FAutomationTestBase& test, const TArray<FReceivedMessage>& received, int32 numMessages, bool bOrdered)
+	{
+		test.TestEqual(TEXT("Messages received"), received.Num(), numMessages);
+
+		TBitArray<> seen(false, numMessages);
+		for (int32 i = 0; i < received.Num(); i++)
+		{
+			const int32 index = GetMessageIndex(received[i]);
+			if (index < 0 || index >= numMessages)
+			{
+				test.AddError(FString::Printf(TEXT("Unexpected message index %d"), index));
+				continue;
+			}
+			if (seen[index])
+			{
+				test.AddError(FString::Printf(TEXT("Message %d delivered twice"), index));
+			}
+			seen[index] = true;
+
+			if (bOrdered && index != i)
+			{
+				test.AddError(FString::Printf(TEXT("Message %d delivered at position %d"), index, i));
+			}
+			if (received[i].Bytes != MakeMessage(index, GetMessageSize(index)))
+			{
+				test.AddError(FString::Printf(TEXT("Message %d corrupted"), index));
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSReliableEndpointLossTest, "ULS.ReliableEndpoint.Loss",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSReliableEndpointLossTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumMessages = 200;
+
+	FLoopbackPeers peers;
+	peers.ToServer.ShouldDrop = [](int32 index) { return index % 3 == 1; };
+	peers.ToClient.ShouldDrop = [](int32 index) { return index % 4 == 2; };
+
+	SendMessages(peers.Client, EULSDeliveryChannel::ReliableOrdered, NumMessages);
+	TestTrue(TEXT("Delivered despite loss"), peers.RunUntilDelivered(NumMessages, 30.0));
+	TestReceivedAll(*this, peers.ReceivedByServer, NumMessages, true);
+
+	TestTrue(TEXT("RTT measured"), peers.Client.GetSmoothedRtt() > 0);
+	TestTrue(TEXT("Retransmit timeout follows the RTT"), peers.Client.GetRetransmitTimeout() < 1.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSReliableEndpointReorderTest, "ULS.ReliableEndpoint.Reordering",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSReliableEndpointReorderTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumMessages = 100;
+
+	// Everything sent in one update arrives in reverse
+	{
+		FLoopbackPeers peers;
+		peers.ToServer.bReverse = true;
+		SendMessages(peers.Client, EULSDeliveryChannel::ReliableOrdered, NumMessages);
+		TestTrue(TEXT("Ordered delivered"), peers.RunUntilDelivered(NumMessages, 10.0));
+		TestReceivedAll(*this, peers.ReceivedByServer, NumMessages, true);
+	}
+	{
+		FLoopbackPeers peers;
+		peers.ToServer.bReverse = true;
+		SendMessages(peers.Client, EULSDeliveryChannel::ReliableUnordered, NumMessages);
+		TestTrue(TEXT("Unordered delivered"), peers.RunUntilDelivered(NumMessages, 10.0));
+		TestReceivedAll(*this, peers.ReceivedByServer, NumMessages, false);
+	}
+
+	// Sequenced messages older than the newest one delivered are dropped
+	{
+		FLoopbackPeers peers;
+		peers.ToServer.bReverse = true;
+		for (int32 i = 0; i < NumMessages; i++)
+		{
+			peers.Client.Send(EULSDeliveryChannel::UnreliableSequenced, MakeMessage(i, 600));
+		}
+		peers.Step();
+		peers.Step();
+
+		TestTrue(TEXT("Sequenced delivered something"), peers.ReceivedByServer.Num() > 0);
+		int32 previous = -1;
+		for (const FReceivedMessage& message : peers.ReceivedByServer)
+		{
+			const int32 index = GetMessageIndex(message);
+			TestTrue(FString::Printf(TEXT("Sequenced message %d after %d"), index, previous), index > previous);
+			previous = index;
+		}
+		TestEqual(TEXT("Newest sequenced message delivered"), previous, NumMessages - 1);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSReliableEndpointDuplicateTest, "ULS.ReliableEndpoint.Duplicates",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSReliableEndpointDuplicateTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumMessages = 100;
+
+	const EULSDeliveryChannel channels[] = { EULSDeliveryChannel::ReliableOrdered, EULSDeliveryChannel::ReliableUnordered };
+	for (EULSDeliveryChannel channel : channels)
+	{
+		// Duplicated datagrams, plus resends of fragments whose acks were lost
+		FLoopbackPeers peers;
+		peers.ToServer.bDuplicate = true;
+		peers.ToClient.ShouldDrop = [](int32 index) { return index % 2 == 0; };
+
+		SendMessages(peers.Client, channel, NumMessages);
+		TestTrue(TEXT("Delivered"), peers.RunUntilDelivered(NumMessages, 30.0));
+
+		// Let late resends arrive as well
+		for (int32 i = 0; i < 300; i++)
+		{
+			peers.Step();
+		}
+		TestReceivedAll(*this, peers.ReceivedByServer, NumMessages, channel == EULSDeliveryChannel::ReliableOrdered);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSReliableEndpointFragmentationTest, "ULS.ReliableEndpoint.Fragmentation",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSReliableEndpointFragmentationTest::RunTest(const FString& Parameters)
+{
+	// One message of many fragments over a lossy link, followed by small ones that must wait for it
+	{
+		FLoopbackPeers peers;
+		peers.ToServer.ShouldDrop = [](int32 index) { return index % 5 == 3; };
+
+		const TArray<uint8> large = MakeMessage(0, 100 * 1024);
+		peers.Client.Send(EULSDeliveryChannel::ReliableOrdered, large);
+		peers.Client.Send(EULSDeliveryChannel::ReliableOrdered, MakeMessage(1, 8));
+		TestTrue(TEXT("Delivered"), peers.RunUntilDelivered(2, 30.0));
+
+		TestEqual(TEXT("Messages received"), peers.ReceivedByServer.Num(), 2);
+		if (peers.ReceivedByServer.Num() == 2)
+		{
+			TestTrue(TEXT("Large message reassembled"), peers.ReceivedByServer[0].Bytes == large);
+			TestEqual(TEXT("Small message after it"), GetMessageIndex(peers.ReceivedByServer[1]), 1);
+		}
+	}
+
+	// Fragmented sequenced message, delivered whole or not at all
+	{
+		FLoopbackPeers peers;
+		const TArray<uint8> large = MakeMessage(0, 10 * 1024);
+		peers.Client.Send(EULSDeliveryChannel::UnreliableSequenced, large);
+		peers.Step();
+
+		TestEqual(TEXT("Sequenced message received"), peers.ReceivedByServer.Num(), 1);
+		if (peers.ReceivedByServer.Num() == 1)
+		{
+			TestTrue(TEXT("Sequenced message reassembled"), peers.ReceivedByServer[0].Bytes == large);
+		}
+	}
+	{
+		FLoopbackPeers peers;
+		peers.ToServer.ShouldDrop = [](int32 index) { return index == 2; };
+		peers.Client.Send(EULSDeliveryChannel::UnreliableSequenced, MakeMessage(0, 10 * 1024));
+		for (int32 i = 0; i < 100; i++)
+		{
+			peers.Step();
+		}
+		TestEqual(TEXT("Sequenced message with a lost fragment dropped"), peers.ReceivedByServer.Num(), 0);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSReliableEndpointBackoffTest, "ULS.ReliableEndpoint.RetransmitBackoff",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSReliableEndpointBackoffTest::RunTest(const FString& Parameters)
+{
+	FLoopbackPeers peers;
+
+	// Nothing reaches the server, so the timeout stays at its initial second and doubles with every resend
+	TArray<double> dataSendTimes;
+	peers.Client.OnSendDatagram = [&peers, &dataSendTimes](TConstArrayView<uint8> datagram)
+	{
+		// Keep-alives carry no messages
+		if (datagram.Num() > FULSReliableEndpoint::DatagramHeaderSize && datagram[9] > 0)
+		{
+			dataSendTimes.Add(peers.Now);
+		}
+	};
+
+	const double initialTimeout = peers.Client.GetRetransmitTimeout();
+	peers.Client.Send(EULSDeliveryChannel::ReliableOrdered, MakeMessage(0, 100));
+	while (peers.Now < 40.0)
+	{
+		peers.Step();
+	}
+
+	// First send, then resends after 1, 2, 4, 8 and 16 timeouts
+	TestEqual(TEXT("Sends"), dataSendTimes.Num(), 6);
+	for (int32 i = 1; i < dataSendTimes.Num(); i++)
+	{
+		const double expected = initialTimeout * (double)(1 << (i - 1));
+		const double interval = dataSendTimes[i] - dataSendTimes[i - 1];
+		TestTrue(FString::Printf(TEXT("Resend %d after %.2fs, expected %.2fs"), i, interval, expected),
+			interval >= expected - KINDA_SMALL_NUMBER && interval <= expected + StepSeconds + KINDA_SMALL_NUMBER);
+	}
+	TestEqual(TEXT("Still unacknowledged"), peers.Client.GetNumUnackedFragments(), 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSReliableEndpointLimitsTest, "ULS.ReliableEndpoint.Limits",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSReliableEndpointLimitsTest::RunTest(const FString& Parameters)
+{
+	// Keep-alives are only acknowledged along with the next datagram of the remote side and give no RTT sample
+	{
+		FLoopbackPeers peers;
+		while (peers.Now < 5.0)
+		{
+			peers.Step();
+		}
+		TestEqual(TEXT("No RTT from keep-alives"), peers.Client.GetSmoothedRtt(), 0.0);
+
+		peers.Client.Send(EULSDeliveryChannel::ReliableOrdered, MakeMessage(0, 100));
+		TestTrue(TEXT("Delivered"), peers.RunUntilDelivered(1, 5.0));
+		TestTrue(TEXT("RTT of the message"), peers.Client.GetSmoothedRtt() > 0 && peers.Client.GetSmoothedRtt() < 0.1);
+	}
+
+	// A fragment count above MaxMessageSize is dropped before anything is allocated for it
+	{
+		FLoopbackPeers peers;
+		TArray<uint8> datagram = { (uint8)EULSDatagramKind::Data, 0, 0, 0xFF, 0xFF, 0, 0, 0, 0, 1 };
+		datagram.Append({ (uint8)EULSDeliveryChannel::ReliableOrdered | 0x80, 0, 0, 0, 0, 0xFF, 0xFF, 4, 0, 1, 2, 3, 4 });
+		peers.Server.ReceiveDatagram(datagram, peers.Now);
+		TestEqual(TEXT("Oversized message not reassembled"), peers.Server.GetNumPartialBytes(), 0);
+	}
+
+	// Incomplete messages don't hold more than MaxPartialBytes
+	{
+		FLoopbackPeers peers;
+		peers.Server.MaxPartialBytes = 20 * 1024;
+		peers.Client.Send(EULSDeliveryChannel::ReliableOrdered, MakeMessage(0, 10 * 1024));
+		TestTrue(TEXT("Message within the limit delivered"), peers.RunUntilDelivered(1, 5.0));
+		TestEqual(TEXT("Reassembly released"), peers.Server.GetNumPartialBytes(), 0);
+
+		peers.Client.Send(EULSDeliveryChannel::ReliableOrdered, MakeMessage(1, 100 * 1024));
+		for (int32 i = 0; i < 100; i++)
+		{
+			peers.Step();
+			if (peers.Server.GetNumPartialBytes() > 20 * 1024)
+			{
+				break;
+			}
+		}
+		TestTrue(TEXT("Reassembly bounded"), peers.Server.GetNumPartialBytes() <= 20 * 1024);
+		TestEqual(TEXT("Message over the limit not delivered"), peers.ReceivedByServer.Num(), 1);
+	}
+	return true;
+}
+
+#endif
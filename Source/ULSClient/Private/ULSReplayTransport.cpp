@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSReplayTransport.h"
+#include "ULSPacketWriter.h"
+#include "ULSWirePacket.h"
+#include "ULSStats.h"
+
+void UULSReplayTransport::BeginDestroy()
+{
+	StopTicker();
+	Reader.Close();
+	bConnected = false;
+
+	Super::BeginDestroy();
+}
+
+bool UULSReplayTransport::IsConnected() const
+{
+	return bConnected;
+}
+
+bool UULSReplayTransport::Connect()
+{
+	ResetNegotiatedFeatures();
+	StopTicker();
+
+	if (Reader.Open(CapturePath) == false)
+	{
+		NotifyConnected(false, FString::Printf(TEXT("Failed to open capture %s"), *CapturePath));
+		return false;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("UULSReplayTransport: Replaying %s, recorded %s"), *CapturePath, *Reader.GetStartTime().ToString());
+
+	PlaybackTime = 0;
+	bConnected = true;
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UULSReplayTransport::Tick));
+
+	FString empty = FString();
+	NotifyConnected(true, empty);
+	return true;
+}
+
+void UULSReplayTransport::Disconnect()
+{
+	bConnected = false;
+	StopTicker();
+	Reader.Close();
+}
+
+void UULSReplayTransport::SendBytes(TConstArrayView<uint8> bytes)
+{
+	// The recorded server doesn't listen
+}
+
+int32 UULSReplayTransport::ReplayAll()
+{
+	if (!IsConnected())
+	{
+		return 0;
+	}
+
+	const int32 numFrames = FeedUntil(TNumericLimits<double>::Max(), 0);
+	Finish();
+	return numFrames;
+}
+
+bool UULSReplayTransport::Tick(float deltaTime)
+{
+	if (!IsConnected())
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	if (PlaybackRate > 0)
+	{
+		PlaybackTime += deltaTime * PlaybackRate;
+		FeedUntil(PlaybackTime, 0);
+	}
+	else
+	{
+		FeedUntil(TNumericLimits<double>::Max(), MaxFramesPerTick);
+	}
+
+	double nextTime;
+	if (IsConnected() && Reader.PeekTime(nextTime) == false)
+	{
+		Finish();
+	}
+
+	if (IsConnected() == false)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+int32 UULSReplayTransport::FeedUntil(double time, int32 maxFrames)
+{
+	int32 numFrames = 0;
+	double nextTime;
+	FULSCaptureFrame frame;
+	while (IsConnected() && (maxFrames <= 0 || numFrames < maxFrames) &&
+		Reader.PeekTime(nextTime) && nextTime <= time && Reader.Next(frame))
+	{
+		if (frame.Direction != EULSCaptureDirection::Inbound)
+		{
+			continue;
+		}
+
+		PlaybackTime = FMath::Max(PlaybackTime, frame.Time);
+		HandleReceivedView(frame.Bytes);
+		numFrames++;
+	}
+	return numFrames;
+}
+
+void UULSReplayTransport::Finish()
+{
+	if (!IsConnected())
+	{
+		return;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("UULSReplayTransport: Finished replaying %s"), *CapturePath);
+
+	// Keeps the network owner from reconnecting, which would start the replay over
+	FULSPacketWriter writer(EWirePacketType::ConnectionEnd);
+	HandleReceivedView(writer.GetBytes());
+
+	bConnected = false;
+	Reader.Close();
+	NotifyDisconnected(1000, TEXT("Replay finished"), true);
+}
+
+void UULSReplayTransport::StopTicker()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+}
@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSSharedMemoryRing.h"
+#include "ULSStats.h"
+
+#if PLATFORM_LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#endif
+
+FULSSharedMemoryRing::~FULSSharedMemoryRing()
+{
+	Close();
+}
+
+bool FULSSharedMemoryRing::Open(const FString& name, FString& outError)
+{
+#if PLATFORM_LINUX
+	Close();
+
+	const FTCHARToUTF8 utf8Name(*name);
+	const int fd = shm_open(utf8Name.Get(), O_RDWR, 0);
+	if (fd < 0)
+	{
+		outError = FString::Printf(TEXT("shm_open(%s) failed with errno %d"), *name, errno);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < DataOffset)
+	{
+		outError = FString::Printf(TEXT("%s is not a ULS ring"), *name);
+		close(fd);
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		outError = FString::Printf(TEXT("mmap(%s) failed with errno %d"), *name, errno);
+		return false;
+	}
+
+	FULSRingHeader* header = (FULSRingHeader*)mapping;
+	const uint32 capacity = header->Capacity;
+	if (FMemory::Memcmp(header->Magic, "ULSRING1", 8) != 0 || header->Version != Version ||
+		FMath::IsPowerOfTwo(capacity) == false || capacity < 64 || (SIZE_T)DataOffset + capacity > (SIZE_T)info.st_size)
+	{
+		outError = FString::Printf(TEXT("%s has an unsupported ring format"), *name);
+		munmap(mapping, info.st_size);
+		return false;
+	}
+
+	Mapping = mapping;
+	MappingSize = info.st_size;
+	Header = header;
+	Data = (uint8*)mapping + DataOffset;
+	Capacity = capacity;
+	PeekedEnd = 0;
+	return true;
+#else
+	outError = TEXT("Shared memory rings are only supported on Linux");
+	return false;
+#endif
+}
+
+void FULSSharedMemoryRing::Close()
+{
+#if PLATFORM_LINUX
+	if (Mapping != nullptr)
+	{
+		munmap(Mapping, MappingSize);
+	}
+#endif
+	Mapping = nullptr;
+	MappingSize = 0;
+	Header = nullptr;
+	Data = nullptr;
+	Capacity = 0;
+	PeekedEnd = 0;
+}
+
+int32 FULSSharedMemoryRing::GetMaxRecordSize() const
+{
+	// Half the ring, so a record always fits after a wrap marker
+	return (int32)(Capacity / 2) - RecordHeaderSize;
+}
+
+bool FULSSharedMemoryRing::Write(TConstArrayView<uint8> bytes)
+{
+	if (Header == nullptr || bytes.Num() > GetMaxRecordSize())
+	{
+		return false;
+	}
+
+	const uint32 recordSize = AlignRecord(RecordHeaderSize + bytes.Num());
+	uint64 writeIndex = Header->WriteIndex.load(std::memory_order_relaxed);
+	const uint64 readIndex = Header->ReadIndex.load(std::memory_order_acquire);
+
+	const uint32 offset = (uint32)(writeIndex & (Capacity - 1));
+	const uint32 tail = Capacity - offset;
+	const uint32 needed = recordSize + (tail < recordSize ? tail : 0);
+	if (Capacity - (uint32)(writeIndex - readIndex) < needed)
+	{
+		return false;
+	}
+
+	if (tail < recordSize)
+	{
+		const uint32 marker = WrapMarker;
+		FMemory::Memcpy(Data + offset, &marker, sizeof(uint32));
+		writeIndex += tail;
+	}
+
+	uint8* record = Data + (writeIndex & (Capacity - 1));
+	const uint32 length = (uint32)bytes.Num();
+	const uint32 reserved = 0;
+	FMemory::Memcpy(record, &length, sizeof(uint32));
+	FMemory::Memcpy(record + sizeof(uint32), &reserved, sizeof(uint32));
+	FMemory::Memcpy(record + RecordHeaderSize, bytes.GetData(), bytes.Num());
+
+	Header->WriteIndex.store(writeIndex + recordSize, std::memory_order_release);
+	Header->DataSignal.fetch_add(1, std::memory_order_release);
+	if (Header->ConsumerWaiting.load(std::memory_order_seq_cst) != 0)
+	{
+		Wake(Header->DataSignal);
+	}
+	return true;
+}
+
+bool FULSSharedMemoryRing::Peek(TConstArrayView<uint8>& outRecord)
+{
+	if (Header == nullptr)
+	{
+		return false;
+	}
+
+	uint64 readIndex = Header->ReadIndex.load(std::memory_order_relaxed);
+	const uint64 writeIndex = Header->WriteIndex.load(std::memory_order_acquire);
+
+	// The producer is another process, nothing it wrote may take us outside the ring or past the published data
+	if (writeIndex - readIndex > Capacity)
+	{
+		UE_LOG(LogULS, Error, TEXT("FULSSharedMemoryRing: Corrupt indices, write %llu read %llu"), writeIndex, readIndex);
+		MarkClosed();
+		return false;
+	}
+
+	while (readIndex != writeIndex)
+	{
+		const uint32 offset = (uint32)(readIndex & (Capacity - 1));
+		uint32 length;
+		FMemory::Memcpy(&length, Data + offset, sizeof(uint32));
+
+		if (length == WrapMarker)
+		{
+			readIndex += Capacity - offset;
+			if (readIndex > writeIndex)
+			{
+				UE_LOG(LogULS, Error, TEXT("FULSSharedMemoryRing: Wrap marker past the written data"));
+				MarkClosed();
+				return false;
+			}
+			continue;
+		}
+
+		const uint32 recordSize = AlignRecord(RecordHeaderSize + FMath::Min(length, Capacity));
+		if (length > (uint32)GetMaxRecordSize() || (uint64)offset + RecordHeaderSize + length > Capacity || readIndex + recordSize > writeIndex)
+		{
+			UE_LOG(LogULS, Error, TEXT("FULSSharedMemoryRing: Corrupt record of %u bytes"), length);
+			MarkClosed();
+			return false;
+		}
+
+		outRecord = TConstArrayView<uint8>(Data + offset + RecordHeaderSize, (int32)length);
+		PeekedEnd = readIndex + recordSize;
+		return true;
+	}
+	return false;
+}
+
+void FULSSharedMemoryRing::Consume()
+{
+	if (Header == nullptr || PeekedEnd == 0)
+	{
+		return;
+	}
+
+	Header->ReadIndex.store(PeekedEnd, std::memory_order_release);
+	PeekedEnd = 0;
+
+	Header->SpaceSignal.fetch_add(1, std::memory_order_release);
+	if (Header->ProducerWaiting.load(std::memory_order_seq_cst) != 0)
+	{
+		Wake(Header->SpaceSignal);
+	}
+}
+
+void FULSSharedMemoryRing::MarkClosed()
+{
+	if (Header == nullptr)
+	{
+		return;
+	}
+
+	Header->Closed.store(1, std::memory_order_release);
+
+	// Whoever sleeps on this ring has to notice
+	Header->DataSignal.fetch_add(1, std::memory_order_release);
+	Header->SpaceSignal.fetch_add(1, std::memory_order_release);
+	Wake(Header->DataSignal);
+	Wake(Header->SpaceSignal);
+}
+
+bool FULSSharedMemoryRing::IsClosed() const
+{
+	return Header != nullptr && Header->Closed.load(std::memory_order_acquire) != 0;
+}
+
+void FULSSharedMemoryRing::Wake(std::atomic<uint32>& futexWord)
+{
+#if PLATFORM_LINUX
+	// Not FUTEX_PRIVATE_FLAG: the waiter lives in another process
+	syscall(SYS_futex, (uint32*)&futexWord, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/*
+* Layout of the control block at the start of a ring. See ULSSharedMemoryTransport.h for the
+* complete format. Fields written by different sides live on separate cache lines.
+*/
+struct FULSRingHeader
+{
+	uint8 Magic[8];
+	uint32 Version;
+	uint32 Capacity;
+	uint8 Padding0[48];
+
+	std::atomic<uint64> WriteIndex;
+	uint8 Padding1[56];
+
+	std::atomic<uint64> ReadIndex;
+	uint8 Padding2[56];
+
+	std::atomic<uint32> DataSignal;
+	std::atomic<uint32> ConsumerWaiting;
+	uint8 Padding3[56];
+
+	std::atomic<uint32> SpaceSignal;
+	std::atomic<uint32> ProducerWaiting;
+	uint8 Padding4[56];
+
+	std::atomic<uint32> Closed;
+};
+
+static_assert(std::atomic<uint64>::is_always_lock_free && std::atomic<uint32>::is_always_lock_free, "Ring indices must be lock-free to be shared between processes");
+static_assert(offsetof(FULSRingHeader, WriteIndex) == 64, "Ring layout changed");
+static_assert(offsetof(FULSRingHeader, ReadIndex) == 128, "Ring layout changed");
+static_assert(offsetof(FULSRingHeader, DataSignal) == 192, "Ring layout changed");
+static_assert(offsetof(FULSRingHeader, SpaceSignal) == 256, "Ring layout changed");
+static_assert(offsetof(FULSRingHeader, Closed) == 320, "Ring layout changed");
+
+/**
+ * One direction of the shared memory transport: a single-producer, single-consumer byte ring in
+ * a POSIX shared memory object created by the server.
+ *
+ * Records never wrap around the end of the data area, so the consumer can hand out a view of the
+ * record and release it after it was processed. Only available on Linux.
+ */
+class FULSSharedMemoryRing
+{
+public:
+	static constexpr int32 DataOffset = 4096;
+	static constexpr int32 RecordHeaderSize = 8;
+	static constexpr uint32 WrapMarker = 0xFFFFFFFF;
+	static constexpr uint32 Version = 1;
+
+	~FULSSharedMemoryRing();
+
+	/* Maps the existing ring /name */
+	bool Open(const FString& name, FString& outError);
+
+	void Close();
+
+	bool IsOpen() const { return Header != nullptr; }
+
+	/* Largest record Write accepts */
+	int32 GetMaxRecordSize() const;
+
+	/* Producer: appends a record and wakes the consumer. Returns false if there is no room right now. */
+	bool Write(TConstArrayView<uint8> bytes);
+
+	/* Consumer: the next record, read in place. Stays valid until Consume. */
+	bool Peek(TConstArrayView<uint8>& outRecord);
+
+	/* Consumer: releases the record returned by the last Peek and wakes the producer */
+	void Consume();
+
+	/* Tells the other side that this side is gone */
+	void MarkClosed();
+
+	bool IsClosed() const;
+
+private:
+	static uint32 AlignRecord(uint32 size) { return (size + 7) & ~7u; }
+
+	static void Wake(std::atomic<uint32>& futexWord);
+
+	void* Mapping = nullptr;
+	SIZE_T MappingSize = 0;
+	FULSRingHeader* Header = nullptr;
+	uint8* Data = nullptr;
+	uint32 Capacity = 0;
+	uint64 PeekedEnd = 0;
+};
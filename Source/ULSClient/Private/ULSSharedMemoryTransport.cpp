@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSSharedMemoryTransport.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSSharedMemoryRing.h"
+#include "ULSStats.h"
+
+UULSSharedMemoryTransport::UULSSharedMemoryTransport()
+{
+	ReceiveRing = MakeShared<FULSSharedMemoryRing>();
+	SendRing = MakeShared<FULSSharedMemoryRing>();
+}
+
+void UULSSharedMemoryTransport::BeginDestroy()
+{
+	Super::BeginDestroy();
+
+	Disconnect();
+}
+
+void UULSSharedMemoryTransport::SetConnectionData(FString channelName)
+{
+	ChannelName = channelName;
+}
+
+bool UULSSharedMemoryTransport::Connect()
+{
+	UE_LOG(LogULS, Display, TEXT("UULSSharedMemoryTransport::Connect to %s"), *ChannelName);
+
+	Disconnect();
+	ResetNegotiatedFeatures();
+
+	FString error;
+	if (ReceiveRing->Open(FString::Printf(TEXT("/uls.%s.s2c"), *ChannelName), error) == false ||
+		SendRing->Open(FString::Printf(TEXT("/uls.%s.c2s"), *ChannelName), error) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSSharedMemoryTransport::Connect: %s"), *error);
+		CloseRings();
+		NotifyConnected(false, error);
+		return false;
+	}
+
+	if (ReceiveRing->IsClosed())
+	{
+		error = TEXT("Server closed the channel");
+		CloseRings();
+		NotifyConnected(false, error);
+		return false;
+	}
+
+	bConnected = true;
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UULSSharedMemoryTransport::Tick));
+
+	FString empty = FString();
+	NotifyConnected(true, empty);
+	return true;
+}
+
+void UULSSharedMemoryTransport::Disconnect()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	if (bConnected)
+	{
+		UE_LOG(LogULS, Display, TEXT("UULSSharedMemoryTransport::Disconnect"));
+		SendRing->MarkClosed();
+	}
+	bConnected = false;
+	PendingSends.Reset();
+
+	if (bDraining)
+	{
+		bCloseAfterDrain = true;
+	}
+	else
+	{
+		CloseRings();
+	}
+}
+
+void UULSSharedMemoryTransport::SendBytes(TConstArrayView<uint8> bytes)
+{
+	if (!IsConnected())
+	{
+		// Don't send if we're not connected.
+		return;
+	}
+
+	if (bytes.Num() > SendRing->GetMaxRecordSize())
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSSharedMemoryTransport: Packet of %d bytes exceeds the ring record limit of %d"), bytes.Num(), SendRing->GetMaxRecordSize());
+		return;
+	}
+
+	// Keep the order: once something is pending, everything else queues behind it
+	if (PendingSends.Num() > 0 || SendRing->Write(bytes) == false)
+	{
+		PendingSends.Emplace(bytes.GetData(), bytes.Num());
+	}
+}
+
+bool UULSSharedMemoryTransport::Tick(float deltaTime)
+{
+	if (!bConnected)
+	{
+		return true;
+	}
+
+	FlushPendingSends();
+
+	// Packets are read in place. A handler that disconnects only defers unmapping the ring.
+	bDraining = true;
+
+	TConstArrayView<uint8> record;
+	while (bConnected && ReceiveRing->Peek(record))
+	{
+		HandleReceivedView(record);
+		ReceiveRing->Consume();
+	}
+
+	bDraining = false;
+	if (bCloseAfterDrain)
+	{
+		bCloseAfterDrain = false;
+		CloseRings();
+		return true;
+	}
+
+	if (bConnected && ReceiveRing->IsClosed())
+	{
+		Disconnect();
+		NotifyDisconnected(0, TEXT("Closed by server"), true);
+	}
+
+	return true;
+}
+
+void UULSSharedMemoryTransport::FlushPendingSends()
+{
+	int32 numSent = 0;
+	while (numSent < PendingSends.Num() && SendRing->Write(PendingSends[numSent]))
+	{
+		numSent++;
+	}
+	PendingSends.RemoveAt(0, numSent);
+}
+
+void UULSSharedMemoryTransport::CloseRings()
+{
+	ReceiveRing->Close();
+	SendRing->Close();
+}
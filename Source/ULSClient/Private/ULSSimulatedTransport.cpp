@@ -0,0 +1,290 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSSimulatedTransport.h"
+#include "ULSStats.h"
+#include "HAL/IConsoleManager.h"
+#include "Algo/BinarySearch.h"
+
+namespace
+{
+	TAutoConsoleVariable<float> CVarNetSimLatency(TEXT("uls.NetSim.Latency"), -1.0f,
+		TEXT("One-way latency in milliseconds added by UULSSimulatedTransport. Negative to use the transport's settings."));
+
+	TAutoConsoleVariable<float> CVarNetSimJitter(TEXT("uls.NetSim.Jitter"), -1.0f,
+		TEXT("Random extra delay in milliseconds (+-). Negative to use the transport's settings."));
+
+	TAutoConsoleVariable<float> CVarNetSimLoss(TEXT("uls.NetSim.Loss"), -1.0f,
+		TEXT("Percentage of datagrams dropped. Negative to use the transport's settings."));
+
+	TAutoConsoleVariable<float> CVarNetSimReorder(TEXT("uls.NetSim.Reorder"), -1.0f,
+		TEXT("Percentage of datagrams delivered out of order. Negative to use the transport's settings."));
+
+	TAutoConsoleVariable<int32> CVarNetSimBandwidth(TEXT("uls.NetSim.Bandwidth"), -1,
+		TEXT("Link capacity in kilobits per second, 0 for unlimited. Negative to use the transport's settings."));
+
+	TAutoConsoleVariable<int32> CVarNetSimSeed(TEXT("uls.NetSim.Seed"), -1,
+		TEXT("Seed of the random stream, applied on the next connect. Negative to use the transport's seed."));
+
+	void SetNetSimPreset(const TArray<FString>& args)
+	{
+		if (args.Num() != 1)
+		{
+			UE_LOG(LogULS, Display, TEXT("Usage: uls.NetSim.Preset Off|Average|Bad|Terrible"));
+			return;
+		}
+
+		// Latency, jitter, loss, reorder, bandwidth
+		float latency = -1, jitter = -1, loss = -1, reorder = -1;
+		int32 bandwidth = -1;
+		if (args[0] == TEXT("Average"))
+		{
+			latency = 40; jitter = 10; loss = 1; reorder = 1; bandwidth = 0;
+		}
+		else if (args[0] == TEXT("Bad"))
+		{
+			latency = 100; jitter = 30; loss = 5; reorder = 3; bandwidth = 4000;
+		}
+		else if (args[0] == TEXT("Terrible"))
+		{
+			latency = 250; jitter = 80; loss = 10; reorder = 5; bandwidth = 1000;
+		}
+		else if (args[0] != TEXT("Off"))
+		{
+			UE_LOG(LogULS, Warning, TEXT("uls.NetSim.Preset: Unknown preset %s"), *args[0]);
+			return;
+		}
+
+		CVarNetSimLatency->Set(latency);
+		CVarNetSimJitter->Set(jitter);
+		CVarNetSimLoss->Set(loss);
+		CVarNetSimReorder->Set(reorder);
+		CVarNetSimBandwidth->Set(bandwidth);
+	}
+
+	FAutoConsoleCommand NetSimPresetCommand(TEXT("uls.NetSim.Preset"),
+		TEXT("Sets the uls.NetSim.* variables to a preset: Off (use the transport's settings), Average, Bad or Terrible."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SetNetSimPreset));
+}
+
+void UULSSimulatedTransport::BeginDestroy()
+{
+	Super::BeginDestroy();
+
+	Disconnect();
+}
+
+bool UULSSimulatedTransport::IsConnected() const
+{
+	return IsValid(WrappedTransport) && WrappedTransport->IsConnected();
+}
+
+bool UULSSimulatedTransport::IsDatagramTransport() const
+{
+	return IsValid(WrappedTransport) && WrappedTransport->IsDatagramTransport();
+}
+
+FULSNetworkConditions UULSSimulatedTransport::GetEffectiveConditions() const
+{
+	FULSNetworkConditions conditions = Conditions;
+	if (bUseConsoleVariables)
+	{
+		if (CVarNetSimLatency.GetValueOnGameThread() >= 0) conditions.LatencyMs = CVarNetSimLatency.GetValueOnGameThread();
+		if (CVarNetSimJitter.GetValueOnGameThread() >= 0) conditions.JitterMs = CVarNetSimJitter.GetValueOnGameThread();
+		if (CVarNetSimLoss.GetValueOnGameThread() >= 0) conditions.LossPercent = CVarNetSimLoss.GetValueOnGameThread();
+		if (CVarNetSimReorder.GetValueOnGameThread() >= 0) conditions.ReorderPercent = CVarNetSimReorder.GetValueOnGameThread();
+		if (CVarNetSimBandwidth.GetValueOnGameThread() >= 0) conditions.BandwidthKbps = CVarNetSimBandwidth.GetValueOnGameThread();
+	}
+	return conditions;
+}
+
+bool UULSSimulatedTransport::Connect()
+{
+	if (IsValid(WrappedTransport) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSSimulatedTransport::Connect: No transport to wrap"));
+		return false;
+	}
+
+	ResetNegotiatedFeatures();
+	ResetLinks();
+
+	const int32 seed = (bUseConsoleVariables && CVarNetSimSeed.GetValueOnGameThread() >= 0) ? CVarNetSimSeed.GetValueOnGameThread() : Seed;
+	Random.Initialize(seed);
+	SimulatedTime = 0;
+
+	if (bTickOnCoreTicker && TickerHandle.IsValid() == false)
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UULSSimulatedTransport::Tick));
+	}
+
+	WrappedTransport->ClientNetworkOwner = ClientNetworkOwner;
+	WrappedTransport->ChannelIndex = ChannelIndex;
+	WrappedTransport->Simulator = this;
+	return WrappedTransport->Connect();
+}
+
+void UULSSimulatedTransport::Disconnect()
+{
+	if (IsValid(WrappedTransport))
+	{
+		WrappedTransport->Disconnect();
+	}
+
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+	ResetLinks();
+}
+
+void UULSSimulatedTransport::SendBytes(TConstArrayView<uint8> bytes)
+{
+	if (!IsConnected())
+	{
+		// Don't send if we're not connected.
+		return;
+	}
+
+	if (IsDatagramTransport())
+	{
+		// Simulated per datagram
+		WrappedTransport->SendBytes(bytes);
+		return;
+	}
+
+	Enqueue(OutgoingLink, bytes, false);
+}
+
+void UULSSimulatedTransport::HandleWrappedReceived(TArray<uint8>&& bytes)
+{
+	if (IsDatagramTransport())
+	{
+		HandleReceivedBytes(MoveTemp(bytes));
+		return;
+	}
+
+	Enqueue(IncomingLink, bytes, false);
+}
+
+void UULSSimulatedTransport::HandleWrappedDatagram(bool bOutgoing, TConstArrayView<uint8> datagram)
+{
+	const FULSNetworkConditions conditions = GetEffectiveConditions();
+	if (conditions.LossPercent > 0 && Random.FRand() * 100.0f < conditions.LossPercent)
+	{
+		return;
+	}
+
+	Enqueue(bOutgoing ? OutgoingLink : IncomingLink, datagram, true);
+}
+
+void UULSSimulatedTransport::HandleWrappedDisconnected(int32 statusCode, const FString& reason, bool bWasClean)
+{
+	// Everything the server sent before closing arrives first, as on the real connection
+	if (IsDatagramTransport() == false)
+	{
+		ReleaseDue(false, TNumericLimits<double>::Max());
+	}
+	ResetLinks();
+
+	NotifyDisconnected(statusCode, reason, bWasClean);
+}
+
+void UULSSimulatedTransport::Enqueue(FLink& link, TConstArrayView<uint8> bytes, bool bDatagram)
+{
+	const FULSNetworkConditions conditions = GetEffectiveConditions();
+	const double now = SimulatedTime;
+
+	// Serialization delay on a link of limited capacity: bytes queue behind what is still being sent
+	double sentTime = now;
+	if (conditions.BandwidthKbps > 0)
+	{
+		sentTime = FMath::Max(now, link.BusyUntil) + (bytes.Num() * 8.0) / (conditions.BandwidthKbps * 1000.0);
+		link.BusyUntil = sentTime;
+	}
+
+	double delay = conditions.LatencyMs;
+	if (conditions.JitterMs > 0)
+	{
+		delay += Random.FRandRange(-conditions.JitterMs, conditions.JitterMs);
+	}
+	if (bDatagram && conditions.ReorderPercent > 0 && Random.FRand() * 100.0f < conditions.ReorderPercent)
+	{
+		// Held back long enough for the following datagrams to overtake it
+		delay += FMath::Max(conditions.LatencyMs, 20.0f) + conditions.JitterMs;
+	}
+
+	double releaseTime = sentTime + FMath::Max(delay, 0.0) / 1000.0;
+	if (bDatagram == false)
+	{
+		// Streams never reorder
+		releaseTime = FMath::Max(releaseTime, link.LastReleaseTime);
+		link.LastReleaseTime = releaseTime;
+	}
+
+	const int32 index = Algo::UpperBoundBy(link.Queue, releaseTime, &FDelayedBytes::ReleaseTime);
+	FDelayedBytes& delayed = link.Queue.InsertDefaulted_GetRef(index);
+	delayed.ReleaseTime = releaseTime;
+	delayed.Bytes = TArray<uint8>(bytes.GetData(), bytes.Num());
+}
+
+bool UULSSimulatedTransport::Tick(float deltaTime)
+{
+	AdvanceTime(deltaTime);
+	return true;
+}
+
+void UULSSimulatedTransport::AdvanceTime(float deltaSeconds)
+{
+	SimulatedTime += FMath::Max(deltaSeconds, 0.0f);
+	ReleaseDue(true, SimulatedTime);
+	ReleaseDue(false, SimulatedTime);
+}
+
+void UULSSimulatedTransport::ReleaseDue(bool bOutgoing, double now)
+{
+	FLink& link = bOutgoing ? OutgoingLink : IncomingLink;
+	const bool bDatagram = IsDatagramTransport();
+
+	int32 numReleased = 0;
+	while (numReleased < link.Queue.Num() && link.Queue[numReleased].ReleaseTime <= now)
+	{
+		numReleased++;
+	}
+	if (numReleased == 0)
+	{
+		return;
+	}
+
+	// Handlers may send, which appends to the queues. Take the due entries out first.
+	TArray<FDelayedBytes> released(link.Queue.GetData(), numReleased);
+	link.Queue.RemoveAt(0, numReleased);
+
+	for (FDelayedBytes& delayed : released)
+	{
+		if (IsValid(WrappedTransport) == false)
+		{
+			return;
+		}
+
+		if (bDatagram)
+		{
+			WrappedTransport->ReleaseSimulatedDatagram(bOutgoing, delayed.Bytes);
+		}
+		else if (bOutgoing)
+		{
+			WrappedTransport->SendBytes(delayed.Bytes);
+		}
+		else
+		{
+			HandleReceivedBytes(MoveTemp(delayed.Bytes));
+		}
+	}
+}
+
+void UULSSimulatedTransport::ResetLinks()
+{
+	OutgoingLink = FLink();
+	IncomingLink = FLink();
+}
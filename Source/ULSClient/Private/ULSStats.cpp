@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSStats.h"
+#include "ULSFunctionLibrary.h"
+#include "ULSWirePacket.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include <atomic>
+
+DEFINE_LOG_CATEGORY(LogULS);
+
+DEFINE_STAT(STAT_ULSDecode);
+DEFINE_STAT(STAT_ULSApply);
+DEFINE_STAT(STAT_ULSOnRep);
+DEFINE_STAT(STAT_ULSPacketsIn);
+DEFINE_STAT(STAT_ULSPacketsOut);
+DEFINE_STAT(STAT_ULSBytesIn);
+DEFINE_STAT(STAT_ULSBytesOut);
+
+UE_TRACE_CHANNEL_DEFINE(ULSChannel);
+
+LLM_DEFINE_TAG(ULS);
+
+TRACE_DECLARE_INT_COUNTER(ULSPacketsIn, TEXT("ULS/PacketsIn"));
+TRACE_DECLARE_INT_COUNTER(ULSPacketsOut, TEXT("ULS/PacketsOut"));
+TRACE_DECLARE_MEMORY_COUNTER(ULSBytesIn, TEXT("ULS/BytesIn"));
+TRACE_DECLARE_MEMORY_COUNTER(ULSBytesOut, TEXT("ULS/BytesOut"));
+
+namespace
+{
+	enum ECounter
+	{
+		PacketsIn,
+		BytesIn,
+		PacketsOut,
+		BytesOut,
+		NumCounters
+	};
+
+	std::atomic<int64> Counters[FULSNetStats::MaxPacketTypes][NumCounters];
+
+	int32 ClampPacketType(int32 packetType)
+	{
+		return FMath::Clamp(packetType & UULSWirePacket::PacketTypeMask, 0, FULSNetStats::MaxPacketTypes - 1);
+	}
+
+#if STATS
+	FCriticalSection StatIdLock;
+	TStatId StatIds[FULSNetStats::MaxPacketTypes][NumCounters];
+
+	/* Per-frame stat of one packet type, created on first use */
+	TStatId GetStatId(int32 packetType, ECounter counter)
+	{
+		FScopeLock lock(&StatIdLock);
+
+		TStatId& statId = StatIds[packetType][counter];
+		if (statId.IsNone())
+		{
+			static const TCHAR* CounterNames[NumCounters] = { TEXT("Packets In"), TEXT("Bytes In"), TEXT("Packets Out"), TEXT("Bytes Out") };
+
+			FString typeName = UULSFunctionLibrary::GetPacketNameByType(packetType);
+			if (typeName.IsEmpty())
+			{
+				typeName = FString::Printf(TEXT("Type %d"), packetType);
+			}
+			statId = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_ULS>(FName(*FString::Printf(TEXT("%s %s"), *typeName, CounterNames[counter])), false);
+		}
+		return statId;
+	}
+#endif
+
+	void Record(int32 packetType, int32 numBytes, ECounter packetsCounter, ECounter bytesCounter)
+	{
+		const int32 index = ClampPacketType(packetType);
+		Counters[index][packetsCounter].fetch_add(1, std::memory_order_relaxed);
+		Counters[index][bytesCounter].fetch_add(numBytes, std::memory_order_relaxed);
+
+#if STATS
+		if (FThreadStats::IsCollectingData())
+		{
+			INC_DWORD_STAT_BY_FName(GetStatId(index, packetsCounter).GetName(), 1);
+			INC_DWORD_STAT_BY_FName(GetStatId(index, bytesCounter).GetName(), numBytes);
+		}
+#endif
+	}
+}
+
+void FULSNetStats::RecordReceived(int32 packetType, int32 numBytes)
+{
+	Record(packetType, numBytes, PacketsIn, BytesIn);
+
+	INC_DWORD_STAT(STAT_ULSPacketsIn);
+	INC_DWORD_STAT_BY(STAT_ULSBytesIn, numBytes);
+	TRACE_COUNTER_INCREMENT(ULSPacketsIn);
+	TRACE_COUNTER_ADD(ULSBytesIn, numBytes);
+}
+
+void FULSNetStats::RecordReceived(TConstArrayView<uint8> wireBytes)
+{
+	if (wireBytes.Num() < UULSWirePacket::HeaderSize)
+	{
+		return;
+	}
+
+	int32 header;
+	FMemory::Memcpy(&header, wireBytes.GetData(), sizeof(int32));
+	RecordReceived(header, wireBytes.Num());
+}
+
+void FULSNetStats::RecordSent(int32 packetType, int32 numBytes)
+{
+	Record(packetType, numBytes, PacketsOut, BytesOut);
+
+	INC_DWORD_STAT(STAT_ULSPacketsOut);
+	INC_DWORD_STAT_BY(STAT_ULSBytesOut, numBytes);
+	TRACE_COUNTER_INCREMENT(ULSPacketsOut);
+	TRACE_COUNTER_ADD(ULSBytesOut, numBytes);
+}
+
+void FULSNetStats::RecordSent(TConstArrayView<uint8> wireBytes)
+{
+	if (wireBytes.Num() < UULSWirePacket::HeaderSize)
+	{
+		return;
+	}
+
+	int32 header;
+	FMemory::Memcpy(&header, wireBytes.GetData(), sizeof(int32));
+	RecordSent(header, wireBytes.Num());
+}
+
+FULSPacketTypeCounters FULSNetStats::GetCounters(int32 packetType)
+{
+	const int32 index = ClampPacketType(packetType);
+
+	FULSPacketTypeCounters counters;
+	counters.PacketsIn = Counters[index][PacketsIn].load(std::memory_order_relaxed);
+	counters.BytesIn = Counters[index][BytesIn].load(std::memory_order_relaxed);
+	counters.PacketsOut = Counters[index][PacketsOut].load(std::memory_order_relaxed);
+	counters.BytesOut = Counters[index][BytesOut].load(std::memory_order_relaxed);
+	return counters;
+}
+
+FULSPacketTypeCounters FULSNetStats::GetTotalCounters()
+{
+	FULSPacketTypeCounters total;
+	for (int32 i = 0; i < MaxPacketTypes; i++)
+	{
+		const FULSPacketTypeCounters counters = GetCounters(i);
+		total.PacketsIn += counters.PacketsIn;
+		total.BytesIn += counters.BytesIn;
+		total.PacketsOut += counters.PacketsOut;
+		total.BytesOut += counters.BytesOut;
+	}
+	return total;
+}
+
+void FULSNetStats::ResetCounters()
+{
+	for (int32 i = 0; i < MaxPacketTypes; i++)
+	{
+		for (int32 j = 0; j < NumCounters; j++)
+		{
+			Counters[i][j].store(0, std::memory_order_relaxed);
+		}
+	}
+}
@@ -0,0 +1,419 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSTcpConnection.h"
+#include "ULSWirePacket.h"
+#include "ULSStats.h"
+#include "HAL/RunnableThread.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+namespace
+{
+	constexpr int32 StagingBufferSize = 64 * 1024;
+	constexpr int32 MaxPooledBuffers = 32;
+	constexpr int32 PollIntervalMs = 10;
+}
+
+FULSTcpConnection::FULSTcpConnection(const FULSTcpSettings& settings, const TSharedRef<FULSInboundQueue, ESPMode::ThreadSafe>& inboundQueue,
+	const TSharedRef<FULSOutboundQueue, ESPMode::ThreadSafe>& outboundQueue, const TWeakObjectPtr<UULSTransport>& transport)
+	: Settings(settings)
+	, InboundQueue(inboundQueue)
+	, OutboundQueue(outboundQueue)
+	, Transport(transport)
+	, BufferPool(StagingBufferSize, MaxPooledBuffers)
+{
+}
+
+FULSTcpConnection::~FULSTcpConnection()
+{
+	Shutdown();
+}
+
+bool FULSTcpConnection::Start()
+{
+	check(Thread == nullptr);
+
+	Thread = FRunnableThread::Create(this, TEXT("ULSTcpConnection"), 0, TPri_AboveNormal);
+	return Thread != nullptr;
+}
+
+void FULSTcpConnection::Shutdown()
+{
+	bStopping = true;
+
+	if (Thread != nullptr)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	CloseSocket();
+}
+
+void FULSTcpConnection::Send(TConstArrayView<uint8> bytes)
+{
+	TArray<uint8> buffer = BufferPool.Acquire();
+	const uint32 length = (uint32)bytes.Num();
+	buffer.Append((const uint8*)&length, sizeof(uint32));
+	buffer.Append(bytes.GetData(), bytes.Num());
+
+	FScopeLock lock(&SendLock);
+	if (Socket == nullptr)
+	{
+		return;
+	}
+
+	Pending.Add(FPendingSend{ MoveTemp(buffer), 0 });
+	if (Pending.Num() == 1)
+	{
+		// Nothing queued ahead of us, skip the round trip through the I/O thread
+		FlushPendingLocked();
+	}
+}
+
+uint32 FULSTcpConnection::Run()
+{
+	LLM_SCOPE_BYTAG(ULS);
+
+	FString error;
+	if (OpenSocket(error) == false)
+	{
+		CloseSocket();
+		if (!bStopping && OnConnected)
+		{
+			OnConnected(false, error);
+		}
+		return 0;
+	}
+
+	Staging = BufferPool.Acquire();
+	Staging.SetNumUninitialized(StagingBufferSize);
+
+	bConnected = true;
+	if (OnConnected)
+	{
+		OnConnected(true, FString());
+	}
+
+	FString closeReason;
+	bool bWasClean = false;
+	while (!bStopping)
+	{
+		DrainOutboundQueue();
+
+		bool bHasPending;
+		{
+			FScopeLock lock(&SendLock);
+			bHasPending = Pending.Num() > 0;
+		}
+
+		const ESocketWaitConditions::Type condition = bHasPending ? ESocketWaitConditions::WaitForReadOrWrite : ESocketWaitConditions::WaitForRead;
+		if (Socket->Wait(condition, FTimespan::FromMilliseconds(PollIntervalMs)) == false)
+		{
+			if (Socket->GetConnectionState() == SCS_ConnectionError)
+			{
+				closeReason = TEXT("Connection error");
+				break;
+			}
+			continue;
+		}
+
+		if (bHasPending)
+		{
+			FScopeLock lock(&SendLock);
+			if (FlushPendingLocked() == false)
+			{
+				closeReason = TEXT("Send failed");
+				break;
+			}
+		}
+
+		if (ReceiveAvailable(closeReason, bWasClean) == false)
+		{
+			break;
+		}
+	}
+
+	bConnected = false;
+	CloseSocket();
+
+	BufferPool.Release(MoveTemp(Staging));
+
+	if (!bStopping && OnClosed)
+	{
+		OnClosed(closeReason, bWasClean);
+	}
+	return 0;
+}
+
+bool FULSTcpConnection::OpenSocket(FString& outError)
+{
+	ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FAddressInfoResult addressInfo = socketSubsystem->GetAddressInfo(*Settings.Host, nullptr, EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Streaming);
+	if (addressInfo.ReturnCode != SE_NO_ERROR || addressInfo.Results.Num() == 0)
+	{
+		outError = FString::Printf(TEXT("Failed to resolve %s"), *Settings.Host);
+		return false;
+	}
+
+	TSharedRef<FInternetAddr> address = addressInfo.Results[0].Address;
+	address->SetPort(Settings.Port);
+
+	FSocket* socket = socketSubsystem->CreateSocket(NAME_Stream, TEXT("ULSTcpConnection"), address->GetProtocolType());
+	if (socket == nullptr)
+	{
+		outError = TEXT("Failed to create socket");
+		return false;
+	}
+
+	{
+		FScopeLock lock(&SendLock);
+		Socket = socket;
+	}
+
+	int32 actualSize = 0;
+	socket->SetNoDelay(Settings.bNoDelay);
+	if (Settings.SendBufferSize > 0)
+	{
+		socket->SetSendBufferSize(Settings.SendBufferSize, actualSize);
+	}
+	if (Settings.ReceiveBufferSize > 0)
+	{
+		socket->SetReceiveBufferSize(Settings.ReceiveBufferSize, actualSize);
+	}
+	socket->SetNonBlocking(true);
+
+	if (socket->Connect(*address) == false)
+	{
+		const ESocketErrors connectError = socketSubsystem->GetLastErrorCode();
+		if (connectError != SE_EINPROGRESS && connectError != SE_EWOULDBLOCK)
+		{
+			outError = FString::Printf(TEXT("Failed to connect to %s:%d (%s)"), *Settings.Host, Settings.Port, socketSubsystem->GetSocketError(connectError));
+			return false;
+		}
+	}
+
+	// Wait in slices so Shutdown doesn't have to wait for the whole timeout
+	const double deadline = FPlatformTime::Seconds() + Settings.ConnectTimeout;
+	while (!bStopping && FPlatformTime::Seconds() < deadline)
+	{
+		if (socket->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::FromMilliseconds(50)))
+		{
+			break;
+		}
+	}
+
+	if (bStopping || socket->GetConnectionState() != SCS_Connected)
+	{
+		outError = FString::Printf(TEXT("Failed to connect to %s:%d"), *Settings.Host, Settings.Port);
+		return false;
+	}
+	return true;
+}
+
+void FULSTcpConnection::CloseSocket()
+{
+	FScopeLock lock(&SendLock);
+
+	if (Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	for (FPendingSend& pending : Pending)
+	{
+		BufferPool.Release(MoveTemp(pending.Buffer));
+	}
+	Pending.Reset();
+}
+
+bool FULSTcpConnection::FlushPendingLocked()
+{
+	int32 numSent = 0;
+	for (; numSent < Pending.Num(); numSent++)
+	{
+		FPendingSend& pending = Pending[numSent];
+		const int32 remaining = pending.Buffer.Num() - pending.Offset;
+
+		int32 bytesSent = 0;
+		if (Socket->Send(pending.Buffer.GetData() + pending.Offset, remaining, bytesSent) == false)
+		{
+			const ESocketErrors sendError = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode();
+			if (sendError != SE_EWOULDBLOCK)
+			{
+				return false;
+			}
+			bytesSent = 0;
+		}
+
+		pending.Offset += bytesSent;
+		if (pending.Offset < pending.Buffer.Num())
+		{
+			// Socket is full, the I/O thread continues once it becomes writable
+			break;
+		}
+		BufferPool.Release(MoveTemp(pending.Buffer));
+	}
+
+	Pending.RemoveAt(0, numSent, false);
+	return true;
+}
+
+bool FULSTcpConnection::ReceiveAvailable(FString& outReason, bool& outWasClean)
+{
+	while (!bStopping)
+	{
+		// Large frames are read straight into their final buffer
+		const bool bDirect = FrameHeaderReceived == sizeof(uint32) && Frame.Num() - FrameReceived >= StagingBufferSize;
+		uint8* target = bDirect ? Frame.GetData() + FrameReceived : Staging.GetData();
+		const int32 capacity = bDirect ? Frame.Num() - FrameReceived : Staging.Num();
+
+		// FSocket::Recv on a stream socket: true with 0 bytes means nothing to read yet, false means the peer
+		// closed the connection or the socket failed
+		int32 bytesRead = 0;
+		if (Socket->Recv(target, capacity, bytesRead) == false)
+		{
+			ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+			const ESocketErrors recvError = socketSubsystem->GetLastErrorCode();
+			if (recvError == SE_EWOULDBLOCK && Socket->GetConnectionState() == SCS_Connected)
+			{
+				return true;
+			}
+
+			if (recvError == SE_NO_ERROR || recvError == SE_EWOULDBLOCK)
+			{
+				outReason = TEXT("Closed by server");
+				outWasClean = true;
+			}
+			else
+			{
+				outReason = socketSubsystem->GetSocketError(recvError);
+				outWasClean = false;
+			}
+			return false;
+		}
+
+		if (bytesRead == 0)
+		{
+			// Woken for writability, or the previous read ended exactly at the end of the socket buffer
+			return true;
+		}
+
+		if (bDirect)
+		{
+			FrameReceived += bytesRead;
+			if (FrameReceived == Frame.Num())
+			{
+				CompleteFrame();
+			}
+		}
+		else if (ConsumeStaging(target, bytesRead, outReason) == false)
+		{
+			outWasClean = false;
+			return false;
+		}
+
+		if (bytesRead < capacity)
+		{
+			// Drained the socket buffer, don't spend a syscall on learning that it would block
+			return true;
+		}
+	}
+	return true;
+}
+
+void FULSTcpConnection::SetCapture(const TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe>& capture, int32 channel)
+{
+	FScopeLock lock(&CaptureLock);
+	Capture = capture;
+	CaptureChannel = channel;
+}
+
+void FULSTcpConnection::DrainOutboundQueue()
+{
+	TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe> capture;
+	int32 channel;
+	{
+		FScopeLock lock(&CaptureLock);
+		capture = Capture;
+		channel = CaptureChannel;
+	}
+
+	TArray<uint8> bytes;
+	while (OutboundQueue->Dequeue(bytes))
+	{
+		if (capture.IsValid())
+		{
+			capture->Write(EULSCaptureDirection::Outbound, channel, bytes);
+		}
+		FULSNetStats::RecordSent(bytes);
+		Send(bytes);
+	}
+}
+
+bool FULSTcpConnection::ConsumeStaging(const uint8* data, int32 count, FString& outReason)
+{
+	while (count > 0)
+	{
+		if (FrameHeaderReceived < (int32)sizeof(uint32))
+		{
+			const int32 headerBytes = FMath::Min<int32>(sizeof(uint32) - FrameHeaderReceived, count);
+			FMemory::Memcpy(FrameHeader + FrameHeaderReceived, data, headerBytes);
+			FrameHeaderReceived += headerBytes;
+			data += headerBytes;
+			count -= headerBytes;
+
+			if (FrameHeaderReceived == sizeof(uint32) && BeginFrame(outReason) == false)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		const int32 frameBytes = FMath::Min(Frame.Num() - FrameReceived, count);
+		FMemory::Memcpy(Frame.GetData() + FrameReceived, data, frameBytes);
+		FrameReceived += frameBytes;
+		data += frameBytes;
+		count -= frameBytes;
+
+		if (FrameReceived == Frame.Num())
+		{
+			CompleteFrame();
+		}
+	}
+	return true;
+}
+
+bool FULSTcpConnection::BeginFrame(FString& outReason)
+{
+	uint32 length;
+	FMemory::Memcpy(&length, FrameHeader, sizeof(uint32));
+
+	if (length < (uint32)UULSWirePacket::HeaderSize || length > (uint32)Settings.MaxFrameSize)
+	{
+		outReason = FString::Printf(TEXT("Invalid frame length %u"), length);
+		return false;
+	}
+
+	// Frames leave with their packet, a pooled buffer only pays off if the frame fills most of it
+	if (length >= (uint32)BufferPool.GetBufferSize() / 2)
+	{
+		Frame = BufferPool.Acquire();
+	}
+	Frame.SetNumUninitialized((int32)length, false);
+	FrameReceived = 0;
+	return true;
+}
+
+void FULSTcpConnection::CompleteFrame()
+{
+	InboundQueue->Enqueue(Transport, MoveTemp(Frame));
+	Frame = TArray<uint8>();
+	FrameReceived = 0;
+	FrameHeaderReceived = 0;
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "ULSBufferPool.h"
+#include "ULSInboundQueue.h"
+#include "ULSOutboundQueue.h"
+#include "ULSCapture.h"
+#include <atomic>
+
+class FSocket;
+class FRunnableThread;
+class UULSTransport;
+
+struct FULSTcpSettings
+{
+	FString Host;
+	int32 Port = 0;
+	bool bNoDelay = true;
+	int32 SendBufferSize = 0;
+	int32 ReceiveBufferSize = 0;
+	int32 MaxFrameSize = 0;
+	float ConnectTimeout = 0;
+};
+
+/**
+ * TCP socket driven by a dedicated I/O thread.
+ *
+ * Frames are a uint32 little endian length followed by that many bytes of wire packet. The thread
+ * reads into a pooled staging buffer and, for frames larger than that, directly into the frame.
+ * Frames that fill most of a pooled buffer take one from the pool. Complete frames go to the inbound
+ * queue of the network owner.
+ *
+ * Sends are attempted right away on the calling thread. Whatever the socket doesn't accept is
+ * queued and flushed by the I/O thread once the socket becomes writable again. The I/O thread is
+ * also the consumer of the transport's outbound queue, which it drains every poll interval.
+ */
+class FULSTcpConnection : public FRunnable
+{
+public:
+	FULSTcpConnection(const FULSTcpSettings& settings, const TSharedRef<FULSInboundQueue, ESPMode::ThreadSafe>& inboundQueue,
+		const TSharedRef<FULSOutboundQueue, ESPMode::ThreadSafe>& outboundQueue, const TWeakObjectPtr<UULSTransport>& transport);
+
+	virtual ~FULSTcpConnection();
+
+	/* Called on the I/O thread once the connection is established or failed */
+	TFunction<void(bool, const FString&)> OnConnected;
+
+	/* Called on the I/O thread when the connection is lost. Not called after Shutdown. */
+	TFunction<void(const FString&, bool)> OnClosed;
+
+	bool Start();
+
+	/* Stops the I/O thread and closes the socket. Blocks until the thread has exited. */
+	void Shutdown();
+
+	bool IsConnected() const { return bConnected; }
+
+	void Send(TConstArrayView<uint8> bytes);
+
+	/* Packets drained from the outbound queue are recorded here. Everything else is captured by the transport. */
+	void SetCapture(const TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe>& capture, int32 channel);
+
+	// FRunnable
+	virtual uint32 Run() override;
+
+	virtual void Stop() override { bStopping = true; }
+
+private:
+	struct FPendingSend
+	{
+		TArray<uint8> Buffer;
+		int32 Offset = 0;
+	};
+
+	bool OpenSocket(FString& outError);
+
+	void CloseSocket();
+
+	/* Sends as much of Pending as the socket takes. Must hold SendLock. Returns false on socket errors. */
+	bool FlushPendingLocked();
+
+	/* Reads until the socket would block. Returns false if the connection was closed. */
+	bool ReceiveAvailable(FString& outReason, bool& outWasClean);
+
+	/* Moves the packets of the outbound queue to Pending */
+	void DrainOutboundQueue();
+
+	bool ConsumeStaging(const uint8* data, int32 count, FString& outReason);
+
+	bool BeginFrame(FString& outReason);
+
+	void CompleteFrame();
+
+	FULSTcpSettings Settings;
+	TSharedRef<FULSInboundQueue, ESPMode::ThreadSafe> InboundQueue;
+	TSharedRef<FULSOutboundQueue, ESPMode::ThreadSafe> OutboundQueue;
+	TWeakObjectPtr<UULSTransport> Transport;
+	FULSBufferPool BufferPool;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping { false };
+	std::atomic<bool> bConnected { false };
+
+	FCriticalSection SendLock;
+	FSocket* Socket = nullptr;
+	TArray<FPendingSend> Pending;
+
+	FCriticalSection CaptureLock;
+	TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe> Capture;
+	int32 CaptureChannel = 0;
+
+	// I/O thread only
+	TArray<uint8> Staging;
+	uint8 FrameHeader[sizeof(uint32)];
+	int32 FrameHeaderReceived = 0;
+	TArray<uint8> Frame;
+	int32 FrameReceived = 0;
+};
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSTcpTransport.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSTcpConnection.h"
+#include "ULSStats.h"
+#include "Async/Async.h"
+
+void UULSTcpTransport::BeginDestroy()
+{
+	Super::BeginDestroy();
+
+	Disconnect();
+}
+
+void UULSTcpTransport::SetConnectionData(FString host, int32 port)
+{
+	Host = host;
+	Port = port;
+}
+
+bool UULSTcpTransport::IsConnected() const
+{
+	return Connection.IsValid() && Connection->IsConnected();
+}
+
+bool UULSTcpTransport::Connect()
+{
+	UE_LOG(LogULS, Display, TEXT("UULSTcpTransport::Connect to %s:%d"), *Host, Port);
+
+	Disconnect();
+	ResetNegotiatedFeatures();
+
+	FULSTcpSettings settings;
+	settings.Host = Host;
+	settings.Port = Port;
+	settings.bNoDelay = bNoDelay;
+	settings.SendBufferSize = SendBufferSize;
+	settings.ReceiveBufferSize = ReceiveBufferSize;
+	settings.MaxFrameSize = MaxFrameSize;
+	settings.ConnectTimeout = ConnectTimeout;
+
+	Connection = MakeShared<FULSTcpConnection>(settings, ClientNetworkOwner->GetInboundQueue(), GetOutboundQueue(), TWeakObjectPtr<UULSTransport>(this));
+	Connection->SetCapture(GetCapture(), ChannelIndex);
+
+	// Events are raised on the I/O thread. Forward them to the game thread, dropping those of replaced connections.
+	TWeakObjectPtr<UULSTcpTransport> weakThis(this);
+	const int32 serial = ++ConnectionSerial;
+
+	Connection->OnConnected = [weakThis, serial](bool bSuccess, const FString& error)
+	{
+		AsyncTask(ENamedThreads::GameThread, [weakThis, serial, bSuccess, error]()
+			{
+				if (UULSTcpTransport* transport = weakThis.Get())
+				{
+					transport->HandleConnected(serial, bSuccess, error);
+				}
+			});
+	};
+
+	Connection->OnClosed = [weakThis, serial](const FString& reason, bool bWasClean)
+	{
+		AsyncTask(ENamedThreads::GameThread, [weakThis, serial, reason, bWasClean]()
+			{
+				if (UULSTcpTransport* transport = weakThis.Get())
+				{
+					transport->HandleClosed(serial, reason, bWasClean);
+				}
+			});
+	};
+
+	if (Connection->Start() == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSTcpTransport::Connect: Failed to start the I/O thread"));
+		Connection.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void UULSTcpTransport::Disconnect()
+{
+	if (Connection.IsValid() == false)
+	{
+		return;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("UULSTcpTransport::Disconnect"));
+
+	// Closed on request, like UULSWebSocketTransport the owner is not notified
+	ConnectionSerial++;
+	Connection->Shutdown();
+	Connection.Reset();
+}
+
+void UULSTcpTransport::SendBytes(TConstArrayView<uint8> bytes)
+{
+	if (!IsConnected())
+	{
+		// Don't send if we're not connected.
+		return;
+	}
+
+	Connection->Send(bytes);
+}
+
+void UULSTcpTransport::FlushOutboundQueue()
+{
+	// Drained by the I/O thread
+}
+
+void UULSTcpTransport::SetCapture(const TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe>& capture)
+{
+	Super::SetCapture(capture);
+
+	if (Connection.IsValid())
+	{
+		Connection->SetCapture(capture, ChannelIndex);
+	}
+}
+
+void UULSTcpTransport::HandleConnected(int32 connectionSerial, bool bSuccess, const FString& error)
+{
+	if (connectionSerial != ConnectionSerial)
+	{
+		return;
+	}
+
+	if (bSuccess == false)
+	{
+		Connection->Shutdown();
+		Connection.Reset();
+	}
+
+	NotifyConnected(bSuccess, error);
+}
+
+void UULSTcpTransport::HandleClosed(int32 connectionSerial, const FString& reason, bool bWasClean)
+{
+	if (connectionSerial != ConnectionSerial)
+	{
+		return;
+	}
+
+	Connection->Shutdown();
+	Connection.Reset();
+
+	// Frames received before the connection closed are handled before the owner learns about it
+	ClientNetworkOwner->ProcessInboundQueue();
+	NotifyDisconnected(0, reason, bWasClean);
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSTestSupport.h"
+#include "ULSTransport.h"
+#include "ULSWirePacket.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+FULSTestSession::FULSTestSession(const TCHAR* worldName, bool bBeginPlay)
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false, worldName);
+	FWorldContext& context = GEngine->CreateNewWorldContext(EWorldType::Game);
+	context.SetCurrentWorld(World);
+	if (bBeginPlay)
+	{
+		World->InitializeActorsForPlay(FURL());
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	Owner = NewObject<UULSTestNetworkOwner>(World);
+	Owner->AddToRoot();
+}
+
+FULSTestSession::~FULSTestSession()
+{
+	Disconnect();
+	Owner->RemoveFromRoot();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+void FULSTestSession::Disconnect()
+{
+	if (IsValid(Owner->Transport))
+	{
+		Owner->Transport->Disconnect();
+	}
+}
+
+void FULSTestSession::Apply(const TArray<TArray<uint8>>& packets)
+{
+	for (const TArray<uint8>& bytes : packets)
+	{
+		UULSWirePacket* packet = NewObject<UULSWirePacket>();
+		if (packet->ParseFromView(bytes))
+		{
+			Owner->HandleWirePacket(packet);
+		}
+		packet->ReleaseView();
+	}
+}
+
+void FULSTestSession::Tick(float deltaTime)
+{
+	Owner->TickOwner(deltaTime);
+}
+
+bool FULSTestSession::TickUntil(float seconds, TFunctionRef<bool()> done)
+{
+	const double endTime = FPlatformTime::Seconds() + seconds;
+	while (done() == false)
+	{
+		if (FPlatformTime::Seconds() >= endTime)
+		{
+			return false;
+		}
+		FPlatformProcess::Sleep(0.005f);
+		Tick(0.005f);
+	}
+	return true;
+}
+
+#endif
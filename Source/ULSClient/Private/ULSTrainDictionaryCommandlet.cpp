@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSTrainDictionaryCommandlet.h"
+#include "ULSCompression.h"
+#include "ULSCapture.h"
+#include "ULSWirePacket.h"
+#include "ULSStats.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UULSTrainDictionaryCommandlet::UULSTrainDictionaryCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UULSTrainDictionaryCommandlet::Main(const FString& Params)
+{
+	FString samplesPath;
+	FString outputFile;
+	int32 dictionarySize = 32 * 1024;
+
+	if (FParse::Value(*Params, TEXT("Samples="), samplesPath) == false ||
+		FParse::Value(*Params, TEXT("Output="), outputFile) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("Usage: -run=ULSTrainDictionary -Samples=<capture file or directory> -Output=<file> [-Size=32768]"));
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("Size="), dictionarySize);
+
+	samplesPath = ULSCapture::ResolvePath(samplesPath);
+	TArray<FString> captureFiles;
+	if (IFileManager::Get().DirectoryExists(*samplesPath))
+	{
+		IFileManager::Get().FindFiles(captureFiles, *FPaths::Combine(samplesPath, TEXT("*.ulscap")), true, false);
+		for (FString& file : captureFiles)
+		{
+			file = FPaths::Combine(samplesPath, file);
+		}
+	}
+	else
+	{
+		captureFiles.Add(samplesPath);
+	}
+
+	TArray<TArray<uint8>> samples;
+	int64 totalBytes = 0;
+	for (const FString& file : captureFiles)
+	{
+		FULSCaptureReader reader;
+		if (reader.Open(file) == false)
+		{
+			UE_LOG(LogULS, Warning, TEXT("ULSTrainDictionary: %s is not a capture file"), *file);
+			continue;
+		}
+
+		// What the server sends is what gets compressed. Captured packets are decompressed already.
+		FULSCaptureFrame frame;
+		while (reader.Next(frame))
+		{
+			if (frame.Direction != EULSCaptureDirection::Inbound || frame.Bytes.Num() <= UULSWirePacket::HeaderSize)
+			{
+				continue;
+			}
+
+			// Chunks carry slices of packets as they were on the wire, possibly compressed
+			const int32 header = *(const int32*)frame.Bytes.GetData();
+			if ((header & EWirePacketFlags::Compressed) != 0 || (header & UULSWirePacket::PacketTypeMask) == (int32)EWirePacketType::ChannelChunk)
+			{
+				continue;
+			}
+
+			// Only payloads are compressed, so the header is not part of the sample
+			samples.Emplace(frame.Bytes.GetData() + UULSWirePacket::HeaderSize, frame.Bytes.Num() - UULSWirePacket::HeaderSize);
+			totalBytes += samples.Last().Num();
+		}
+	}
+
+	if (samples.Num() == 0)
+	{
+		UE_LOG(LogULS, Error, TEXT("ULSTrainDictionary: No inbound packets found in %s"), *samplesPath);
+		return 1;
+	}
+
+	const TArray<uint8> dictionary = FULSCompression::TrainDictionary(samples, dictionarySize);
+	if (FFileHelper::SaveArrayToFile(dictionary, *outputFile) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("ULSTrainDictionary: Failed to write %s"), *outputFile);
+		return 1;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("ULSTrainDictionary: Trained %i byte dictionary (id %08x) from %i samples (%lld bytes) of %i capture file(s)"),
+		dictionary.Num(), FULSCompression::GetDictionaryId(dictionary), samples.Num(), totalBytes, captureFiles.Num());
+	return 0;
+}
@@ -3,6 +3,13 @@
 
 #include "ULSTransport.h"
 #include "ULSWirePacket.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSSimulatedTransport.h"
+#include "ULSCompression.h"
+#include "ULSStats.h"
+#include "ULSLatencyStats.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
 
 bool UULSTransport::IsConnected() const
 {
@@ -20,6 +27,371 @@ void UULSTransport::Disconnect()
 }
 
 void UULSTransport::SendWirePacket(const UULSWirePacket* packet)
+{
+	if (IsValid(packet) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("SendWirePacket: Failed to send packet. Packet is NULL."));
+		return;
+	}
+
+	// Packets built in Blueprints may not be finalized, they are sent as a copy with the header written
+	TArray<uint8> serializedBytes;
+	TConstArrayView<uint8> wireBytes = packet->GetWireBytes();
+	if (packet->IsHeaderFinalized() == false)
+	{
+		serializedBytes = packet->SerializeToBytes();
+		wireBytes = serializedBytes;
+	}
+
+	if (Capture.IsValid())
+	{
+		Capture->Write(EULSCaptureDirection::Outbound, ChannelIndex, wireBytes);
+	}
+
+	if (EnumHasAnyFlags(NegotiatedFeatures, ETransportFeatures::Compression) &&
+		packet->GetPayloadSize() >= CompressionThreshold)
+	{
+		TArray<uint8> compressedBytes;
+		if (CompressPacket(packet, compressedBytes))
+		{
+			FULSNetStats::RecordSent(compressedBytes);
+			SendBytes(compressedBytes);
+			return;
+		}
+	}
+
+	FULSNetStats::RecordSent(wireBytes);
+	SendBytes(wireBytes);
+}
+
+void UULSTransport::SendBytes(TConstArrayView<uint8> bytes)
 {
 	//
-}
\ No newline at end of file
+}
+
+void UULSTransport::FlushOutboundQueue()
+{
+	TArray<uint8> bytes;
+	while (OutboundQueue->Dequeue(bytes))
+	{
+		if (Capture.IsValid())
+		{
+			Capture->Write(EULSCaptureDirection::Outbound, ChannelIndex, bytes);
+		}
+		FULSNetStats::RecordSent(bytes);
+		SendBytes(bytes);
+	}
+}
+
+ETransportFeatures UULSTransport::GetRequestedFeatures() const
+{
+	ETransportFeatures features = ETransportFeatures::None;
+	if (bEnableCompression)
+	{
+		features |= ETransportFeatures::Compression;
+	}
+	return features;
+}
+
+int32 UULSTransport::GetFeatureOptionsSize(ETransportFeatures feature) const
+{
+	switch (feature)
+	{
+	case ETransportFeatures::Compression:
+		// Threshold, dictionary id
+		return sizeof(int32) + sizeof(uint32);
+
+	default:
+		return 0;
+	}
+}
+
+void UULSTransport::WriteFeatureOptions(ETransportFeatures feature, UULSWirePacket* packet, int& position) const
+{
+	switch (feature)
+	{
+	case ETransportFeatures::Compression:
+		packet->PutInt32(CompressionThreshold, position, position);
+		packet->PutUInt32(CompressionDictionaryId, position, position);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UULSTransport::ReadFeatureOptions(ETransportFeatures feature, const UULSWirePacket* packet, int& position)
+{
+	switch (feature)
+	{
+	case ETransportFeatures::Compression:
+	{
+		// The server's threshold only affects what the server sends
+		const int32 serverThreshold = packet->ReadInt32(position, position);
+		const uint32 dictionaryId = (uint32)packet->ReadInt32(position, position);
+		bServerAcceptedDictionary = (dictionaryId != 0 && dictionaryId == CompressionDictionaryId);
+		if (dictionaryId != 0 && bServerAcceptedDictionary == false)
+		{
+			UE_LOG(LogULS, Warning, TEXT("ReadFeatureOptions: Server uses compression dictionary %08x, expected %08x. Compressing without dictionary."),
+				dictionaryId, CompressionDictionaryId);
+		}
+	}
+	break;
+
+	default:
+		break;
+	}
+}
+
+void UULSTransport::SetNegotiatedFeatures(ETransportFeatures features)
+{
+	NegotiatedFeatures = features & GetRequestedFeatures();
+}
+
+void UULSTransport::HandleReceivedBytes(TArray<uint8>&& bytes, uint64 receiveCycles)
+{
+	if (Simulator != nullptr)
+	{
+		Simulator->HandleWrappedReceived(MoveTemp(bytes));
+		return;
+	}
+
+	DecodeReceivedBytes(MoveTemp(bytes), true, receiveCycles);
+}
+
+void UULSTransport::DecodeReceivedBytes(TArray<uint8>&& bytes, bool bCapture, uint64 receiveCycles)
+{
+	const uint64 decodeStartCycles = FPlatformTime::Cycles64();
+
+	LLM_SCOPE_BYTAG(ULS);
+	FULSNetStats::RecordReceived(bytes);
+
+	UULSWirePacket* packet;
+	{
+		ULS_SCOPE_CYCLE_COUNTER(STAT_ULSDecode);
+
+		if (bytes.Num() >= UULSWirePacket::HeaderSize &&
+			(*(int32*)bytes.GetData() & EWirePacketFlags::Compressed) != 0)
+		{
+			if (DecompressBytes(bytes) == false)
+			{
+				UE_LOG(LogULS, Error, TEXT("Failed to decompress WirePacket"));
+				return;
+			}
+		}
+
+		if (bCapture && Capture.IsValid())
+		{
+			Capture->Write(EULSCaptureDirection::Inbound, ChannelIndex, bytes);
+		}
+
+		packet = NewObject<UULSWirePacket>();
+		if (packet != nullptr && packet->ParseFromBytes(MoveTemp(bytes)) == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("Failed to parse WirePacket from bytes"));
+			return;
+		}
+	}
+
+	if (packet != nullptr)
+	{
+		DispatchPacket(packet, receiveCycles, decodeStartCycles);
+	}
+}
+
+void UULSTransport::HandleReceivedView(TConstArrayView<uint8> bytes, uint64 receiveCycles)
+{
+	if (Simulator != nullptr ||
+		(bytes.Num() >= UULSWirePacket::HeaderSize &&
+		(*(const int32*)bytes.GetData() & EWirePacketFlags::Compressed) != 0))
+	{
+		HandleReceivedBytes(TArray<uint8>(bytes.GetData(), bytes.Num()), receiveCycles);
+		return;
+	}
+
+	const uint64 decodeStartCycles = FPlatformTime::Cycles64();
+
+	LLM_SCOPE_BYTAG(ULS);
+	FULSNetStats::RecordReceived(bytes);
+
+	if (Capture.IsValid())
+	{
+		Capture->Write(EULSCaptureDirection::Inbound, ChannelIndex, bytes);
+	}
+
+	UULSWirePacket* packet;
+	{
+		ULS_SCOPE_CYCLE_COUNTER(STAT_ULSDecode);
+
+		packet = NewObject<UULSWirePacket>();
+		if (packet != nullptr && packet->ParseFromView(bytes) == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("Failed to parse WirePacket from bytes"));
+			return;
+		}
+	}
+
+	if (packet != nullptr)
+	{
+		DispatchPacket(packet, receiveCycles, decodeStartCycles);
+
+		// The bytes go away after this call. Handlers that kept the packet had to detach it.
+		packet->ReleaseView();
+	}
+}
+
+void UULSTransport::DispatchPacket(UULSWirePacket* packet, uint64 receiveCycles, uint64 decodeStartCycles)
+{
+	if (FULSLatencyStats::IsEnabled() == false)
+	{
+		ClientNetworkOwner->HandleWirePacket(packet);
+		return;
+	}
+
+	const uint64 decodedCycles = FPlatformTime::Cycles64();
+	const uint64 onRepCycles = FULSLatencyStats::GetOnRepCycles();
+
+	ClientNetworkOwner->HandleWirePacket(packet);
+
+	FULSLatencyStats::RecordPacket(packet->PacketType, receiveCycles != 0 ? receiveCycles : decodeStartCycles, decodeStartCycles, decodedCycles,
+		FULSLatencyStats::GetOnRepCycles() - onRepCycles, FPlatformTime::Cycles64());
+}
+
+void UULSTransport::ResetNegotiatedFeatures()
+{
+	NegotiatedFeatures = ETransportFeatures::None;
+	bServerAcceptedDictionary = false;
+
+	// Packets queued for the previous connection would arrive out of context
+	OutboundQueue->Reset();
+	OutboundQueue->SetMaxQueuedBytes(MaxOutboundQueueBytes);
+
+	LoadCompressionDictionary();
+}
+
+void UULSTransport::NotifyConnected(bool bSuccess, const FString& errorMessage)
+{
+	if (Simulator != nullptr)
+	{
+		Simulator->NotifyConnected(bSuccess, errorMessage);
+		return;
+	}
+
+	if (ClientNetworkOwner == nullptr)
+	{
+		return;
+	}
+
+	if (ChannelIndex == 0)
+	{
+		ClientNetworkOwner->OnConnected(bSuccess, errorMessage);
+	}
+	else
+	{
+		ClientNetworkOwner->OnChannelConnected(this, bSuccess, errorMessage);
+	}
+}
+
+void UULSTransport::NotifyDisconnected(int32 statusCode, const FString& reason, bool bWasClean)
+{
+	if (Simulator != nullptr)
+	{
+		Simulator->HandleWrappedDisconnected(statusCode, reason, bWasClean);
+		return;
+	}
+
+	if (ClientNetworkOwner == nullptr)
+	{
+		return;
+	}
+
+	if (ChannelIndex == 0)
+	{
+		ClientNetworkOwner->OnDisconnected(statusCode, reason, bWasClean);
+	}
+	else
+	{
+		ClientNetworkOwner->OnChannelDisconnected(this, statusCode, reason);
+	}
+}
+
+void UULSTransport::SimulateDatagram(bool bOutgoing, TConstArrayView<uint8> datagram)
+{
+	if (Simulator != nullptr)
+	{
+		Simulator->HandleWrappedDatagram(bOutgoing, datagram);
+	}
+}
+
+void UULSTransport::LoadCompressionDictionary()
+{
+	CompressionDictionary.Reset();
+	CompressionDictionaryId = 0;
+
+	if (bEnableCompression == false || CompressionDictionaryPath.IsEmpty())
+	{
+		return;
+	}
+
+	const FString fullPath = FPaths::Combine(FPaths::ProjectDir(), CompressionDictionaryPath);
+	if (FFileHelper::LoadFileToArray(CompressionDictionary, *fullPath) == false)
+	{
+		UE_LOG(LogULS, Warning, TEXT("LoadCompressionDictionary: Failed to load %s. Compressing without dictionary."), *fullPath);
+		CompressionDictionary.Reset();
+		return;
+	}
+
+	CompressionDictionaryId = FULSCompression::GetDictionaryId(CompressionDictionary);
+}
+
+TConstArrayView<uint8> UULSTransport::GetActiveDictionary() const
+{
+	if (bServerAcceptedDictionary)
+	{
+		return CompressionDictionary;
+	}
+	return TConstArrayView<uint8>();
+}
+
+bool UULSTransport::CompressPacket(const UULSWirePacket* packet, TArray<uint8>& outBytes) const
+{
+	// Header, uncompressed payload size, deflate stream
+	const TConstArrayView<uint8> payload = packet->GetPayload();
+	const int32 prefixSize = UULSWirePacket::HeaderSize + sizeof(int32);
+	outBytes.Reset(prefixSize + payload.Num());
+	outBytes.AddUninitialized(prefixSize);
+
+	*(int32*)outBytes.GetData() = (packet->PacketType & UULSWirePacket::PacketTypeMask) | packet->HeaderFlags | EWirePacketFlags::Compressed;
+	*(int32*)(outBytes.GetData() + UULSWirePacket::HeaderSize) = payload.Num();
+
+	return FULSCompression::Compress(payload, GetActiveDictionary(), outBytes);
+}
+
+bool UULSTransport::DecompressBytes(TArray<uint8>& bytes) const
+{
+	const int32 prefixSize = UULSWirePacket::HeaderSize + sizeof(int32);
+	if (bytes.Num() < prefixSize)
+	{
+		return false;
+	}
+
+	const int32 uncompressedSize = *(int32*)(bytes.GetData() + UULSWirePacket::HeaderSize);
+	if (uncompressedSize < 0 || uncompressedSize > MaxDecompressedSize)
+	{
+		UE_LOG(LogULS, Error, TEXT("DecompressBytes: Invalid uncompressed size %i"), uncompressedSize);
+		return false;
+	}
+
+	TArray<uint8> inflated;
+	inflated.SetNumUninitialized(UULSWirePacket::HeaderSize + uncompressedSize);
+	*(int32*)inflated.GetData() = *(int32*)bytes.GetData() & ~EWirePacketFlags::Compressed;
+
+	const TConstArrayView<uint8> compressed(bytes.GetData() + prefixSize, bytes.Num() - prefixSize);
+	if (FULSCompression::Decompress(compressed, GetActiveDictionary(), inflated.GetData() + UULSWirePacket::HeaderSize, uncompressedSize) == false)
+	{
+		return false;
+	}
+
+	bytes = MoveTemp(inflated);
+	return true;
+}
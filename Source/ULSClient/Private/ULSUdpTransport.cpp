@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSUdpTransport.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSWirePacket.h"
+#include "ULSStats.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+UULSUdpTransport::UULSUdpTransport()
+{
+	// Deltas are sequenced and carry everything that changed since an acknowledged baseline,
+	// so they don't have to wait for each other
+	ChannelRouting.Add(EWirePacketType::ReplicationDelta, EULSDeliveryChannel::ReliableUnordered);
+}
+
+void UULSUdpTransport::BeginDestroy()
+{
+	Super::BeginDestroy();
+
+	Disconnect();
+}
+
+void UULSUdpTransport::SetConnectionData(FString host, int32 port)
+{
+	Host = host;
+	Port = port;
+}
+
+float UULSUdpTransport::GetSmoothedRtt() const
+{
+	return Endpoint.IsValid() ? (float)Endpoint->GetSmoothedRtt() : 0.0f;
+}
+
+bool UULSUdpTransport::Connect()
+{
+	UE_LOG(LogULS, Display, TEXT("UULSUdpTransport::Connect to %s:%d"), *Host, Port);
+
+	Disconnect();
+	ResetNegotiatedFeatures();
+
+	ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FAddressInfoResult addressInfo = socketSubsystem->GetAddressInfo(*Host, nullptr, EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Datagram);
+	if (addressInfo.ReturnCode != SE_NO_ERROR || addressInfo.Results.Num() == 0)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSUdpTransport::Connect: Failed to resolve %s"), *Host);
+		return false;
+	}
+
+	ServerAddress = addressInfo.Results[0].Address;
+	ServerAddress->SetPort(Port);
+	ReceiveAddress = socketSubsystem->CreateInternetAddr(ServerAddress->GetProtocolType());
+
+	Socket = socketSubsystem->CreateSocket(NAME_DGram, TEXT("ULSUdpTransport"), ServerAddress->GetProtocolType());
+	if (Socket == nullptr)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSUdpTransport::Connect: Failed to create socket"));
+		return false;
+	}
+	Socket->SetNonBlocking(true);
+
+	ReceiveBuffer.SetNumUninitialized(FMath::Max(Mtu, 2048));
+
+	Endpoint = MakeShared<FULSReliableEndpoint>(Mtu);
+	Endpoint->OnSendDatagram = [this](TConstArrayView<uint8> datagram)
+	{
+		SendDatagram(datagram);
+	};
+	Endpoint->OnReceiveMessage = [this](EULSDeliveryChannel channel, TArray<uint8>&& message)
+	{
+		HandleReceivedBytes(MoveTemp(message));
+	};
+
+	State = EState::Connecting;
+	ConnectStartTime = FPlatformTime::Seconds();
+	LastConnectAttemptTime = ConnectStartTime;
+	SendControl(EULSDatagramKind::Connect);
+
+	if (TickerHandle.IsValid() == false)
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UULSUdpTransport::Tick));
+	}
+
+	return true;
+}
+
+void UULSUdpTransport::Disconnect()
+{
+	if (Socket == nullptr)
+	{
+		return;
+	}
+
+	UE_LOG(LogULS, Display, TEXT("UULSUdpTransport::Disconnect"));
+
+	if (State == EState::Connected)
+	{
+		// Flush what is queued. The server times the connection out if the notification is lost.
+		Endpoint->Update(FPlatformTime::Seconds());
+
+		// Bypasses a simulator, the socket is closed before it would release the datagram
+		const uint8 datagram = (uint8)EULSDatagramKind::Disconnect;
+		SendDatagramNow(TConstArrayView<uint8>(&datagram, 1));
+	}
+
+	// Closed on request, like UULSWebSocketTransport the owner is not notified
+	State = EState::Disconnected;
+	CloseConnection(0, FString(), true);
+}
+
+void UULSUdpTransport::SendBytes(TConstArrayView<uint8> bytes)
+{
+	if (!IsConnected() || bytes.Num() < UULSWirePacket::HeaderSize)
+	{
+		// Don't send if we're not connected.
+		return;
+	}
+
+	int32 header;
+	FMemory::Memcpy(&header, bytes.GetData(), sizeof(int32));
+	const EULSDeliveryChannel* channel = ChannelRouting.Find(header & UULSWirePacket::PacketTypeMask);
+
+	Endpoint->Send(channel != nullptr ? *channel : DefaultChannel, bytes);
+}
+
+bool UULSUdpTransport::Tick(float deltaTime)
+{
+	if (Socket == nullptr)
+	{
+		return true;
+	}
+
+	const double now = FPlatformTime::Seconds();
+	ReceiveDatagrams(now);
+
+	if (State == EState::Connecting)
+	{
+		if (now - ConnectStartTime > ConnectTimeout)
+		{
+			CloseConnection(0, TEXT("Connection timed out"), false);
+		}
+		else if (now - LastConnectAttemptTime >= ConnectRetryInterval)
+		{
+			LastConnectAttemptTime = now;
+			SendControl(EULSDatagramKind::Connect);
+		}
+	}
+	else if (State == EState::Connected)
+	{
+		// The endpoint only sees Data datagrams, the Accept starts the idle time
+		if (now - FMath::Max(Endpoint->GetLastReceiveTime(), AcceptTime) > IdleTimeout)
+		{
+			CloseConnection(0, TEXT("Connection timed out"), false);
+		}
+		else
+		{
+			Endpoint->Update(now);
+		}
+	}
+
+	return true;
+}
+
+void UULSUdpTransport::ReceiveDatagrams(double now)
+{
+	// Message handlers may disconnect or reconnect, keep the endpoint alive until we're done with it
+	TSharedPtr<FULSReliableEndpoint> endpoint = Endpoint;
+
+	int32 bytesRead = 0;
+	while (Socket != nullptr && Socket->RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), bytesRead, *ReceiveAddress))
+	{
+		if (bytesRead <= 0 || !(*ReceiveAddress == *ServerAddress))
+		{
+			continue;
+		}
+
+		const TConstArrayView<uint8> datagram(ReceiveBuffer.GetData(), bytesRead);
+		if (Simulator != nullptr)
+		{
+			SimulateDatagram(false, datagram);
+			continue;
+		}
+		ProcessDatagram(datagram, now);
+
+		if (endpoint != Endpoint)
+		{
+			break;
+		}
+	}
+}
+
+void UULSUdpTransport::ProcessDatagram(TConstArrayView<uint8> datagram, double now)
+{
+	switch ((EULSDatagramKind)datagram[0])
+	{
+	case EULSDatagramKind::Accept:
+		if (State == EState::Connecting)
+		{
+			State = EState::Connected;
+			AcceptTime = now;
+			FString empty = FString();
+			NotifyConnected(true, empty);
+		}
+		break;
+
+	case EULSDatagramKind::Disconnect:
+		CloseConnection(0, TEXT("Closed by server"), true);
+		break;
+
+	case EULSDatagramKind::Data:
+		if (State == EState::Connected)
+		{
+			// Message handlers may disconnect or reconnect
+			TSharedPtr<FULSReliableEndpoint> endpoint = Endpoint;
+			endpoint->ReceiveDatagram(datagram, now);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UULSUdpTransport::SendControl(EULSDatagramKind kind)
+{
+	const uint8 datagram = (uint8)kind;
+	SendDatagram(TConstArrayView<uint8>(&datagram, 1));
+}
+
+void UULSUdpTransport::SendDatagram(TConstArrayView<uint8> datagram)
+{
+	if (Simulator != nullptr)
+	{
+		SimulateDatagram(true, datagram);
+		return;
+	}
+	SendDatagramNow(datagram);
+}
+
+void UULSUdpTransport::SendDatagramNow(TConstArrayView<uint8> datagram)
+{
+	if (Socket == nullptr)
+	{
+		return;
+	}
+
+	int32 bytesSent = 0;
+	if (!Socket->SendTo(datagram.GetData(), datagram.Num(), bytesSent, *ServerAddress))
+	{
+		UE_LOG(LogULS, Verbose, TEXT("UULSUdpTransport: Failed to send datagram of %d bytes"), datagram.Num());
+	}
+}
+
+void UULSUdpTransport::ReleaseSimulatedDatagram(bool bOutgoing, TConstArrayView<uint8> datagram)
+{
+	if (bOutgoing)
+	{
+		SendDatagramNow(datagram);
+	}
+	else if (Socket != nullptr)
+	{
+		ProcessDatagram(datagram, FPlatformTime::Seconds());
+	}
+}
+
+void UULSUdpTransport::CloseConnection(int32 code, const FString& reason, bool bWasClean)
+{
+	const EState previousState = State;
+	State = EState::Disconnected;
+
+	if (Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	if (ClientNetworkOwner == nullptr)
+	{
+		return;
+	}
+
+	if (previousState == EState::Connecting)
+	{
+		NotifyConnected(false, reason);
+	}
+	else if (previousState == EState::Connected)
+	{
+		NotifyDisconnected(code, reason, bWasClean);
+	}
+}
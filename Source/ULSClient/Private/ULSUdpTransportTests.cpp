@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSUdpTransport.h"
+#include "ULSReliableEndpoint.h"
+#include "ULSPacketWriter.h"
+#include "Misc/AutomationTest.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* UULSUdpTransport against a server stand-in on a loopback socket: it answers Connect with Accept and
+* runs its own FULSReliableEndpoint for the client. Both sides are ticked by the test in real time.
+*/
+
+namespace
+{
+	class FUdpTestServer
+	{
+	public:
+		FUdpTestServer()
+		{
+			ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+			TSharedRef<FInternetAddr> bindAddress = socketSubsystem->CreateInternetAddr();
+			bool bValid = false;
+			bindAddress->SetIp(TEXT("127.0.0.1"), bValid);
+			bindAddress->SetPort(0);
+
+			Socket = socketSubsystem->CreateSocket(NAME_DGram, TEXT("ULSUdpTestServer"), bindAddress->GetProtocolType());
+			if (Socket != nullptr && (Socket->Bind(*bindAddress) == false || Socket->SetNonBlocking(true) == false))
+			{
+				socketSubsystem->DestroySocket(Socket);
+				Socket = nullptr;
+			}
+			ClientAddress = socketSubsystem->CreateInternetAddr();
+
+			Endpoint.OnSendDatagram = [this](TConstArrayView<uint8> datagram)
+			{
+				SendTo(datagram);
+			};
+			Endpoint.OnReceiveMessage = [this](EULSDeliveryChannel channel, TArray<uint8>&& message)
+			{
+				Received.Add(MoveTemp(message));
+			};
+		}
+
+		~FUdpTestServer()
+		{
+			if (Socket != nullptr)
+			{
+				ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+			}
+		}
+
+		bool IsValid() const { return Socket != nullptr; }
+
+		int32 GetPort() const { return Socket->GetPortNo(); }
+
+		/* Answers Connect datagrams and feeds the endpoint. With bSilent nothing is answered. */
+		void Tick(double now, bool bSilent = false)
+		{
+			uint8 buffer[2048];
+			int32 bytesRead = 0;
+			while (Socket->RecvFrom(buffer, sizeof(buffer), bytesRead, *ClientAddress))
+			{
+				if (bytesRead <= 0 || bSilent)
+				{
+					continue;
+				}
+				bHasClient = true;
+
+				if (buffer[0] == (uint8)EULSDatagramKind::Connect)
+				{
+					NumConnects++;
+					const uint8 accept = (uint8)EULSDatagramKind::Accept;
+					SendTo(TConstArrayView<uint8>(&accept, 1));
+				}
+				else if (buffer[0] == (uint8)EULSDatagramKind::Data)
+				{
+					Endpoint.ReceiveDatagram(TConstArrayView<uint8>(buffer, bytesRead), now);
+				}
+			}
+
+			if (bHasClient && bSilent == false)
+			{
+				Endpoint.Update(now);
+			}
+		}
+
+		FULSReliableEndpoint Endpoint;
+		TArray<TArray<uint8>> Received;
+		int32 NumConnects = 0;
+
+	private:
+		void SendTo(TConstArrayView<uint8> datagram)
+		{
+			int32 bytesSent = 0;
+			Socket->SendTo(datagram.GetData(), datagram.Num(), bytesSent, *ClientAddress);
+		}
+
+		FSocket* Socket = nullptr;
+		TSharedPtr<FInternetAddr> ClientAddress;
+		bool bHasClient = false;
+	};
+
+	/* Ticks the transport and the server every few milliseconds for the given time, or until done returns true */
+	bool TickFor(UULSUdpTransport* transport, FUdpTestServer& server, double seconds, bool bSilent, TFunctionRef<bool()> done)
+	{
+		const double endTime = FPlatformTime::Seconds() + seconds;
+		while (FPlatformTime::Seconds() < endTime)
+		{
+			transport->Tick(0.005f);
+			server.Tick(FPlatformTime::Seconds(), bSilent);
+			if (done())
+			{
+				return true;
+			}
+			FPlatformProcess::Sleep(0.005f);
+		}
+		return false;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSUdpTransportConnectionTest, "ULS.Udp.Connection",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSUdpTransportConnectionTest::RunTest(const FString& Parameters)
+{
+	FUdpTestServer server;
+	if (TestTrue(TEXT("Server socket bound"), server.IsValid()) == false)
+	{
+		return false;
+	}
+
+	UULSUdpTransport* transport = NewObject<UULSUdpTransport>();
+	transport->AddToRoot();
+	transport->SetConnectionData(TEXT("127.0.0.1"), server.GetPort());
+	transport->IdleTimeout = 0.3f;
+	server.Endpoint.KeepAliveInterval = 0.05;
+
+	TestTrue(TEXT("Connecting"), transport->Connect());
+	TestTrue(TEXT("Accepted"), TickFor(transport, server, 2.0, false, [transport]() { return transport->IsConnected(); }));
+
+	// Idle until the keepalives arrive, the handshake alone must not count as silence
+	TickFor(transport, server, 1.0, false, []() { return false; });
+	TestTrue(TEXT("Connected across ticks and past the idle timeout"), transport->IsConnected());
+	TestEqual(TEXT("One connection"), server.NumConnects, 1);
+
+	// Packets reach the server's endpoint
+	FULSPacketWriter writer(EWirePacketType::Custom);
+	writer.WriteInt32(1234);
+	const TArray<uint8> packet = writer.MoveBytes();
+	transport->SendBytes(packet);
+	TestTrue(TEXT("Packet delivered"), TickFor(transport, server, 1.0, false, [&server]() { return server.Received.Num() > 0; }));
+	if (server.Received.Num() > 0)
+	{
+		TestTrue(TEXT("Packet bytes"), server.Received[0] == packet);
+	}
+
+	// A server that went silent is detected
+	const bool bTimedOut = TickFor(transport, server, 2.0, true, [transport]() { return transport->IsConnected() == false; });
+	TestTrue(TEXT("Silent server timed out"), bTimedOut);
+
+	transport->Disconnect();
+	transport->RemoveFromRoot();
+	return true;
+}
+
+#endif
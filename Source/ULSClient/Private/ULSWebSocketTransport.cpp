@@ -4,6 +4,7 @@
 #include "ULSWebSocketTransport.h"
 #include "ULSClientNetworkOwner.h"
 #include "ULSWirePacket.h"
+#include "ULSStats.h"
 
 UULSWebSocketTransport::~UULSWebSocketTransport()
 {
@@ -29,23 +30,28 @@ bool UULSWebSocketTransport::Connect()
 {
     FString serverUrl = FString::Printf(TEXT("%s://%s:%d/%s"), *_protocol, *_ip, _port, *_resource);
 
-    UE_LOG(LogTemp, Display, TEXT("UWebSocketConnection::Connect to %s"), *serverUrl);
+    UE_LOG(LogULS, Display, TEXT("UWebSocketConnection::Connect to %s"), *serverUrl);
 
     if (!FModuleManager::Get().IsModuleLoaded("WebSockets"))
     {
         FModuleManager::Get().LoadModule("WebSockets");
     }
 
+    ResetNegotiatedFeatures();
+
+    MessageAssembler.Reset();
+    MessageAssembler.MaxMessageSize = MaxDecompressedSize + UULSWirePacket::HeaderSize;
+
     auto WebSocketModule = &FWebSocketsModule::Get();
-    _webSocket = WebSocketModule->CreateWebSocket(serverUrl, *_protocol);
+    _webSocket = WebSocketModule->CreateWebSocket(serverUrl, Subprotocol.IsEmpty() ? _protocol : Subprotocol);
 
     // We bind all available events
     OnConnectedHandle = _webSocket->OnConnected().AddLambda([this]() -> void {
         AsyncTask(ENamedThreads::GameThread, [this]()
             {
-                //UE_LOG(LogTemp, Display, TEXT("OnConnected"));
+                //UE_LOG(LogULS, Display, TEXT("OnConnected"));
                 FString empty = FString();
-                this->ClientNetworkOwner->OnConnected(true, empty);
+                this->NotifyConnected(true, empty);
             });
         });
 
@@ -53,19 +59,19 @@ bool UULSWebSocketTransport::Connect()
         // This code will run if the connection failed. Check Error to see what happened.
         AsyncTask(ENamedThreads::GameThread, [this, Error]()
             {
-                //UE_LOG(LogTemp, Display, TEXT("OnConnectionError"));
-                this->ClientNetworkOwner->OnConnected(false, Error);
+                //UE_LOG(LogULS, Display, TEXT("OnConnectionError"));
+                this->NotifyConnected(false, Error);
             });
         });
 
     OnClosedHandle = _webSocket->OnClosed().AddLambda([this](int32 StatusCode, const FString& Reason, bool bWasClean) -> void {
         // This code will run when the connection to the server has been terminated.
         // Because of an error or a call to Socket->Close().
-        //UE_LOG(LogTemp, Display, TEXT("OnClosed"));
+        //UE_LOG(LogULS, Display, TEXT("OnClosed"));
         AsyncTask(ENamedThreads::GameThread, [this, StatusCode, Reason, bWasClean]()
             {
-                //UE_LOG(LogTemp, Display, TEXT("Call OnDisconnected"));
-                this->ClientNetworkOwner->OnDisconnected(StatusCode, Reason, bWasClean);
+                //UE_LOG(LogULS, Display, TEXT("Call OnDisconnected"));
+                this->NotifyDisconnected(StatusCode, Reason, bWasClean);
             });
         });
 
@@ -73,28 +79,28 @@ bool UULSWebSocketTransport::Connect()
         // This code will run when we receive a string message from the server.
         AsyncTask(ENamedThreads::GameThread, [this, Message]()
             {
-                //UE_LOG(LogTemp, Display, TEXT("OnMessage"));
+                //UE_LOG(LogULS, Display, TEXT("OnMessage"));
             });
         });
 
-    OnRawMessageHandle = _webSocket->OnRawMessage().AddLambda([this](const void* Data, SIZE_T Size, SIZE_T BytesRemaining) -> void {
-        // This code will run when we receive a raw (binary) message from the server.
-        //UE_LOG(LogTemp, Display, TEXT("OnRawMessage"));
-        TArray<uint8> bytes = TArray<uint8>((uint8*)Data, Size);
-        AsyncTask(ENamedThreads::GameThread, [this, bytes]()
+    OnBinaryMessageHandle = _webSocket->OnBinaryMessage().AddLambda([this](const void* Data, SIZE_T Size, bool bIsLastFragment) -> void {
+        // This code will run when we receive a binary message, or a fragment of one, from the server.
+        //UE_LOG(LogULS, Display, TEXT("OnBinaryMessage"));
+        TArray<uint8> bytes;
+        const int32 numDropped = MessageAssembler.GetNumDroppedMessages();
+        if (MessageAssembler.AddFragment((const uint8*)Data, (int32)Size, bIsLastFragment, bytes) == false)
+        {
+            if (MessageAssembler.GetNumDroppedMessages() != numDropped)
+            {
+                UE_LOG(LogULS, Error, TEXT("UWebSocketConnection: Dropped a message larger than %d bytes"), MessageAssembler.MaxMessageSize);
+            }
+            return;
+        }
+
+        const uint64 receiveCycles = FPlatformTime::Cycles64();
+        AsyncTask(ENamedThreads::GameThread, [this, bytes = MoveTemp(bytes), receiveCycles]() mutable
             {
-                //this->OnReceiveBytes(bytes);
-                auto packet = NewObject<UULSWirePacket>();
-                if (packet != nullptr)
-                {
-                    if (packet->ParseFromBytes(bytes) == false)
-                    {
-                        UE_LOG(LogTemp, Error, TEXT("Failed to parse WirePacket from bytes"));
-                        return;
-                    }
-
-                    this->ClientNetworkOwner->HandleWirePacket(packet);
-                }
+                this->HandleReceivedBytes(MoveTemp(bytes), receiveCycles);
             });
         });
 
@@ -102,7 +108,7 @@ bool UULSWebSocketTransport::Connect()
         // This code is called after we sent a message to the server.
         AsyncTask(ENamedThreads::GameThread, [this, MessageString]()
             {
-                //UE_LOG(LogTemp, Display, TEXT("OnMessageSent"));
+                //UE_LOG(LogULS, Display, TEXT("OnMessageSent"));
             });
         });
 
@@ -113,14 +119,14 @@ bool UULSWebSocketTransport::Connect()
 
 void UULSWebSocketTransport::Disconnect()
 {
-    UE_LOG(LogTemp, Display, TEXT("UWebSocketConnection::Disconnect"));
+    UE_LOG(LogULS, Display, TEXT("UWebSocketConnection::Disconnect"));
 
     if (_webSocket != nullptr)
     {
         _webSocket->OnConnected().Remove(OnConnectedHandle);
         _webSocket->OnConnectionError().Remove(OnConnectionErrorHandle);
         _webSocket->OnMessage().Remove(OnMessageHandle);
-        _webSocket->OnRawMessage().Remove(OnRawMessageHandle);
+        _webSocket->OnBinaryMessage().Remove(OnBinaryMessageHandle);
         _webSocket->OnMessageSent().Remove(OnMessageSentHandle);
         _webSocket->OnClosed().Remove(OnClosedHandle);
 
@@ -129,7 +135,7 @@ void UULSWebSocketTransport::Disconnect()
     _webSocket = nullptr;
 }
 
-void UULSWebSocketTransport::SendWirePacket(const UULSWirePacket* packet)
+void UULSWebSocketTransport::SendBytes(TConstArrayView<uint8> bytes)
 {
     if (!IsConnected())
     {
@@ -137,12 +143,5 @@ void UULSWebSocketTransport::SendWirePacket(const UULSWirePacket* packet)
         return;
     }
 
-    if (IsValid(packet) == false)
-    {
-        UE_LOG(LogTemp, Error, TEXT("SendWirePacket: Failed to send packet. Packet is NULL."));
-        return;
-    }
-
-    auto bytes = packet->SerializeToBytes();
     _webSocket->Send(bytes.GetData(), sizeof(uint8) * bytes.Num(), true);
 }
\ No newline at end of file
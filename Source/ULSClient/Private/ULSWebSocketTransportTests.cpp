@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSWebSocketTransport.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	TArray<uint8> MakeMessage(int32 size, uint8 seed)
+	{
+		TArray<uint8> message;
+		message.SetNumUninitialized(size);
+		for (int32 i = 0; i < size; i++)
+		{
+			message[i] = (uint8)(seed + i * 31);
+		}
+		return message;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSWebSocketReassemblyTest, "ULS.WebSocket.Reassembly",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSWebSocketReassemblyTest::RunTest(const FString& Parameters)
+{
+	FULSWebSocketMessageAssembler assembler;
+	TArray<uint8> received;
+
+	// Unfragmented message
+	const TArray<uint8> single = MakeMessage(100, 1);
+	TestTrue(TEXT("Single fragment completes"), assembler.AddFragment(single.GetData(), single.Num(), true, received));
+	TestTrue(TEXT("Single fragment bytes"), received == single);
+
+	// One message split into three frames, each frame delivered in two reads. The end of every frame
+	// looks like the end of the message to a per frame remaining byte count.
+	const TArray<uint8> split = MakeMessage(6000, 2);
+	const int32 pieces[] = { 700, 1300, 1500, 500, 1000, 1000 };
+	int32 offset = 0;
+	const int32 numPieces = UE_ARRAY_COUNT(pieces);
+	for (int32 i = 0; i < numPieces; i++)
+	{
+		const bool bIsLast = i == numPieces - 1;
+		const bool bCompleted = assembler.AddFragment(split.GetData() + offset, pieces[i], bIsLast, received);
+		TestEqual(FString::Printf(TEXT("Fragment %d completes"), i), bCompleted, bIsLast);
+		offset += pieces[i];
+	}
+	TestTrue(TEXT("Split message bytes"), received == split);
+	TestFalse(TEXT("Nothing left over"), assembler.HasPartialMessage());
+
+	// The next message starts clean, including one whose last fragment is empty
+	const TArray<uint8> next = MakeMessage(64, 3);
+	TestFalse(TEXT("First half pending"), assembler.AddFragment(next.GetData(), next.Num(), false, received));
+	TestTrue(TEXT("Empty last fragment completes"), assembler.AddFragment(nullptr, 0, true, received));
+	TestTrue(TEXT("Next message bytes"), received == next);
+
+	// A reconnect drops a half received message
+	TestFalse(TEXT("Partial before reset"), assembler.AddFragment(split.GetData(), 10, false, received));
+	assembler.Reset();
+	TestTrue(TEXT("Message after reset"), assembler.AddFragment(single.GetData(), single.Num(), true, received));
+	TestTrue(TEXT("Message after reset bytes"), received == single);
+
+	// Messages over the limit are dropped with all their fragments, the next one is received again
+	assembler.MaxMessageSize = 1000;
+	TestFalse(TEXT("Within the limit"), assembler.AddFragment(split.GetData(), 800, false, received));
+	TestFalse(TEXT("Over the limit"), assembler.AddFragment(split.GetData() + 800, 800, false, received));
+	TestFalse(TEXT("Partial message released"), assembler.HasPartialMessage());
+	TestFalse(TEXT("Last fragment of the dropped message skipped"), assembler.AddFragment(split.GetData() + 1600, 100, true, received));
+	TestFalse(TEXT("Single fragment over the limit"), assembler.AddFragment(split.GetData(), 2000, true, received));
+	TestEqual(TEXT("Dropped messages"), assembler.GetNumDroppedMessages(), 2);
+	TestTrue(TEXT("Message after the dropped ones"), assembler.AddFragment(single.GetData(), single.Num(), true, received));
+	TestTrue(TEXT("Message after the dropped ones bytes"), received == single);
+	return true;
+}
+
+#endif
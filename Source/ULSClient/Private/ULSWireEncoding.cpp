@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSWireEncoding.h"
+
+void FULSBitWriter::WriteQuantizedVector(const FVector& value, const FULSQuantizationSettings& settings)
+{
+	const double components[3] = { value.X, value.Y, value.Z };
+	Writer.WriteQuantizedVector(components, settings.ToWire());
+}
+
+FVector FULSBitReader::ReadQuantizedVector(const FULSQuantizationSettings& settings)
+{
+	double components[3];
+	Reader.ReadQuantizedVector(components, settings.ToWire());
+	return FVector(components[0], components[1], components[2]);
+}
@@ -6,289 +6,264 @@
 UULSWirePacket::UULSWirePacket()
 {
 	PacketType = 0;
-	Payload = TArray<uint8>();
+	HeaderFlags = 0;
+	PayloadOffset = HeaderSize;
+	Buffer.SetNumZeroed(HeaderSize);
 }
 
 bool UULSWirePacket::ParseFromBytes(const TArray<uint8>& bytes)
 {
-	if (bytes.Num() < 4)
+	return ParseFromBytes(TArray<uint8>(bytes));
+}
+
+bool UULSWirePacket::ParseFromBytes(TArray<uint8>&& bytes)
+{
+	if (ParseHeader(bytes.GetData(), bytes.Num()) == false)
 	{
 		return false;
 	}
 
-	PacketType = *(int32*)bytes.GetData();
-
-	int payloadLength = bytes.Num() - 4;
-	Payload = TArray<uint8>(bytes.GetData() + 4, payloadLength);
+	Buffer = MoveTemp(bytes);
+	ViewData = nullptr;
+	ViewSize = 0;
 
 	return true;
 }
 
-TArray<uint8> UULSWirePacket::SerializeToBytes() const
+bool UULSWirePacket::ParseFromView(TConstArrayView<uint8> bytes)
 {
-	int32 packetType = PacketType;
+	if (ParseHeader(bytes.GetData(), bytes.Num()) == false)
+	{
+		return false;
+	}
 
-	TArray<uint8> result;
-	result.Append((uint8*)&packetType, sizeof(int32));
-	result.Append(Payload);
-	return result;
+	Buffer.Reset();
+	ViewData = bytes.GetData();
+	ViewSize = bytes.Num();
+
+	return true;
 }
 
-int8 UULSWirePacket::ReadInt8(int index, int& advancedPosition) const
+bool UULSWirePacket::ParseHeader(const uint8* data, int32 size)
 {
-	if (Payload.Num() < (index + sizeof(int8)))
+	ULSWire::FWireHeader header;
+	if (ULSWire::ParseHeader(data, size, header) == false)
 	{
-		return 0;
+		return false;
 	}
 
-	advancedPosition += sizeof(int8);
-	const uint8* dataPtr = Payload.GetData() + index;
-	return *(int8*)dataPtr;
+	PacketType = header.PacketType;
+	HeaderFlags = header.Flags;
+	Sequence = header.Sequence;
+	PayloadOffset = header.PayloadOffset;
+
+	return true;
 }
 
-int16 UULSWirePacket::ReadInt16(int index, int& advancedPosition) const
+void UULSWirePacket::DetachFromView() const
 {
-	if (Payload.Num() < (index + sizeof(int16)))
+	if (ViewData != nullptr)
 	{
-		return 0;
+		Buffer = TArray<uint8>(ViewData, ViewSize);
+		ViewData = nullptr;
+		ViewSize = 0;
 	}
-
-	advancedPosition += sizeof(int16);
-	const uint8* dataPtr = Payload.GetData() + index;
-	return *(int16*)dataPtr;
 }
 
-
-int32 UULSWirePacket::ReadInt32(int index, int& advancedPosition) const
+void UULSWirePacket::ReleaseView()
 {
-	if (Payload.Num() < (index + sizeof(int32)))
+	if (ViewData != nullptr)
 	{
-		return 0;
+		ViewData = nullptr;
+		ViewSize = 0;
+		Buffer.SetNumZeroed(PayloadOffset);
 	}
+}
 
-	advancedPosition += sizeof(int32);
-	const uint8* dataPtr = Payload.GetData() + index;
-	return *(int32*)dataPtr;
+TArray<uint8> UULSWirePacket::SerializeToBytes() const
+{
+	// A copy, so the header can be written even if the packet wasn't finalized
+	TArray<uint8> bytes(GetWireBytes());
+	const int32 header = ULSWire::MakeHeader(PacketType, HeaderFlags);
+	FMemory::Memcpy(bytes.GetData(), &header, sizeof(int32));
+	return bytes;
 }
 
-float UULSWirePacket::ReadFloat32(int index, int& advancedPosition) const
+void UULSWirePacket::FinalizeHeader()
 {
-	if (Payload.Num() < (index + sizeof(float)))
+	DetachFromView();
+	const int32 header = ULSWire::MakeHeader(PacketType, HeaderFlags);
+	FMemory::Memcpy(Buffer.GetData(), &header, sizeof(int32));
+}
+
+bool UULSWirePacket::IsHeaderFinalized() const
+{
+	const int32 header = ULSWire::MakeHeader(PacketType, HeaderFlags);
+	return FMemory::Memcmp(ViewData != nullptr ? ViewData : Buffer.GetData(), &header, sizeof(int32)) == 0;
+}
+
+TConstArrayView<uint8> UULSWirePacket::GetWireBytes() const
+{
+	if (ViewData != nullptr)
 	{
-		return 0;
+		return TConstArrayView<uint8>(ViewData, ViewSize);
 	}
+	return TConstArrayView<uint8>(Buffer);
+}
 
-	advancedPosition += sizeof(float);
-	const uint8* dataPtr = Payload.GetData() + index;
-	return *(float*)dataPtr;
+void UULSWirePacket::SetPayloadSize(int32 size)
+{
+	DetachFromView();
+	Buffer.SetNumUninitialized(PayloadOffset + FMath::Max(size, 0));
 }
 
-double UULSWirePacket::ReadFloat64(int index, int& advancedPosition) const
+void UULSWirePacket::ResizePayload(int32 size)
 {
-	if (Payload.Num() < (index + sizeof(double)))
+	DetachFromView();
+	Buffer.SetNumZeroed(PayloadOffset + FMath::Max(size, 0));
+}
+
+TArray<uint8> UULSWirePacket::GetPayloadBytes() const
+{
+	return TArray<uint8>(GetPayload());
+}
+
+void UULSWirePacket::SetPayloadBytes(const TArray<uint8>& bytes)
+{
+	SetPayloadSize(bytes.Num());
+	if (bytes.Num() > 0)
 	{
-		return 0;
+		FMemory::Memcpy(GetPayloadData(), bytes.GetData(), bytes.Num());
 	}
+}
 
-	advancedPosition += sizeof(double);
-	const uint8* dataPtr = Payload.GetData() + index;
-	return *(double*)dataPtr;
+int8 UULSWirePacket::ReadInt8(int index, int& advancedPosition) const
+{
+	return GetReader().Read<int8>(index, advancedPosition);
+}
+
+int16 UULSWirePacket::ReadInt16(int index, int& advancedPosition) const
+{
+	return GetReader().Read<int16>(index, advancedPosition);
+}
+
+int32 UULSWirePacket::ReadInt32(int index, int& advancedPosition) const
+{
+	return GetReader().Read<int32>(index, advancedPosition);
 }
 
 int64 UULSWirePacket::ReadInt64(int index, int& advancedPosition) const
 {
-	if (Payload.Num() < (index + sizeof(int64)))
-	{
-		return 0;
-	}
+	return GetReader().Read<int64>(index, advancedPosition);
+}
 
-	advancedPosition += sizeof(int64);
-	const uint8* dataPtr = Payload.GetData() + index;
-	return *(int32*)dataPtr;
+float UULSWirePacket::ReadFloat32(int index, int& advancedPosition) const
+{
+	return GetReader().Read<float>(index, advancedPosition);
+}
+
+double UULSWirePacket::ReadFloat64(int index, int& advancedPosition) const
+{
+	return GetReader().Read<double>(index, advancedPosition);
 }
 
 FString UULSWirePacket::ReadString(int index, int& advancedPosition) const
 {
-	if (Payload.Num() < (index + sizeof(int)))
-	{
-		return FString();
-	}
+	int32 len;
+	const char* chars = GetReader().ReadString(index, advancedPosition, len);
+	return chars != nullptr ? FString(len, (const UTF8CHAR*)chars) : FString();
+}
 
-	const uint8* dataPtr = Payload.GetData() + index;
-	int len = *(int32*)dataPtr;
-	advancedPosition += sizeof(int32);
-	if (Payload.Num() < (index + sizeof(int) + len))
-	{
-		return FString();
-	}
-	advancedPosition += len;
-	dataPtr += sizeof(int32);
-	return FString(len, (UTF8CHAR*)dataPtr);
+uint64 UULSWirePacket::ReadVarUInt(int index, int& advancedPosition) const
+{
+	return GetReader().ReadVarUInt(index, advancedPosition);
 }
 
-void UULSWirePacket::PutInt8(int8 value, int index, int& advancedPosition)
+int64 UULSWirePacket::ReadVarInt(int index, int& advancedPosition) const
 {
-	if (Payload.Num() < (index + 1))
-	{
-		return;
-	}
+	return GetReader().ReadVarInt(index, advancedPosition);
+}
 
-	Payload[index] = value;
-	advancedPosition = index + sizeof(value);
+FString UULSWirePacket::ReadVarString(int index, int& advancedPosition) const
+{
+	int32 len;
+	const char* chars = GetReader().ReadVarString(index, advancedPosition, len);
+	return chars != nullptr ? FString(len, (const UTF8CHAR*)chars) : FString();
 }
 
-void UULSWirePacket::PutInt16(int16 value, int index, int& advancedPosition)
+const uint8* UULSWirePacket::ReadDataPtr(int size, int index, int& advancedPosition) const
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
+	return GetReader().ReadDataPtr(size, index, advancedPosition);
+}
 
-	int16* ptr = (int16*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+void UULSWirePacket::PutInt8(int8 value, int index, int& advancedPosition)
+{
+	GetWriter().Put<int8>(value, index, advancedPosition);
 }
 
-void UULSWirePacket::PutUInt16(uint16 value, int index, int& advancedPosition)
+void UULSWirePacket::PutInt16(int16 value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
+	GetWriter().Put<int16>(value, index, advancedPosition);
+}
 
-	uint16* ptr = (uint16*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+void UULSWirePacket::PutUInt16(uint16 value, int index, int& advancedPosition)
+{
+	GetWriter().Put<uint16>(value, index, advancedPosition);
 }
 
 void UULSWirePacket::PutInt32(int32 value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
-
-	int32* ptr = (int32*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+	GetWriter().Put<int32>(value, index, advancedPosition);
 }
 
 void UULSWirePacket::PutFloat32(float value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
-
-	float* ptr = (float*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+	GetWriter().Put<float>(value, index, advancedPosition);
 }
 
 void UULSWirePacket::PutFloat64(double value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
-
-	double* ptr = (double*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+	GetWriter().Put<double>(value, index, advancedPosition);
 }
 
 void UULSWirePacket::PutUInt32(uint32 value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
-
-	uint32* ptr = (uint32*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+	GetWriter().Put<uint32>(value, index, advancedPosition);
 }
 
 void UULSWirePacket::PutInt64(int64 value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
-
-	int64* ptr = (int64*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+	GetWriter().Put<int64>(value, index, advancedPosition);
 }
 
 void UULSWirePacket::PutUInt64(uint64 value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + sizeof(value)))
-	{
-		return;
-	}
-
-	uint64* ptr = (uint64*)&Payload[index];
-	*ptr = value;
-	advancedPosition = index + sizeof(value);
+	GetWriter().Put<uint64>(value, index, advancedPosition);
 }
 
 void UULSWirePacket::PutString(FString value, int index, int& advancedPosition)
 {
-	TArray<uint8> bytes;
-	FTCHARToUTF8 Src = FTCHARToUTF8(value.GetCharArray().GetData());
-	bytes.Append((uint8*)Src.Get(), Src.Length());
-
-	if (Payload.Num() < (index + sizeof(value.Len()) + bytes.Num()))
-	{
-		return;
-	}
-	
-	// This is likely broken logic
-	// TODO: Fixme
-
-	// Length
-
-	int32* ptr = (int32*)&Payload[index];
-	*ptr = bytes.Num();
-	advancedPosition += sizeof(int32);
-
-	// String chars
-	if (bytes.Num() > 0)
-	{
-		uint8* bptr = (uint8*)&Payload[index + 4];
-		memcpy(bptr, bytes.GetData(), bytes.Num());
-	}
-	advancedPosition += bytes.Num();
+	FTCHARToUTF8 utf8(*value);
+	GetWriter().PutString(utf8.Get(), utf8.Length(), index, advancedPosition);
 }
 
 void UULSWirePacket::PutArray(TArray<uint8> bytes, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + bytes.Num()))
-	{
-		return;
-	}
-
-	uint8* dataPtr = bytes.GetData();
-	if (dataPtr == nullptr)
-	{
-		return;
-	}
-
-	uint8* ptr = (uint8*)&Payload[index];
-	memcpy(ptr, dataPtr, bytes.Num());
-	advancedPosition += bytes.Num();
+	GetWriter().PutBytes(bytes.GetData(), bytes.Num(), index, advancedPosition);
 }
 
-const uint8* UULSWirePacket::ReadDataPtr(int size, int index, int& advancedPosition) const
+void UULSWirePacket::PutVarUInt(uint64 value, int index, int& advancedPosition)
 {
-	if (Payload.Num() < (index + size))
-	{
-		return nullptr;
-	}
+	GetWriter().PutVarUInt(value, index, advancedPosition);
+}
 
-	advancedPosition += size;
-	const uint8* dataPtr = Payload.GetData() + index;
-	return dataPtr;
+void UULSWirePacket::PutVarInt(int64 value, int index, int& advancedPosition)
+{
+	GetWriter().PutVarInt(value, index, advancedPosition);
 }
 
+void UULSWirePacket::PutVarString(FString value, int index, int& advancedPosition)
+{
+	FTCHARToUTF8 utf8(*value);
+	GetWriter().PutVarString(utf8.Get(), utf8.Length(), index, advancedPosition);
+}
@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WireCore/ULSBitStream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace ULSWire
+{
+	/* Rounds halves up, like FMath::RoundToDouble, so both sides quantize identically */
+	static double RoundHalfUp(double value)
+	{
+		return std::floor(value + 0.5);
+	}
+
+	int64_t QuantizeFloat(double value, float precision)
+	{
+		return (int64_t)RoundHalfUp(value / precision);
+	}
+
+	double DequantizeFloat(int64_t value, float precision)
+	{
+		return (double)value * precision;
+	}
+
+	// Writer
+
+	void FBitWriter::WriteBits(uint64_t value, int32_t numBits)
+	{
+		assert(numBits >= 0 && numBits <= 64);
+
+		// Fills the partial last byte, then whole bytes
+		while (numBits > 0)
+		{
+			const int32_t bitOffset = NumBits & 7;
+			if (bitOffset == 0)
+			{
+				Data.push_back(0);
+			}
+
+			const int32_t count = std::min(8 - bitOffset, numBits);
+			Data.back() |= (uint8_t)((value & ((1u << count) - 1)) << bitOffset);
+			value >>= count;
+			NumBits += count;
+			numBits -= count;
+		}
+	}
+
+	void FBitWriter::WriteVarUInt(uint64_t value)
+	{
+		if ((NumBits & 7) == 0)
+		{
+			const size_t offset = Data.size();
+			Data.resize(offset + MaxVarUIntSize);
+			const int32_t size = EncodeVarUInt(value, Data.data() + offset);
+			Data.resize(offset + size);
+			NumBits += size * 8;
+			return;
+		}
+
+		while (value >= 0x80)
+		{
+			WriteBits((value & 0x7F) | 0x80, 8);
+			value >>= 7;
+		}
+		WriteBits(value, 8);
+	}
+
+	void FBitWriter::WriteQuantizedFloat(double value, const FQuantization& settings)
+	{
+		WriteVarInt(QuantizeFloat(value, settings.FloatPrecision));
+	}
+
+	void FBitWriter::WriteQuantizedVector(const double value[3], const FQuantization& settings)
+	{
+		const double cellSize = settings.VectorCellSize;
+		const int32_t bits = std::clamp(settings.VectorComponentBits, 1, 32);
+		const uint64_t maxOffset = (1ull << bits) - 1;
+
+		int64_t cells[3];
+		uint64_t offsets[3];
+		for (int32_t i = 0; i < 3; i++)
+		{
+			const double component = value[i];
+			cells[i] = (int64_t)std::floor(component / cellSize);
+			const double offset = (component - (double)cells[i] * cellSize) / cellSize;
+			offsets[i] = (uint64_t)std::clamp(RoundHalfUp(offset * (double)maxOffset), 0.0, (double)maxOffset);
+		}
+
+		for (int32_t i = 0; i < 3; i++)
+		{
+			WriteVarInt(cells[i]);
+		}
+		for (int32_t i = 0; i < 3; i++)
+		{
+			WriteBits(offsets[i], bits);
+		}
+		AlignToByte();
+	}
+
+	void FBitWriter::AlignToByte()
+	{
+		// The padding bits of the last byte are already zero
+		NumBits = (NumBits + 7) & ~7;
+	}
+
+	void FBitWriter::Reset()
+	{
+		Data.clear();
+		NumBits = 0;
+	}
+
+	// Reader
+
+	FBitReader::FBitReader(const uint8_t* data, int32_t size, int32_t startByte)
+		: Data(data)
+		, Size(size)
+		, StartByte(startByte)
+		, BitPosition(startByte * 8)
+	{
+	}
+
+	uint64_t FBitReader::ReadBits(int32_t numBits)
+	{
+		assert(numBits >= 0 && numBits <= 64);
+
+		if (bOverflowed || (int64_t)BitPosition + numBits > (int64_t)Size * 8)
+		{
+			bOverflowed = true;
+			return 0;
+		}
+
+		uint64_t value = 0;
+		int32_t shift = 0;
+		while (numBits > 0)
+		{
+			const int32_t bitOffset = BitPosition & 7;
+			const int32_t count = std::min(8 - bitOffset, numBits);
+			const uint64_t bits = (uint64_t)((Data[BitPosition >> 3] >> bitOffset) & ((1u << count) - 1));
+			value |= bits << shift;
+			shift += count;
+			BitPosition += count;
+			numBits -= count;
+		}
+		return value;
+	}
+
+	uint64_t FBitReader::ReadVarUInt()
+	{
+		if ((BitPosition & 7) == 0 && bOverflowed == false)
+		{
+			const int32_t byteIndex = BitPosition >> 3;
+			uint64_t value;
+			const int32_t size = byteIndex < Size ? DecodeVarUInt(Data + byteIndex, Size - byteIndex, value) : 0;
+			if (size > 0)
+			{
+				BitPosition += size * 8;
+				return value;
+			}
+			// Truncated or overlong, the bitwise path below flags it like any other read
+		}
+
+		uint64_t value = 0;
+		for (int32_t shift = 0; shift < 64; shift += 7)
+		{
+			const uint64_t byte = ReadBits(8);
+			value |= (byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0 || bOverflowed)
+			{
+				return value;
+			}
+		}
+
+		// More than 10 bytes: not a valid varint
+		bOverflowed = true;
+		return 0;
+	}
+
+	double FBitReader::ReadQuantizedFloat(const FQuantization& settings)
+	{
+		return DequantizeFloat(ReadVarInt(), settings.FloatPrecision);
+	}
+
+	void FBitReader::ReadQuantizedVector(double outValue[3], const FQuantization& settings)
+	{
+		const double cellSize = settings.VectorCellSize;
+		const int32_t bits = std::clamp(settings.VectorComponentBits, 1, 32);
+		const double maxOffset = (double)((1ull << bits) - 1);
+
+		int64_t cells[3];
+		for (int32_t i = 0; i < 3; i++)
+		{
+			cells[i] = ReadVarInt();
+		}
+
+		for (int32_t i = 0; i < 3; i++)
+		{
+			const double offset = (double)ReadBits(bits) / maxOffset;
+			outValue[i] = ((double)cells[i] + offset) * cellSize;
+		}
+		AlignToByte();
+	}
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "ULSBlobTransfer.generated.h"
+
+class IFileHandle;
+
+UENUM(BlueprintType)
+enum class EULSBlobState : uint8
+{
+	Transferring,
+	Completed,
+	Failed,
+	Cancelled,
+};
+
+/**
+ * One large payload streamed in BlobChunk packets, in either direction.
+ *
+ * Wire format (ids are positive for blobs sent by the server, negative for blobs sent by the client):
+ *
+ *   BlobBegin   int64 id, int64 total size, string name    Sender announces a blob, or resumes it after a reconnect
+ *   BlobChunk   int64 id, int64 offset, bytes              Consecutive slices, in order
+ *   BlobAck     int64 id, int64 received size              Receiver confirms progress and where to continue after a reconnect
+ *   BlobCancel  int64 id                                   Either side gives up on the blob
+ *
+ * Received blobs are written straight from the packet into their destination: a file, a buffer
+ * allocated once for the whole blob or memory supplied by the caller. Transfers survive a
+ * disconnect and continue where the receiver left off once the network owner is connected again.
+ */
+UCLASS(BlueprintType)
+class ULSCLIENT_API UULSBlobTransfer : public UObject
+{
+	GENERATED_BODY()
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FBlobProgressEvent, int64, transferredBytes, int64, totalBytes);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FBlobCompletedEvent, EULSBlobState, state);
+
+public:
+	virtual void BeginDestroy() override;
+
+	UPROPERTY(BlueprintReadOnly, Category = ULSBlobTransfer)
+		int64 BlobId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = ULSBlobTransfer)
+		FString Name;
+
+	UPROPERTY(BlueprintReadOnly, Category = ULSBlobTransfer)
+		int64 TotalSize = 0;
+
+	/* Bytes written for downloads, bytes the server acknowledged for uploads */
+	UPROPERTY(BlueprintReadOnly, Category = ULSBlobTransfer)
+		int64 TransferredSize = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = ULSBlobTransfer)
+		EULSBlobState State = EULSBlobState::Transferring;
+
+	UPROPERTY(BlueprintReadOnly, Category = ULSBlobTransfer)
+		bool bUpload = false;
+
+	UPROPERTY(BlueprintAssignable, Category = ULSBlobTransfer)
+		FBlobProgressEvent OnProgress;
+
+	UPROPERTY(BlueprintAssignable, Category = ULSBlobTransfer)
+		FBlobCompletedEvent OnCompleted;
+
+	UFUNCTION(BlueprintPure, Category = ULSBlobTransfer)
+		float GetProgress() const { return TotalSize > 0 ? (float)((double)TransferredSize / (double)TotalSize) : 1.0f; }
+
+	/* Download destination: the file is created or truncated */
+	UFUNCTION(BlueprintCallable, Category = ULSBlobTransfer)
+		bool WriteToFile(const FString& path);
+
+	/* Download destination: a buffer allocated once for the whole blob, see GetBuffer */
+	UFUNCTION(BlueprintCallable, Category = ULSBlobTransfer)
+		bool WriteToBuffer();
+
+	/* Download destination: memory owned by the caller, at least TotalSize bytes, valid until the transfer ends */
+	bool WriteToMemory(TArrayView<uint8> destination);
+
+	/* Received data of WriteToBuffer downloads, or the data of buffer uploads */
+	UFUNCTION(BlueprintCallable, Category = ULSBlobTransfer)
+		const TArray<uint8>& GetBuffer() const { return Buffer; }
+
+	UFUNCTION(BlueprintCallable, Category = ULSBlobTransfer)
+		void Cancel();
+
+	bool HasDestination() const;
+
+private:
+	friend class UULSClientNetworkOwner;
+
+	bool ReadFromFile(const FString& path);
+
+	void ReadFromBuffer(const TArray<uint8>& data);
+
+	/* Writes the next slice of a download */
+	bool WriteChunk(int64 offset, const uint8* data, int32 size);
+
+	/* Reads the next slice of an upload */
+	bool ReadChunk(int64 offset, uint8* destination, int32 size);
+
+	void Finish(EULSBlobState state);
+
+	UPROPERTY()
+		class UULSClientNetworkOwner* Owner;
+
+	TArray<uint8> Buffer;
+	TArrayView<uint8> Memory;
+	TUniquePtr<IFileHandle> File;
+
+	/* Uploads: next byte to send. Paused after a reconnect until the server acknowledged where to continue. */
+	int64 SendOffset = 0;
+	bool bAwaitingAck = false;
+
+	/* Downloads: bytes received since the last BlobAck */
+	int64 UnacknowledgedSize = 0;
+};
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+enum class EULSCaptureDirection : uint8
+{
+	Inbound = 0,
+	Outbound = 1,
+};
+
+/* One recorded wire packet */
+struct FULSCaptureFrame
+{
+	/* Seconds since the capture started */
+	double Time = 0;
+	EULSCaptureDirection Direction = EULSCaptureDirection::Inbound;
+	/* ChannelIndex of the transport that sent or received the packet */
+	int32 Channel = 0;
+	/* Header followed by the payload, uncompressed */
+	TConstArrayView<uint8> Bytes;
+};
+
+/*
+* Capture file layout, all values little endian:
+*
+*   File header:   "ULSCAP01", int64 capture start (FDateTime ticks, UTC)
+*   Every record:  int64 microseconds since the start, uint32 size, uint8 EULSCaptureDirection,
+*                  uint8 channel, uint16 reserved (0), followed by size bytes of wire packet
+*
+* Records are only ever appended. A record cut short by a crash ends the capture, everything before
+* it stays readable.
+*/
+namespace ULSCapture
+{
+	constexpr int32 MagicSize = 8;
+	constexpr int32 FileHeaderSize = MagicSize + sizeof(int64);
+	constexpr int32 RecordHeaderSize = sizeof(int64) + sizeof(uint32) + sizeof(uint8) * 2 + sizeof(uint16);
+
+	ULSCLIENT_API extern const uint8 Magic[MagicSize];
+
+	/* Relative paths are relative to the project's Saved directory */
+	ULSCLIENT_API FString ResolvePath(const FString& path);
+}
+
+/**
+ * Appends frames to a capture file.
+ *
+ * Write is thread-safe. Records are buffered and handed to the operating system once the buffer fills
+ * up or a second has passed, so a crash of the process loses at most that much. Writes run on the
+ * thread that captured the packet, only Flush and the destructor wait for the file to reach the disk.
+ */
+class ULSCLIENT_API FULSCaptureWriter
+{
+public:
+	/* Creates or truncates the file, see ULSCapture::ResolvePath. Returns null if it can't be opened. */
+	static TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe> Create(const FString& path);
+
+	~FULSCaptureWriter();
+
+	void Write(EULSCaptureDirection direction, int32 channel, TConstArrayView<uint8> bytes);
+
+	/* Writes the buffered records and waits until they reached the disk */
+	void Flush();
+
+	const FString& GetPath() const { return Path; }
+
+private:
+	FULSCaptureWriter(const FString& path, IFileHandle* file);
+
+	void WriteBufferLocked();
+
+	void FlushLocked();
+
+	FCriticalSection Lock;
+	FString Path;
+	TUniquePtr<IFileHandle> File;
+	TArray<uint8> Buffer;
+	double StartTime = 0;
+	double LastWriteTime = 0;
+};
+
+/**
+ * Reads a capture file through a memory mapping, without copying the frames.
+ *
+ * Frame bytes point into the mapping and stay valid until the reader is closed.
+ */
+class ULSCLIENT_API FULSCaptureReader
+{
+public:
+	FULSCaptureReader();
+
+	~FULSCaptureReader();
+
+	bool Open(const FString& path);
+
+	void Close();
+
+	bool IsOpen() const { return Data != nullptr; }
+
+	/* Returns false at the end of the capture */
+	bool Next(FULSCaptureFrame& outFrame);
+
+	/* Time of the frame Next returns, without consuming it. Returns false at the end of the capture. */
+	bool PeekTime(double& outTime) const;
+
+	void Rewind() { Position = ULSCapture::FileHeaderSize; }
+
+	FDateTime GetStartTime() const { return FDateTime(StartTicks); }
+
+private:
+	bool ReadRecordHeader(int64 position, int64& outMicros, uint32& outSize) const;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	int64 Position = 0;
+	int64 StartTicks = 0;
+};
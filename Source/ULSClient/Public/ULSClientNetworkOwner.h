@@ -4,9 +4,18 @@
 
 #include "CoreMinimal.h"
 #include "ULSDefines.h"
+#include "ULSTransport.h"
+#include "ULSWireEncoding.h"
+#include "ULSInboundQueue.h"
 #include "UObject/NoExportTypes.h"
+#include "Containers/Ticker.h"
 #include "ULSClientNetworkOwner.generated.h"
 
+struct FULSBaselineField;
+class FULSBaselineStore;
+class FULSNetClock;
+class UULSBlobTransfer;
+
 enum EReplicatedFieldType : int8
 {
 	Reference = 0,
@@ -16,6 +25,48 @@ enum EReplicatedFieldType : int8
     PrimitiveFloat = 4,
 };
 
+/* Packet on a logical channel that is sent to the main transport in ChannelChunk slices */
+struct FULSOutgoingChannelPacket
+{
+    int32 Channel = 0;
+    int32 MessageId = 0;
+    TArray<uint8> Bytes;
+    int32 Offset = 0;
+};
+
+/* Packet on a logical channel that is being reassembled from ChannelChunk slices */
+struct FULSIncomingChannelPacket
+{
+    TArray<uint8> Bytes;
+    int32 ReceivedSize = 0;
+    /* Disjoint byte ranges [X, Y) received so far, duplicate and overlapping chunks only count once */
+    TArray<FIntPoint> ReceivedRanges;
+};
+
+/* SpawnActor or CreateObject entry of a SpawnSnapshot packet that waits for its turn */
+struct FULSPendingSpawn
+{
+    const UULSWirePacket* Packet = nullptr;
+    int32 PacketType = 0;
+    /* Start of the entry's payload in Packet */
+    int32 Position = 0;
+    int64 UniqueId = 0;
+    /* Order in the snapshot, breaks ties between equal priorities */
+    int32 Order = 0;
+    bool bHasLocation = false;
+    FVector Location = FVector::ZeroVector;
+    /* Spawned in ascending order */
+    double Priority = 0;
+};
+
+/* Reference field pointing at an object that waits in the spawn queue. Set once the object is spawned. */
+struct FULSParkedReference
+{
+    TWeakObjectPtr<UObject> Target;
+    FObjectProperty* Property = nullptr;
+    bool bCallOnRep = false;
+};
+
 /**
  * 
  */
@@ -26,6 +77,9 @@ class ULSCLIENT_API UULSClientNetworkOwner : public UObject
 
     DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FConnectionEvent, bool, bSuccess);
     DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FDisconnectionEvent, int32, statusCode, bool, bWasClean);
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE(FConnectionInterruptedEvent);
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FReconnectionEvent, bool, bSessionResumed);
+    DECLARE_DYNAMIC_MULTICAST_DELEGATE(FWorldReadyEvent);
 	
 public:
 	UPROPERTY(BlueprintReadWrite)
@@ -37,12 +91,216 @@ public:
     UPROPERTY(BlueprintAssignable)
         FDisconnectionEvent OnDisconnectionEvent;
 
+    /* The connection dropped and bAutoReconnect is trying to restore it. OnDisconnectionEvent follows if that fails. */
+    UPROPERTY(BlueprintAssignable)
+        FConnectionInterruptedEvent OnConnectionInterruptedEvent;
+
+    /* Connected again after an interruption. Without a resumed session the server sends the world from scratch. */
+    UPROPERTY(BlueprintAssignable)
+        FReconnectionEvent OnReconnectionEvent;
+
+    /*
+    * Reconnect when the connection drops after the server accepted it. If the server supports
+    * session resume, it only re-sends the packets the client missed and network objects are kept.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Reconnect)
+        bool bAutoReconnect = false;
+
+    /* Give up reconnecting after this many seconds. Also the time the server is asked to keep the session. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Reconnect)
+        float ReconnectTimeout = 30.0f;
+
+    /* Delay before the first reconnect attempt, doubled after every failed attempt up to ReconnectMaxDelay */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Reconnect)
+        float ReconnectInitialDelay = 0.5f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Reconnect)
+        float ReconnectMaxDelay = 5.0f;
+
+    /* Exchange Ping / Pong packets with the server to measure RTT, synchronise clocks and detect dead connections */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Heartbeat)
+        bool bEnableHeartbeat = false;
+
+    /* Seconds between two Ping packets. The server may ask for a different interval on each connection. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Heartbeat)
+        float HeartbeatInterval = 1.0f;
+
+    /* The connection is considered dead if nothing was received for this many seconds */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Heartbeat)
+        float HeartbeatTimeout = 5.0f;
+
+    /* Smoothed round trip time in seconds, 0 before the first Pong */
+    UFUNCTION(BlueprintPure, Category = Heartbeat)
+        float GetRoundTripTime() const;
+
+    /* Smoothed RTT variation in seconds */
+    UFUNCTION(BlueprintPure, Category = Heartbeat)
+        float GetRoundTripJitter() const;
+
+    /* RTT in seconds below which the given fraction (0..1) of the recent samples lie, e.g. 0.95 */
+    UFUNCTION(BlueprintPure, Category = Heartbeat)
+        float GetRoundTripPercentile(float fraction) const;
+
+    /* Estimated server clock in seconds. Local time until the first Pong. */
+    UFUNCTION(BlueprintPure, Category = Heartbeat)
+        double GetServerTime() const;
+
+    /* Server time minus local FPlatformTime::Seconds() */
+    UFUNCTION(BlueprintPure, Category = Heartbeat)
+        double GetServerClockOffset() const;
+
+    /* Minimum time in seconds between two SessionAck packets */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Reconnect)
+        float SessionAckInterval = 0.25f;
+
+    /* Allow the server to send packets in the compact encoding (varints, quantized floats and vectors) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Encoding)
+        bool bEnableCompactEncoding = false;
+
+    /* Quantization requested from the server. The server's answer applies to the current connection only. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Encoding)
+        FULSQuantizationSettings QuantizationSettings;
+
+    /* Allow the server to send ReplicationDelta packets against baselines the client acknowledged */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Baselines)
+        bool bEnableDeltaBaselines = false;
+
+    /* Number of baselines kept per object. The server can only encode against one of these. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Baselines)
+        int32 BaselineHistorySize = 4;
+
+    /* Minimum time in seconds between two BaselineAck packets */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Baselines)
+        float BaselineAckInterval = 0.05f;
+
+    /*
+    * Logical channel per packet type, used by SendWirePacket. Packet types without an entry use
+    * channel 0, the main Transport. Route bulk traffic (large Custom packets, ...) to another
+    * channel so it can't delay latency-critical packets.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+        TMap<int32, int32> ChannelRouting;
+
+    /*
+    * Optional dedicated connections per channel, e.g. a second UULSWebSocketTransport. They are
+    * connected once the server accepted the main connection and announce their channel with a
+    * ChannelAttach packet. Channels without a connected transport fall back to ChannelChunk
+    * packets on the main Transport.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+        TMap<int32, UULSTransport*> ChannelTransports;
+
+    /* Allow packets on channels other than 0 to be split into ChannelChunk packets and interleaved on the main Transport */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+        bool bEnableChannelChunks = false;
+
+    /* Largest slice of a channel packet, in bytes. The server may lower it. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+        int32 ChannelChunkSize = 16 * 1024;
+
+    /* Chunk bytes handed to the main Transport per tick, so latency-critical packets don't queue behind them in the socket */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+        int32 ChannelBytesPerTick = 64 * 1024;
+
+    /* Channel packets the server may have in reassembly at the same time. Chunks of further packets are dropped. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+        int32 MaxIncomingChannelPackets = 16;
+
+    /* Bytes all channel packets in reassembly may hold together. Chunks of packets beyond it are dropped. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+        int32 MaxIncomingChannelBytes = 128 * 1024 * 1024;
+
+    /* Size of the BlobChunk slices of blobs the client sends */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Blobs)
+        int32 BlobChunkSize = 16 * 1024;
+
+    /* Blob bytes sent per tick, across all uploads. Route BlobChunk to a bulk channel to keep them away from other traffic. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Blobs)
+        int32 BlobBytesPerTick = 256 * 1024;
+
+    /* Received blob bytes between two BlobAck packets. The server resumes from the last acknowledged size after a reconnect. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Blobs)
+        int32 BlobAckInterval = 1024 * 1024;
+
+    /* Largest received blob that is kept in memory if OnBlobTransferStarted chose no destination */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Blobs)
+        int32 MaxBlobBufferSize = 64 * 1024 * 1024;
+
+    /*
+    * Milliseconds per tick spent spawning the entries of SpawnSnapshot packets, nearest to the local
+    * player first. At least one entry is spawned per tick. 0 spawns a snapshot as soon as it arrives.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+        float SpawnBudgetMilliseconds = 4.0f;
+
+    /* Every entry of the SpawnSnapshot packets received so far was spawned */
+    UPROPERTY(BlueprintAssignable)
+        FWorldReadyEvent OnWorldReady;
+
+    /* Entries of SpawnSnapshot packets still waiting to be spawned */
+    UFUNCTION(BlueprintPure, Category = Spawning)
+        int32 GetNumPendingSpawns() const { return PendingSpawnIds.Num(); }
+
+    /*
+    * Milliseconds per tick spent destroying the actors of DespawnActors packets. They are hidden right
+    * away and at least one is destroyed per tick. 0 destroys them as soon as the packet arrives.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+        float DespawnBudgetMilliseconds = 2.0f;
+
+    /* Actors of DespawnActors packets that are hidden but not destroyed yet */
+    UFUNCTION(BlueprintPure, Category = Spawning)
+        int32 GetNumPendingDespawns() const { return PendingDespawns.Num(); }
+
+    /* Streams a copy of data to the server */
+    UFUNCTION(BlueprintCallable, Category = Blobs)
+        UULSBlobTransfer* SendBlob(const FString& name, const TArray<uint8>& data);
+
+    /* Streams the file to the server, reading one chunk at a time */
+    UFUNCTION(BlueprintCallable, Category = Blobs)
+        UULSBlobTransfer* SendBlobFile(const FString& name, const FString& path);
+
+    /* Tells the server and forgets the transfer. Use UULSBlobTransfer::Cancel. */
+    void CancelBlobTransfer(UULSBlobTransfer* transfer);
+
+    /* Sends the packet on the channel ChannelRouting assigns to its type */
+    UFUNCTION(BlueprintCallable, Category = Channels)
+        void SendWirePacket(const UULSWirePacket* packet);
+
+    /*
+    * Records every packet sent or received on the transport and the channel transports to the file,
+    * until StopCapture. Relative paths are relative to the project's Saved directory. Play the file
+    * back with UULSReplayTransport. Also available as the uls.Capture.Start / Stop console commands.
+    */
+    UFUNCTION(BlueprintCallable, Category = Capture)
+        bool StartCapture(const FString& path);
+
+    UFUNCTION(BlueprintCallable, Category = Capture)
+        void StopCapture();
+
+    UFUNCTION(BlueprintCallable, Category = Capture)
+        bool IsCapturing() const { return Capture.IsValid(); }
+
     void OnConnected(bool success, const FString& errorMessage);
 
     void OnDisconnected(int32 StatusCode, const FString& Reason, bool bWasClean);
 
+    void OnChannelConnected(UULSTransport* channelTransport, bool success, const FString& errorMessage);
+
+    void OnChannelDisconnected(UULSTransport* channelTransport, int32 StatusCode, const FString& Reason);
+
+    virtual void BeginDestroy() override;
+
+    static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 	void HandleWirePacket(const UULSWirePacket* packet);
 
+    /* Queue for transports that receive on their own threads. Drained every tick. */
+    TSharedRef<FULSInboundQueue, ESPMode::ThreadSafe> GetInboundQueue() const { return InboundQueue; }
+
+    /* Decodes and handles every frame in the inbound queue. Game thread only. */
+    void ProcessInboundQueue();
+
 	UFUNCTION(BlueprintImplementableEvent, Category = WebsocketMasterServer)
 		void OnReceivePacket(const UULSWirePacket* packet);
 
@@ -77,6 +335,44 @@ protected:
 
     virtual void HandleConnectionEndMessage(const UULSWirePacket* packet);
 
+    /*
+    * Called when the server starts sending a blob. Choose where it goes with WriteToFile, WriteToBuffer
+    * or WriteToMemory on the transfer, or cancel it. Without a destination, blobs up to MaxBlobBufferSize
+    * are received into a buffer.
+    */
+    UFUNCTION(BlueprintNativeEvent, Category = Blobs)
+        void OnBlobTransferStarted(UULSBlobTransfer* transfer);
+
+    /*
+    * Features to request from the server in the TransportOptions packet sent right after connecting.
+    * 
+    * The default implementation requests whatever the transport asks for.
+    */
+    virtual ETransportFeatures GetRequestedFeatures() const;
+
+    virtual int32 GetFeatureOptionsSize(ETransportFeatures feature) const;
+
+    virtual void WriteFeatureOptions(ETransportFeatures feature, UULSWirePacket* packet, int& position) const;
+
+    virtual void ReadFeatureOptions(ETransportFeatures feature, const UULSWirePacket* packet, int& position);
+
+    virtual void HandleTransportOptionsMessage(const UULSWirePacket* packet);
+
+    /* Features the server accepted for the current connection */
+    ETransportFeatures NegotiatedFeatures = ETransportFeatures::None;
+
+    /* Quantization the server answered with, used to decode the compact encoding of the current connection */
+    FULSQuantizationSettings NegotiatedQuantization;
+
+    /* Baselines kept per object on the current connection, at most the requested BaselineHistorySize */
+    int32 NegotiatedBaselineHistorySize = 0;
+
+    /* Seconds between two Ping packets on the current connection, as answered by the server */
+    float NegotiatedHeartbeatInterval = 0;
+
+    /* Forgets what was negotiated with the previous connection */
+    void ResetNegotiatedFeatures();
+
     /*
     * Called when the network object was torn off server-side. 
     * 
@@ -85,23 +381,125 @@ protected:
     */
     virtual void NetworkObjectWasTornOff(UObject* existingObject);
 
+    /* Called on the game thread every frame while the owner is in use */
+    virtual bool Tick(float DeltaTime);
+
+    void CallRepNotify(UObject* existingObject, UFunction* repFunction);
+
 private:
+    void SendTransportOptions();
+
+    void HandleReplicationDeltaMessage(const UULSWirePacket* packet);
+
+    bool ApplyBaselineField(UObject* targetObject, const FULSBaselineField& field, const uint64* words);
+
+    void SendBaselineAck();
+
+    void ConnectChannelTransports();
+
+    void DisconnectChannelTransports();
+
+    void SendChannelChunks();
+
+    void HandleChannelChunkMessage(const UULSWirePacket* packet);
+
+    UULSBlobTransfer* StartBlobUpload(UULSBlobTransfer* transfer);
+
+    void ResumeBlobTransfers();
+
+    void SendBlobChunks();
+
+    void SendBlobBegin(const UULSBlobTransfer* transfer);
+
+    void SendBlobAck(UULSBlobTransfer* transfer);
+
+    void SendBlobCancel(int64 blobId);
+
+    void HandleBlobBeginMessage(const UULSWirePacket* packet);
+
+    void HandleBlobChunkMessage(const UULSWirePacket* packet);
+
+    void HandleBlobAckMessage(const UULSWirePacket* packet);
+
+    void HandleBlobCancelMessage(const UULSWirePacket* packet);
+
+    void SendConnectionRequest();
+
+    void SendSessionResume();
+
+    void SendSessionAck();
+
+    void SendPing();
+
+    void HandlePingMessage(const UULSWirePacket* packet);
+
+    void HandlePongMessage(const UULSWirePacket* packet);
+
+    void UpdateHeartbeat();
+
+    void ScheduleReconnect();
+
+    void UpdateReconnect();
+
+    /* Destroys every network object, before the server sends the world again for a new session */
+    void DiscardNetworkObjects();
+
     void HandleRpcPacket(const UULSWirePacket* packet);
 
     void HandleRpcResponsePacket(const UULSWirePacket* packet);
 
     void HandleTearOffPacket(const UULSWirePacket* packet);
 
-    void HandleSpawnActorMessage(const UULSWirePacket* packet);
+    /* Hands the packet to its handler, without the sequence and spawn queue checks of HandleWirePacket */
+    void DispatchWirePacket(const UULSWirePacket* packet);
+
+    /* The payload starts at position, which is not 0 for the entries of a SpawnSnapshot */
+    void HandleSpawnActorMessage(const UULSWirePacket* packet, int position = 0);
 
     void HandleDespawnActorMessage(const UULSWirePacket* packet);
 
-    void HandleCreateObjectMessage(const UULSWirePacket* packet);
+    void HandleCreateObjectMessage(const UULSWirePacket* packet, int position = 0);
+
+    void HandleSpawnSnapshotMessage(const UULSWirePacket* packet);
+
+    /* Spawns queued snapshot entries until SpawnBudgetMilliseconds are used up */
+    void ProcessPendingSpawns();
+
+    void SortPendingSpawns(const FVector& origin);
+
+    /* View location of the first local player, the origin of the spawn priorities */
+    FVector GetSpawnPriorityOrigin() const;
+
+    /* Holds back packets addressed to objects in the spawn queue. Returns true if the packet was parked or made obsolete. */
+    bool ParkPacketForPendingSpawn(const UULSWirePacket* packet);
+
+    /* Spawns the queued entry and applies what was parked for it */
+    void SpawnPending(const FULSPendingSpawn& spawn);
+
+    /* Spawns the queued entry of uniqueId ahead of its turn */
+    void SpawnPendingNow(int64 uniqueId);
+
+    /* Drops uniqueId from the spawn queue along with what was parked for it */
+    void CancelPendingSpawn(int64 uniqueId);
+
+    /* Sets the references and applies the packets that waited for the object */
+    void ResolveParked(int64 uniqueId);
+
+    void ResetPendingSpawns();
 
     void HandleDestroyObjectMessage(const UULSWirePacket* packet);
 
+    /* DespawnActors, DestroyObjects and TearOffs */
+    void HandleLifecycleBatchMessage(const UULSWirePacket* packet);
+
+    /* Destroys despawned actors until DespawnBudgetMilliseconds are used up */
+    void ProcessPendingDespawns();
+
+    void FlushPendingDespawns();
+
     void HandleReplicationMessage(const UULSWirePacket* packet);
 
+    /* Applies numProperties replicated fields starting at position. OnRep functions of changed fields are called if callOnRep is set. */
     void ReadProperties(const UULSWirePacket* packet, const UClass* theClass, int numProperties, UObject* targetObject, int position, bool callOnRep = false);
 
     void ReadProperties(const UULSWirePacket* packet, const UClass* theClass, int numProperties, void* targetObject, int position, bool callOnRep = false);
@@ -111,6 +509,67 @@ private:
 		TMap<int64, UObject*> objectMap;
 	UPROPERTY()
 		TMap<UObject*, int64> uniqueIdLookup;
+    UPROPERTY()
+        TMap<int64, UULSBlobTransfer*> BlobTransfers;
+    /* SpawnSnapshot packets and the packets parked for their entries, until the spawn queue is empty. Referenced in AddReferencedObjects. */
+    TArray<const UULSWirePacket*> HeldSpawnPackets;
+
+    /* Nearest entry last */
+    TArray<FULSPendingSpawn> PendingSpawns;
+    TSet<int64> PendingSpawnIds;
+    TMap<int64, TArray<const UULSWirePacket*>> ParkedPackets;
+    TMultiMap<int64, FULSParkedReference> ParkedReferences;
+    FVector SpawnPriorityOrigin = FVector::ZeroVector;
+    int32 NextSpawnOrder = 0;
+
+    /* Hidden actors of DespawnActors packets, destroyed from the back */
+    TArray<TWeakObjectPtr<AActor>> PendingDespawns;
+
+    FTSTicker::FDelegateHandle TickerHandle;
+
+    TSharedRef<FULSInboundQueue, ESPMode::ThreadSafe> InboundQueue = MakeShared<FULSInboundQueue, ESPMode::ThreadSafe>();
+
+    TSharedPtr<FULSBaselineStore> Baselines;
+    /* Newest applied delta sequence per object since the last BaselineAck */
+    TMap<int64, int64> PendingBaselineAcks;
+    TArray<int64> PendingBaselineResyncs;
+    double LastBaselineAckTime = 0;
+
+    TArray<FULSOutgoingChannelPacket> OutgoingChannelPackets;
+    TMap<uint64, FULSIncomingChannelPacket> IncomingChannelPackets;
+    /* Sum of the sizes of IncomingChannelPackets */
+    int64 IncomingChannelBytes = 0;
+    TMap<int32, int32> NextChannelMessageIds;
+    int32 NegotiatedChannelChunkSize = 0;
+
+    /* The server answered the ConnectionRequest of the current connection with success */
+    bool bConnectionAccepted = false;
+
+    /* Ids of blobs sent by the client are negative */
+    int64 NextBlobId = -1;
+
+    /* Session issued by the server, 0 without session resume */
+    int64 SessionToken = 0;
+    int64 LastAppliedSequence = 0;
+    bool bSessionAckPending = false;
+    double LastSessionAckTime = 0;
+    float ServerSessionTimeout = 0;
+
+    /* Reconnect state. The ConnectionResponse answers a SessionResume while bResumePending is set. */
+    bool bReconnecting = false;
+    bool bResumePending = false;
+    bool bConnectionEnded = false;
+    double ReconnectStartTime = 0;
+    double NextReconnectTime = 0;
+    float ReconnectDelay = 0;
+    int32 InterruptedStatusCode = 0;
+
+    TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe> Capture;
+
+    TSharedPtr<FULSNetClock> NetClock;
+    double LastPingTime = 0;
+    double LastReceiveTime = 0;
+    double LastTickTime = 0;
 
 protected:
     UObject* FindObjectRef(int64 uniqueId) const;
@@ -119,6 +578,12 @@ protected:
 
 	AActor* SpawnNetworkActor(int64 uniqueId, UClass* cls);
 
+	/*
+	 * Spawns deferred at transform. The numProperties fields at propertiesPosition of packet are applied
+	 * before the construction script and BeginPlay run, without OnRep calls.
+	 */
+	AActor* SpawnNetworkActor(int64 uniqueId, UClass* cls, const FTransform& transform, const UULSWirePacket* packet, int numProperties, int propertiesPosition);
+
     UObject* CreateNetworkObject(int64 uniqueId, UClass* cls);
 	
     UFUNCTION()
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Per-message compression used by UULSTransport.
+ *
+ * Payloads are compressed as raw deflate streams (no zlib header) so that the only overhead per
+ * packet is the uncompressed size. Both sides may use a preset dictionary, which has to be identical
+ * on the client and the server. Dictionaries are identified by their Adler-32 checksum.
+ */
+class ULSCLIENT_API FULSCompression
+{
+public:
+	/* Returns the id used to agree on a dictionary during the handshake. 0 means "no dictionary" */
+	static uint32 GetDictionaryId(TConstArrayView<uint8> dictionary);
+
+	/*
+	* Compresses source and appends the deflate stream to outCompressed.
+	*
+	* Returns false if compression failed or did not make the data smaller.
+	*/
+	static bool Compress(TConstArrayView<uint8> source, TConstArrayView<uint8> dictionary, TArray<uint8>& outCompressed);
+
+	/* Inflates exactly destSize bytes from source into dest */
+	static bool Decompress(TConstArrayView<uint8> source, TConstArrayView<uint8> dictionary, uint8* dest, int32 destSize);
+
+	/*
+	* Builds a preset dictionary from sample packets.
+	*
+	* Frequently repeated segments (class paths, field names, common values) are picked from the samples
+	* and concatenated, most valuable segment last, since deflate encodes nearer matches more cheaply.
+	*/
+	static TArray<uint8> TrainDictionary(const TArray<TArray<uint8>>& samples, int32 maxDictionarySize = 32 * 1024);
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+
+class UULSTransport;
+
+/* Wire bytes received by a transport, waiting to be decoded on the game thread */
+struct FULSInboundFrame
+{
+	TWeakObjectPtr<UULSTransport> Transport;
+	TArray<uint8> Bytes;
+	/* FPlatformTime::Cycles64 when the frame was enqueued, right after the socket delivered it */
+	uint64 ReceiveCycles = 0;
+};
+
+/**
+ * Queue between transports that receive on their own threads and the network owner.
+ *
+ * Any number of threads may enqueue. The network owner drains the queue on the game thread
+ * and hands every frame back to the transport that received it for decoding.
+ */
+class ULSCLIENT_API FULSInboundQueue
+{
+public:
+	/* Thread-safe */
+	void Enqueue(const TWeakObjectPtr<UULSTransport>& transport, TArray<uint8>&& bytes)
+	{
+		Frames.Enqueue(FULSInboundFrame{ transport, MoveTemp(bytes), FPlatformTime::Cycles64() });
+	}
+
+	/* Game thread only */
+	bool Dequeue(FULSInboundFrame& outFrame)
+	{
+		return Frames.Dequeue(outFrame);
+	}
+
+	bool IsEmpty() const
+	{
+		return Frames.IsEmpty();
+	}
+
+private:
+	TQueue<FULSInboundFrame, EQueueMode::Mpsc> Frames;
+};
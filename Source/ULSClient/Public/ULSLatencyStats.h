@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Log-linear histogram of microsecond values, in the spirit of HdrHistogram.
+ *
+ * Every power of two is split into 16 linear buckets, so any recorded value is reported within
+ * about 6% of its real value across the whole range of uint64. Recording is an index computation
+ * and an increment. Not thread-safe.
+ */
+class ULSCLIENT_API FULSLatencyHistogram
+{
+public:
+	static constexpr int32 SubBucketBits = 4;
+	static constexpr int32 SubBucketCount = 1 << SubBucketBits;
+	static constexpr int32 BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+	FULSLatencyHistogram();
+
+	void Record(uint64 value);
+
+	/* Adds the values recorded by another histogram, e.g. to aggregate per-thread histograms */
+	void Add(const FULSLatencyHistogram& other);
+
+	void Reset();
+
+	/* Highest value equivalent to the bucket that contains the given percentile (0-100), 0 if empty */
+	uint64 GetPercentile(double percentile) const;
+
+	uint64 GetCount() const { return Count; }
+
+	uint64 GetMax() const { return Max; }
+
+private:
+	static int32 GetBucketIndex(uint64 value);
+
+	static uint64 GetHighestEquivalentValue(int32 bucketIndex);
+
+	TArray<uint32> Counts;
+	uint64 Count = 0;
+	uint64 Max = 0;
+};
+
+/* Hops of an inbound packet, each measured from the end of the previous one */
+enum class EULSLatencyStage : uint8
+{
+	Queue,		// Socket receive until the game thread picks the bytes up
+	Decode,		// Decompression and parsing
+	Apply,		// Handling the packet, without OnRep calls
+	OnRep,		// OnRep calls made while handling the packet
+	Total,		// Socket receive until the packet took effect
+
+	Count
+};
+
+/**
+ * Latency of inbound packets per packet type and stage, from socket receive to applied state.
+ *
+ * Transports stamp the bytes when the socket delivers them. "uls.Latency.Dump" logs p50 / p99 / p999
+ * of every packet type seen, and with uls.Latency.CsvInterval set, the percentiles of every interval
+ * are appended to Saved/Profiling/ULS/Latency-<time>.csv. Recording is on unless uls.Latency.Enabled
+ * is 0. Game thread only.
+ */
+class ULSCLIENT_API FULSLatencyStats
+{
+public:
+	static bool IsEnabled();
+
+	/*
+	* Records one packet. Cycles are FPlatformTime::Cycles64 values: when the socket delivered the bytes,
+	* when decoding started, when the packet was decoded and when it was handled.
+	*/
+	static void RecordPacket(int32 packetType, uint64 receiveCycles, uint64 decodeStartCycles, uint64 decodedCycles,
+		uint64 onRepCycles, uint64 appliedCycles);
+
+	/* Running total of the time spent in OnRep calls. Packets take the difference across their handling. */
+	static uint64 GetOnRepCycles() { return OnRepCycles; }
+
+	static void AddOnRepCycles(uint64 cycles) { OnRepCycles += cycles; }
+
+	/* Writes the CSV interval if it is due. Called by the network owners every tick. */
+	static void Tick();
+
+	static void Reset();
+
+	/* Logs the percentiles of every stage of every packet type seen */
+	static void Dump();
+
+	/* Histogram since startup or the last Reset, null if the packet type wasn't seen yet */
+	static const FULSLatencyHistogram* GetHistogram(int32 packetType, EULSLatencyStage stage);
+
+private:
+	static uint64 OnRepCycles;
+};
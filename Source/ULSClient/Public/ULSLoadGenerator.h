@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSLatencyStats.h"
+
+class FULSLoadServer;
+class FULSLoadSession;
+class FULSLoadWorker;
+
+enum class EULSLoadStep : uint8
+{
+	Connect,		// Sends a ConnectionRequest and waits for the response
+	Rpc,			// Sends Count RpcCall packets, Milliseconds apart, with a string parameter of PayloadBytes. The server has to echo them as RpcCallResponse.
+	Idle,			// Stays connected for Milliseconds, sending Pings like an idle client does
+	Disconnect,		// Waits up to 5 seconds for outstanding RPC answers, then closes the connection
+};
+
+struct FULSLoadStep
+{
+	EULSLoadStep Type = EULSLoadStep::Idle;
+	int32 Count = 0;
+	int32 Milliseconds = 0;
+	int32 PayloadBytes = 0;
+};
+
+/**
+ * What every load session does, in order.
+ *
+ * One step per line or separated by ';', e.g. "connect; rpc 100 20 64; idle 5000; disconnect":
+ *
+ *   connect
+ *   rpc <count> <intervalMs> [payloadBytes]
+ *   idle <ms>
+ *   disconnect
+ *
+ * Sessions disconnect after the last step in any case.
+ */
+struct ULSCLIENT_API FULSLoadScript
+{
+	TArray<FULSLoadStep> Steps;
+
+	static bool Parse(const FString& text, FULSLoadScript& outScript, FString& outError);
+};
+
+/* How load sessions reach the server */
+enum class EULSLoadTransport : uint8
+{
+	WebSocket,		// Binary messages, like UULSWebSocketTransport
+	Tcp,			// Length prefixed frames, like UULSTcpTransport. One I/O thread per session.
+	Udp,			// Datagrams through FULSReliableEndpoint, like UULSUdpTransport
+	SelfTest,		// In-process server stand-in (see ULSLoadServer.h), no sockets. Checks the generator itself.
+};
+
+struct FULSLoadSettings
+{
+	EULSLoadTransport Transport = EULSLoadTransport::WebSocket;
+
+	/* Server to load. Not used by SelfTest. */
+	FString Host = TEXT("127.0.0.1");
+	int32 Port = 0;
+
+	/* WebSocket only: the URL is <Protocol>://<Host>:<Port>/<Resource>, Protocol is also the subprotocol */
+	FString Protocol = TEXT("ws");
+	FString Resource;
+
+	/* UDP only: largest datagram sent */
+	int32 Mtu = 1200;
+
+	int32 NumSessions = 100;
+
+	/* Threads that run the sessions and decode what they receive. Sessions are spread evenly. */
+	int32 NumWorkers = 4;
+
+	FULSLoadScript Script;
+
+	/* Seconds over which the session starts are spread */
+	float RampUpSeconds = 1.0f;
+
+	/* Sessions still running after this many seconds are stopped */
+	float MaxSeconds = 300.0f;
+
+	/* Milliseconds between Pings while idle */
+	int32 PingIntervalMs = 1000;
+
+	/* SelfTest only: Replication packets the stand-in sends per object and second. 0 disables replication. */
+	float ReplicationRate = 10.0f;
+
+	/* SelfTest only: Objects the stand-in replicates to every session */
+	int32 ObjectsPerSession = 10;
+};
+
+/* What one session measured. Latencies are in microseconds. */
+struct ULSCLIENT_API FULSLoadSessionStats
+{
+	bool bConnected = false;
+	uint64 ConnectMicroseconds = 0;
+	double ActiveSeconds = 0;
+
+	int64 PacketsSent = 0;
+	int64 BytesSent = 0;
+	int64 PacketsReceived = 0;
+	int64 BytesReceived = 0;
+	int64 FieldsDecoded = 0;
+	int64 RpcsSent = 0;
+	int64 RpcsAnswered = 0;
+	uint64 DecodeCycles = 0;
+
+	/* RpcCall sent until its RpcCallResponse was decoded */
+	FULSLatencyHistogram RpcLatency;
+	/* Ping sent until its Pong was decoded */
+	FULSLatencyHistogram PingLatency;
+	/* Packet read from the socket (SelfTest: queued by the stand-in) until the session decoded it */
+	FULSLatencyHistogram DeliveryLatency;
+
+	/* Adds the counters and histograms of another session. ActiveSeconds and ConnectMicroseconds keep the maximum. */
+	void Add(const FULSLoadSessionStats& other);
+};
+
+/**
+ * Runs many lightweight client sessions in one process, for capacity planning.
+ *
+ * Sessions don't need a world, a player or a network owner. They connect to a server over the
+ * transport given in the settings, speak the wire protocol directly and share a few worker threads,
+ * which run the session scripts and decode everything the sessions receive. With
+ * EULSLoadTransport::SelfTest they talk to an in-process server stand-in instead, to check the
+ * generator without a server. Used by the ULSLoadTest commandlet.
+ *
+ * Run blocks the game thread and pumps its task graph and core ticker, which WebSocket sessions
+ * need for their events.
+ */
+class ULSCLIENT_API FULSLoadGenerator
+{
+public:
+	explicit FULSLoadGenerator(const FULSLoadSettings& settings);
+
+	~FULSLoadGenerator();
+
+	/* Runs all sessions to the end of their script, or until MaxSeconds. Call on the game thread, blocks it. */
+	void Run();
+
+	/* Valid after Run, indexed by session */
+	const TArray<FULSLoadSessionStats>& GetSessionStats() const { return SessionStats; }
+
+	FULSLoadSessionStats GetAggregateStats() const;
+
+	double GetElapsedSeconds() const { return ElapsedSeconds; }
+
+	/* Logs the aggregate, and every session at Log verbosity */
+	void LogReport() const;
+
+	/* One row per session followed by the aggregate. Relative paths are relative to the Saved directory. */
+	bool WriteCsv(const FString& path) const;
+
+private:
+	/* Runs what the sessions posted to the game thread and ticks the WebSockets module */
+	static void PumpGameThread(double& lastPumpTime);
+
+	FULSLoadSettings Settings;
+
+	/* SelfTest only */
+	TUniquePtr<FULSLoadServer> Server;
+	TArray<TUniquePtr<FULSLoadSession>> Sessions;
+	TArray<TUniquePtr<FULSLoadWorker>> Workers;
+
+	TArray<FULSLoadSessionStats> SessionStats;
+	double ElapsedSeconds = 0;
+};
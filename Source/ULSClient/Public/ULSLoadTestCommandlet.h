@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ULSLoadTestCommandlet.generated.h"
+
+/**
+ * Runs many headless client sessions against a server and reports their throughput and latency
+ * (see FULSLoadGenerator).
+ * 
+ * Usage: -run=ULSLoadTest -Port=<port> [-Host=127.0.0.1] [-Transport=WebSocket|Tcp|Udp] [-Protocol=ws]
+ *        [-Resource=<path>] [-Mtu=1200] [-Sessions=100] [-Workers=4]
+ *        [-Script="connect; rpc 50 100 64; idle 5000; disconnect"] [-ScriptFile=<file>] [-RampUp=1]
+ *        [-MaxSeconds=300] [-PingInterval=1000] [-Csv=<file>]
+ * 
+ * -SelfTest runs the sessions against an in-process server stand-in instead, which replicates
+ * -Objects=10 objects to every session at -ReplicationRate=10 packets per second. No sockets are
+ * involved, so it only checks the generator.
+ * 
+ * The script syntax is described at FULSLoadScript. The CSV goes to Saved/Profiling/ULS/LoadTest-<time>.csv
+ * unless -Csv is given. Returns 0 if every session connected.
+ */
+UCLASS()
+class ULSCLIENT_API UULSLoadTestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UULSLoadTestCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSTransport.h"
+#include "ULSPacketWriter.h"
+#include "ULSLoopbackTransport.generated.h"
+
+class UULSLoopbackServer;
+
+/**
+ * Transport that connects the network owner to an in-process UULSLoopbackServer.
+ *
+ * Server packets are delivered through the inbound queue of the network owner, the same path the
+ * threaded transports use, so they are decoded on the owner's next tick (or when the queue is pumped
+ * with ProcessInboundQueue). Client packets reach the server synchronously.
+ */
+UCLASS(Blueprintable)
+class ULSCLIENT_API UULSLoopbackTransport : public UULSTransport
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool IsConnected() const override { return bConnected; }
+
+	/* Connects immediately. Creates a server if none was assigned. */
+	virtual bool Connect() override;
+
+	virtual void Disconnect() override;
+
+	virtual void SendBytes(TConstArrayView<uint8> bytes) override;
+
+	UPROPERTY(BlueprintReadWrite, Category = ULSLoopbackTransport)
+		UULSLoopbackServer* Server;
+
+private:
+	friend class UULSLoopbackServer;
+
+	/* Called by the server */
+	void DeliverToClient(TArray<uint8>&& bytes);
+
+	/* Called by the server */
+	void CloseFromServer(int32 statusCode, const FString& reason);
+
+	bool bConnected = false;
+};
+
+/**
+ * Scripted stand-in for a ULS server, for tests and benchmarks.
+ *
+ * Connection requests and Pings are answered automatically, optional transport features are declined
+ * unless listed in AcceptedFeatures. Everything else is emitted on request, in the default wire encoding.
+ */
+UCLASS(BlueprintType)
+class ULSCLIENT_API UULSLoopbackServer : public UObject
+{
+	GENERATED_BODY()
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FClientPacketEvent, const UULSWirePacket*, packet);
+
+public:
+	/* Accept ConnectionRequest packets. Answers with a failed ConnectionResponse if false. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSLoopbackServer)
+		bool bAcceptConnections = true;
+
+	/*
+	* ETransportFeatures accepted from TransportOptions requests, answered with the options the client
+	* asked for. Compression is used without a dictionary. With SessionResume the packets sent after the
+	* connection was accepted are sequenced and kept until the client acknowledges them, a SessionResume
+	* carrying the issued token gets the ones it missed again.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSLoopbackServer)
+		int32 AcceptedFeatures = 0;
+
+	/* Answer Ping packets with a Pong. Clear it to let the client's heartbeat time out. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSLoopbackServer)
+		bool bAnswerPings = true;
+
+	/* Every packet the client sends, after the automatic handling */
+	UPROPERTY(BlueprintAssignable, Category = ULSLoopbackServer)
+		FClientPacketEvent OnClientPacket;
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FNativeClientPacketEvent, const UULSWirePacket*);
+
+	/* Native counterpart of OnClientPacket, broadcast right before it */
+	FNativeClientPacketEvent OnClientPacketNative;
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendSpawnActor(int64 uniqueId, const FString& className);
+
+	/* SpawnActor carrying the initial transform and fields, applied before the actor's BeginPlay */
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendSpawnActorWithState(int64 uniqueId, const FString& className, const FTransform& transform, const TArray<FULSReplicatedField>& fields);
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendDespawnActor(int64 uniqueId);
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendCreateObject(int64 uniqueId, const FString& className);
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendDestroyObject(int64 uniqueId);
+
+	/* One DespawnActors, DestroyObjects or TearOffs packet for all uniqueIds */
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendDespawnActors(const TArray<int64>& uniqueIds);
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendDestroyObjects(const TArray<int64>& uniqueIds);
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendTearOffs(const TArray<int64>& uniqueIds);
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendReplication(int64 uniqueId, const TArray<FULSReplicatedField>& fields);
+
+	/* Calls methodName on the object with full reflection */
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendRpc(int64 uniqueId, const FString& methodName, const TArray<FULSReplicatedField>& parameters);
+
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void SendConnectionEnd();
+
+	/* Closes the connection as if the server went away */
+	UFUNCTION(BlueprintCallable, Category = ULSLoopbackServer)
+		void CloseConnection(int32 statusCode, const FString& reason);
+
+	/* Sends complete wire bytes as they are, e.g. from an FULSPacketWriter */
+	void SendBytes(TArray<uint8>&& bytes);
+
+	void SendPacket(FULSPacketWriter& writer) { SendBytes(writer.MoveBytes()); }
+
+	UULSLoopbackTransport* GetTransport() const { return Transport; }
+
+	/* Features negotiated with the current connection */
+	ETransportFeatures GetNegotiatedFeatures() const { return NegotiatedFeatures; }
+
+	/* Sequenced packets kept for a resume, until the client acknowledges them */
+	int32 GetNumUnacknowledgedPackets() const { return UnacknowledgedPackets.Num(); }
+
+private:
+	struct FSequencedPacket
+	{
+		int64 Sequence = 0;
+		TArray<uint8> Bytes;
+	};
+
+	void SendLifecycleBatch(int32 packetType, const TArray<int64>& uniqueIds);
+
+	friend class UULSLoopbackTransport;
+
+	/* Called by the transport when it connects. The session survives for a SessionResume. */
+	void HandleClientConnected();
+
+	void HandleClientBytes(TConstArrayView<uint8> bytes);
+
+	void HandleTransportOptions(const UULSWirePacket* packet);
+
+	void HandleSessionResume(const UULSWirePacket* packet);
+
+	void SendConnectionResponse(bool bAccepted);
+
+	/* Compresses the packet if that was negotiated and hands it to the transport */
+	void DeliverBytes(TArray<uint8>&& bytes);
+
+	ETransportFeatures NegotiatedFeatures = ETransportFeatures::None;
+	int32 CompressionThreshold = 0;
+
+	/* Session of the last accepted connection, 0 without SessionResume */
+	int64 SessionToken = 0;
+	int64 NextSessionToken = 1;
+	int64 NextSequence = 1;
+	bool bSessionActive = false;
+	TArray<FSequencedPacket> UnacknowledgedPackets;
+
+	UPROPERTY()
+		UULSLoopbackTransport* Transport;
+};
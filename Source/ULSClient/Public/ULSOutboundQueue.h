@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "ULSPacketWriter.h"
+#include <atomic>
+
+/**
+ * Queue of wire packets sent from threads other than the game thread.
+ *
+ * Any number of threads may enqueue complete wire packets (header followed by the payload, as built
+ * by FULSPacketWriter) without taking a lock. A single consumer, the I/O side of the transport that
+ * owns the queue, drains it and sends the packets. Packets of one producer are sent in the order
+ * they were enqueued; packets of different producers and of SendWirePacket interleave freely.
+ *
+ * The bytes of queued packets are bounded by the max queued bytes. Enqueue fails once the bound
+ * would be exceeded, so a producer outpacing the connection finds out instead of exhausting memory.
+ */
+class ULSCLIENT_API FULSOutboundQueue
+{
+public:
+	explicit FULSOutboundQueue(int32 maxQueuedBytes = 4 * 1024 * 1024)
+		: MaxQueuedBytes(maxQueuedBytes)
+	{
+	}
+
+	/* Thread-safe. Returns false and leaves bytes untouched if the queue is full or the packet has no header. */
+	bool Enqueue(TArray<uint8>&& bytes)
+	{
+		const int32 size = bytes.Num();
+		if (size < (int32)sizeof(int32))
+		{
+			return false;
+		}
+
+		// Reserve first, so concurrent producers can't overshoot the bound together
+		const int64 previous = QueuedBytes.fetch_add(size, std::memory_order_relaxed);
+		if (previous + size > MaxQueuedBytes.load(std::memory_order_relaxed))
+		{
+			QueuedBytes.fetch_sub(size, std::memory_order_relaxed);
+			return false;
+		}
+
+		Packets.Enqueue(MoveTemp(bytes));
+		return true;
+	}
+
+	/* Thread-safe */
+	bool Enqueue(FULSPacketWriter&& writer)
+	{
+		TArray<uint8> bytes = writer.MoveBytes();
+		return Enqueue(MoveTemp(bytes));
+	}
+
+	/* Consumer only */
+	bool Dequeue(TArray<uint8>& outBytes)
+	{
+		if (Packets.Dequeue(outBytes) == false)
+		{
+			return false;
+		}
+		QueuedBytes.fetch_sub(outBytes.Num(), std::memory_order_relaxed);
+		return true;
+	}
+
+	/* Consumer only. Discards everything queued. */
+	void Reset()
+	{
+		TArray<uint8> bytes;
+		while (Dequeue(bytes))
+		{
+		}
+	}
+
+	bool IsEmpty() const
+	{
+		return Packets.IsEmpty();
+	}
+
+	int64 GetQueuedBytes() const
+	{
+		return QueuedBytes.load(std::memory_order_relaxed);
+	}
+
+	void SetMaxQueuedBytes(int32 maxQueuedBytes)
+	{
+		MaxQueuedBytes.store(maxQueuedBytes, std::memory_order_relaxed);
+	}
+
+private:
+	TQueue<TArray<uint8>, EQueueMode::Mpsc> Packets;
+	std::atomic<int64> QueuedBytes { 0 };
+	std::atomic<int32> MaxQueuedBytes;
+};
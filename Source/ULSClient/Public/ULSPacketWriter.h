@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSPacketWriter.generated.h"
+
+/*
+* A replicated field or RPC parameter as the server writes it.
+*
+* Type is an EReplicatedFieldType. Size is the announced value size of integers and floats
+* (1, 2, 4 or 8 bytes). Use the static constructors to get consistent values.
+*/
+USTRUCT(BlueprintType)
+struct ULSCLIENT_API FULSReplicatedField
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FString Name;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		int32 Type = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		int32 Size = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		int64 IntValue = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		double FloatValue = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FString StringValue;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FVector VectorValue = FVector::ZeroVector;
+
+	/* Reference to a network object, -1 for null */
+	static FULSReplicatedField Ref(const FString& name, int64 uniqueId);
+	static FULSReplicatedField Int16(const FString& name, int16 value);
+	static FULSReplicatedField Int32(const FString& name, int32 value);
+	static FULSReplicatedField Int64(const FString& name, int64 value);
+	static FULSReplicatedField Bool(const FString& name, bool value);
+	static FULSReplicatedField Float(const FString& name, float value);
+	static FULSReplicatedField Double(const FString& name, double value);
+	static FULSReplicatedField String(const FString& name, const FString& value);
+	static FULSReplicatedField Vector(const FString& name, const FVector& value);
+};
+
+/**
+ * Builds wire packets the way the server does, in the default (non-compact) encoding.
+ *
+ * Unlike UULSWirePacket the buffer grows as values are written, so the payload size doesn't have
+ * to be known up front. The result is the complete wire representation, header included.
+ */
+class ULSCLIENT_API FULSPacketWriter
+{
+public:
+	explicit FULSPacketWriter(int32 packetType, int32 initialCapacity = 256);
+
+	void WriteInt8(int8 value) { WriteValue(value); }
+	void WriteInt16(int16 value) { WriteValue(value); }
+	void WriteInt32(int32 value) { WriteValue(value); }
+	void WriteInt64(int64 value) { WriteValue(value); }
+	void WriteFloat32(float value) { WriteValue(value); }
+	void WriteFloat64(double value) { WriteValue(value); }
+
+	/* int32 byte length followed by the UTF-8 characters */
+	void WriteString(const FString& value);
+
+	/* Three float32 components */
+	void WriteVector(const FVector& value);
+
+	void WriteBytes(TConstArrayView<uint8> bytes) { Bytes.Append(bytes.GetData(), bytes.Num()); }
+
+	/* Type tag, name and value, as used by Replication packets and RPC parameters */
+	void WriteField(const FULSReplicatedField& field);
+
+	int32 GetPayloadSize() const;
+
+	const TArray<uint8>& GetBytes() const { return Bytes; }
+
+	TArray<uint8> MoveBytes() { return MoveTemp(Bytes); }
+
+private:
+	template<typename T>
+	void WriteValue(T value)
+	{
+		Bytes.Append((const uint8*)&value, sizeof(T));
+	}
+
+	TArray<uint8> Bytes;
+};
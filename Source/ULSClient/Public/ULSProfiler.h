@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* What one replicated field or RPC method cost, cumulative since the profiler was started or reset */
+struct FULSFieldProfile
+{
+	/* Times the field was applied, or the method called */
+	int64 Updates = 0;
+	/* Updates that left the value as it was, i.e. wasted on the wire */
+	int64 Unchanged = 0;
+	/* Payload bytes of the field (type, name and value) or of the whole RPC packet */
+	int64 Bytes = 0;
+	uint64 ApplyCycles = 0;
+	uint64 OnRepCycles = 0;
+};
+
+/**
+ * Attributes replication and RPC traffic and time to (class, field) and (class, method).
+ *
+ * Off by default, the replication path only checks IsEnabled then. Start it with "uls.Profile.Start"
+ * and write the table with "uls.Profile.Dump [file]", which lists the most expensive entries first.
+ * Game thread only.
+ */
+class ULSCLIENT_API FULSProfiler
+{
+public:
+	static bool IsEnabled() { return bEnabled; }
+
+	static void SetEnabled(bool bInEnabled);
+
+	static void Reset();
+
+	/* Bytes a field took in a Replication or ReplicationDelta packet */
+	static void RecordFieldBytes(const UClass* cls, FName fieldName, int32 numBytes);
+
+	/* A field was applied. Delta updates also apply fields that changed with the baseline, without any bytes. */
+	static void RecordFieldApply(const UClass* cls, FName fieldName, bool bChanged, uint64 applyCycles, uint64 onRepCycles);
+
+	static void RecordRpc(const UClass* cls, FName methodName, int32 numBytes, uint64 cycles);
+
+	/* Writes one CSV row per field and method, sorted by bytes. Relative paths are relative to the Saved directory. */
+	static bool DumpCsv(const FString& path);
+
+	/* Records the RPC when it goes out of scope, if the profiler is enabled */
+	class FRpcScope
+	{
+	public:
+		FRpcScope(const UClass* cls, const FString& methodName, int32 numBytes);
+
+		~FRpcScope();
+
+	private:
+		const UClass* Class = nullptr;
+		FName MethodName;
+		int32 NumBytes = 0;
+		uint64 StartCycles = 0;
+	};
+
+private:
+	static bool bEnabled;
+};
@@ -0,0 +1,193 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSRttEstimator.h"
+#include "ULSReliableEndpoint.generated.h"
+
+/* Delivery guarantees of a message sent through FULSReliableEndpoint */
+UENUM(BlueprintType)
+enum class EULSDeliveryChannel : uint8
+{
+	ReliableOrdered = 0,		// Delivered exactly once, in send order
+	ReliableUnordered = 1,		// Delivered exactly once, as soon as it is complete
+	UnreliableSequenced = 2,	// May be lost. Messages older than the newest delivered one are dropped.
+};
+
+/* First byte of every datagram */
+enum class EULSDatagramKind : uint8
+{
+	Data = 0,
+	Connect = 1,
+	Accept = 2,
+	Disconnect = 3,
+};
+
+/**
+ * Reliability layer on top of an unreliable datagram socket.
+ *
+ * The endpoint does not own a socket: outgoing datagrams are handed to OnSendDatagram and received
+ * datagrams are passed in through ReceiveDatagram. Two endpoints can therefore be wired to each
+ * other in-process (optionally dropping or reordering datagrams in between) to test the protocol
+ * without any networking.
+ *
+ * Datagram layout (little endian):
+ *   uint8  Kind (EULSDatagramKind::Data)
+ *   uint16 Sequence         Datagram sequence number
+ *   uint16 Ack              Newest datagram sequence received from the remote side
+ *   uint32 AckBits          Bit n set: datagram (Ack - 1 - n) was received as well
+ *   uint8  NumMessages
+ *   Messages:
+ *     uint8  Channel        EULSDeliveryChannel, 0x80 set if the message is a fragment
+ *     uint16 MessageId      Per channel
+ *     uint16 FragmentIndex  Only present for fragments
+ *     uint16 FragmentCount  Only present for fragments
+ *     uint16 Length
+ *     uint8  Data[Length]
+ *
+ * Reliable fragments are resent when the datagram that carried them was not acknowledged within
+ * the retransmit timeout, which is derived from the measured round trip time (RFC 6298).
+ */
+class ULSCLIENT_API FULSReliableEndpoint
+{
+public:
+	static constexpr int32 DatagramHeaderSize = 10;
+	static constexpr int32 MessageHeaderSize = 5;
+	static constexpr int32 FragmentHeaderSize = 4;
+
+	explicit FULSReliableEndpoint(int32 mtu = 1200);
+
+	/* Called for every datagram that has to go out */
+	TFunction<void(TConstArrayView<uint8>)> OnSendDatagram;
+
+	/* Called for every complete message, according to the guarantees of its channel */
+	TFunction<void(EULSDeliveryChannel, TArray<uint8>&&)> OnReceiveMessage;
+
+	/* Queues a message. It is sent on the next Update. */
+	void Send(EULSDeliveryChannel channel, TConstArrayView<uint8> message);
+
+	void ReceiveDatagram(TConstArrayView<uint8> datagram, double now);
+
+	/* Sends queued messages, retransmissions and acknowledgements */
+	void Update(double now);
+
+	/* Smoothed round trip time in seconds, 0 before the first sample */
+	double GetSmoothedRtt() const { return Rtt.GetSmoothedRtt(); }
+
+	double GetRttVariation() const { return Rtt.GetRttVariation(); }
+
+	double GetRetransmitTimeout() const { return RetransmitTimeout; }
+
+	/* Time of the last datagram received from the remote side */
+	double GetLastReceiveTime() const { return LastReceiveTime; }
+
+	/* Reliable fragments that were not acknowledged yet */
+	int32 GetNumUnackedFragments() const { return Outgoing.Num(); }
+
+	/* Unacknowledged reliable fragments that may be in flight at the same time */
+	int32 MaxFragmentsInFlight = 512;
+
+	/* Interval for sending empty datagrams so the remote side sees the connection alive */
+	double KeepAliveInterval = 0.5;
+
+	/* Largest message accepted from the remote side. Both sides are expected to use the same MTU, fragment counts above this size are dropped. */
+	int32 MaxMessageSize = 64 * 1024 * 1024;
+
+	/* Bytes all incomplete fragmented messages may hold together. Fragments beyond it are dropped, reliable ones are resent. */
+	int32 MaxPartialBytes = 64 * 1024 * 1024;
+
+	/* Bytes held by incomplete fragmented messages */
+	int32 GetNumPartialBytes() const { return PartialBytes; }
+
+	static bool SequenceGreaterThan(uint16 a, uint16 b)
+	{
+		return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+	}
+
+private:
+	struct FOutgoingFragment
+	{
+		EULSDeliveryChannel Channel;
+		uint16 MessageId;
+		uint16 FragmentIndex;
+		uint16 FragmentCount;
+		TArray<uint8> Data;
+		double LastSendTime = 0;
+		int32 SendCount = 0;
+	};
+
+	struct FSentDatagram
+	{
+		uint16 Sequence = 0;
+		bool bValid = false;
+		bool bContainsResend = false;
+		bool bCarriesMessages = false;
+		double SendTime = 0;
+		TArray<uint64, TInlineAllocator<8>> FragmentKeys;
+	};
+
+	struct FReassembly
+	{
+		int32 NumReceived = 0;
+		int32 NumBytes = 0;
+		TArray<TArray<uint8>> Fragments;
+	};
+
+	struct FReceiveChannel
+	{
+		uint16 NextMessageId = 0;
+		bool bReceivedAny = false;
+		TMap<uint16, FReassembly> Partial;
+		TMap<uint16, TArray<uint8>> Completed;
+		TBitArray<> Delivered;
+	};
+
+	static uint64 MakeFragmentKey(EULSDeliveryChannel channel, uint16 messageId, uint16 fragmentIndex)
+	{
+		return ((uint64)channel << 32) | ((uint64)messageId << 16) | fragmentIndex;
+	}
+
+	int32 GetMaxFragmentSize() const { return Mtu - DatagramHeaderSize - MessageHeaderSize - FragmentHeaderSize; }
+
+	void ProcessAck(uint16 ack, uint32 ackBits, double now);
+
+	void AcknowledgeDatagram(uint16 sequence, double now);
+
+	void AddRttSample(double rtt);
+
+	void ReceiveFragment(EULSDeliveryChannel channel, uint16 messageId, uint16 fragmentIndex, uint16 fragmentCount, TConstArrayView<uint8> data);
+
+	void DeliverMessage(EULSDeliveryChannel channel, uint16 messageId, TArray<uint8>&& message);
+
+	void BeginDatagram(double now);
+
+	void FinishDatagram(double now);
+
+	int32 Mtu;
+
+	// Sending
+	uint16 NextSequence = 0;
+	uint16 NextMessageIds[3] = {};
+	TMap<uint64, FOutgoingFragment> Outgoing;
+	TArray<uint64> OutgoingOrder;
+	TArray<FOutgoingFragment> OutgoingUnreliable;
+	TArray<FSentDatagram> SentDatagrams;
+	TArray<uint8> DatagramBuffer;
+	int32 DatagramMessageCount = 0;
+	double LastSendTime = 0;
+
+	// Receiving. Until the first datagram arrives we acknowledge 65535, which the remote side can't have
+	// sent yet, instead of its datagram 0.
+	uint16 RemoteSequence = MAX_uint16;
+	uint32 RemoteAckBits = 0;
+	bool bReceivedAnyDatagram = false;
+	bool bAckPending = false;
+	double LastReceiveTime = 0;
+	FReceiveChannel ReceiveChannels[3];
+	int32 PartialBytes = 0;
+
+	// Round trip time estimation
+	FULSRttEstimator Rtt;
+	double RetransmitTimeout = 1.0;
+};
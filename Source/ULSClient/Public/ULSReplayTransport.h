@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "ULSTransport.h"
+#include "ULSCapture.h"
+#include "ULSReplayTransport.generated.h"
+
+/**
+ * Plays a capture written by UULSClientNetworkOwner::StartCapture back into the network owner.
+ *
+ * The file is memory mapped and every inbound frame is decoded straight from the mapping. Frames of
+ * all channels arrive on this transport, outbound frames are skipped and whatever the owner sends is
+ * dropped. The owner has to enable the same features as the recorded one, the server's answer to the
+ * TransportOptions request is part of the capture.
+ *
+ * With PlaybackRate 0 the frames are fed as fast as possible, otherwise with their recorded timing
+ * scaled by the rate. At the end of the capture the session ends as if the server had sent a
+ * ConnectionEnd, followed by a clean disconnect.
+ */
+UCLASS(Blueprintable)
+class ULSCLIENT_API UULSReplayTransport : public UULSTransport
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginDestroy() override;
+
+	/* Capture file, relative paths are relative to the project's Saved directory */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSReplayTransport)
+		FString CapturePath;
+
+	/* 1 for real time, 0 for as fast as possible */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSReplayTransport)
+		float PlaybackRate = 1.0f;
+
+	/* Upper bound for the frames fed per tick when playing as fast as possible, 0 for no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSReplayTransport)
+		int32 MaxFramesPerTick = 0;
+
+	virtual bool IsConnected() const override;
+
+	virtual bool Connect() override;
+
+	virtual void Disconnect() override;
+
+	virtual void SendBytes(TConstArrayView<uint8> bytes) override;
+
+	/* Feeds the rest of the capture right away, regardless of PlaybackRate. Returns the number of frames fed. */
+	UFUNCTION(BlueprintCallable, Category = ULSReplayTransport)
+		int32 ReplayAll();
+
+	/* Seconds of the capture played so far */
+	UFUNCTION(BlueprintCallable, Category = ULSReplayTransport)
+		float GetPlaybackTime() const { return (float)PlaybackTime; }
+
+private:
+	bool Tick(float deltaTime);
+
+	/* Feeds inbound frames recorded up to time. Returns the number of frames fed. */
+	int32 FeedUntil(double time, int32 maxFrames);
+
+	void Finish();
+
+	void StopTicker();
+
+	FULSCaptureReader Reader;
+	FTSTicker::FDelegateHandle TickerHandle;
+	double PlaybackTime = 0;
+	bool bConnected = false;
+};
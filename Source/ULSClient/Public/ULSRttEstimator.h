@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Smoothed round trip time as specified by RFC 6298: an EWMA with gain 1/8 for the RTT and 1/4 for its
+ * variation. Shared by the net clock (Ping / Pong) and the reliable endpoint (acknowledged datagrams).
+ */
+struct FULSRttEstimator
+{
+	/* rtt in seconds */
+	void AddSample(double rtt)
+	{
+		if (!bHasSamples)
+		{
+			SmoothedRtt = rtt;
+			RttVariation = rtt / 2;
+			bHasSamples = true;
+		}
+		else
+		{
+			RttVariation = 0.75 * RttVariation + 0.25 * FMath::Abs(SmoothedRtt - rtt);
+			SmoothedRtt = 0.875 * SmoothedRtt + 0.125 * rtt;
+		}
+	}
+
+	void Reset() { *this = FULSRttEstimator(); }
+
+	bool HasSamples() const { return bHasSamples; }
+
+	double GetSmoothedRtt() const { return SmoothedRtt; }
+
+	double GetRttVariation() const { return RttVariation; }
+
+	/* SRTT + 4 * RTTVAR, clamped */
+	double GetRetransmitTimeout(double minTimeout, double maxTimeout) const
+	{
+		return FMath::Clamp(SmoothedRtt + 4 * RttVariation, minTimeout, maxTimeout);
+	}
+
+private:
+	double SmoothedRtt = 0;
+	double RttVariation = 0;
+	bool bHasSamples = false;
+};
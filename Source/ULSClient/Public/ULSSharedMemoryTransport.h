@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "ULSTransport.h"
+#include "ULSSharedMemoryTransport.generated.h"
+
+class FULSSharedMemoryRing;
+
+/**
+ * Transport for a server running on the same host, over two shared memory rings. Linux only.
+ *
+ * Ring format (version 1)
+ * -----------------------
+ * The server creates two POSIX shared memory objects per client before the client connects:
+ *
+ *   /uls.<ChannelName>.s2c   Server to client
+ *   /uls.<ChannelName>.c2s   Client to server
+ *
+ * Each object is a 4096 byte control block followed by the data area. All values are little
+ * endian, indices and signals are accessed atomically.
+ *
+ *   Offset  Size  Field
+ *   0       8     Magic "ULSRING1"
+ *   8       4     Version, 1
+ *   12      4     Capacity: size of the data area in bytes, a power of two
+ *   64      8     WriteIndex: total bytes produced, only written by the producer
+ *   128     8     ReadIndex: total bytes consumed, only written by the consumer
+ *   192     4     DataSignal: futex word, incremented by the producer after every record
+ *   196     4     ConsumerWaiting: non-zero while the consumer sleeps on DataSignal
+ *   256     4     SpaceSignal: futex word, incremented by the consumer after releasing a record
+ *   260     4     ProducerWaiting: non-zero while the producer sleeps on SpaceSignal
+ *   320     4     Closed: set to 1 by the side that goes away
+ *   4096    ...   Data area
+ *
+ * A record starts at (index mod Capacity) and consists of a uint32 length, 4 reserved bytes and
+ * one complete wire packet of that length, padded to a multiple of 8 bytes. Records never wrap:
+ * if a record doesn't fit before the end of the data area, the producer writes the length
+ * 0xFFFFFFFF there and continues at offset 0. Records may not exceed Capacity / 2 - 8 bytes.
+ *
+ * The producer publishes a record by storing the new WriteIndex with release semantics, then
+ * increments DataSignal and issues FUTEX_WAKE on it if ConsumerWaiting is set. The consumer does
+ * the same with ReadIndex and SpaceSignal once it is done with a record. The futex words are
+ * shared between processes, so FUTEX_PRIVATE_FLAG must not be used.
+ *
+ * The client never blocks: it drains the server ring on the game thread every tick, reading each
+ * packet in place, and retries sends that didn't fit on the next tick. Connection setup and
+ * teardown are the regular ConnectionRequest / ConnectionEnd packets plus the Closed flag.
+ */
+UCLASS(Blueprintable)
+class ULSCLIENT_API UULSSharedMemoryTransport : public UULSTransport
+{
+	GENERATED_BODY()
+
+public:
+	UULSSharedMemoryTransport();
+
+	virtual void BeginDestroy() override;
+
+	UFUNCTION(BlueprintCallable, Category = ULSSharedMemoryTransport)
+		void SetConnectionData(FString channelName);
+
+	virtual bool IsConnected() const override { return bConnected; }
+
+	virtual bool Connect() override;
+
+	virtual void Disconnect() override;
+
+	virtual void SendBytes(TConstArrayView<uint8> bytes) override;
+
+private:
+	bool Tick(float deltaTime);
+
+	void FlushPendingSends();
+
+	void CloseRings();
+
+	UPROPERTY()
+		FString ChannelName;
+
+	TSharedPtr<FULSSharedMemoryRing> ReceiveRing;
+	TSharedPtr<FULSSharedMemoryRing> SendRing;
+	TArray<TArray<uint8>> PendingSends;
+	FTSTicker::FDelegateHandle TickerHandle;
+	bool bConnected = false;
+
+	/* Received packets point into the ring, so it can't be unmapped while they are handled */
+	bool bDraining = false;
+	bool bCloseAfterDrain = false;
+};
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "ULSTransport.h"
+#include "ULSSimulatedTransport.generated.h"
+
+/* Conditions applied in each direction */
+USTRUCT(BlueprintType)
+struct ULSCLIENT_API FULSNetworkConditions
+{
+	GENERATED_BODY()
+
+	/* One-way delay in milliseconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NetworkConditions)
+		float LatencyMs = 0;
+
+	/* Random extra delay of up to +-JitterMs milliseconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NetworkConditions)
+		float JitterMs = 0;
+
+	/* Percentage of datagrams dropped. Datagram transports only. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NetworkConditions)
+		float LossPercent = 0;
+
+	/* Percentage of datagrams held back long enough to arrive after later ones. Datagram transports only. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NetworkConditions)
+		float ReorderPercent = 0;
+
+	/* Link capacity in kilobits per second, 0 for unlimited. Excess traffic queues up. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NetworkConditions)
+		int32 BandwidthKbps = 0;
+};
+
+/**
+ * Wraps another transport and delays, throttles, drops and reorders its traffic.
+ *
+ * Stream transports (WebSocket, TCP, ...) are simulated per wire packet: latency, jitter and bandwidth
+ * apply, but packets stay in order and are never lost, like on the real connection. Datagram transports
+ * route every datagram through the simulator, below their reliability layer, so loss and reordering
+ * are simulated as well.
+ *
+ * Connect the simulated transport instead of the wrapped one. Compression is negotiated by the
+ * simulated transport, so configure it there.
+ *
+ * Delays are scheduled on a simulated clock that starts at 0 on Connect and advances by the delta time
+ * of the core ticker, or by AdvanceTime when bTickOnCoreTicker is off. The precision is bounded by the
+ * step size.
+ *
+ * With bUseConsoleVariables the uls.NetSim.* console variables override Conditions and Seed, and
+ * "uls.NetSim.Preset Off|Average|Bad|Terrible" sets them all at once. The random stream is seeded on
+ * every Connect, so the same seed, traffic and time steps give the same result.
+ */
+UCLASS(Blueprintable)
+class ULSCLIENT_API UULSSimulatedTransport : public UULSTransport
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginDestroy() override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSSimulatedTransport)
+		UULSTransport* WrappedTransport;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSSimulatedTransport)
+		FULSNetworkConditions Conditions;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSSimulatedTransport)
+		int32 Seed = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSSimulatedTransport)
+		bool bUseConsoleVariables = true;
+
+	/* Off to step the simulated clock with AdvanceTime only, e.g. from tests. Applied on Connect. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSSimulatedTransport)
+		bool bTickOnCoreTicker = true;
+
+	virtual bool IsConnected() const override;
+
+	virtual bool Connect() override;
+
+	virtual void Disconnect() override;
+
+	virtual void SendBytes(TConstArrayView<uint8> bytes) override;
+
+	virtual bool IsDatagramTransport() const override;
+
+	/* Conditions in effect, including console variable overrides */
+	FULSNetworkConditions GetEffectiveConditions() const;
+
+	/* Advances the simulated clock and releases everything that became due */
+	UFUNCTION(BlueprintCallable, Category = ULSSimulatedTransport)
+		void AdvanceTime(float deltaSeconds);
+
+	/* Seconds on the simulated clock since Connect */
+	double GetSimulatedTime() const { return SimulatedTime; }
+
+private:
+	friend class UULSTransport;
+
+	struct FDelayedBytes
+	{
+		double ReleaseTime = 0;
+		TArray<uint8> Bytes;
+	};
+
+	/* One direction of the simulated link */
+	struct FLink
+	{
+		TArray<FDelayedBytes> Queue;
+		double BusyUntil = 0;
+		double LastReleaseTime = 0;
+	};
+
+	/* Called by the wrapped transport for received wire bytes */
+	void HandleWrappedReceived(TArray<uint8>&& bytes);
+
+	/* Called by the wrapped datagram transport for every datagram it sends or receives */
+	void HandleWrappedDatagram(bool bOutgoing, TConstArrayView<uint8> datagram);
+
+	/* Called by the wrapped transport when the server or the network closed the connection */
+	void HandleWrappedDisconnected(int32 statusCode, const FString& reason, bool bWasClean);
+
+	void Enqueue(FLink& link, TConstArrayView<uint8> bytes, bool bDatagram);
+
+	bool Tick(float deltaTime);
+
+	void ReleaseDue(bool bOutgoing, double now);
+
+	void ResetLinks();
+
+	FLink OutgoingLink;
+	FLink IncomingLink;
+	FRandomStream Random;
+	double SimulatedTime = 0;
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "HAL/LowLevelMemTracker.h"
+
+ULSCLIENT_API DECLARE_LOG_CATEGORY_EXTERN(LogULS, Log, All);
+
+/*
+* Logging of every packet, field and parameter. Far too expensive to keep compiled in, define it
+* as 1 in the module rules (PublicDefinitions) to debug the serialization.
+*/
+#ifndef ULS_HOTPATH_LOGGING
+#define ULS_HOTPATH_LOGGING 0
+#endif
+
+#if ULS_HOTPATH_LOGGING
+#define ULS_HOTPATH_LOG(Verbosity, Format, ...) UE_LOG(LogULS, Verbosity, Format, ##__VA_ARGS__)
+#else
+#define ULS_HOTPATH_LOG(Verbosity, Format, ...)
+#endif
+
+/* "stat ULS" */
+DECLARE_STATS_GROUP(TEXT("ULS"), STATGROUP_ULS, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode"), STAT_ULSDecode, STATGROUP_ULS, ULSCLIENT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply"), STAT_ULSApply, STATGROUP_ULS, ULSCLIENT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnRep"), STAT_ULSOnRep, STATGROUP_ULS, ULSCLIENT_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Packets In"), STAT_ULSPacketsIn, STATGROUP_ULS, ULSCLIENT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Packets Out"), STAT_ULSPacketsOut, STATGROUP_ULS, ULSCLIENT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes In"), STAT_ULSBytesIn, STATGROUP_ULS, ULSCLIENT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Out"), STAT_ULSBytesOut, STATGROUP_ULS, ULSCLIENT_API);
+
+/* Insights channel of the ULS timing scopes. Enable with -trace=cpu,ULS */
+UE_TRACE_CHANNEL_EXTERN(ULSChannel, ULSCLIENT_API);
+
+/* Memory tag for allocations of the networking layer, shown by "stat LLM" and in Insights memory captures */
+LLM_DECLARE_TAG_API(ULS, ULSCLIENT_API);
+
+/* Times the scope for "stat ULS" and as a ULSChannel event in Insights */
+#define ULS_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, ULSChannel)
+
+/* Traffic of one packet type, cumulative since startup or the last ResetCounters */
+struct FULSPacketTypeCounters
+{
+	int64 PacketsIn = 0;
+	int64 BytesIn = 0;
+	int64 PacketsOut = 0;
+	int64 BytesOut = 0;
+};
+
+/**
+ * Traffic counters per packet type.
+ *
+ * Every packet is counted with its size on the wire, after compression. Besides the cumulative
+ * counters kept here, each packet type gets per-frame counters in "stat ULS" (created on first use,
+ * named after UULSFunctionLibrary::GetPacketNameByType) and the totals are traced as Insights counters.
+ * Thread-safe.
+ */
+class ULSCLIENT_API FULSNetStats
+{
+public:
+	/* Packet types at or above this are counted together with the last one */
+	static constexpr int32 MaxPacketTypes = 256;
+
+	static void RecordReceived(int32 packetType, int32 numBytes);
+
+	/* Reads the packet type from the header of wire bytes */
+	static void RecordReceived(TConstArrayView<uint8> wireBytes);
+
+	static void RecordSent(int32 packetType, int32 numBytes);
+
+	/* Reads the packet type from the header of wire bytes */
+	static void RecordSent(TConstArrayView<uint8> wireBytes);
+
+	static FULSPacketTypeCounters GetCounters(int32 packetType);
+
+	static FULSPacketTypeCounters GetTotalCounters();
+
+	static void ResetCounters();
+};
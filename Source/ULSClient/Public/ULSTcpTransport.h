@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSTransport.h"
+#include "ULSTcpTransport.generated.h"
+
+class FULSTcpConnection;
+
+/**
+ * Transport over a plain TCP connection.
+ *
+ * Every wire packet is sent as one frame: a uint32 little endian length followed by the packet.
+ * A dedicated I/O thread reads the socket and feeds complete frames into the inbound queue of
+ * the network owner, which decodes them on the game thread.
+ */
+UCLASS(Blueprintable)
+class ULSCLIENT_API UULSTcpTransport : public UULSTransport
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginDestroy() override;
+
+	UFUNCTION(BlueprintCallable, Category = ULSTcpTransport)
+		void SetConnectionData(FString host, int32 port);
+
+	virtual bool IsConnected() const override;
+
+	virtual bool Connect() override;
+
+	virtual void Disconnect() override;
+
+	virtual void SendBytes(TConstArrayView<uint8> bytes) override;
+
+	virtual void FlushOutboundQueue() override;
+
+	virtual void SetCapture(const TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe>& capture) override;
+
+	/* Disable Nagle's algorithm so small packets go out immediately */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSTcpTransport)
+		bool bNoDelay = true;
+
+	/* Socket send buffer size in bytes. 0 keeps the OS default. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSTcpTransport)
+		int32 SendBufferSize = 256 * 1024;
+
+	/* Socket receive buffer size in bytes. 0 keeps the OS default. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSTcpTransport)
+		int32 ReceiveBufferSize = 256 * 1024;
+
+	/* Frames announcing a larger size close the connection */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSTcpTransport)
+		int32 MaxFrameSize = 64 * 1024 * 1024;
+
+	/* Seconds to wait for the connection to be established */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSTcpTransport)
+		float ConnectTimeout = 5.0f;
+
+private:
+	void HandleConnected(int32 connectionSerial, bool bSuccess, const FString& error);
+
+	void HandleClosed(int32 connectionSerial, const FString& reason, bool bWasClean);
+
+	UPROPERTY()
+		FString Host;
+	UPROPERTY()
+		int32 Port = 0;
+
+	TSharedPtr<FULSTcpConnection> Connection;
+
+	/* Identifies the connection events posted to the game thread belong to */
+	int32 ConnectionSerial = 0;
+};
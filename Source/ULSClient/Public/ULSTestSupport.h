@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSTestTypes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+class UWorld;
+
+/**
+ * World and network owner of one automation test or benchmark run. The test ticks the owner itself and
+ * connects it to whatever transport it needs. Tests of other modules derive from it to add their server.
+ */
+class ULSCLIENT_API FULSTestSession
+{
+public:
+	/* With bBeginPlay the world begins play, so spawned actors run their BeginPlay */
+	explicit FULSTestSession(const TCHAR* worldName, bool bBeginPlay = false);
+
+	virtual ~FULSTestSession();
+
+	/* Disconnects the owner's transport, if it has one */
+	void Disconnect();
+
+	/* Feeds packets the way UULSTransport::HandleReceivedView does */
+	void Apply(const TArray<TArray<uint8>>& packets);
+
+	void Tick(float deltaTime = 0.01f);
+
+	/* Ticks in real time until done returns true or seconds have passed. Returns done's last result. */
+	bool TickUntil(float seconds, TFunctionRef<bool()> done);
+
+	template<typename T>
+	T* Find(int64 uniqueId) const
+	{
+		return Cast<T>(Owner->FindObjectRefByUniqueId(uniqueId));
+	}
+
+	UWorld* World;
+	UULSTestNetworkOwner* Owner;
+};
+
+#endif
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ULSClientNetworkOwner.h"
+#include "ULSBlobTransfer.h"
+#include "ULSTestTypes.generated.h"
+
+/*
+* Types of the ULS automation tests and benchmarks, shared by the ULSClient and ULSMockServer modules.
+* UHT can't compile classes conditionally, so they are always built. Use them through FULSTestSession.
+*/
+
+/**
+ * Replication and RPC target of the ULS automation tests. Covers every field type the replication path
+ * handles and one OnRep.
+ */
+UCLASS(Transient, NotBlueprintable)
+class ULSCLIENT_API UULSTestObject : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+		int32 Health = 0;
+
+	UPROPERTY()
+		int64 Score = 0;
+
+	UPROPERTY()
+		float Speed = 0;
+
+	UPROPERTY()
+		FString Label;
+
+	UPROPERTY()
+		FVector Location = FVector::ZeroVector;
+
+	UFUNCTION()
+		void OnRep_Health() { NumOnReps++; }
+
+	UFUNCTION()
+		void ApplyHit(int32 damage, float force, const FString& source) { Health -= damage; NumHits++; }
+
+	int32 NumOnReps = 0;
+	int32 NumHits = 0;
+};
+
+/**
+ * Spawn and despawn target of the ULS automation tests. Remembers the Health it saw during construction
+ * and BeginPlay, to tell whether spawn fields arrive before either.
+ */
+UCLASS(Transient, NotBlueprintable, NotPlaceable)
+class ULSCLIENT_API AULSTestActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+		int32 Health = 0;
+
+	int32 HealthAtConstruction = INDEX_NONE;
+	int32 HealthAtBeginPlay = INDEX_NONE;
+
+	virtual void OnConstruction(const FTransform& transform) override
+	{
+		Super::OnConstruction(transform);
+		HealthAtConstruction = Health;
+	}
+
+protected:
+	virtual void BeginPlay() override
+	{
+		Super::BeginPlay();
+		HealthAtBeginPlay = Health;
+	}
+};
+
+/**
+ * Network owner of the ULS automation tests. Ticked by the test rather than the core ticker, so it can
+ * run at the pace a test needs. Receives every blob the server sends into a buffer and records the
+ * connection responses and the objects the server tore off.
+ */
+UCLASS(Transient, NotBlueprintable)
+class ULSCLIENT_API UULSTestNetworkOwner : public UULSClientNetworkOwner
+{
+	GENERATED_BODY()
+
+public:
+	void TickOwner(float deltaTime) { Tick(deltaTime); }
+
+	UPROPERTY()
+		TArray<UULSBlobTransfer*> ReceivedBlobs;
+
+	TArray<bool> ConnectionResults;
+
+	UPROPERTY()
+		TArray<UObject*> TornOffObjects;
+
+protected:
+	virtual void OnBlobTransferStarted_Implementation(UULSBlobTransfer* transfer) override
+	{
+		transfer->WriteToBuffer();
+		ReceivedBlobs.Add(transfer);
+	}
+
+	virtual bool ProcessConnectionResponsePacket(const UULSWirePacket* packet) override
+	{
+		const bool bSuccess = Super::ProcessConnectionResponsePacket(packet);
+		ConnectionResults.Add(bSuccess);
+		return bSuccess;
+	}
+
+	virtual void NetworkObjectWasTornOff(UObject* existingObject) override
+	{
+		Super::NetworkObjectWasTornOff(existingObject);
+		TornOffObjects.Add(existingObject);
+	}
+};
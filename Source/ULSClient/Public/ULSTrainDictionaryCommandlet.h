@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ULSTrainDictionaryCommandlet.generated.h"
+
+/**
+ * Trains a compression dictionary from captured packets.
+ * 
+ * Usage: -run=ULSTrainDictionary -Samples=<capture file or directory> -Output=<file> [-Size=32768]
+ * 
+ * Samples are the inbound packets of capture files recorded with UULSClientNetworkOwner::StartCapture
+ * (uls.Capture.Start), either one file or every *.ulscap file in a directory. Relative paths are
+ * relative to the project's Saved directory, like the captures themselves. The resulting file is used
+ * as UULSTransport::CompressionDictionaryPath on the client and must be deployed to the server.
+ */
+UCLASS()
+class ULSCLIENT_API UULSTrainDictionaryCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UULSTrainDictionaryCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
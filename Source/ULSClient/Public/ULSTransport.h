@@ -4,8 +4,30 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "ULSOutboundQueue.h"
+#include "ULSCapture.h"
 #include "ULSTransport.generated.h"
 
+class UULSWirePacket;
+
+/*
+* Optional features negotiated with the server through a TransportOptions packet.
+* 
+* The TransportOptions payload is an int32 feature mask followed by one options block per
+* set bit, in ascending bit order. The server answers with the subset it accepts.
+*/
+enum class ETransportFeatures : int32
+{
+	None = 0,
+	Compression = 1 << 0,			// Payloads above a size threshold are deflated, optionally with a shared dictionary
+	CompactEncoding = 1 << 1,		// Server may send packets in the compact encoding (see ULSWireEncoding.h)
+	DeltaBaselines = 1 << 2,		// Server may send ReplicationDelta packets against baselines acknowledged by the client
+	ChannelChunks = 1 << 3,			// Packets on logical channels may be split into ChannelChunk packets and interleaved
+	SessionResume = 1 << 4,			// Server issues a session token and sequences its packets, so a dropped connection can be resumed
+	Heartbeat = 1 << 5,				// Both sides exchange Ping / Pong packets, used for RTT, clock sync and dead connection detection
+};
+ENUM_CLASS_FLAGS(ETransportFeatures)
+
 /**
  * 
  */
@@ -27,6 +49,137 @@ public:
 	UFUNCTION(BlueprintCallable, Category = ULSTransport)
 		virtual void SendWirePacket(const UULSWirePacket* packet);
 
+	/*
+	* Sends bytes that are already framed as a wire packet (header followed by the payload).
+	* 
+	* The bytes only have to stay valid for the duration of the call. SendWirePacket hands
+	* the packet's buffer to this function directly, so implementations should send from
+	* the view instead of copying it wherever the underlying socket allows.
+	*/
+	virtual void SendBytes(TConstArrayView<uint8> bytes);
+
+	/*
+	* Queue for sending from any thread. Fetch it on the game thread and keep the reference, it stays
+	* valid after the transport is gone. Packets are sent as they are, without compression.
+	*/
+	TSharedRef<FULSOutboundQueue, ESPMode::ThreadSafe> GetOutboundQueue() const { return OutboundQueue; }
+
+	/* Sends what worker threads queued. Called by the network owner every tick. */
+	virtual void FlushOutboundQueue();
+
+	/* True if the transport sends datagrams that can be lost or reordered below its own reliability layer */
+	virtual bool IsDatagramTransport() const { return false; }
+
+	/* Records every wire packet sent or received from now on, null to stop. See UULSClientNetworkOwner::StartCapture. */
+	virtual void SetCapture(const TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe>& capture) { Capture = capture; }
+
+	const TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe>& GetCapture() const { return Capture; }
+
 	UPROPERTY(BlueprintReadWrite)
 		class UULSClientNetworkOwner* ClientNetworkOwner;
+
+	/* Logical channel carried by this transport. 0 is the main connection, see UULSClientNetworkOwner::ChannelTransports. */
+	UPROPERTY(BlueprintReadOnly)
+		int32 ChannelIndex = 0;
+
+	/* Upper bound for the bytes waiting in the outbound queue. Enqueueing fails beyond that. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSTransport)
+		int32 MaxOutboundQueueBytes = 4 * 1024 * 1024;
+
+	/* Compress outgoing packets if the server agrees to it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Compression)
+		bool bEnableCompression = false;
+
+	/* Payloads smaller than this (in bytes) are always sent uncompressed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Compression)
+		int32 CompressionThreshold = 256;
+
+	/* Optional preset dictionary file, relative to the project directory. The server must use the identical file. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Compression)
+		FString CompressionDictionaryPath;
+
+	/* Upper bound for the uncompressed size announced by a received packet */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Compression)
+		int32 MaxDecompressedSize = 64 * 1024 * 1024;
+
+	/* Features this transport wants to negotiate with the server */
+	virtual ETransportFeatures GetRequestedFeatures() const;
+
+	/* Features the server accepted for the current connection */
+	ETransportFeatures GetNegotiatedFeatures() const { return NegotiatedFeatures; }
+
+	virtual int32 GetFeatureOptionsSize(ETransportFeatures feature) const;
+
+	virtual void WriteFeatureOptions(ETransportFeatures feature, UULSWirePacket* packet, int& position) const;
+
+	virtual void ReadFeatureOptions(ETransportFeatures feature, const UULSWirePacket* packet, int& position);
+
+	/* Called by the network owner once the server answered the TransportOptions request */
+	virtual void SetNegotiatedFeatures(ETransportFeatures features);
+
+protected:
+	friend class UULSClientNetworkOwner;
+	friend class UULSSimulatedTransport;
+
+	/* Set while this transport is wrapped by a UULSSimulatedTransport, which then receives its traffic */
+	UPROPERTY()
+		class UULSSimulatedTransport* Simulator;
+
+	/*
+	* Decodes received wire bytes and hands the resulting packet to the network owner.
+	* 
+	* Compressed packets are inflated first. Must be called on the game thread. receiveCycles is
+	* the FPlatformTime::Cycles64 stamp of the socket receive, for FULSLatencyStats. The WebSocket
+	* transport stamps it on its socket thread and transports receiving through FULSInboundQueue (TCP,
+	* loopback) when the frame is queued. The others pass 0, their packets count as received when
+	* decoding starts, so their latency stats leave out the time spent waiting for the game thread.
+	*/
+	void HandleReceivedBytes(TArray<uint8>&& bytes, uint64 receiveCycles = 0);
+
+	/*
+	* Like HandleReceivedBytes, but reads the packet in place if it isn't compressed.
+	* 
+	* The bytes only have to stay valid for the duration of the call.
+	*/
+	void HandleReceivedView(TConstArrayView<uint8> bytes, uint64 receiveCycles = 0);
+
+	/* Clears everything negotiated for the previous connection, and the outbound queue. Call before connecting. */
+	void ResetNegotiatedFeatures();
+
+	/* Reports the outcome of Connect() to the network owner, or to its channel handling for channel transports */
+	void NotifyConnected(bool bSuccess, const FString& errorMessage);
+
+	/* Reports a connection the server or the network closed. Not called for Disconnect(). */
+	void NotifyDisconnected(int32 statusCode, const FString& reason, bool bWasClean);
+
+	/* Datagram transports hand every datagram they send or receive to the simulator, if there is one */
+	void SimulateDatagram(bool bOutgoing, TConstArrayView<uint8> datagram);
+
+	/* Called by the simulator when a datagram passed to SimulateDatagram is due */
+	virtual void ReleaseSimulatedDatagram(bool bOutgoing, TConstArrayView<uint8> datagram) {}
+
+private:
+	/* Compressed packets are inflated before they are captured. Reassembled channel packets aren't captured again. */
+	void DecodeReceivedBytes(TArray<uint8>&& bytes, bool bCapture, uint64 receiveCycles = 0);
+
+	/* Hands a decoded packet to the network owner and records its latency */
+	void DispatchPacket(UULSWirePacket* packet, uint64 receiveCycles, uint64 decodeStartCycles);
+
+	void LoadCompressionDictionary();
+
+	TConstArrayView<uint8> GetActiveDictionary() const;
+
+	bool CompressPacket(const UULSWirePacket* packet, TArray<uint8>& outBytes) const;
+
+	bool DecompressBytes(TArray<uint8>& bytes) const;
+
+	ETransportFeatures NegotiatedFeatures = ETransportFeatures::None;
+
+	TSharedRef<FULSOutboundQueue, ESPMode::ThreadSafe> OutboundQueue = MakeShared<FULSOutboundQueue, ESPMode::ThreadSafe>();
+
+	TSharedPtr<FULSCaptureWriter, ESPMode::ThreadSafe> Capture;
+
+	TArray<uint8> CompressionDictionary;
+	uint32 CompressionDictionaryId = 0;
+	bool bServerAcceptedDictionary = false;
 };
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "ULSTransport.h"
+#include "ULSReliableEndpoint.h"
+#include "ULSUdpTransport.generated.h"
+
+class FSocket;
+class FInternetAddr;
+
+/**
+ * Transport over plain UDP with the reliability layer of FULSReliableEndpoint.
+ *
+ * Every wire packet is sent as one message on the channel configured for its packet type, so a lost
+ * datagram only delays the packets of its own channel. Connection handshake:
+ *
+ *   Client: Connect datagram (single EULSDatagramKind::Connect byte), repeated every ConnectRetryInterval
+ *   Server: Accept datagram (single EULSDatagramKind::Accept byte)
+ *   Either side: Disconnect datagram (single EULSDatagramKind::Disconnect byte)
+ *
+ * All other datagrams are EULSDatagramKind::Data and belong to the reliability layer. A server stand-in
+ * only has to answer Connect with Accept and run its own FULSReliableEndpoint for the client address.
+ */
+UCLASS(Blueprintable)
+class ULSCLIENT_API UULSUdpTransport : public UULSTransport
+{
+	GENERATED_BODY()
+
+public:
+	UULSUdpTransport();
+
+	virtual void BeginDestroy() override;
+
+	UFUNCTION(BlueprintCallable, Category = ULSUdpTransport)
+		void SetConnectionData(FString host, int32 port);
+
+	virtual bool IsConnected() const override { return State == EState::Connected; }
+
+	virtual bool Connect() override;
+
+	virtual void Disconnect() override;
+
+	virtual void SendBytes(TConstArrayView<uint8> bytes) override;
+
+	virtual bool IsDatagramTransport() const override { return true; }
+
+	/* Smoothed round trip time measured by the reliability layer, in seconds */
+	UFUNCTION(BlueprintCallable, Category = ULSUdpTransport)
+		float GetSmoothedRtt() const;
+
+	/* Largest datagram that is sent. Larger packets are fragmented. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSUdpTransport)
+		int32 Mtu = 1200;
+
+	/* Seconds to wait for the server to accept the connection */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSUdpTransport)
+		float ConnectTimeout = 5.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSUdpTransport)
+		float ConnectRetryInterval = 0.25f;
+
+	/* The connection is closed if nothing was received from the server for this many seconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSUdpTransport)
+		float IdleTimeout = 10.0f;
+
+	/* Channel per wire packet type. Packet types that are not listed use DefaultChannel. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSUdpTransport)
+		TMap<int32, EULSDeliveryChannel> ChannelRouting;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSUdpTransport)
+		EULSDeliveryChannel DefaultChannel = EULSDeliveryChannel::ReliableOrdered;
+
+	/* Receives, retries the handshake and sends. Called by the core ticker while the socket is open, tests call it to advance synchronously. */
+	bool Tick(float deltaTime);
+
+protected:
+	virtual void ReleaseSimulatedDatagram(bool bOutgoing, TConstArrayView<uint8> datagram) override;
+
+private:
+	enum class EState : uint8
+	{
+		Disconnected,
+		Connecting,
+		Connected,
+	};
+
+	void ReceiveDatagrams(double now);
+
+	void ProcessDatagram(TConstArrayView<uint8> datagram, double now);
+
+	void SendControl(EULSDatagramKind kind);
+
+	/* Sends through the simulator if there is one */
+	void SendDatagram(TConstArrayView<uint8> datagram);
+
+	void SendDatagramNow(TConstArrayView<uint8> datagram);
+
+	/* Closes the socket. Notifies the network owner if the connection was open or being opened. */
+	void CloseConnection(int32 code, const FString& reason, bool bWasClean);
+
+	UPROPERTY()
+		FString Host;
+	UPROPERTY()
+		int32 Port = 0;
+
+	EState State = EState::Disconnected;
+	FSocket* Socket = nullptr;
+	TSharedPtr<FInternetAddr> ServerAddress;
+	TSharedPtr<FInternetAddr> ReceiveAddress;
+	TSharedPtr<FULSReliableEndpoint> Endpoint;
+	TArray<uint8> ReceiveBuffer;
+	FTSTicker::FDelegateHandle TickerHandle;
+	double ConnectStartTime = 0;
+	double LastConnectAttemptTime = 0;
+	/* Counts as the last receive until the first Data datagram arrives */
+	double AcceptTime = 0;
+};
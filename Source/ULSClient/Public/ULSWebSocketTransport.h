@@ -8,6 +8,68 @@
 #include "ULSTransport.h"
 #include "ULSWebSocketTransport.generated.h"
 
+/**
+ * Joins the fragments of binary WebSocket messages.
+ *
+ * The engine delivers a message in as many pieces as it was split into frames and socket reads. Only the
+ * last fragment flag marks the end of the message, the remaining byte count of a piece is per frame.
+ */
+class ULSCLIENT_API FULSWebSocketMessageAssembler
+{
+public:
+	/* Messages larger than this are dropped, the rest of their fragments is skipped */
+	int32 MaxMessageSize = 64 * 1024 * 1024;
+
+	/* Returns true and moves the complete message to outMessage once the last fragment arrived */
+	bool AddFragment(const uint8* data, int32 size, bool bIsLastFragment, TArray<uint8>& outMessage)
+	{
+		if (bDiscarding)
+		{
+			bDiscarding = bIsLastFragment == false;
+			return false;
+		}
+		if ((int64)PartialMessage.Num() + size > MaxMessageSize)
+		{
+			PartialMessage.Empty();
+			bDiscarding = bIsLastFragment == false;
+			NumDroppedMessages++;
+			return false;
+		}
+
+		if (bIsLastFragment && PartialMessage.Num() == 0)
+		{
+			outMessage = TArray<uint8>(data, size);
+			return true;
+		}
+
+		PartialMessage.Append(data, size);
+		if (bIsLastFragment == false)
+		{
+			return false;
+		}
+
+		outMessage = MoveTemp(PartialMessage);
+		PartialMessage.Reset();
+		return true;
+	}
+
+	void Reset()
+	{
+		PartialMessage.Reset();
+		bDiscarding = false;
+	}
+
+	bool HasPartialMessage() const { return PartialMessage.Num() > 0; }
+
+	/* Messages dropped for exceeding MaxMessageSize */
+	int32 GetNumDroppedMessages() const { return NumDroppedMessages; }
+
+private:
+	TArray<uint8> PartialMessage;
+	bool bDiscarding = false;
+	int32 NumDroppedMessages = 0;
+};
+
 /**
  * 
  */
@@ -19,6 +81,10 @@ class ULSCLIENT_API UULSWebSocketTransport : public UULSTransport
 public:
 	~UULSWebSocketTransport();
 
+	/* Subprotocol requested in the handshake. The protocol of SetConnectionData is used if empty. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSWebSocketTransport)
+		FString Subprotocol;
+
 protected:
 	virtual void BeginDestroy() override;
 
@@ -31,7 +97,7 @@ protected:
 
 	virtual void Disconnect();
 
-	virtual void SendWirePacket(const UULSWirePacket* packet);
+	virtual void SendBytes(TConstArrayView<uint8> bytes) override;
 
 private:
 	UPROPERTY()
@@ -45,10 +111,13 @@ private:
 
 	TSharedPtr<IWebSocket> _webSocket;
 
+	/* Only touched on the WebSocket thread */
+	FULSWebSocketMessageAssembler MessageAssembler;
+
 	FDelegateHandle OnConnectedHandle;
 	FDelegateHandle OnConnectionErrorHandle;
 	FDelegateHandle OnClosedHandle;
-	FDelegateHandle OnRawMessageHandle;
+	FDelegateHandle OnBinaryMessageHandle;
 	FDelegateHandle OnMessageHandle;
 	FDelegateHandle OnMessageSentHandle;
 };
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WireCore/ULSBitStream.h"
+#include "ULSWireEncoding.generated.h"
+
+/*
+* Compact wire encoding
+*
+* Negotiated through ETransportFeatures::CompactEncoding and marked per packet with
+* EWirePacketFlags::CompactEncoding. In a compact packet:
+*
+* - All integers (flags, unique ids, counts, sizes, field values and bools) are zig-zag
+*   encoded LEB128 varints instead of fixed-size little endian values.
+* - Strings are prefixed with their byte length as unsigned varint.
+* - Floats are fixed-point: the zig-zag varint of round(value / FloatPrecision). A precision
+*   of 0 sends them as raw float32 / float64 depending on the announced size.
+* - Vectors are cell-relative: the integer cell index of each component as zig-zag varint,
+*   followed by the bit-packed position within the cell (VectorComponentBits per component,
+*   padded to the next byte). Precision only depends on the cell size, not on the distance
+*   to the world origin.
+* - Field type tags stay single bytes.
+*
+* The encoding itself lives in WireCore/ULSBitStream.h, the types here adapt it to engine types.
+*/
+
+USTRUCT(BlueprintType)
+struct ULSCLIENT_API FULSQuantizationSettings
+{
+	GENERATED_BODY()
+
+	/* Step size of fixed-point floats. 0 disables float quantization */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		float FloatPrecision = 0.001f;
+
+	/* Edge length of the cells vectors are encoded relative to */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		double VectorCellSize = 1024.0;
+
+	/* Bits used for each component of the position within a cell (1 - 32) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		int32 VectorComponentBits = 16;
+
+	ULSWire::FQuantization ToWire() const { return { FloatPrecision, VectorCellSize, VectorComponentBits }; }
+};
+
+class ULSCLIENT_API FULSWireEncoding
+{
+public:
+	static inline uint64 ZigZagEncode(int64 value) { return ULSWire::ZigZagEncode(value); }
+	static inline int64 ZigZagDecode(uint64 value) { return ULSWire::ZigZagDecode(value); }
+
+	/* Number of bytes needed to write value as unsigned varint */
+	static inline int32 GetVarUIntSize(uint64 value) { return ULSWire::GetVarUIntSize(value); }
+
+	static inline int64 QuantizeFloat(double value, const FULSQuantizationSettings& settings) { return ULSWire::QuantizeFloat(value, settings.FloatPrecision); }
+	static inline double DequantizeFloat(int64 value, const FULSQuantizationSettings& settings) { return ULSWire::DequantizeFloat(value, settings.FloatPrecision); }
+};
+
+/**
+ * Writes values into a bit stream. Bits are filled starting with the least significant bit of each byte.
+ */
+class ULSCLIENT_API FULSBitWriter
+{
+public:
+	void WriteBits(uint64 value, int32 numBits) { Writer.WriteBits(value, numBits); }
+
+	void WriteVarUInt(uint64 value) { Writer.WriteVarUInt(value); }
+
+	void WriteVarInt(int64 value) { Writer.WriteVarInt(value); }
+
+	void WriteQuantizedFloat(double value, const FULSQuantizationSettings& settings) { Writer.WriteQuantizedFloat(value, settings.ToWire()); }
+
+	void WriteQuantizedVector(const FVector& value, const FULSQuantizationSettings& settings);
+
+	/* Pads the stream with zero bits up to the next byte boundary */
+	void AlignToByte() { Writer.AlignToByte(); }
+
+	int32 GetNumBits() const { return Writer.GetNumBits(); }
+
+	int32 GetNumBytes() const { return Writer.GetNumBytes(); }
+
+	TConstArrayView<uint8> GetData() const { return TConstArrayView<uint8>(Writer.GetData().data(), Writer.GetNumBytes()); }
+
+private:
+	ULSWire::FBitWriter Writer;
+};
+
+/**
+ * Reads values from a bit stream written by FULSBitWriter.
+ *
+ * Reading past the end sets the overflow flag and returns zeros.
+ */
+class ULSCLIENT_API FULSBitReader
+{
+public:
+	FULSBitReader(TConstArrayView<uint8> data, int32 startByte = 0)
+		: Reader(data.GetData(), data.Num(), startByte)
+	{
+	}
+
+	uint64 ReadBits(int32 numBits) { return Reader.ReadBits(numBits); }
+
+	uint64 ReadVarUInt() { return Reader.ReadVarUInt(); }
+
+	int64 ReadVarInt() { return Reader.ReadVarInt(); }
+
+	double ReadQuantizedFloat(const FULSQuantizationSettings& settings) { return Reader.ReadQuantizedFloat(settings.ToWire()); }
+
+	FVector ReadQuantizedVector(const FULSQuantizationSettings& settings);
+
+	void AlignToByte() { Reader.AlignToByte(); }
+
+	bool IsOverflowed() const { return Reader.IsOverflowed(); }
+
+	/* Bytes consumed since startByte, including a partially read last byte */
+	int32 GetNumBytesConsumed() const { return Reader.GetNumBytesConsumed(); }
+
+private:
+	ULSWire::FBitReader Reader;
+};
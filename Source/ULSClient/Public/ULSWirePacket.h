@@ -4,26 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "WireCore/ULSWireReader.h"
+#include "WireCore/ULSWireWriter.h"
 #include "ULSWirePacket.generated.h"
 
-enum EWirePacketType : int
-{
-    ConnectionRequest = 0,          // Sent by client. Request to establisch connection. Followed by ConnectionResponse
-    ConnectionResponse = 1,         // Sent by server upon receiving a ConnectionRequest. Contains "success true/false"
-    ConnectionEnd = 2,              // Sent by server when the connection is closed gracefully from the server side (i.e. when the "world" is shut down)
-
-    Replication = 110,              // Replication message. Sent by the server only.
-    SpawnActor = 111,               // Spawns a new network actor on the client. Sent by the server only.
-    DespawnActor = 112,             // Despawns a network actor on the client. Sent by the server only.
-    CreateObject = 113,             // Creates a new UObject based object on the client. Sent by the server only.
-    DestroyObject = 114,            // Destroy a UObject based object on the client. Sent by the server only.
-    RpcCall = 115,                  // Serialized RpcCall. Can be sent by both parties.
-    RpcCallResponse = 116,          // Serialized response to an RpcCall. Can be sent by both parties.
-    TearOff = 117,                  // Server has torn off the link between the server and client object. No more messages will be sent for this object after this message.
-
-    Custom = 200                    // Custom, user-specific data. Ignored in low-level operations
-};
-
 /**
  * 
  */
@@ -35,18 +19,94 @@ class ULSCLIENT_API UULSWirePacket : public UObject
 public:
     UULSWirePacket();
 
+    /** Size of the header (the packet type) that precedes the payload on the wire */
+    static constexpr int32 HeaderSize = ULSWire::HeaderSize;
+
+    /** Bits of the header that hold the packet type. The remaining bits are EWirePacketFlags */
+    static constexpr int32 PacketTypeMask = ULSWire::PacketTypeMask;
+
     UPROPERTY(BlueprintReadWrite)
         int32 PacketType;
 
-    UPROPERTY(BlueprintReadWrite)
-        TArray<uint8> Payload;
+    /** EWirePacketFlags sent along with the packet type */
+    int32 HeaderFlags;
+
+    /** Session sequence number of received packets with the Sequenced flag, 0 otherwise */
+    int64 Sequence = 0;
+
+    bool IsCompactEncoding() const { return (HeaderFlags & EWirePacketFlags::CompactEncoding) != 0; }
 
     UFUNCTION()
         bool ParseFromBytes(const TArray<uint8>& bytes);
 
+    /*
+    * Takes ownership of the received bytes.
+    * 
+    * The header stays in place in front of the payload, so the payload is not copied.
+    */
+    bool ParseFromBytes(TArray<uint8>&& bytes);
+
+    /*
+    * Reads the packet in place, without copying the bytes.
+    * 
+    * The bytes must stay valid and unchanged until ReleaseView is called. Writing to the payload
+    * copies it into a buffer owned by the packet first. Handlers that keep the packet beyond the
+    * call they received it in must call DetachFromView.
+    */
+    bool ParseFromView(TConstArrayView<uint8> bytes);
+
+    /* Copies viewed bytes into a buffer owned by the packet. Does nothing for owned packets. */
+    void DetachFromView() const;
+
+    /* Forgets viewed bytes, leaving an empty payload. Does nothing for owned packets. */
+    void ReleaseView();
+
+    bool IsView() const { return ViewData != nullptr; }
+
     UFUNCTION()
         TArray<uint8> SerializeToBytes() const;
 
+    /*
+    * Writes PacketType and HeaderFlags into the header room in front of the payload. Call it once the
+    * packet is built, before it is sent.
+    */
+    UFUNCTION(BlueprintCallable, Category = ULSWirePacket)
+        void FinalizeHeader();
+
+    /* False if PacketType or HeaderFlags changed since the header was written or received */
+    bool IsHeaderFinalized() const;
+
+    /*
+    * Returns the packet exactly as it is sent on the wire (header followed by the payload), with the
+    * header as finalized or received.
+    * 
+    * The header room is reserved when the packet is created, so no copy is made. The view is
+    * valid until the payload is resized.
+    */
+    TConstArrayView<uint8> GetWireBytes() const;
+
+    TConstArrayView<uint8> GetPayload() const { return TConstArrayView<uint8>(GetPayloadData(), GetPayloadSize()); }
+
+    /* Writable payload, for filling it with raw bytes. Copies viewed bytes first. */
+    TArrayView<uint8> GetMutablePayload() { return TArrayView<uint8>(GetPayloadData(), GetPayloadSize()); }
+
+    UFUNCTION(BlueprintCallable, Category = ULSWirePacket)
+        int32 GetPayloadSize() const { return (ViewData != nullptr ? ViewSize : Buffer.Num()) - PayloadOffset; }
+
+    /* Resizes the payload. Newly added bytes are uninitialized, the caller has to fill them. */
+    void SetPayloadSize(int32 size);
+
+    /* Resizes the payload. Newly added bytes are zeroed. */
+    UFUNCTION(BlueprintCallable, Category = ULSWirePacket, meta = (DisplayName = "Set Payload Size"))
+        void ResizePayload(int32 size);
+
+    /* Copy of the payload for Blueprints. C++ code reads it in place with GetPayload and the Read functions. */
+    UFUNCTION(BlueprintPure, Category = ULSWirePacket)
+        TArray<uint8> GetPayloadBytes() const;
+
+    UFUNCTION(BlueprintCallable, Category = ULSWirePacket)
+        void SetPayloadBytes(const TArray<uint8>& bytes);
+
     UFUNCTION()
         int8 ReadInt8(int index, int& advancedPosition) const;
     UFUNCTION()
@@ -61,6 +121,12 @@ public:
         double ReadFloat64(int index, int& advancedPosition) const;
     UFUNCTION()
         FString ReadString(int index, int& advancedPosition) const;
+    UFUNCTION()
+        int64 ReadVarInt(int index, int& advancedPosition) const;
+    UFUNCTION()
+        FString ReadVarString(int index, int& advancedPosition) const;
+
+    uint64 ReadVarUInt(int index, int& advancedPosition) const;
     
     const uint8* ReadDataPtr(int size, int index, int& advancedPosition) const;
 
@@ -86,8 +152,30 @@ public:
         void PutString(FString value, int index, int& advancedPosition);
     UFUNCTION()
         void PutArray(TArray<uint8> bytes, int index, int& advancedPosition);
+    UFUNCTION()
+        void PutVarInt(int64 value, int index, int& advancedPosition);
+    UFUNCTION()
+        void PutVarString(FString value, int index, int& advancedPosition);
+
+    void PutVarUInt(uint64 value, int index, int& advancedPosition);
 
 private:
-    static inline uint32 EndianSwap(uint32 value) { return (value << 24) | ((value & 0xff00) << 8) | ((value >> 8) & 0xff00) | (value >> 24); }
-    static inline int32 EndianSwap(int32 value) { return int32(EndianSwap(uint32(value))); }
+    const uint8* GetPayloadData() const { return (ViewData != nullptr ? ViewData : Buffer.GetData()) + PayloadOffset; }
+    uint8* GetPayloadData() { DetachFromView(); return Buffer.GetData() + PayloadOffset; }
+
+    /* Header followed by the payload. Mutable so viewed bytes can be detached from const packets. */
+    mutable TArray<uint8> Buffer;
+
+    /* Bytes read in place by ParseFromView. Take precedence over Buffer while set. */
+    mutable const uint8* ViewData = nullptr;
+    mutable int32 ViewSize = 0;
+
+    /* Offset of the first payload byte within Buffer */
+    int32 PayloadOffset;
+
+    /* Reads the header fields in front of the payload. Sets PayloadOffset. */
+    bool ParseHeader(const uint8* data, int32 size);
+
+    ULSWire::FWireReader GetReader() const { return ULSWire::FWireReader(GetPayloadData(), GetPayloadSize()); }
+    ULSWire::FPayloadWriter GetWriter() { return ULSWire::FPayloadWriter(GetPayloadData(), GetPayloadSize()); }
 };
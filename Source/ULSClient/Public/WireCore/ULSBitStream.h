@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ULSWireFormat.h"
+
+#include <vector>
+
+namespace ULSWire
+{
+	/* Mirrors FULSQuantizationSettings, see ULSWireEncoding.h for the compact encoding */
+	struct FQuantization
+	{
+		/* Step size of fixed-point floats. 0 disables float quantization */
+		float FloatPrecision = 0.001f;
+		/* Edge length of the cells vectors are encoded relative to */
+		double VectorCellSize = 1024.0;
+		/* Bits used for each component of the position within a cell (1 - 32) */
+		int32_t VectorComponentBits = 16;
+	};
+
+	int64_t QuantizeFloat(double value, float precision);
+
+	double DequantizeFloat(int64_t value, float precision);
+
+	/**
+	 * Writes values into a bit stream. Bits are filled starting with the least significant bit of each byte.
+	 */
+	class FBitWriter
+	{
+	public:
+		void WriteBits(uint64_t value, int32_t numBits);
+
+		void WriteVarUInt(uint64_t value);
+
+		void WriteVarInt(int64_t value) { WriteVarUInt(ZigZagEncode(value)); }
+
+		void WriteQuantizedFloat(double value, const FQuantization& settings);
+
+		void WriteQuantizedVector(const double value[3], const FQuantization& settings);
+
+		/* Pads the stream with zero bits up to the next byte boundary */
+		void AlignToByte();
+
+		void Reset();
+
+		int32_t GetNumBits() const { return NumBits; }
+
+		int32_t GetNumBytes() const { return (NumBits + 7) / 8; }
+
+		const std::vector<uint8_t>& GetData() const { return Data; }
+
+	private:
+		/* Always holds GetNumBytes bytes, the unused bits of the last one are zero */
+		std::vector<uint8_t> Data;
+		int32_t NumBits = 0;
+	};
+
+	/**
+	 * Reads values from a bit stream written by FBitWriter.
+	 *
+	 * Reading past the end sets the overflow flag and returns zeros.
+	 */
+	class FBitReader
+	{
+	public:
+		FBitReader(const uint8_t* data, int32_t size, int32_t startByte = 0);
+
+		uint64_t ReadBits(int32_t numBits);
+
+		uint64_t ReadVarUInt();
+
+		int64_t ReadVarInt() { return ZigZagDecode(ReadVarUInt()); }
+
+		double ReadQuantizedFloat(const FQuantization& settings);
+
+		void ReadQuantizedVector(double outValue[3], const FQuantization& settings);
+
+		void AlignToByte() { BitPosition = (BitPosition + 7) & ~7; }
+
+		bool IsOverflowed() const { return bOverflowed; }
+
+		/* Bytes consumed since startByte, including a partially read last byte */
+		int32_t GetNumBytesConsumed() const { return (BitPosition + 7) / 8 - StartByte; }
+
+	private:
+		const uint8_t* Data;
+		int32_t Size;
+		int32_t StartByte;
+		int32_t BitPosition;
+		bool bOverflowed = false;
+	};
+}
@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/*
+* ULS wire format core
+*
+* Packet framing, varints and the other low-level pieces of the wire format, without any engine
+* dependency. The engine types (UULSWirePacket, FULSBitWriter, ...) are thin wrappers around this,
+* and Source/ULSWireCore builds it as a plain static library with unit tests and benchmarks.
+*
+* Only the standard library may be included from the WireCore folder.
+*/
+
+#include <cstdint>
+#include <cstring>
+
+enum EWirePacketType : int
+{
+    ConnectionRequest = 0,          // Sent by client. Request to establisch connection. Followed by ConnectionResponse
+    ConnectionResponse = 1,         // Sent by server upon receiving a ConnectionRequest. Contains "success true/false"
+    ConnectionEnd = 2,              // Sent by server when the connection is closed gracefully from the server side (i.e. when the "world" is shut down)
+    TransportOptions = 3,           // Sent by client after connecting, answered by the server. Negotiates optional transport features (compression, ...)
+
+    Replication = 110,              // Replication message. Sent by the server only.
+    SpawnActor = 111,               // Spawns a new network actor on the client. Sent by the server only.
+    DespawnActor = 112,             // Despawns a network actor on the client. Sent by the server only.
+    CreateObject = 113,             // Creates a new UObject based object on the client. Sent by the server only.
+    DestroyObject = 114,            // Destroy a UObject based object on the client. Sent by the server only.
+    RpcCall = 115,                  // Serialized RpcCall. Can be sent by both parties.
+    RpcCallResponse = 116,          // Serialized response to an RpcCall. Can be sent by both parties.
+    TearOff = 117,                  // Server has torn off the link between the server and client object. No more messages will be sent for this object after this message.
+    ReplicationDelta = 118,         // Replication message delta-encoded against an acknowledged baseline. Sent by the server only.
+    BaselineAck = 119,              // Newest applied ReplicationDelta sequence per object, then objects that need a full update. Sent by the client only.
+    ChannelChunk = 120,             // Slice of a packet sent on a logical channel, interleaved with other traffic. Can be sent by both parties.
+    ChannelAttach = 121,            // First packet on a dedicated channel connection, names the channel. Sent by the client only.
+    BlobBegin = 122,                // Announces or resumes a blob transfer (see ULSBlobTransfer.h). Can be sent by both parties.
+    BlobChunk = 123,                // Slice of a blob. Can be sent by both parties.
+    BlobAck = 124,                  // Confirms the received part of a blob. Can be sent by both parties.
+    BlobCancel = 125,               // Aborts a blob transfer. Can be sent by both parties.
+    SessionResume = 126,            // Sent by client instead of a ConnectionRequest to continue a dropped session. Followed by ConnectionResponse
+    SessionAck = 127,               // Last sequence the client applied, lets the server drop packets it keeps for a resume. Sent by the client only.
+    Ping = 128,                     // Heartbeat carrying the sender's clock. Answered with Pong. Can be sent by both parties.
+    Pong = 129,                     // Echoes the Ping time followed by the responder's clock. Can be sent by both parties.
+    SpawnSnapshot = 130,            // SpawnActor and CreateObject payloads in one packet, e.g. the world for a late-joining client. Spawned over several frames. Sent by the server only.
+    DespawnActors = 131,            // DespawnActor for a list of ids, e.g. on a level transition. The actors are destroyed over several frames. Sent by the server only.
+    DestroyObjects = 132,           // DestroyObject for a list of ids. Sent by the server only.
+    TearOffs = 133,                 // TearOff for a list of ids. Sent by the server only.
+
+    Custom = 200                    // Custom, user-specific data. Ignored in low-level operations
+};
+
+/*
+* Flags stored in the upper byte of the packet header. The lower bytes hold the EWirePacketType.
+*/
+enum EWirePacketFlags : int32_t
+{
+    Compressed = 1 << 24,           // Payload is deflated: int32 uncompressed size followed by the raw deflate stream
+    CompactEncoding = 1 << 25,      // Payload uses the compact encoding described in ULSWireEncoding.h
+    Sequenced = 1 << 26,            // An int64 session sequence number precedes the payload. Compressed along with the payload.
+};
+
+/*
+* Flags of the int32 that starts a SpawnActor payload. Each set flag appends a block after the unique id, in this order.
+*/
+enum EWireSpawnFlags : int32_t
+{
+    SpawnTransform = 1 << 0,        // Location, rotation (pitch, yaw, roll in degrees) and scale, as three vectors
+    SpawnProperties = 1 << 1,       // Field count and fields like in a Replication packet, applied before the actor's construction finishes
+};
+
+namespace ULSWire
+{
+	/* Size of the header (the packet type and flags) that precedes the payload on the wire */
+	constexpr int32_t HeaderSize = sizeof(int32_t);
+
+	/* Bits of the header that hold the packet type. The remaining bits are EWirePacketFlags */
+	constexpr int32_t PacketTypeMask = 0x00FFFFFF;
+
+	/* Longest valid unsigned varint of a 64 bit value */
+	constexpr int32_t MaxVarUIntSize = 10;
+
+	struct FWireHeader
+	{
+		int32_t PacketType = 0;
+		/* EWirePacketFlags */
+		int32_t Flags = 0;
+		/* Session sequence number of packets with the Sequenced flag, 0 otherwise */
+		int64_t Sequence = 0;
+		/* Offset of the first payload byte, past the header and the sequence */
+		int32_t PayloadOffset = HeaderSize;
+	};
+
+	inline int32_t MakeHeader(int32_t packetType, int32_t flags)
+	{
+		return (packetType & PacketTypeMask) | (flags & ~PacketTypeMask);
+	}
+
+	/* Reads the header fields in front of the payload. False if the bytes are too short for them. */
+	inline bool ParseHeader(const uint8_t* data, int32_t size, FWireHeader& outHeader)
+	{
+		if (size < HeaderSize)
+		{
+			return false;
+		}
+
+		int32_t header;
+		std::memcpy(&header, data, sizeof(int32_t));
+		outHeader.PacketType = header & PacketTypeMask;
+		outHeader.Flags = header & ~PacketTypeMask;
+		outHeader.Sequence = 0;
+		outHeader.PayloadOffset = HeaderSize;
+
+		if ((outHeader.Flags & EWirePacketFlags::Sequenced) != 0)
+		{
+			if (size < HeaderSize + (int32_t)sizeof(int64_t))
+			{
+				return false;
+			}
+
+			// Skipped like the header, so handlers read the payload from position 0 as usual
+			std::memcpy(&outHeader.Sequence, data + HeaderSize, sizeof(int64_t));
+			outHeader.PayloadOffset += sizeof(int64_t);
+		}
+
+		return true;
+	}
+
+	inline uint64_t ZigZagEncode(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+	inline int64_t ZigZagDecode(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+	/* Number of bytes needed to write value as unsigned varint */
+	inline int32_t GetVarUIntSize(uint64_t value)
+	{
+		int32_t size = 1;
+		while (value >= 0x80)
+		{
+			value >>= 7;
+			size++;
+		}
+		return size;
+	}
+
+	/* Writes value as LEB128 varint. The destination needs room for GetVarUIntSize bytes. Returns the bytes written. */
+	inline int32_t EncodeVarUInt(uint64_t value, uint8_t* dest)
+	{
+		uint8_t* ptr = dest;
+		while (value >= 0x80)
+		{
+			*ptr++ = (uint8_t)(value | 0x80);
+			value >>= 7;
+		}
+		*ptr++ = (uint8_t)value;
+		return (int32_t)(ptr - dest);
+	}
+
+	/*
+	* Reads a LEB128 varint from at most available bytes.
+	*
+	* Returns the bytes consumed, 0 for a truncated or overlong varint (outValue is 0 then).
+	*/
+	inline int32_t DecodeVarUInt(const uint8_t* data, int32_t available, uint64_t& outValue)
+	{
+		// Single byte values are by far the most common (flags, small ids and counts)
+		if (available > 0 && data[0] < 0x80)
+		{
+			outValue = data[0];
+			return 1;
+		}
+
+		uint64_t value = 0;
+		for (int32_t i = 0; i < available && i < MaxVarUIntSize; i++)
+		{
+			value |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+			if ((data[i] & 0x80) == 0)
+			{
+				outValue = value;
+				return i + 1;
+			}
+		}
+
+		outValue = 0;
+		return 0;
+	}
+}
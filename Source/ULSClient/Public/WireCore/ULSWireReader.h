@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ULSWireFormat.h"
+
+#include <type_traits>
+
+namespace ULSWire
+{
+	/**
+	 * Bounds-checked reads from a packet payload, in the default and the compact encoding.
+	 *
+	 * Reads take the payload index and add the bytes they consumed to advancedPosition. Reads
+	 * out of bounds return zero (or null) and leave advancedPosition as it is. Does not own
+	 * the bytes.
+	 */
+	class FWireReader
+	{
+	public:
+		FWireReader(const uint8_t* data, int32_t size)
+			: Data(data)
+			, Size(size)
+		{
+		}
+
+		int32_t GetSize() const { return Size; }
+
+		bool HasBytes(int32_t index, int64_t count) const
+		{
+			return index >= 0 && count >= 0 && (int64_t)index + count <= (int64_t)Size;
+		}
+
+		/* Fixed-size little endian value, as used by the default encoding */
+		template<typename T>
+		T Read(int32_t index, int32_t& advancedPosition) const
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read");
+
+			if (HasBytes(index, sizeof(T)) == false)
+			{
+				return T();
+			}
+
+			T value;
+			std::memcpy(&value, Data + index, sizeof(T));
+			advancedPosition += sizeof(T);
+			return value;
+		}
+
+		uint64_t ReadVarUInt(int32_t index, int32_t& advancedPosition) const
+		{
+			if (HasBytes(index, 0) == false)
+			{
+				return 0;
+			}
+
+			uint64_t value;
+			advancedPosition += DecodeVarUInt(Data + index, Size - index, value);
+			return value;
+		}
+
+		int64_t ReadVarInt(int32_t index, int32_t& advancedPosition) const
+		{
+			return ZigZagDecode(ReadVarUInt(index, advancedPosition));
+		}
+
+		/* int32 byte length followed by the UTF-8 characters. Returns the characters, not terminated. */
+		const char* ReadString(int32_t index, int32_t& advancedPosition, int32_t& outLength) const
+		{
+			outLength = 0;
+			int32_t lengthSize = 0;
+			const int32_t length = Read<int32_t>(index, lengthSize);
+			if (lengthSize == 0 || HasBytes(index + lengthSize, length) == false)
+			{
+				return nullptr;
+			}
+
+			outLength = length;
+			advancedPosition += lengthSize + length;
+			return (const char*)(Data + index + lengthSize);
+		}
+
+		/* Varint byte length followed by the UTF-8 characters. Returns the characters, not terminated. */
+		const char* ReadVarString(int32_t index, int32_t& advancedPosition, int32_t& outLength) const
+		{
+			outLength = 0;
+			int32_t lengthSize = 0;
+			const uint64_t length = ReadVarUInt(index, lengthSize);
+			if (lengthSize == 0 || length > (uint64_t)Size || HasBytes(index + lengthSize, (int64_t)length) == false)
+			{
+				return nullptr;
+			}
+
+			outLength = (int32_t)length;
+			advancedPosition += lengthSize + outLength;
+			return (const char*)(Data + index + lengthSize);
+		}
+
+		const uint8_t* ReadDataPtr(int32_t size, int32_t index, int32_t& advancedPosition) const
+		{
+			if (HasBytes(index, size) == false)
+			{
+				return nullptr;
+			}
+
+			advancedPosition += size;
+			return Data + index;
+		}
+
+	private:
+		const uint8_t* Data;
+		int32_t Size;
+	};
+}
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ULSWireFormat.h"
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ULSWire
+{
+	/**
+	 * Bounds-checked writes into a payload of fixed size.
+	 *
+	 * Writes that don't fit leave the payload and advancedPosition as they are and return false.
+	 * Fixed-size values and varints set advancedPosition past the written value, strings and
+	 * raw bytes add their size to it. Does not own the bytes.
+	 */
+	class FPayloadWriter
+	{
+	public:
+		FPayloadWriter(uint8_t* data, int32_t size)
+			: Data(data)
+			, Size(size)
+		{
+		}
+
+		bool HasRoom(int32_t index, int64_t count) const
+		{
+			return index >= 0 && count >= 0 && (int64_t)index + count <= (int64_t)Size;
+		}
+
+		template<typename T>
+		bool Put(T value, int32_t index, int32_t& advancedPosition)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+
+			if (HasRoom(index, sizeof(T)) == false)
+			{
+				return false;
+			}
+
+			std::memcpy(Data + index, &value, sizeof(T));
+			advancedPosition = index + (int32_t)sizeof(T);
+			return true;
+		}
+
+		bool PutBytes(const void* bytes, int32_t count, int32_t index, int32_t& advancedPosition)
+		{
+			if (bytes == nullptr || HasRoom(index, count) == false)
+			{
+				return false;
+			}
+
+			std::memcpy(Data + index, bytes, count);
+			advancedPosition += count;
+			return true;
+		}
+
+		/* int32 byte length followed by the UTF-8 characters */
+		bool PutString(const char* chars, int32_t length, int32_t index, int32_t& advancedPosition)
+		{
+			if (length < 0 || HasRoom(index, (int64_t)sizeof(int32_t) + length) == false)
+			{
+				return false;
+			}
+
+			std::memcpy(Data + index, &length, sizeof(int32_t));
+			if (length > 0)
+			{
+				std::memcpy(Data + index + sizeof(int32_t), chars, length);
+			}
+			advancedPosition += (int32_t)sizeof(int32_t) + length;
+			return true;
+		}
+
+		bool PutVarUInt(uint64_t value, int32_t index, int32_t& advancedPosition)
+		{
+			if (HasRoom(index, GetVarUIntSize(value)) == false)
+			{
+				return false;
+			}
+
+			advancedPosition = index + EncodeVarUInt(value, Data + index);
+			return true;
+		}
+
+		bool PutVarInt(int64_t value, int32_t index, int32_t& advancedPosition)
+		{
+			return PutVarUInt(ZigZagEncode(value), index, advancedPosition);
+		}
+
+		/* Varint byte length followed by the UTF-8 characters */
+		bool PutVarString(const char* chars, int32_t length, int32_t index, int32_t& advancedPosition)
+		{
+			if (length < 0 || HasRoom(index, (int64_t)GetVarUIntSize(length) + length) == false)
+			{
+				return false;
+			}
+
+			PutVarUInt(length, index, advancedPosition);
+			if (length > 0)
+			{
+				std::memcpy(Data + advancedPosition, chars, length);
+			}
+			advancedPosition += length;
+			return true;
+		}
+
+	private:
+		uint8_t* Data;
+		int32_t Size;
+	};
+
+	/**
+	 * Builds a complete wire packet, header included, in a buffer that grows as values are written.
+	 *
+	 * For producers outside the engine (tests, benchmarks, tools). The header is written when the
+	 * writer is created.
+	 */
+	class FWireWriter
+	{
+	public:
+		explicit FWireWriter(int32_t packetType, int32_t flags = 0, size_t initialCapacity = 256)
+		{
+			Bytes.reserve(initialCapacity);
+			WriteValue(MakeHeader(packetType, flags));
+		}
+
+		template<typename T>
+		void WriteValue(T value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+
+			const size_t offset = Bytes.size();
+			Bytes.resize(offset + sizeof(T));
+			std::memcpy(Bytes.data() + offset, &value, sizeof(T));
+		}
+
+		void WriteBytes(const void* bytes, size_t count)
+		{
+			const uint8_t* begin = (const uint8_t*)bytes;
+			Bytes.insert(Bytes.end(), begin, begin + count);
+		}
+
+		/* int32 byte length followed by the UTF-8 characters */
+		void WriteString(const char* chars, int32_t length)
+		{
+			WriteValue(length);
+			WriteBytes(chars, length);
+		}
+
+		void WriteVarUInt(uint64_t value)
+		{
+			const size_t offset = Bytes.size();
+			Bytes.resize(offset + MaxVarUIntSize);
+			Bytes.resize(offset + EncodeVarUInt(value, Bytes.data() + offset));
+		}
+
+		void WriteVarInt(int64_t value) { WriteVarUInt(ZigZagEncode(value)); }
+
+		/* Varint byte length followed by the UTF-8 characters */
+		void WriteVarString(const char* chars, int32_t length)
+		{
+			WriteVarUInt((uint64_t)length);
+			WriteBytes(chars, length);
+		}
+
+		int32_t GetPayloadSize() const { return (int32_t)Bytes.size() - HeaderSize; }
+
+		const std::vector<uint8_t>& GetBytes() const { return Bytes; }
+
+		std::vector<uint8_t> MoveBytes() { return std::move(Bytes); }
+
+	private:
+		std::vector<uint8_t> Bytes;
+	};
+}
@@ -26,5 +26,15 @@ public class ULSClient : ModuleRules
 				"WebSockets"
 			}
 		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[] {
+				// Benchmark reports
+				"Json"
+			}
+		);
+
+		// Per-message compression
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
 	}
 }
@@ -0,0 +1,292 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSMockScenario.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	bool ParseCount(const FString& token, int32& outValue)
+	{
+		if (token.IsNumeric() == false)
+		{
+			return false;
+		}
+		outValue = FCString::Atoi(*token);
+		return outValue >= 0;
+	}
+
+	bool ParseId(const FString& token, int64& outValue)
+	{
+		if (token.IsNumeric() == false)
+		{
+			return false;
+		}
+		outValue = FCString::Atoi64(*token);
+		return true;
+	}
+
+	bool ParseSeconds(const FString& token, float& outValue)
+	{
+		if (token.IsNumeric() == false)
+		{
+			return false;
+		}
+		outValue = FCString::Atof(*token);
+		return outValue >= 0;
+	}
+
+	/* Numbers, or x,y,z for vectors */
+	bool ParseValue(const FString& text, bool bVector, FVector& outValue)
+	{
+		if (bVector)
+		{
+			TArray<FString> components;
+			text.ParseIntoArray(components, TEXT(","), false);
+			if (components.Num() != 3)
+			{
+				return false;
+			}
+			for (int32 i = 0; i < 3; i++)
+			{
+				if (components[i].IsNumeric() == false)
+				{
+					return false;
+				}
+				outValue[i] = FCString::Atod(*components[i]);
+			}
+			return true;
+		}
+
+		if (text.IsNumeric() == false)
+		{
+			return false;
+		}
+		outValue = FVector(FCString::Atod(*text), 0, 0);
+		return true;
+	}
+
+	/* Steps that address a range of objects: <firstId> <count> */
+	bool ParseRange(const TArray<FString>& tokens, FULSMockStep& step)
+	{
+		return tokens.Num() >= 3 && ParseId(tokens[1], step.FirstId) && ParseCount(tokens[2], step.Count);
+	}
+
+	bool ParseFields(const TArray<FString>& tokens, int32 first, FULSMockStep& step)
+	{
+		for (int32 i = first; i < tokens.Num(); i++)
+		{
+			FULSMockField field;
+			if (FULSMockField::Parse(tokens[i], field) == false)
+			{
+				return false;
+			}
+			step.Fields.Add(MoveTemp(field));
+		}
+		return true;
+	}
+}
+
+FULSReplicatedField FULSMockField::Make(int32 round) const
+{
+	const FVector value = Value + Delta * round;
+	if (Type == TEXT("ref"))
+	{
+		return FULSReplicatedField::Ref(Name, (int64)value.X);
+	}
+	if (Type == TEXT("int16"))
+	{
+		return FULSReplicatedField::Int16(Name, (int16)value.X);
+	}
+	if (Type == TEXT("int32"))
+	{
+		return FULSReplicatedField::Int32(Name, (int32)value.X);
+	}
+	if (Type == TEXT("int64"))
+	{
+		return FULSReplicatedField::Int64(Name, (int64)value.X);
+	}
+	if (Type == TEXT("bool"))
+	{
+		// Deltas toggle, e.g. bIsSprinting:bool=0+1
+		return FULSReplicatedField::Bool(Name, ((int64)value.X & 1) != 0);
+	}
+	if (Type == TEXT("float"))
+	{
+		return FULSReplicatedField::Float(Name, (float)value.X);
+	}
+	if (Type == TEXT("double"))
+	{
+		return FULSReplicatedField::Double(Name, value.X);
+	}
+	if (Type == TEXT("vector"))
+	{
+		return FULSReplicatedField::Vector(Name, value);
+	}
+	return FULSReplicatedField::String(Name, Text);
+}
+
+bool FULSMockField::Parse(const FString& token, FULSMockField& outField)
+{
+	FString name;
+	FString rest;
+	FString valueText;
+	if (token.Split(TEXT(":"), &name, &rest) == false || name.IsEmpty() ||
+		rest.Split(TEXT("="), &outField.Type, &valueText) == false)
+	{
+		return false;
+	}
+	outField.Name = name;
+	outField.Type.ToLowerInline();
+
+	if (outField.Type == TEXT("string"))
+	{
+		outField.Text = valueText;
+		return true;
+	}
+
+	static const TCHAR* numericTypes[] = { TEXT("ref"), TEXT("int16"), TEXT("int32"), TEXT("int64"), TEXT("bool"), TEXT("float"), TEXT("double"), TEXT("vector") };
+	bool bKnownType = false;
+	for (const TCHAR* numericType : numericTypes)
+	{
+		bKnownType |= outField.Type == numericType;
+	}
+	if (bKnownType == false)
+	{
+		return false;
+	}
+
+	// The first character may be a sign, a later '+' starts the delta
+	const bool bVector = outField.Type == TEXT("vector");
+	const int32 plusIndex = valueText.Find(TEXT("+"), ESearchCase::CaseSensitive, ESearchDir::FromStart, 1);
+	if (plusIndex == INDEX_NONE)
+	{
+		return ParseValue(valueText, bVector, outField.Value);
+	}
+	return ParseValue(valueText.Left(plusIndex), bVector, outField.Value) &&
+		ParseValue(valueText.Mid(plusIndex + 1), bVector, outField.Delta);
+}
+
+bool FULSMockScenario::Parse(const FString& text, FULSMockScenario& outScenario, FString& outError)
+{
+	outScenario.bAcceptConnections = true;
+	outScenario.Steps.Reset();
+
+	TArray<FString> lines;
+	text.Replace(TEXT("\n"), TEXT(";")).ParseIntoArray(lines, TEXT(";"), true);
+	for (FString& line : lines)
+	{
+		line.TrimStartAndEndInline();
+		if (line.IsEmpty() || line.StartsWith(TEXT("#")))
+		{
+			continue;
+		}
+
+		TArray<FString> tokens;
+		line.ParseIntoArrayWS(tokens);
+
+		FULSMockStep step;
+		bool bValid = true;
+		if (tokens[0] == TEXT("reject"))
+		{
+			bValid = outScenario.Steps.Num() == 0;
+			outScenario.bAcceptConnections = false;
+			if (bValid)
+			{
+				continue;
+			}
+		}
+		else if (tokens[0] == TEXT("spawn") || tokens[0] == TEXT("create"))
+		{
+			step.Type = tokens[0] == TEXT("spawn") ? EULSMockStep::Spawn : EULSMockStep::Create;
+			bValid = (tokens.Num() == 4 || (step.Type == EULSMockStep::Spawn && tokens.Num() > 4)) &&
+				ParseRange(tokens, step) && ParseFields(tokens, 4, step);
+			if (bValid)
+			{
+				step.Name = tokens[3];
+			}
+		}
+		else if (tokens[0] == TEXT("snapshot"))
+		{
+			step.Type = EULSMockStep::Snapshot;
+			bValid = tokens.Num() >= 4 && ParseRange(tokens, step) && ParseFields(tokens, 4, step);
+			if (bValid)
+			{
+				step.Name = tokens[3];
+			}
+		}
+		else if (tokens[0] == TEXT("replicate"))
+		{
+			step.Type = EULSMockStep::Replicate;
+			bValid = tokens.Num() >= 6 && ParseRange(tokens, step) &&
+				ParseSeconds(tokens[3], step.Rate) && step.Rate > 0 && ParseSeconds(tokens[4], step.Seconds) &&
+				ParseFields(tokens, 5, step);
+		}
+		else if (tokens[0] == TEXT("rpc"))
+		{
+			step.Type = EULSMockStep::Rpc;
+			bValid = tokens.Num() >= 4 && ParseRange(tokens, step) && ParseFields(tokens, 4, step);
+			if (bValid)
+			{
+				step.Name = tokens[3];
+			}
+		}
+		else if (tokens[0] == TEXT("wait"))
+		{
+			step.Type = EULSMockStep::Wait;
+			int32 milliseconds = 0;
+			bValid = tokens.Num() == 2 && ParseCount(tokens[1], milliseconds);
+			step.Seconds = milliseconds / 1000.0f;
+		}
+		else if (tokens[0] == TEXT("despawn") || tokens[0] == TEXT("destroy") || tokens[0] == TEXT("tearoff"))
+		{
+			step.Type = tokens[0] == TEXT("despawn") ? EULSMockStep::Despawn :
+				tokens[0] == TEXT("destroy") ? EULSMockStep::Destroy : EULSMockStep::TearOff;
+			step.bBatch = tokens.Num() == 4 && tokens[3] == TEXT("batch");
+			bValid = (tokens.Num() == 3 || step.bBatch) && ParseRange(tokens, step);
+		}
+		else if (tokens[0] == TEXT("end"))
+		{
+			step.Type = EULSMockStep::End;
+			bValid = tokens.Num() == 1;
+		}
+		else if (tokens[0] == TEXT("close"))
+		{
+			step.Type = EULSMockStep::Close;
+			bValid = tokens.Num() == 1 || (tokens.Num() == 2 && ParseCount(tokens[1], step.StatusCode));
+		}
+		else
+		{
+			outError = FString::Printf(TEXT("Unknown step \"%s\""), *line);
+			return false;
+		}
+
+		if (bValid == false)
+		{
+			outError = FString::Printf(TEXT("Invalid arguments in \"%s\""), *line);
+			return false;
+		}
+		outScenario.Steps.Add(MoveTemp(step));
+	}
+
+	if (outScenario.Steps.Num() == 0 && outScenario.bAcceptConnections)
+	{
+		outError = TEXT("The scenario has no steps");
+		return false;
+	}
+	return true;
+}
+
+bool FULSMockScenario::LoadFromFile(const FString& path, FULSMockScenario& outScenario, FString& outError)
+{
+	const FString fullPath = FPaths::IsRelative(path) ? FPaths::Combine(FPaths::ProjectDir(), path) : path;
+
+	FString text;
+	if (FFileHelper::LoadFileToString(text, *fullPath) == false)
+	{
+		outError = FString::Printf(TEXT("Failed to read %s"), *fullPath);
+		return false;
+	}
+	return Parse(text, outScenario, outError);
+}
@@ -0,0 +1,598 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSMockServer.h"
+#include "ULSLoopbackTransport.h"
+#include "ULSPacketWriter.h"
+#include "ULSWirePacket.h"
+#include "ULSStats.h"
+#include "WireCore/ULSWireReader.h"
+#include "IWebSocketNetworkingModule.h"
+#include "IWebSocketServer.h"
+#include "INetworkingWebSocket.h"
+#include "WebSocketNetworkingDelegates.h"
+
+/* Server side of one client, playing the scenario */
+class FULSMockConnection
+{
+public:
+	FULSMockConnection(int32 index, const TSharedPtr<const FULSMockScenario>& scenario, bool bAnswersHandshake)
+		: Index(index)
+		, Scenario(scenario)
+		, bAnswersHandshake(bAnswersHandshake)
+	{
+	}
+
+	virtual ~FULSMockConnection() {}
+
+	void HandleClientPacket(int32 packetType, TConstArrayView<uint8> payload);
+
+	void Tick(double now);
+
+	/* Played the whole scenario, was rejected or went away */
+	bool IsFinished() const { return bFinished; }
+
+	/* Whether the connection can be deleted once finished */
+	virtual bool CanRelease() const { return true; }
+
+protected:
+	/* False once the client went away */
+	virtual bool IsOpen() const = 0;
+
+	virtual void SendBytes(TArray<uint8>&& bytes) = 0;
+
+	virtual void Close(int32 statusCode, const FString& reason) = 0;
+
+	void SendPacket(FULSPacketWriter& writer)
+	{
+		TArray<uint8> bytes = writer.MoveBytes();
+		PacketsSent++;
+		BytesSent += bytes.Num();
+		SendBytes(MoveTemp(bytes));
+	}
+
+	void Finish();
+
+	const int32 Index;
+	const TSharedPtr<const FULSMockScenario> Scenario;
+
+private:
+	struct FReplication
+	{
+		const FULSMockStep* Step = nullptr;
+		int32 Round = 0;
+		double NextTime = 0;
+		double EndTime = 0;
+	};
+
+	void RunStep(const FULSMockStep& step);
+
+	void SendReplication(const FULSMockStep& step, int32 round);
+
+	const bool bAnswersHandshake;
+
+	TArray<FReplication> Replications;
+	int32 NextStep = 0;
+	/* Scenario time the next step is due */
+	double ResumeTime = 0;
+	int64 PacketsSent = 0;
+	int64 BytesSent = 0;
+	bool bPlaying = false;
+	bool bFinished = false;
+};
+
+void FULSMockConnection::HandleClientPacket(int32 packetType, TConstArrayView<uint8> payload)
+{
+	// Pings and RPCs are answered until the client goes away, the scenario is played once
+	const ULSWire::FWireReader reader(payload.GetData(), payload.Num());
+
+	switch (packetType)
+	{
+	case EWirePacketType::ConnectionRequest:
+	{
+		if (bFinished)
+		{
+			break;
+		}
+
+		if (bAnswersHandshake)
+		{
+			FULSPacketWriter writer(EWirePacketType::ConnectionResponse);
+			writer.WriteInt8(Scenario->bAcceptConnections ? 1 : 0);
+			SendPacket(writer);
+		}
+
+		if (Scenario->bAcceptConnections == false)
+		{
+			UE_LOG(LogULS, Display, TEXT("UULSMockServer: Rejected connection %d"), Index);
+			Finish();
+			return;
+		}
+
+		if (bPlaying == false)
+		{
+			UE_LOG(LogULS, Display, TEXT("UULSMockServer: Accepted connection %d"), Index);
+			bPlaying = true;
+			ResumeTime = FPlatformTime::Seconds();
+		}
+	}
+	break;
+
+	case EWirePacketType::TransportOptions:
+	{
+		if (bAnswersHandshake)
+		{
+			// No optional features
+			FULSPacketWriter writer(EWirePacketType::TransportOptions);
+			writer.WriteInt32((int32)ETransportFeatures::None);
+			SendPacket(writer);
+		}
+	}
+	break;
+
+	case EWirePacketType::RpcCall:
+	{
+		FULSPacketWriter writer(EWirePacketType::RpcCallResponse, payload.Num());
+		writer.WriteBytes(payload);
+		SendPacket(writer);
+	}
+	break;
+
+	case EWirePacketType::Ping:
+	{
+		if (bAnswersHandshake == false)
+		{
+			// Answered by the loopback server
+			break;
+		}
+
+		int position = 0;
+		const double senderTime = reader.Read<double>(position, position);
+
+		FULSPacketWriter writer(EWirePacketType::Pong, sizeof(double) * 2);
+		writer.WriteFloat64(senderTime);
+		writer.WriteFloat64(FPlatformTime::Seconds());
+		SendPacket(writer);
+	}
+	break;
+
+	default:
+		break;
+	}
+}
+
+void FULSMockConnection::Tick(double now)
+{
+	if (bFinished)
+	{
+		return;
+	}
+	if (IsOpen() == false)
+	{
+		Finish();
+		return;
+	}
+	if (bPlaying == false)
+	{
+		return;
+	}
+
+	const TArray<FULSMockStep>& steps = Scenario->Steps;
+	while (bPlaying && NextStep < steps.Num() && now >= ResumeTime)
+	{
+		RunStep(steps[NextStep++]);
+	}
+
+	for (int32 i = Replications.Num() - 1; i >= 0; i--)
+	{
+		// Late rounds are sent in a burst, so every run sends the same packets
+		FReplication& replication = Replications[i];
+		const double interval = 1.0 / replication.Step->Rate;
+		while (bPlaying && replication.NextTime <= now && replication.NextTime < replication.EndTime)
+		{
+			SendReplication(*replication.Step, replication.Round++);
+			replication.NextTime += interval;
+		}
+		if (replication.NextTime >= replication.EndTime)
+		{
+			Replications.RemoveAtSwap(i);
+		}
+	}
+
+	if (bPlaying && NextStep == steps.Num() && Replications.Num() == 0)
+	{
+		Finish();
+	}
+}
+
+void FULSMockConnection::RunStep(const FULSMockStep& step)
+{
+	switch (step.Type)
+	{
+	case EULSMockStep::Spawn:
+	case EULSMockStep::Create:
+		for (int32 i = 0; i < step.Count; i++)
+		{
+			FULSPacketWriter writer(step.Type == EULSMockStep::Spawn ? EWirePacketType::SpawnActor : EWirePacketType::CreateObject);
+			writer.WriteInt32(step.Fields.Num() > 0 ? EWireSpawnFlags::SpawnProperties : 0);
+			writer.WriteString(step.Name);
+			writer.WriteInt64(step.FirstId + i);
+			if (step.Fields.Num() > 0)
+			{
+				writer.WriteInt32(step.Fields.Num());
+				for (const FULSMockField& field : step.Fields)
+				{
+					writer.WriteField(field.Make(0));
+				}
+			}
+			SendPacket(writer);
+		}
+		break;
+
+	case EULSMockStep::Snapshot:
+	{
+		FULSPacketWriter writer(EWirePacketType::SpawnSnapshot);
+		writer.WriteInt32(0);
+		writer.WriteInt32(step.Count);
+		for (int32 i = 0; i < step.Count; i++)
+		{
+			// Entries are SpawnActor payloads, fields advance by their delta from one entry to the next
+			FULSPacketWriter entry(EWirePacketType::SpawnActor);
+			entry.WriteInt32(step.Fields.Num() > 0 ? EWireSpawnFlags::SpawnProperties : 0);
+			entry.WriteString(step.Name);
+			entry.WriteInt64(step.FirstId + i);
+			if (step.Fields.Num() > 0)
+			{
+				entry.WriteInt32(step.Fields.Num());
+				for (const FULSMockField& field : step.Fields)
+				{
+					entry.WriteField(field.Make(i));
+				}
+			}
+
+			writer.WriteInt32(EWirePacketType::SpawnActor);
+			writer.WriteInt32(entry.GetPayloadSize());
+			writer.WriteBytes(TConstArrayView<uint8>(entry.GetBytes()).RightChop(UULSWirePacket::HeaderSize));
+		}
+		SendPacket(writer);
+		break;
+	}
+
+	case EULSMockStep::Despawn:
+	case EULSMockStep::Destroy:
+	case EULSMockStep::TearOff:
+		if (step.bBatch)
+		{
+			FULSPacketWriter writer(step.Type == EULSMockStep::Despawn ? EWirePacketType::DespawnActors :
+				step.Type == EULSMockStep::Destroy ? EWirePacketType::DestroyObjects : EWirePacketType::TearOffs);
+			writer.WriteInt32(0);
+			writer.WriteInt32(step.Count);
+			for (int32 i = 0; i < step.Count; i++)
+			{
+				writer.WriteInt64(step.FirstId + i);
+			}
+			SendPacket(writer);
+			break;
+		}
+		for (int32 i = 0; i < step.Count; i++)
+		{
+			FULSPacketWriter writer(step.Type == EULSMockStep::Despawn ? EWirePacketType::DespawnActor :
+				step.Type == EULSMockStep::Destroy ? EWirePacketType::DestroyObject : EWirePacketType::TearOff);
+			writer.WriteInt32(0);
+			writer.WriteInt64(step.FirstId + i);
+			SendPacket(writer);
+		}
+		break;
+
+	case EULSMockStep::Replicate:
+	{
+		// Timed from when the step was due rather than when it ran, like the following steps
+		FReplication& replication = Replications.AddDefaulted_GetRef();
+		replication.Step = &step;
+		replication.NextTime = ResumeTime;
+		replication.EndTime = ResumeTime + step.Seconds;
+	}
+	break;
+
+	case EULSMockStep::Rpc:
+		for (int32 i = 0; i < step.Count; i++)
+		{
+			FULSPacketWriter writer(EWirePacketType::RpcCall);
+			writer.WriteInt32(1 << 0); // FullReflection
+			writer.WriteInt64(step.FirstId + i);
+			writer.WriteString(step.Name);
+			writer.WriteString(FString());
+			writer.WriteInt32(step.Fields.Num());
+			for (const FULSMockField& field : step.Fields)
+			{
+				writer.WriteField(field.Make(0));
+			}
+			SendPacket(writer);
+		}
+		break;
+
+	case EULSMockStep::Wait:
+		ResumeTime += step.Seconds;
+		break;
+
+	case EULSMockStep::End:
+	{
+		FULSPacketWriter writer(EWirePacketType::ConnectionEnd);
+		SendPacket(writer);
+	}
+	break;
+
+	case EULSMockStep::Close:
+		Close(step.StatusCode, TEXT("Scenario ended"));
+		Finish();
+		break;
+	}
+}
+
+void FULSMockConnection::SendReplication(const FULSMockStep& step, int32 round)
+{
+	TArray<FULSReplicatedField> fields;
+	fields.Reserve(step.Fields.Num());
+	for (const FULSMockField& field : step.Fields)
+	{
+		fields.Add(field.Make(round));
+	}
+
+	for (int32 i = 0; i < step.Count; i++)
+	{
+		FULSPacketWriter writer(EWirePacketType::Replication);
+		writer.WriteInt32(0);
+		writer.WriteInt64(step.FirstId + i);
+		writer.WriteInt32(fields.Num());
+		for (const FULSReplicatedField& field : fields)
+		{
+			writer.WriteField(field);
+		}
+		SendPacket(writer);
+	}
+}
+
+void FULSMockConnection::Finish()
+{
+	if (bFinished)
+	{
+		return;
+	}
+
+	bFinished = true;
+	bPlaying = false;
+	Replications.Reset();
+
+	UE_LOG(LogULS, Display, TEXT("UULSMockServer: Connection %d finished, sent %lld packets, %lld bytes"), Index, PacketsSent, BytesSent);
+}
+
+/* Scenario played to a UULSLoopbackTransport */
+class FULSMockLoopbackConnection : public FULSMockConnection
+{
+public:
+	FULSMockLoopbackConnection(int32 index, const TSharedPtr<const FULSMockScenario>& scenario, UULSLoopbackServer* server)
+		: FULSMockConnection(index, scenario, false)
+		, Server(server)
+	{
+	}
+
+protected:
+	/* Open until the transport disconnects after having connected */
+	virtual bool IsOpen() const override
+	{
+		return Server.IsValid() && (Server->GetTransport() == nullptr || Server->GetTransport()->IsConnected());
+	}
+
+	virtual void SendBytes(TArray<uint8>&& bytes) override
+	{
+		if (Server.IsValid())
+		{
+			Server->SendBytes(MoveTemp(bytes));
+		}
+	}
+
+	virtual void Close(int32 statusCode, const FString& reason) override
+	{
+		if (Server.IsValid())
+		{
+			Server->CloseConnection(statusCode, reason);
+		}
+	}
+
+private:
+	TWeakObjectPtr<UULSLoopbackServer> Server;
+};
+
+/* Scenario played to a client of the WebSocket listener */
+class FULSMockWebSocketConnection : public FULSMockConnection
+{
+public:
+	FULSMockWebSocketConnection(int32 index, const TSharedPtr<const FULSMockScenario>& scenario, INetworkingWebSocket* socket)
+		: FULSMockConnection(index, scenario, true)
+		, Socket(socket)
+	{
+	}
+
+	/* The socket belongs to the listener's connection until the client closes it */
+	virtual bool CanRelease() const override { return bOpen == false; }
+
+	void HandleReceived(void* data, int32 size)
+	{
+		// The listener hands over whole messages, one wire packet each
+		ULSWire::FWireHeader header;
+		if (ULSWire::ParseHeader((const uint8*)data, size, header) == false)
+		{
+			UE_LOG(LogULS, Warning, TEXT("UULSMockServer: Connection %d sent a malformed packet"), Index);
+			return;
+		}
+		HandleClientPacket(header.PacketType, TConstArrayView<uint8>((const uint8*)data + header.PayloadOffset, size - header.PayloadOffset));
+	}
+
+	void HandleClosed()
+	{
+		bOpen = false;
+	}
+
+protected:
+	virtual bool IsOpen() const override { return bOpen; }
+
+	virtual void SendBytes(TArray<uint8>&& bytes) override
+	{
+		if (bOpen)
+		{
+			Socket->Send(bytes.GetData(), bytes.Num(), false);
+		}
+	}
+
+	/* The listener can't close connections, ending the session is the closest */
+	virtual void Close(int32 statusCode, const FString& reason) override
+	{
+		FULSPacketWriter writer(EWirePacketType::ConnectionEnd);
+		SendPacket(writer);
+	}
+
+private:
+	TUniquePtr<INetworkingWebSocket> Socket;
+	bool bOpen = true;
+};
+
+// Server
+
+void UULSMockServer::BeginDestroy()
+{
+	Stop();
+
+	Super::BeginDestroy();
+}
+
+bool UULSMockServer::Start()
+{
+	Stop();
+
+	if (Scenario.IsValid() == false)
+	{
+		FULSMockScenario scenario;
+		FString error;
+		if (FULSMockScenario::LoadFromFile(ScenarioPath, scenario, error) == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("UULSMockServer: %s"), *error);
+			return false;
+		}
+		SetScenario(scenario);
+	}
+
+	if (Port > 0)
+	{
+		IWebSocketNetworkingModule& module = FModuleManager::LoadModuleChecked<IWebSocketNetworkingModule>(TEXT("WebSocketNetworking"));
+		WebSocketServer = MakeShareable(module.CreateServer().Release());
+
+		FWebSocketClientConnectedCallBack callback;
+		callback.BindUObject(this, &UULSMockServer::HandleWebSocketConnected);
+		if (WebSocketServer->Init(Port, callback) == false)
+		{
+			UE_LOG(LogULS, Error, TEXT("UULSMockServer: Failed to listen on port %d"), Port);
+			WebSocketServer.Reset();
+			return false;
+		}
+		UE_LOG(LogULS, Display, TEXT("UULSMockServer: Listening on port %d"), Port);
+	}
+
+	bRunning = true;
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UULSMockServer::Tick));
+	return true;
+}
+
+void UULSMockServer::Stop()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	bRunning = false;
+
+	// Closing the listener first lets the connections see their sockets close
+	WebSocketServer.Reset();
+	Connections.Reset();
+}
+
+UULSLoopbackTransport* UULSMockServer::CreateLoopbackTransport()
+{
+	if (Scenario.IsValid() == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("UULSMockServer: No scenario, call Start first"));
+		return nullptr;
+	}
+
+	UULSLoopbackTransport* transport = NewObject<UULSLoopbackTransport>(this);
+	UULSLoopbackServer* server = NewObject<UULSLoopbackServer>(transport);
+	server->bAcceptConnections = Scenario->bAcceptConnections;
+	transport->Server = server;
+
+	const TSharedRef<FULSMockConnection> connection = MakeShared<FULSMockLoopbackConnection>(NextConnectionIndex++, Scenario, server);
+	Connections.Add(connection);
+
+	server->OnClientPacketNative.AddWeakLambda(this, [this, weakConnection = TWeakPtr<FULSMockConnection>(connection)](const UULSWirePacket* packet)
+	{
+		const TSharedPtr<FULSMockConnection> pinned = weakConnection.Pin();
+		if (bRunning && pinned.IsValid())
+		{
+			pinned->HandleClientPacket(packet->PacketType, packet->GetPayload());
+		}
+	});
+	return transport;
+}
+
+int32 UULSMockServer::GetNumActiveConnections() const
+{
+	int32 count = 0;
+	for (const TSharedRef<FULSMockConnection>& connection : Connections)
+	{
+		count += connection->IsFinished() ? 0 : 1;
+	}
+	return count;
+}
+
+int32 UULSMockServer::GetNumFinishedConnections() const
+{
+	return NumReleasedConnections + Connections.Num() - GetNumActiveConnections();
+}
+
+void UULSMockServer::SetScenario(const FULSMockScenario& scenario)
+{
+	Scenario = MakeShared<const FULSMockScenario>(scenario);
+}
+
+bool UULSMockServer::Tick(float deltaTime)
+{
+	if (WebSocketServer.IsValid())
+	{
+		WebSocketServer->Tick();
+	}
+
+	const double now = FPlatformTime::Seconds();
+	for (int32 i = Connections.Num() - 1; i >= 0; i--)
+	{
+		const TSharedRef<FULSMockConnection> connection = Connections[i];
+		connection->Tick(now);
+		if (connection->IsFinished() && connection->CanRelease())
+		{
+			Connections.RemoveAt(i);
+			NumReleasedConnections++;
+		}
+	}
+	return true;
+}
+
+void UULSMockServer::HandleWebSocketConnected(INetworkingWebSocket* socket)
+{
+	const TSharedRef<FULSMockWebSocketConnection> connection = MakeShared<FULSMockWebSocketConnection>(NextConnectionIndex++, Scenario, socket);
+	Connections.Add(connection);
+
+	socket->SetReceiveCallBack(FWebSocketPacketReceivedCallBack::CreateSP(connection, &FULSMockWebSocketConnection::HandleReceived));
+	socket->SetSocketClosedCallBack(FWebSocketInfoCallBack::CreateSP(connection, &FULSMockWebSocketConnection::HandleClosed));
+	socket->SetErrorCallBack(FWebSocketInfoCallBack::CreateSP(connection, &FULSMockWebSocketConnection::HandleClosed));
+
+	UE_LOG(LogULS, Display, TEXT("UULSMockServer: WebSocket client %s connected"), *socket->RemoteEndPoint(true));
+}
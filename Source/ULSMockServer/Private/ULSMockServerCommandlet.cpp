@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSMockServerCommandlet.h"
+#include "ULSMockServer.h"
+#include "ULSStats.h"
+#include "Containers/Ticker.h"
+#include "CoreGlobals.h"
+
+UULSMockServerCommandlet::UULSMockServerCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UULSMockServerCommandlet::Main(const FString& Params)
+{
+	UULSMockServer* server = NewObject<UULSMockServer>();
+	server->Port = 8080;
+
+	if (FParse::Value(*Params, TEXT("Scenario="), server->ScenarioPath) == false)
+	{
+		UE_LOG(LogULS, Error, TEXT("Usage: -run=ULSMockServer -Scenario=<file> [-Port=8080] [-Connections=0] [-MaxSeconds=0]"));
+		return 1;
+	}
+
+	int32 connections = 0;
+	float maxSeconds = 0;
+	FParse::Value(*Params, TEXT("Port="), server->Port);
+	FParse::Value(*Params, TEXT("Connections="), connections);
+	FParse::Value(*Params, TEXT("MaxSeconds="), maxSeconds);
+
+	if (server->Start() == false)
+	{
+		return 1;
+	}
+	server->AddToRoot();
+
+	const double startTime = FPlatformTime::Seconds();
+	double lastTime = startTime;
+	while (IsEngineExitRequested() == false)
+	{
+		const double now = FPlatformTime::Seconds();
+		FTSTicker::GetCoreTicker().Tick((float)(now - lastTime));
+		lastTime = now;
+
+		if ((connections > 0 && server->GetNumFinishedConnections() >= connections) ||
+			(maxSeconds > 0 && now - startTime >= maxSeconds))
+		{
+			break;
+		}
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	UE_LOG(LogULS, Display, TEXT("ULSMockServer: %d connections finished"), server->GetNumFinishedConnections());
+
+	server->Stop();
+	server->RemoveFromRoot();
+	return 0;
+}
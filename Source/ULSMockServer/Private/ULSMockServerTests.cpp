@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ULSMockServer.h"
+#include "ULSTestSupport.h"
+#include "ULSLoopbackTransport.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Scenarios of the mock server played to a network owner over a loopback transport. The test ticks the
+* server and the owner itself, sleeping between ticks while a wait step runs.
+*/
+
+namespace
+{
+	/* Test session in a world that has begun play, with a mock server playing one scenario */
+	class FMockSession : public FULSTestSession
+	{
+	public:
+		explicit FMockSession(const FString& scenarioText)
+			: FULSTestSession(TEXT("ULSMockServerTest"), true)
+		{
+			Server = NewObject<UULSMockServer>();
+			Server->AddToRoot();
+
+			FULSMockScenario scenario;
+			bParsed = FULSMockScenario::Parse(scenarioText, scenario, ParseError);
+			Server->SetScenario(scenario);
+		}
+
+		virtual ~FMockSession() override
+		{
+			Disconnect();
+			Server->Stop();
+			Server->RemoveFromRoot();
+		}
+
+		/* Starts the server and connects the owner with a loopback transport of it */
+		bool Connect()
+		{
+			if (bParsed == false || Server->Start() == false)
+			{
+				return false;
+			}
+
+			UULSLoopbackTransport* transport = Server->CreateLoopbackTransport();
+			transport->ClientNetworkOwner = Owner;
+			Owner->Transport = transport;
+			return transport->Connect();
+		}
+
+		/* Ticks in real time until the server finished the scenario, then lets the owner handle the rest */
+		bool Play(float seconds = 2.0f)
+		{
+			const double endTime = FPlatformTime::Seconds() + seconds;
+			while (Server->GetNumFinishedConnections() == 0 && FPlatformTime::Seconds() < endTime)
+			{
+				Server->Tick(0.005f);
+				Tick(0.005f);
+				FPlatformProcess::Sleep(0.005f);
+			}
+			Tick(0.01f);
+			return Server->GetNumFinishedConnections() == 1;
+		}
+
+		UULSMockServer* Server;
+		bool bParsed = false;
+		FString ParseError;
+	};
+
+	FString GetActorClassPath()
+	{
+		return AULSTestActor::StaticClass()->GetPathName();
+	}
+
+	FString GetObjectClassPath()
+	{
+		return UULSTestObject::StaticClass()->GetPathName();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSMockServerHandshakeTest, "ULS.MockServer.Handshake",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSMockServerHandshakeTest::RunTest(const FString& Parameters)
+{
+	{
+		FMockSession session(FString::Printf(TEXT("create 1 1 %s; end"), *GetObjectClassPath()));
+		if (TestTrue(TEXT("Accepting server connected"), session.Connect()) == false)
+		{
+			return false;
+		}
+		TestTrue(TEXT("Scenario played"), session.Play());
+		TestTrue(TEXT("Connection accepted"), session.Owner->ConnectionResults == TArray<bool>({ true }));
+		TestNotNull(TEXT("Scenario object created"), session.Find<UULSTestObject>(1));
+	}
+
+	{
+		FMockSession session(FString::Printf(TEXT("reject; create 1 1 %s"), *GetObjectClassPath()));
+		if (TestTrue(TEXT("Rejecting server connected"), session.Connect()) == false)
+		{
+			return false;
+		}
+		TestTrue(TEXT("Rejected connection finished"), session.Play());
+		TestTrue(TEXT("Connection rejected"), session.Owner->ConnectionResults == TArray<bool>({ false }));
+		TestNull(TEXT("Nothing played after the rejection"), session.Find<UULSTestObject>(1));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSMockServerDeferredSpawnTest, "ULS.MockServer.DeferredSpawn",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSMockServerDeferredSpawnTest::RunTest(const FString& Parameters)
+{
+	FMockSession session(FString::Printf(TEXT("spawn 1 3 %s Health:int32=50"), *GetActorClassPath()));
+	if (TestTrue(TEXT("Connected"), session.Connect()) == false)
+	{
+		return false;
+	}
+	TestTrue(TEXT("Scenario played"), session.Play());
+
+	for (int64 uniqueId = 1; uniqueId <= 3; uniqueId++)
+	{
+		const AULSTestActor* actor = session.Find<AULSTestActor>(uniqueId);
+		if (TestNotNull(TEXT("Actor spawned"), actor) == false)
+		{
+			continue;
+		}
+		TestEqual(TEXT("Spawn field applied"), actor->Health, 50);
+		TestEqual(TEXT("Spawn field seen by the construction script"), actor->HealthAtConstruction, 50);
+		TestEqual(TEXT("Spawn field seen by BeginPlay"), actor->HealthAtBeginPlay, 50);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSMockServerSpawnSnapshotTest, "ULS.MockServer.SpawnSnapshot",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSMockServerSpawnSnapshotTest::RunTest(const FString& Parameters)
+{
+	const FString scenario = FString::Printf(TEXT("snapshot 1 5 %s Health:int32=10+5"), *GetActorClassPath());
+
+	// Spawned as soon as the packet arrives
+	{
+		FMockSession session(scenario);
+		session.Owner->SpawnBudgetMilliseconds = 0;
+		if (TestTrue(TEXT("Connected"), session.Connect()) == false)
+		{
+			return false;
+		}
+		TestTrue(TEXT("Scenario played"), session.Play());
+		TestEqual(TEXT("Nothing pending"), session.Owner->GetNumPendingSpawns(), 0);
+
+		for (int64 uniqueId = 1; uniqueId <= 5; uniqueId++)
+		{
+			const AULSTestActor* actor = session.Find<AULSTestActor>(uniqueId);
+			if (TestNotNull(TEXT("Snapshot entry spawned"), actor))
+			{
+				TestEqual(TEXT("Entry fields advance per entry"), actor->Health, 10 + 5 * (int32)(uniqueId - 1));
+				TestEqual(TEXT("Entry fields seen by BeginPlay"), actor->HealthAtBeginPlay, actor->Health);
+			}
+		}
+	}
+
+	// Spawned over several ticks, at least one per tick
+	{
+		FMockSession session(scenario);
+		session.Owner->SpawnBudgetMilliseconds = 0.0001f;
+		if (TestTrue(TEXT("Connected"), session.Connect()) == false)
+		{
+			return false;
+		}
+		TestTrue(TEXT("Scenario played"), session.Play());
+		TestTrue(TEXT("Entries pending"), session.Owner->GetNumPendingSpawns() > 0);
+
+		for (int32 i = 0; i < 10 && session.Owner->GetNumPendingSpawns() > 0; i++)
+		{
+			session.Owner->TickOwner(0.01f);
+		}
+		TestEqual(TEXT("All entries spawned"), session.Owner->GetNumPendingSpawns(), 0);
+		for (int64 uniqueId = 1; uniqueId <= 5; uniqueId++)
+		{
+			TestNotNull(TEXT("Snapshot entry spawned"), session.Find<AULSTestActor>(uniqueId));
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FULSMockServerLifecycleBatchesTest, "ULS.MockServer.LifecycleBatches",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FULSMockServerLifecycleBatchesTest::RunTest(const FString& Parameters)
+{
+	FMockSession session(FString::Printf(TEXT("spawn 1 5 %s; create 11 3 %s; create 21 2 %s; wait 100; despawn 1 5 batch; destroy 11 3 batch; tearoff 21 2 batch"),
+		*GetActorClassPath(), *GetObjectClassPath(), *GetObjectClassPath()));
+	session.Owner->DespawnBudgetMilliseconds = 0.0001f;
+	if (TestTrue(TEXT("Connected"), session.Connect()) == false)
+	{
+		return false;
+	}
+
+	// Everything up to the wait step, to hold the objects before the batches take them out of the registry
+	session.Server->Tick(0.01f);
+	session.Owner->TickOwner(0.01f);
+
+	TArray<AULSTestActor*> actors;
+	for (int64 uniqueId = 1; uniqueId <= 5; uniqueId++)
+	{
+		actors.Add(session.Find<AULSTestActor>(uniqueId));
+	}
+	TArray<UULSTestObject*> objects;
+	for (int64 uniqueId : { 11, 12, 13, 21, 22 })
+	{
+		objects.Add(session.Find<UULSTestObject>(uniqueId));
+	}
+	if (TestFalse(TEXT("Nothing missing before the batches"), actors.Contains(nullptr) || objects.Contains(nullptr)) == false)
+	{
+		return false;
+	}
+
+	TestTrue(TEXT("Scenario played"), session.Play());
+	for (int64 uniqueId : { 1, 2, 3, 4, 5, 11, 12, 13, 21, 22 })
+	{
+		TestNull(TEXT("Id released right away"), session.Owner->FindObjectRefByUniqueId(uniqueId));
+	}
+
+	// Despawned actors are hidden at once and destroyed over the following ticks
+	const int32 numPending = session.Owner->GetNumPendingDespawns();
+	TestTrue(TEXT("Despawns time-sliced"), numPending > 0 && numPending < 5);
+	for (const AULSTestActor* actor : actors)
+	{
+		TestTrue(TEXT("Despawned actor hidden"), IsValid(actor) == false || actor->IsHidden());
+	}
+
+	for (int32 i = 0; i < 10 && session.Owner->GetNumPendingDespawns() > 0; i++)
+	{
+		session.Owner->TickOwner(0.01f);
+	}
+	TestEqual(TEXT("All actors despawned"), session.Owner->GetNumPendingDespawns(), 0);
+	for (const AULSTestActor* actor : actors)
+	{
+		TestFalse(TEXT("Actor destroyed"), IsValid(actor));
+	}
+
+	// Destroyed objects are marked as garbage, torn off ones are handed to the game
+	TestFalse(TEXT("Object 11 destroyed"), IsValid(objects[0]));
+	TestFalse(TEXT("Object 12 destroyed"), IsValid(objects[1]));
+	TestFalse(TEXT("Object 13 destroyed"), IsValid(objects[2]));
+	TestTrue(TEXT("Objects torn off"), session.Owner->TornOffObjects == TArray<UObject*>({ objects[3], objects[4] }));
+	TestTrue(TEXT("Torn off objects kept"), IsValid(objects[3]) && IsValid(objects[4]));
+	return true;
+}
+
+#endif
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ULSPacketWriter.h"
+
+enum class EULSMockStep : uint8
+{
+	Spawn,			// SpawnActor for Count ids starting at FirstId, with Fields as initial state
+	Create,			// CreateObject for Count ids starting at FirstId
+	Snapshot,		// One SpawnSnapshot with a SpawnActor entry per id, like Spawn
+	Replicate,		// Replication rounds for Count ids, Rate per second for Seconds, alongside the following steps
+	Rpc,			// RpcCall of Name on Count ids, with Fields as parameters
+	Wait,			// Delays the following steps by Seconds
+	Despawn,		// DespawnActor for Count ids starting at FirstId, or one DespawnActors if bBatch
+	Destroy,		// DestroyObject for Count ids starting at FirstId, or one DestroyObjects if bBatch
+	TearOff,		// TearOff for Count ids starting at FirstId, or one TearOffs if bBatch
+	End,			// ConnectionEnd
+	Close,			// Closes the connection with StatusCode
+};
+
+/* A replicated field or RPC parameter of a scenario. Numbers and vectors advance by Delta every replication round. */
+struct ULSMOCKSERVER_API FULSMockField
+{
+	FString Name;
+	FString Type;
+	/* Numbers use X */
+	FVector Value = FVector::ZeroVector;
+	FVector Delta = FVector::ZeroVector;
+	FString Text;
+
+	FULSReplicatedField Make(int32 round) const;
+
+	/* Parses <name>:<type>=<value>[+<delta>] */
+	static bool Parse(const FString& token, FULSMockField& outField);
+};
+
+struct FULSMockStep
+{
+	EULSMockStep Type = EULSMockStep::Wait;
+	int64 FirstId = 0;
+	int32 Count = 1;
+	/* Class of Spawn and Create, method of Rpc */
+	FString Name;
+	float Rate = 0;
+	float Seconds = 0;
+	int32 StatusCode = 1000;
+	bool bBatch = false;
+	TArray<FULSMockField> Fields;
+};
+
+/**
+ * What the mock server does with every connection, in order, starting when the connection request
+ * was accepted.
+ *
+ * One step per line or separated by ';', '#' starts a comment line:
+ *
+ *   reject                                                  declines connection requests, must come first
+ *   spawn <firstId> <count> <class> [<field>...]
+ *   create <firstId> <count> <class>
+ *   snapshot <firstId> <count> <class> [<field>...]         one SpawnSnapshot packet
+ *   replicate <firstId> <count> <rate> <seconds> <field>...
+ *   rpc <firstId> <count> <method> [<field>...]
+ *   wait <ms>
+ *   despawn <firstId> <count> [batch]
+ *   destroy <firstId> <count> [batch]
+ *   tearoff <firstId> <count> [batch]                       "batch" sends one packet with all ids
+ *   end                                                     sends ConnectionEnd
+ *   close [statusCode]
+ *
+ * Fields are written <name>:<type>=<value>[+<delta>] with the types ref, int16, int32, int64, bool,
+ * float, double, string and vector, e.g. "Location:vector=0,0,0+10,0,0" or "Health:int32=100+-1".
+ * Spawn fields are the actors' initial state, applied before BeginPlay, snapshot fields advance by
+ * their delta from one entry to the next. Replication runs in the background while the following
+ * steps go on, one packet per object and round. For example
+ *
+ *   spawn 1 100 /Game/BP_Pawn.BP_Pawn_C
+ *   replicate 1 100 10 30 Location:vector=0,0,0+10,0,0 Health:int32=100
+ *   wait 30000
+ *   despawn 1 100
+ *   end
+ */
+struct ULSMOCKSERVER_API FULSMockScenario
+{
+	bool bAcceptConnections = true;
+	TArray<FULSMockStep> Steps;
+
+	static bool Parse(const FString& text, FULSMockScenario& outScenario, FString& outError);
+
+	/* Relative paths are relative to the project directory */
+	static bool LoadFromFile(const FString& path, FULSMockScenario& outScenario, FString& outError);
+};
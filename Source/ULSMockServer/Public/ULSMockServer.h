@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "ULSMockScenario.h"
+#include "ULSMockServer.generated.h"
+
+class IWebSocketServer;
+class INetworkingWebSocket;
+class UULSLoopbackTransport;
+class FULSMockConnection;
+
+/**
+ * Local stand-in for the ULS server, for end-to-end tests and profiling without network access.
+ *
+ * Plays a scenario (see FULSMockScenario) to every client that connects, over WebSocket, the
+ * loopback transport or both. The connection handshake is answered like the real server does,
+ * optional transport features are declined, Pings are answered and RpcCall packets are echoed as
+ * RpcCallResponse. Each connection plays the scenario on its own timeline, starting when its
+ * connection request was accepted, so the same scenario always produces the same load shape.
+ *
+ * WebSocket clients use UULSWebSocketTransport with SetConnectionData("127.0.0.1", Port, "", "ws")
+ * and the Subprotocol "binary", the one the WebSocketNetworking listener accepts. The listener
+ * can't close connections from the server side, a "close" step ends the session with a
+ * ConnectionEnd there instead.
+ *
+ * The server ticks on the core ticker between Start and Stop.
+ */
+UCLASS(BlueprintType)
+class ULSMOCKSERVER_API UULSMockServer : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginDestroy() override;
+
+	/* Scenario file played when Start is called, relative paths are relative to the project directory */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSMockServer)
+		FString ScenarioPath;
+
+	/* WebSocket port to listen on, 0 for loopback connections only */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ULSMockServer)
+		int32 Port = 0;
+
+	/* Loads ScenarioPath, unless a scenario was set with SetScenario, and starts listening */
+	UFUNCTION(BlueprintCallable, Category = ULSMockServer)
+		bool Start();
+
+	/* Stops listening and playing. Loopback transports created before stay connected but receive nothing. */
+	UFUNCTION(BlueprintCallable, Category = ULSMockServer)
+		void Stop();
+
+	/* New loopback transport, played the scenario once the network owner connects with it */
+	UFUNCTION(BlueprintCallable, Category = ULSMockServer)
+		UULSLoopbackTransport* CreateLoopbackTransport();
+
+	UFUNCTION(BlueprintCallable, Category = ULSMockServer)
+		int32 GetNumActiveConnections() const;
+
+	/* Connections that played the whole scenario, were rejected or went away */
+	UFUNCTION(BlueprintCallable, Category = ULSMockServer)
+		int32 GetNumFinishedConnections() const;
+
+	/* Replaces the scenario for connections accepted from now on */
+	void SetScenario(const FULSMockScenario& scenario);
+
+	bool IsRunning() const { return bRunning; }
+
+	/* Plays the scenario up to now. Called by the core ticker while running, tests call it to play synchronously. */
+	bool Tick(float deltaTime);
+
+private:
+	void HandleWebSocketConnected(INetworkingWebSocket* socket);
+
+	TSharedPtr<const FULSMockScenario> Scenario;
+	TArray<TSharedRef<FULSMockConnection>> Connections;
+	/* Shared so the header can get away with a forward declaration */
+	TSharedPtr<IWebSocketServer> WebSocketServer;
+	FTSTicker::FDelegateHandle TickerHandle;
+	int32 NumReleasedConnections = 0;
+	int32 NextConnectionIndex = 0;
+	bool bRunning = false;
+};
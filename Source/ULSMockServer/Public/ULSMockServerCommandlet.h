@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ULSMockServerCommandlet.generated.h"
+
+/**
+ * Runs a UULSMockServer on its own, for clients in other processes on the same machine.
+ * 
+ * Usage: -run=ULSMockServer -Scenario=<file> [-Port=8080] [-Connections=0] [-MaxSeconds=0]
+ * 
+ * The scenario syntax is described at FULSMockScenario. Exits once -Connections clients finished
+ * the scenario or after -MaxSeconds, whichever comes first; 0 for no limit. Returns 0 unless the
+ * server failed to start.
+ */
+UCLASS()
+class ULSMOCKSERVER_API UULSMockServerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UULSMockServerCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
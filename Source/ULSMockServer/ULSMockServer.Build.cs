@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class ULSMockServer : ModuleRules
+{
+	public ULSMockServer(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[] {
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"ULSClient"
+			}
+		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[] {
+				// WebSocket listener, from the WebSocketNetworking plugin
+				"WebSocketNetworking"
+			}
+		);
+	}
+}
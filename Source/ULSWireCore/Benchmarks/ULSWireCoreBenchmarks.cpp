@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WireCore/ULSBitStream.h"
+#include "WireCore/ULSWireReader.h"
+#include "WireCore/ULSWireWriter.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+using namespace ULSWire;
+
+namespace
+{
+	/* Mostly small values with a long tail, like ids, counts and integer fields */
+	std::vector<uint64_t> MakeVarUIntValues(size_t count)
+	{
+		std::mt19937_64 random(7);
+		std::vector<uint64_t> values(count);
+		for (uint64_t& value : values)
+		{
+			value = random() >> (random() % 64);
+		}
+		return values;
+	}
+
+	std::vector<uint8_t> EncodeVarUInts(const std::vector<uint64_t>& values)
+	{
+		FWireWriter writer(EWirePacketType::Replication);
+		for (uint64_t value : values)
+		{
+			writer.WriteVarUInt(value);
+		}
+		return writer.MoveBytes();
+	}
+
+	/* Replication-like payload: field type, name and an int32 value, in the default encoding */
+	std::vector<uint8_t> MakeFieldPayload(int32_t numFields)
+	{
+		FWireWriter writer(EWirePacketType::Replication);
+		for (int32_t i = 0; i < numFields; i++)
+		{
+			writer.WriteValue<int8_t>(1);
+			writer.WriteString("Health", 6);
+			writer.WriteValue<int32_t>(sizeof(int32_t));
+			writer.WriteValue<int32_t>(i);
+		}
+		return writer.MoveBytes();
+	}
+}
+
+static void BM_EncodeVarUInt(benchmark::State& state)
+{
+	const std::vector<uint64_t> values = MakeVarUIntValues(4096);
+	std::vector<uint8_t> buffer(values.size() * MaxVarUIntSize);
+	for (auto _ : state)
+	{
+		uint8_t* ptr = buffer.data();
+		for (uint64_t value : values)
+		{
+			ptr += EncodeVarUInt(value, ptr);
+		}
+		benchmark::DoNotOptimize(ptr);
+	}
+	state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_EncodeVarUInt);
+
+static void BM_DecodeVarUInt(benchmark::State& state)
+{
+	const std::vector<uint64_t> values = MakeVarUIntValues(4096);
+	const std::vector<uint8_t> bytes = EncodeVarUInts(values);
+	const FWireReader reader(bytes.data() + HeaderSize, (int32_t)bytes.size() - HeaderSize);
+	for (auto _ : state)
+	{
+		int32_t position = 0;
+		uint64_t sum = 0;
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			sum += reader.ReadVarUInt(position, position);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * values.size());
+	state.SetBytesProcessed(state.iterations() * (bytes.size() - HeaderSize));
+}
+BENCHMARK(BM_DecodeVarUInt);
+
+static void BM_ReadFields(benchmark::State& state)
+{
+	const std::vector<uint8_t> bytes = MakeFieldPayload((int32_t)state.range(0));
+	FWireHeader header;
+	for (auto _ : state)
+	{
+		ParseHeader(bytes.data(), (int32_t)bytes.size(), header);
+		const FWireReader reader(bytes.data() + header.PayloadOffset, (int32_t)bytes.size() - header.PayloadOffset);
+		int32_t position = 0;
+		int64_t sum = 0;
+		while (position < reader.GetSize())
+		{
+			int32_t length;
+			sum += reader.Read<int8_t>(position, position);
+			sum += reader.ReadString(position, position, length) != nullptr ? length : 0;
+			const int32_t size = reader.Read<int32_t>(position, position);
+			sum += size == sizeof(int32_t) ? reader.Read<int32_t>(position, position) : 0;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_ReadFields)->Arg(16)->Arg(256);
+
+static void BM_WriteBits(benchmark::State& state)
+{
+	const int32_t numBits = (int32_t)state.range(0);
+	FBitWriter writer;
+	for (auto _ : state)
+	{
+		writer.Reset();
+		for (int32_t i = 0; i < 1024; i++)
+		{
+			writer.WriteBits((uint64_t)i * 0x9E3779B97F4A7C15ull, numBits);
+		}
+		benchmark::DoNotOptimize(writer.GetData().data());
+	}
+	state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_WriteBits)->Arg(3)->Arg(16)->Arg(64);
+
+static void BM_ReadBits(benchmark::State& state)
+{
+	const int32_t numBits = (int32_t)state.range(0);
+	FBitWriter writer;
+	for (int32_t i = 0; i < 1024; i++)
+	{
+		writer.WriteBits((uint64_t)i * 0x9E3779B97F4A7C15ull, numBits);
+	}
+
+	for (auto _ : state)
+	{
+		FBitReader reader(writer.GetData().data(), writer.GetNumBytes());
+		uint64_t sum = 0;
+		for (int32_t i = 0; i < 1024; i++)
+		{
+			sum += reader.ReadBits(numBits);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_ReadBits)->Arg(3)->Arg(16)->Arg(64);
+
+static void BM_WriteQuantizedVector(benchmark::State& state)
+{
+	const FQuantization settings;
+	std::mt19937_64 random(3);
+	std::uniform_real_distribution<double> distribution(-100000.0, 100000.0);
+	std::vector<double> components(3 * 1024);
+	for (double& component : components)
+	{
+		component = distribution(random);
+	}
+
+	FBitWriter writer;
+	for (auto _ : state)
+	{
+		writer.Reset();
+		for (size_t i = 0; i < components.size(); i += 3)
+		{
+			writer.WriteQuantizedVector(&components[i], settings);
+		}
+		benchmark::DoNotOptimize(writer.GetData().data());
+	}
+	state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_WriteQuantizedVector);
+
+static void BM_ReadQuantizedVector(benchmark::State& state)
+{
+	const FQuantization settings;
+	std::mt19937_64 random(3);
+	std::uniform_real_distribution<double> distribution(-100000.0, 100000.0);
+	FBitWriter writer;
+	for (int32_t i = 0; i < 1024; i++)
+	{
+		const double value[3] = { distribution(random), distribution(random), distribution(random) };
+		writer.WriteQuantizedVector(value, settings);
+	}
+
+	for (auto _ : state)
+	{
+		FBitReader reader(writer.GetData().data(), writer.GetNumBytes());
+		double sum = 0;
+		for (int32_t i = 0; i < 1024; i++)
+		{
+			double value[3];
+			reader.ReadQuantizedVector(value, settings);
+			sum += value[0];
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_ReadQuantizedVector);
@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WireCore/ULSBitStream.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace ULSWire;
+
+namespace
+{
+	/* The original bit-by-bit writer. The byte-wise writer must produce identical streams. */
+	class FReferenceBitWriter
+	{
+	public:
+		void WriteBits(uint64_t value, int32_t numBits)
+		{
+			for (int32_t i = 0; i < numBits; i++)
+			{
+				const size_t byteIndex = NumBits >> 3;
+				if (byteIndex >= Data.size())
+				{
+					Data.push_back(0);
+				}
+				if ((value >> i) & 1)
+				{
+					Data[byteIndex] |= (uint8_t)(1 << (NumBits & 7));
+				}
+				NumBits++;
+			}
+		}
+
+		void WriteVarUInt(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				WriteBits((value & 0x7F) | 0x80, 8);
+				value >>= 7;
+			}
+			WriteBits(value, 8);
+		}
+
+		void AlignToByte()
+		{
+			NumBits = (NumBits + 7) & ~7;
+			Data.resize(NumBits >> 3);
+		}
+
+		std::vector<uint8_t> Data;
+		int32_t NumBits = 0;
+	};
+
+	uint64_t Mask(int32_t numBits)
+	{
+		return numBits == 64 ? ~0ull : (1ull << numBits) - 1;
+	}
+}
+
+TEST(ULSBitStream, MatchesReferenceWriter)
+{
+	std::mt19937_64 random(1234);
+	FBitWriter writer;
+	FReferenceBitWriter reference;
+
+	for (int32_t i = 0; i < 10000; i++)
+	{
+		const uint64_t value = random();
+		switch (random() % 3)
+		{
+		case 0:
+		{
+			const int32_t numBits = (int32_t)(random() % 65);
+			writer.WriteBits(value, numBits);
+			reference.WriteBits(value, numBits);
+			break;
+		}
+		case 1:
+		{
+			const uint64_t varint = value >> (random() % 64);
+			writer.WriteVarUInt(varint);
+			reference.WriteVarUInt(varint);
+			break;
+		}
+		default:
+			writer.AlignToByte();
+			reference.AlignToByte();
+			break;
+		}
+	}
+
+	EXPECT_EQ(writer.GetNumBits(), reference.NumBits);
+	EXPECT_EQ(writer.GetData(), reference.Data);
+}
+
+TEST(ULSBitStream, ReadsWhatWasWritten)
+{
+	std::mt19937_64 random(42);
+	std::vector<std::pair<uint64_t, int32_t>> values;
+	FBitWriter writer;
+	for (int32_t i = 0; i < 5000; i++)
+	{
+		const int32_t numBits = (int32_t)(random() % 65);
+		const uint64_t value = random() & Mask(numBits);
+		values.emplace_back(value, numBits);
+		writer.WriteBits(value, numBits);
+	}
+
+	FBitReader reader(writer.GetData().data(), writer.GetNumBytes());
+	for (const std::pair<uint64_t, int32_t>& value : values)
+	{
+		ASSERT_EQ(reader.ReadBits(value.second), value.first);
+	}
+	EXPECT_FALSE(reader.IsOverflowed());
+	EXPECT_EQ(reader.GetNumBytesConsumed(), writer.GetNumBytes());
+}
+
+TEST(ULSBitStream, VarIntsRoundTripAlignedAndUnaligned)
+{
+	const int64_t values[] = { 0, 1, -1, 127, 128, -129, 1ll << 50, -(1ll << 62) };
+
+	FBitWriter writer;
+	for (int64_t value : values)
+	{
+		writer.WriteVarInt(value);
+		writer.WriteBits(1, 3);
+	}
+
+	FBitReader reader(writer.GetData().data(), writer.GetNumBytes());
+	for (int64_t value : values)
+	{
+		EXPECT_EQ(reader.ReadVarInt(), value);
+		EXPECT_EQ(reader.ReadBits(3), 1u);
+	}
+	EXPECT_FALSE(reader.IsOverflowed());
+}
+
+TEST(ULSBitStream, OverflowReturnsZero)
+{
+	const uint8_t data[2] = { 0xFF, 0xFF };
+	FBitReader reader(data, sizeof(data));
+
+	EXPECT_EQ(reader.ReadBits(12), 0xFFFu);
+	EXPECT_EQ(reader.ReadBits(5), 0u);
+	EXPECT_TRUE(reader.IsOverflowed());
+	EXPECT_EQ(reader.ReadBits(1), 0u);
+
+	// A varint that never ends
+	FBitReader varint(data, sizeof(data));
+	varint.ReadVarUInt();
+	EXPECT_TRUE(varint.IsOverflowed());
+}
+
+TEST(ULSBitStream, ReaderStartsAtByte)
+{
+	FBitWriter writer;
+	writer.WriteBits(0xAB, 8);
+	writer.WriteVarUInt(300);
+
+	FBitReader reader(writer.GetData().data(), writer.GetNumBytes(), 1);
+	EXPECT_EQ(reader.ReadVarUInt(), 300u);
+	EXPECT_EQ(reader.GetNumBytesConsumed(), 2);
+}
+
+TEST(ULSBitStream, QuantizedFloatsKeepPrecision)
+{
+	const FQuantization settings;
+	const double values[] = { 0.0, 1.0, -1.0, 3.14159, -1234.5678, 0.0005 };
+
+	FBitWriter writer;
+	for (double value : values)
+	{
+		writer.WriteQuantizedFloat(value, settings);
+	}
+
+	FBitReader reader(writer.GetData().data(), writer.GetNumBytes());
+	for (double value : values)
+	{
+		EXPECT_NEAR(reader.ReadQuantizedFloat(settings), value, settings.FloatPrecision * 0.5 + 1e-9);
+	}
+}
+
+TEST(ULSBitStream, QuantizedVectorsKeepPrecision)
+{
+	FQuantization settings;
+	const double tolerance = settings.VectorCellSize / ((1 << settings.VectorComponentBits) - 1) * 0.5 + 1e-9;
+	const double values[][3] = { { 0, 0, 0 }, { 100.25, -5000.5, 1e6 }, { -0.001, 1023.999, -1024.0 } };
+
+	FBitWriter writer;
+	for (const double* value : values)
+	{
+		writer.WriteQuantizedVector(value, settings);
+	}
+	EXPECT_EQ(writer.GetNumBits() % 8, 0);
+
+	FBitReader reader(writer.GetData().data(), writer.GetNumBytes());
+	for (const double* value : values)
+	{
+		double decoded[3];
+		reader.ReadQuantizedVector(decoded, settings);
+		for (int32_t i = 0; i < 3; i++)
+		{
+			EXPECT_NEAR(decoded[i], value[i], tolerance);
+		}
+	}
+	EXPECT_FALSE(reader.IsOverflowed());
+	EXPECT_EQ(reader.GetNumBytesConsumed(), writer.GetNumBytes());
+}
+
+TEST(ULSBitStream, ResetClearsTheStream)
+{
+	FBitWriter writer;
+	writer.WriteBits(0x1F, 5);
+	writer.Reset();
+	writer.WriteBits(0x1, 1);
+	EXPECT_EQ(writer.GetNumBits(), 1);
+	ASSERT_EQ(writer.GetData().size(), 1u);
+	EXPECT_EQ(writer.GetData()[0], 1);
+}
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WireCore/ULSWireFormat.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <vector>
+
+using namespace ULSWire;
+
+TEST(ULSWireFormat, ParsesHeader)
+{
+	const int32_t header = MakeHeader(EWirePacketType::Replication, EWirePacketFlags::CompactEncoding);
+	uint8_t bytes[HeaderSize + 2];
+	std::memcpy(bytes, &header, sizeof(header));
+
+	FWireHeader parsed;
+	ASSERT_TRUE(ParseHeader(bytes, sizeof(bytes), parsed));
+	EXPECT_EQ(parsed.PacketType, EWirePacketType::Replication);
+	EXPECT_EQ(parsed.Flags, EWirePacketFlags::CompactEncoding);
+	EXPECT_EQ(parsed.Sequence, 0);
+	EXPECT_EQ(parsed.PayloadOffset, HeaderSize);
+}
+
+TEST(ULSWireFormat, ParsesSequencedHeader)
+{
+	const int32_t header = MakeHeader(EWirePacketType::RpcCall, EWirePacketFlags::Sequenced);
+	const int64_t sequence = 0x0123456789ABCDEFll;
+	uint8_t bytes[HeaderSize + sizeof(int64_t)];
+	std::memcpy(bytes, &header, sizeof(header));
+	std::memcpy(bytes + HeaderSize, &sequence, sizeof(sequence));
+
+	FWireHeader parsed;
+	ASSERT_TRUE(ParseHeader(bytes, sizeof(bytes), parsed));
+	EXPECT_EQ(parsed.PacketType, EWirePacketType::RpcCall);
+	EXPECT_EQ(parsed.Sequence, sequence);
+	EXPECT_EQ(parsed.PayloadOffset, HeaderSize + (int32_t)sizeof(int64_t));
+
+	EXPECT_FALSE(ParseHeader(bytes, sizeof(bytes) - 1, parsed));
+}
+
+TEST(ULSWireFormat, RejectsShortHeader)
+{
+	const uint8_t bytes[3] = { 110, 0, 0 };
+	FWireHeader parsed;
+	EXPECT_FALSE(ParseHeader(bytes, sizeof(bytes), parsed));
+	EXPECT_FALSE(ParseHeader(bytes, 0, parsed));
+}
+
+TEST(ULSWireFormat, MakeHeaderKeepsTypeAndFlagsApart)
+{
+	const int32_t header = MakeHeader(0x7FFFFFFF, EWirePacketFlags::Compressed);
+	EXPECT_EQ(header & PacketTypeMask, PacketTypeMask);
+	EXPECT_EQ(header & ~PacketTypeMask, EWirePacketFlags::Compressed);
+}
+
+TEST(ULSWireFormat, ZigZagRoundTrips)
+{
+	EXPECT_EQ(ZigZagEncode(0), 0u);
+	EXPECT_EQ(ZigZagEncode(-1), 1u);
+	EXPECT_EQ(ZigZagEncode(1), 2u);
+	EXPECT_EQ(ZigZagEncode(-2), 3u);
+
+	const int64_t values[] = { 0, 1, -1, 63, -64, 1000000, -1000000,
+		std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min() };
+	for (int64_t value : values)
+	{
+		EXPECT_EQ(ZigZagDecode(ZigZagEncode(value)), value);
+	}
+}
+
+TEST(ULSWireFormat, VarUIntRoundTrips)
+{
+	const uint64_t values[] = { 0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, 0xFFFFFFFFull, std::numeric_limits<uint64_t>::max() };
+	const int32_t sizes[] = { 1, 1, 1, 2, 2, 3, 5, 10 };
+
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+	{
+		uint8_t bytes[MaxVarUIntSize];
+		EXPECT_EQ(GetVarUIntSize(values[i]), sizes[i]);
+		ASSERT_EQ(EncodeVarUInt(values[i], bytes), sizes[i]);
+
+		uint64_t decoded = 1;
+		EXPECT_EQ(DecodeVarUInt(bytes, sizes[i], decoded), sizes[i]);
+		EXPECT_EQ(decoded, values[i]);
+	}
+}
+
+TEST(ULSWireFormat, RejectsTruncatedAndOverlongVarUInt)
+{
+	uint8_t bytes[MaxVarUIntSize + 1];
+	const int32_t size = EncodeVarUInt(0x123456789ull, bytes);
+
+	uint64_t decoded = 1;
+	EXPECT_EQ(DecodeVarUInt(bytes, size - 1, decoded), 0);
+	EXPECT_EQ(decoded, 0u);
+	EXPECT_EQ(DecodeVarUInt(bytes, 0, decoded), 0);
+
+	std::memset(bytes, 0x80, sizeof(bytes));
+	EXPECT_EQ(DecodeVarUInt(bytes, sizeof(bytes), decoded), 0);
+}
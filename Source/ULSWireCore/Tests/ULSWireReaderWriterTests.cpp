@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WireCore/ULSWireReader.h"
+#include "WireCore/ULSWireWriter.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace ULSWire;
+
+TEST(ULSWireReaderWriter, PutAndReadFixedValues)
+{
+	std::vector<uint8_t> payload(1 + 2 + 4 + 8 + 4 + 8);
+	FPayloadWriter writer(payload.data(), (int32_t)payload.size());
+
+	int32_t position = 0;
+	ASSERT_TRUE(writer.Put<int8_t>(-5, position, position));
+	ASSERT_TRUE(writer.Put<int16_t>(-1234, position, position));
+	ASSERT_TRUE(writer.Put<int32_t>(123456789, position, position));
+	ASSERT_TRUE(writer.Put<int64_t>(-9876543210ll, position, position));
+	ASSERT_TRUE(writer.Put<float>(1.5f, position, position));
+	ASSERT_TRUE(writer.Put<double>(-2.25, position, position));
+	EXPECT_EQ(position, (int32_t)payload.size());
+	EXPECT_FALSE(writer.Put<int8_t>(1, position, position));
+
+	const FWireReader reader(payload.data(), (int32_t)payload.size());
+	int32_t index = 0;
+	EXPECT_EQ(reader.Read<int8_t>(index, index), -5);
+	EXPECT_EQ(reader.Read<int16_t>(index, index), -1234);
+	EXPECT_EQ(reader.Read<int32_t>(index, index), 123456789);
+	EXPECT_EQ(reader.Read<int64_t>(index, index), -9876543210ll);
+	EXPECT_EQ(reader.Read<float>(index, index), 1.5f);
+	EXPECT_EQ(reader.Read<double>(index, index), -2.25);
+	EXPECT_EQ(index, (int32_t)payload.size());
+}
+
+TEST(ULSWireReaderWriter, OutOfBoundsReadsReturnZeroWithoutAdvancing)
+{
+	const uint8_t payload[3] = { 1, 2, 3 };
+	const FWireReader reader(payload, sizeof(payload));
+
+	int32_t position = 0;
+	EXPECT_EQ(reader.Read<int32_t>(0, position), 0);
+	EXPECT_EQ(reader.Read<int8_t>(3, position), 0);
+	EXPECT_EQ(reader.Read<int8_t>(-1, position), 0);
+	EXPECT_EQ(reader.ReadDataPtr(4, 0, position), nullptr);
+	EXPECT_EQ(reader.ReadVarUInt(3, position), 0u);
+	EXPECT_EQ(position, 0);
+
+	EXPECT_EQ(reader.Read<int8_t>(2, position), 3);
+	EXPECT_EQ(position, 1);
+}
+
+TEST(ULSWireReaderWriter, ReadsAccumulateIntoAdvancedPosition)
+{
+	const uint8_t payload[4] = { 1, 2, 3, 4 };
+	const FWireReader reader(payload, sizeof(payload));
+
+	// Handlers pass a running position and read at their own index
+	int32_t position = 10;
+	reader.Read<int16_t>(2, position);
+	EXPECT_EQ(position, 12);
+}
+
+TEST(ULSWireReaderWriter, StringsRoundTrip)
+{
+	const std::string text = "Hello ULS";
+	std::vector<uint8_t> payload(4 + text.size() + 1 + text.size());
+	FPayloadWriter writer(payload.data(), (int32_t)payload.size());
+
+	int32_t position = 0;
+	ASSERT_TRUE(writer.PutString(text.data(), (int32_t)text.size(), position, position));
+	ASSERT_TRUE(writer.PutVarString(text.data(), (int32_t)text.size(), position, position));
+	EXPECT_EQ(position, (int32_t)payload.size());
+
+	const FWireReader reader(payload.data(), (int32_t)payload.size());
+	int32_t index = 0;
+	int32_t length = 0;
+	const char* chars = reader.ReadString(index, index, length);
+	ASSERT_NE(chars, nullptr);
+	EXPECT_EQ(std::string(chars, length), text);
+
+	chars = reader.ReadVarString(index, index, length);
+	ASSERT_NE(chars, nullptr);
+	EXPECT_EQ(std::string(chars, length), text);
+	EXPECT_EQ(index, (int32_t)payload.size());
+}
+
+TEST(ULSWireReaderWriter, RejectsStringsPastTheEnd)
+{
+	std::vector<uint8_t> payload(8);
+	const int32_t length = 5;
+	std::memcpy(payload.data(), &length, sizeof(length));
+
+	const FWireReader reader(payload.data(), (int32_t)payload.size());
+	int32_t position = 0;
+	int32_t outLength = -1;
+	EXPECT_EQ(reader.ReadString(0, position, outLength), nullptr);
+	EXPECT_EQ(outLength, 0);
+	EXPECT_EQ(position, 0);
+
+	const int32_t negative = -2;
+	std::memcpy(payload.data(), &negative, sizeof(negative));
+	EXPECT_EQ(reader.ReadString(0, position, outLength), nullptr);
+	EXPECT_EQ(position, 0);
+
+	payload[0] = 100;
+	EXPECT_EQ(reader.ReadVarString(0, position, outLength), nullptr);
+	EXPECT_EQ(position, 0);
+}
+
+TEST(ULSWireReaderWriter, VarIntsRoundTrip)
+{
+	const int64_t values[] = { 0, -1, 1, 300, -300, 1ll << 40, -(1ll << 40) };
+	std::vector<uint8_t> payload(sizeof(values) / sizeof(values[0]) * MaxVarUIntSize);
+	FPayloadWriter writer(payload.data(), (int32_t)payload.size());
+
+	int32_t position = 0;
+	for (int64_t value : values)
+	{
+		ASSERT_TRUE(writer.PutVarInt(value, position, position));
+	}
+
+	const FWireReader reader(payload.data(), position);
+	int32_t index = 0;
+	for (int64_t value : values)
+	{
+		EXPECT_EQ(reader.ReadVarInt(index, index), value);
+	}
+	EXPECT_EQ(index, position);
+}
+
+TEST(ULSWireReaderWriter, FullPayloadRejectsWrites)
+{
+	uint8_t payload[4] = {};
+	FPayloadWriter writer(payload, sizeof(payload));
+
+	int32_t position = 0;
+	EXPECT_FALSE(writer.Put<int64_t>(1, 0, position));
+	EXPECT_FALSE(writer.PutString("abc", 3, 0, position));
+	EXPECT_FALSE(writer.PutVarUInt(1ull << 30, 0, position));
+	EXPECT_FALSE(writer.PutBytes(payload, 1, 4, position));
+	EXPECT_EQ(position, 0);
+}
+
+TEST(ULSWireReaderWriter, WireWriterBuildsParsablePackets)
+{
+	FWireWriter writer(EWirePacketType::RpcCall, EWirePacketFlags::CompactEncoding);
+	writer.WriteVarInt(-42);
+	writer.WriteVarString("Method", 6);
+	writer.WriteValue<float>(0.5f);
+
+	const std::vector<uint8_t>& bytes = writer.GetBytes();
+	FWireHeader header;
+	ASSERT_TRUE(ParseHeader(bytes.data(), (int32_t)bytes.size(), header));
+	EXPECT_EQ(header.PacketType, EWirePacketType::RpcCall);
+	EXPECT_EQ(header.Flags, EWirePacketFlags::CompactEncoding);
+	EXPECT_EQ(writer.GetPayloadSize(), (int32_t)bytes.size() - header.PayloadOffset);
+
+	const FWireReader reader(bytes.data() + header.PayloadOffset, writer.GetPayloadSize());
+	int32_t index = 0;
+	int32_t length = 0;
+	EXPECT_EQ(reader.ReadVarInt(index, index), -42);
+	const char* chars = reader.ReadVarString(index, index, length);
+	EXPECT_EQ(std::string(chars, length), "Method");
+	EXPECT_EQ(reader.Read<float>(index, index), 0.5f);
+	EXPECT_EQ(index, writer.GetPayloadSize());
+}